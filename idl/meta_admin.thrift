@@ -100,12 +100,23 @@ struct replica_server_info
     2:i64 total_capacity_mb;
 }
 
+// The digest of the app info and the partition configuration synced from meta server to
+// a replica by config sync.
+struct config_sync_digest
+{
+    1:dsn.gpid pid;
+    2:i64      digest;
+}
+
 struct configuration_query_by_node_request
 {
     1:dsn.rpc_address                      node;
     2:optional list<metadata.replica_info> stored_replicas;
     3:optional replica_server_info         info;
     4:optional dsn.host_port               hp_node;
+    // The digests of the configs which have been applied by the replicas. Meta server would
+    // not send the configs back if they are not changed since then.
+    5:optional list<config_sync_digest>    synced_digests;
 }
 
 struct configuration_query_by_node_response
@@ -113,6 +124,11 @@ struct configuration_query_by_node_response
     1:dsn.error_code err;
     2:list<configuration_update_request> partitions;
     3:optional list<metadata.replica_info> gc_replicas;
+    // The digests of the configs in `partitions`, in the same order.
+    4:optional list<config_sync_digest> digests;
+    // The partitions which are still served by the node, but whose configs are not sent
+    // since they are the same as the synced digests.
+    5:optional list<dsn.gpid> unchanged_partitions;
 }
 
 struct configuration_recovery_request
@@ -237,6 +237,10 @@ struct incr_request
     3:i32           expire_ts_seconds; // 0 means keep original ttl
                                        // >0 means reset to new ttl
                                        // <0 means reset to no ttl
+    4:optional bool return_new_value = true; // false means the new value is not needed by
+                                             // the client, thus the incr could be written
+                                             // without read-before-write on the tables whose
+                                             // incr merge is enabled
 }
 
 struct incr_response
@@ -310,6 +314,59 @@ struct check_and_mutate_response
     8:string         server;
 }
 
+struct scan_aggregation_request
+{
+    // Parse the values as decimal int64 to calculate the sum, min and max.
+    1:bool          numeric_value_stats;
+    // The ascending upper bounds (exclusive) of the buckets of the value size histogram, empty
+    // means no histogram.
+    2:list<i64>     value_size_buckets;
+    // The number of the records with the largest values to be returned, 0 means none.
+    3:i32           top_k_by_value_size;
+}
+
+struct scan_value_size_entry
+{
+    1:dsn.blob      key;
+    2:i64           value_size;
+}
+
+struct scan_aggregation_result
+{
+    1:i64           count;
+    2:i64           total_key_size;
+    3:i64           total_value_size;
+    // The following are set only if numeric_value_stats is requested, and min/max are
+    // meaningful only if numeric_count > 0.
+    4:i64           numeric_count;
+    5:i64           non_numeric_count;
+    6:i64           sum;
+    7:bool          sum_overflow;
+    8:i64           min;
+    9:i64           max;
+    // value_size_histogram[i] is the number of the records whose value size is in
+    // [value_size_buckets[i-1], value_size_buckets[i]), thus it has one more element than
+    // value_size_buckets for the sizes no less than the last bound.
+    10:list<i64>    value_size_histogram;
+    // Sorted by value_size in descending order.
+    11:list<scan_value_size_entry> top_k;
+}
+
+// Only the records whose values hold a point within the circle around the center are returned
+// by the scan. The latitude and longitude are the fields at the given indices of the value split
+// by '|', the same as the ones encoded by the geo client.
+struct scan_geo_filter
+{
+    1:double        lat_degrees;
+    2:double        lng_degrees;
+    3:double        radius_m;
+    4:i32           latitude_index;
+    5:i32           longitude_index;
+    // If > 0, only the nearest ones of all the matched records of the scan are returned, which
+    // are returned by the last batch in ascending order of the distance.
+    6:i32           top_k_nearest;
+}
+
 struct get_scanner_request
 {
     1:dsn.blob  start_key;
@@ -326,6 +383,14 @@ struct get_scanner_request
     12:optional bool    return_expire_ts;
     13:optional bool full_scan; // true means client want to build 'full scan' context with the server side, false otherwise
     14:optional bool only_return_count = false;
+    // The max bytes of the keys and values returned in a batch, 0 means no limit. A batch is
+    // ended once either batch_size or batch_bytes is reached.
+    15:optional i32 batch_bytes = 0;
+    // If set, the records are aggregated on the server side instead of being returned, and
+    // only the aggregated result of each batch is returned.
+    16:optional scan_aggregation_request aggregation;
+    // If set, the records are filtered by the distance of the points held by the values.
+    17:optional scan_geo_filter geo_filter;
 }
 
 struct scan_request
@@ -342,6 +407,7 @@ struct scan_response
     5:i32           partition_index;
     6:string        server;
     7:optional i32  kv_count;
+    8:optional scan_aggregation_result aggregation;
 }
 
 service rrdb
@@ -81,6 +81,10 @@ public:
 
     virtual aio_context *prepare_aio_context(aio_task *) = 0;
 
+    // Whether the provider is able to write the `_unmerged_write_buffers` of an aio_task
+    // directly. If not, the buffers would be collapsed into a single one before submitted.
+    virtual bool support_vectored_write() const { return false; }
+
     void complete_io(aio_task *aio, error_code err, uint64_t bytes);
 
 private:
@@ -33,6 +33,7 @@
 
 #include "aio/aio_provider.h"
 #include "aio/aio_task.h"
+#include "io_uring_aio_provider.h"
 #include "native_linux_aio_provider.h"
 #include "task/task.h"
 #include "task/task_code.h"
@@ -40,17 +41,29 @@
 #include "runtime/tool_api.h"
 #include "utils/error_code.h"
 #include "utils/factory_store.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/join_point.h"
 #include "utils/link.h"
 #include "utils/threadpool_code.h"
 
+DSN_DEFINE_string(aio,
+                  aio_factory_name,
+                  "dsn::tools::native_aio_provider",
+                  "The implementation class of aio provider, could be "
+                  "'dsn::tools::native_aio_provider' or 'dsn::tools::io_uring_aio_provider'");
+
 namespace dsn {
 DEFINE_TASK_CODE_AIO(LPC_AIO_BATCH_WRITE, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 
 const char *native_aio_provider = "dsn::tools::native_aio_provider";
 DSN_REGISTER_COMPONENT_PROVIDER(native_linux_aio_provider, native_aio_provider);
 
+#ifdef DSN_HAS_IO_URING
+const char *io_uring_aio_provider_name = "dsn::tools::io_uring_aio_provider";
+DSN_REGISTER_COMPONENT_PROVIDER(io_uring_aio_provider, io_uring_aio_provider_name);
+#endif
+
 struct disk_engine_initializer
 {
     disk_engine_initializer() { disk_engine::instance(); }
@@ -161,11 +174,23 @@ aio_task *disk_file::on_write_completed(aio_task *wk, void *ctx, error_code err,
 }
 
 //----------------- disk_engine ------------------------
-disk_engine::disk_engine()
+disk_engine::disk_engine() = default;
+
+aio_provider &disk_engine::get_provider()
 {
-    aio_provider *provider = utils::factory_store<aio_provider>::create(
-        native_aio_provider, dsn::PROVIDER_TYPE_MAIN, this);
-    _provider.reset(provider);
+    std::call_once(_provider_once, [this]() {
+        aio_provider *provider = utils::factory_store<aio_provider>::create(
+            FLAGS_aio_factory_name, dsn::PROVIDER_TYPE_MAIN, this);
+        if (provider == nullptr) {
+            LOG_WARNING("aio provider '{}' is not available, use '{}' instead",
+                        FLAGS_aio_factory_name,
+                        native_aio_provider);
+            provider = utils::factory_store<aio_provider>::create(
+                native_aio_provider, dsn::PROVIDER_TYPE_MAIN, this);
+        }
+        _provider.reset(provider);
+    });
+    return *_provider;
 }
 
 class batch_write_io_task : public aio_task
@@ -213,8 +238,10 @@ void disk_engine::process_write(aio_task *aio, uint64_t sz)
 
     // no batching
     if (dio->buffer_size == sz) {
-        aio->collapse();
-        _provider->submit_aio_task(aio);
+        if (!get_provider().support_vectored_write()) {
+            aio->collapse();
+        }
+        get_provider().submit_aio_task(aio);
     }
 
     // batching
@@ -270,7 +297,7 @@ void disk_engine::complete_io(aio_task *aio, error_code err, uint64_t bytes)
         if (aio->get_aio_context()->type == AIO_Read) {
             auto wk = dfile->on_read_completed(aio, err, (size_t)bytes);
             if (wk) {
-                _provider->submit_aio_task(wk);
+                get_provider().submit_aio_task(wk);
             }
         }
 
@@ -29,6 +29,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <memory>
+#include <mutex>
 
 #include "aio/aio_task.h"
 #include "aio_provider.h"
@@ -80,16 +81,21 @@ class disk_engine : public utils::singleton<disk_engine>
 {
 public:
     void write(aio_task *aio);
-    static aio_provider &provider() { return *instance()._provider.get(); }
+    static aio_provider &provider() { return instance().get_provider(); }
 
 private:
     // the object of disk_engine must be created by `singleton::instance`
     disk_engine();
     ~disk_engine() = default;
 
+    // The provider is created on the first use rather than the construction of disk_engine,
+    // which happens before the configurations are loaded.
+    aio_provider &get_provider();
+
     void process_write(aio_task *wk, uint64_t sz);
     void complete_io(aio_task *aio, error_code err, uint64_t bytes);
 
+    std::once_flag _provider_once;
     std::unique_ptr<aio_provider> _provider;
 
     friend class aio_provider;
@@ -0,0 +1,398 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifdef DSN_HAS_IO_URING
+
+#include "io_uring_aio_provider.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "aio/disk_engine.h"
+#include "rocksdb/env.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "runtime/service_engine.h"
+#include "task/task_worker.h"
+#include "utils/error_code.h"
+#include "utils/flags.h"
+#include "utils/fmt_logging.h"
+#include "utils/latency_tracer.h"
+#include "utils/ports.h"
+#include "utils/safe_strerror_posix.h"
+
+DSN_DECLARE_bool(encrypt_data_at_rest);
+
+DSN_DEFINE_uint32(aio,
+                  io_uring_queue_depth,
+                  1024,
+                  "The number of submission queue entries of the io_uring instance used by "
+                  "io_uring_aio_provider");
+DSN_DEFINE_validator(io_uring_queue_depth, [](uint32_t value) -> bool { return value > 0; });
+
+namespace dsn {
+namespace {
+
+rocksdb::Status
+pread_fully(int fd, uint64_t offset, size_t n, rocksdb::Slice *result, char *scratch)
+{
+    size_t read_bytes = 0;
+    while (read_bytes < n) {
+        ssize_t r = ::pread(fd, scratch + read_bytes, n - read_bytes, offset + read_bytes);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return rocksdb::Status::IOError("pread", utils::safe_strerror(errno));
+        }
+        // Reach the end of the file.
+        if (r == 0) {
+            break;
+        }
+        read_bytes += r;
+    }
+    *result = rocksdb::Slice(scratch, read_bytes);
+    return rocksdb::Status::OK();
+}
+
+// The files opened by io_uring_aio_provider, which expose the raw file descriptors to be
+// submitted to io_uring. The synchronous interfaces are also implemented for the callers
+// which operate the files directly, e.g. the sync read/write of aio_provider.
+class io_uring_read_file : public rocksdb::RandomAccessFile
+{
+public:
+    explicit io_uring_read_file(int fd) : _fd(fd) {}
+    ~io_uring_read_file() override { ::close(_fd); }
+
+    rocksdb::Status
+    Read(uint64_t offset, size_t n, rocksdb::Slice *result, char *scratch) const override
+    {
+        return pread_fully(_fd, offset, n, result, scratch);
+    }
+
+    int fd() const { return _fd; }
+
+private:
+    int _fd;
+};
+
+class io_uring_rw_file : public rocksdb::RandomRWFile
+{
+public:
+    explicit io_uring_rw_file(int fd) : _fd(fd) {}
+    ~io_uring_rw_file() override
+    {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+    }
+
+    rocksdb::Status Write(uint64_t offset, const rocksdb::Slice &data) override
+    {
+        size_t written_bytes = 0;
+        while (written_bytes < data.size()) {
+            ssize_t r = ::pwrite(_fd,
+                                 data.data() + written_bytes,
+                                 data.size() - written_bytes,
+                                 offset + written_bytes);
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return rocksdb::Status::IOError("pwrite", utils::safe_strerror(errno));
+            }
+            written_bytes += r;
+        }
+        return rocksdb::Status::OK();
+    }
+
+    rocksdb::Status
+    Read(uint64_t offset, size_t n, rocksdb::Slice *result, char *scratch) const override
+    {
+        return pread_fully(_fd, offset, n, result, scratch);
+    }
+
+    rocksdb::Status Flush() override { return rocksdb::Status::OK(); }
+
+    rocksdb::Status Sync() override
+    {
+        if (::fdatasync(_fd) != 0) {
+            return rocksdb::Status::IOError("fdatasync", utils::safe_strerror(errno));
+        }
+        return rocksdb::Status::OK();
+    }
+
+    rocksdb::Status Fsync() override
+    {
+        if (::fsync(_fd) != 0) {
+            return rocksdb::Status::IOError("fsync", utils::safe_strerror(errno));
+        }
+        return rocksdb::Status::OK();
+    }
+
+    rocksdb::Status Close() override
+    {
+        const int fd = _fd;
+        _fd = -1;
+        if (fd >= 0 && ::close(fd) != 0) {
+            return rocksdb::Status::IOError("close", utils::safe_strerror(errno));
+        }
+        return rocksdb::Status::OK();
+    }
+
+    int fd() const { return _fd; }
+
+private:
+    int _fd;
+};
+
+} // anonymous namespace
+
+io_uring_aio_provider::io_uring_aio_provider(disk_engine *disk) : native_linux_aio_provider(disk)
+{
+    int ret = io_uring_queue_init(FLAGS_io_uring_queue_depth, &_ring, 0);
+    if (ret < 0) {
+        LOG_WARNING("failed to set up io_uring, all I/Os will fall back to "
+                    "native_linux_aio_provider: {}",
+                    utils::safe_strerror(-ret));
+        return;
+    }
+
+    _ring_ready = true;
+    _reaper = std::thread([this]() {
+        task_worker::set_name("io_uring_reaper");
+        reap_completions();
+    });
+}
+
+io_uring_aio_provider::~io_uring_aio_provider()
+{
+    if (!_ring_ready) {
+        return;
+    }
+
+    // Wake up the reaper thread by a NOP without user data.
+    _stopped.store(true);
+    {
+        std::lock_guard<std::mutex> l(_sq_lock);
+        io_uring_sqe *sqe = io_uring_get_sqe(&_ring);
+        while (sqe == nullptr) {
+            io_uring_submit(&_ring);
+            sqe = io_uring_get_sqe(&_ring);
+        }
+        io_uring_prep_nop(sqe);
+        io_uring_sqe_set_data(sqe, nullptr);
+        io_uring_submit(&_ring);
+    }
+    _reaper.join();
+    io_uring_queue_exit(&_ring);
+}
+
+std::unique_ptr<rocksdb::RandomAccessFile>
+io_uring_aio_provider::open_read_file(const std::string &fname)
+{
+    if (FLAGS_encrypt_data_at_rest || !_ring_ready) {
+        return native_linux_aio_provider::open_read_file(fname);
+    }
+
+    int fd = ::open(fname.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("open read file '{}' failed, err = {}", fname, utils::safe_strerror(errno));
+        return nullptr;
+    }
+    return std::make_unique<io_uring_read_file>(fd);
+}
+
+std::unique_ptr<rocksdb::RandomRWFile>
+io_uring_aio_provider::open_write_file(const std::string &fname)
+{
+    if (FLAGS_encrypt_data_at_rest || !_ring_ready) {
+        return native_linux_aio_provider::open_write_file(fname);
+    }
+
+    // Create the file if it not exists, which is consistent with native_linux_aio_provider.
+    int fd = ::open(fname.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("open write file '{}' failed, err = {}", fname, utils::safe_strerror(errno));
+        return nullptr;
+    }
+    return std::make_unique<io_uring_rw_file>(fd);
+}
+
+/*static*/ int io_uring_aio_provider::get_fd(aio_task *aio)
+{
+    const aio_context *aio_ctx = aio->get_aio_context();
+    if (aio_ctx->type == AIO_Read) {
+        const auto *rf = dynamic_cast<io_uring_read_file *>(aio_ctx->dfile->rfile());
+        return rf == nullptr ? -1 : rf->fd();
+    }
+
+    const auto *wf = dynamic_cast<io_uring_rw_file *>(aio_ctx->dfile->wfile());
+    return wf == nullptr ? -1 : wf->fd();
+}
+
+void io_uring_aio_provider::prepare_sqe(io_uring_sqe *sqe, aio_task *aio, int fd)
+{
+    auto *aio_ctx = static_cast<io_uring_aio_context *>(aio->get_aio_context());
+    if (aio_ctx->type == AIO_Read) {
+        io_uring_prep_read(
+            sqe, fd, aio_ctx->buffer, aio_ctx->buffer_size, aio_ctx->file_offset);
+    } else if (aio_ctx->buffer != nullptr) {
+        io_uring_prep_write(
+            sqe, fd, aio_ctx->buffer, aio_ctx->buffer_size, aio_ctx->file_offset);
+    } else {
+        // The buffers of a batched write are gathered by the kernel directly, unless there
+        // are too many of them to be described by one iovec array.
+        if (aio->_unmerged_write_buffers.size() > IOV_MAX) {
+            aio->collapse();
+            io_uring_prep_write(
+                sqe, fd, aio_ctx->buffer, aio_ctx->buffer_size, aio_ctx->file_offset);
+        } else {
+            aio_ctx->iovs.clear();
+            aio_ctx->iovs.reserve(aio->_unmerged_write_buffers.size());
+            for (const auto &buf : aio->_unmerged_write_buffers) {
+                aio_ctx->iovs.push_back({buf.buffer, static_cast<size_t>(buf.size)});
+            }
+            io_uring_prep_writev(sqe,
+                                 fd,
+                                 aio_ctx->iovs.data(),
+                                 static_cast<unsigned>(aio_ctx->iovs.size()),
+                                 aio_ctx->file_offset);
+        }
+    }
+    io_uring_sqe_set_data(sqe, aio);
+}
+
+void io_uring_aio_provider::submit_aio_task(aio_task *aio_tsk)
+{
+    // For the tests which use simulator, and the files which are not opened by this provider,
+    // fall back to native_linux_aio_provider.
+    const int fd = get_fd(aio_tsk);
+    if (dsn_unlikely(service_engine::instance().is_simulator()) || fd < 0) {
+        native_linux_aio_provider::submit_aio_task(aio_tsk);
+        return;
+    }
+
+    ADD_POINT(aio_tsk->_tracer);
+
+    {
+        std::lock_guard<std::mutex> l(_pending_lock);
+        _pending_tasks.emplace_back(aio_tsk, fd);
+        // The task will be submitted by the thread which is draining.
+        if (_draining) {
+            return;
+        }
+        _draining = true;
+    }
+    drain_pending_tasks();
+}
+
+void io_uring_aio_provider::drain_pending_tasks()
+{
+    std::vector<std::pair<aio_task *, int>> tasks;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> l(_pending_lock);
+            if (_pending_tasks.empty()) {
+                _draining = false;
+                return;
+            }
+            tasks.swap(_pending_tasks);
+        }
+
+        std::lock_guard<std::mutex> l(_sq_lock);
+        for (const auto &[aio_tsk, fd] : tasks) {
+            io_uring_sqe *sqe = io_uring_get_sqe(&_ring);
+            while (sqe == nullptr) {
+                // The submission queue is full, flush the prepared entries to the kernel.
+                submit_sqes();
+                sqe = io_uring_get_sqe(&_ring);
+            }
+            prepare_sqe(sqe, aio_tsk, fd);
+        }
+        submit_sqes();
+        tasks.clear();
+    }
+}
+
+void io_uring_aio_provider::submit_sqes()
+{
+    int ret;
+    while ((ret = io_uring_submit(&_ring)) < 0) {
+        // EAGAIN/EBUSY means the kernel is short of resources or the completion queue is
+        // overflowed, which would be relieved once the reaper consumes the completions.
+        CHECK(ret == -EINTR || ret == -EAGAIN || ret == -EBUSY,
+              "io_uring_submit failed: {}",
+              utils::safe_strerror(-ret));
+        std::this_thread::yield();
+    }
+}
+
+void io_uring_aio_provider::reap_completions()
+{
+    while (true) {
+        io_uring_cqe *cqe = nullptr;
+        int ret = io_uring_wait_cqe(&_ring, &cqe);
+        if (ret == -EINTR) {
+            continue;
+        }
+        CHECK_EQ_MSG(ret, 0, "io_uring_wait_cqe failed: {}", utils::safe_strerror(-ret));
+
+        auto *aio_tsk = static_cast<aio_task *>(io_uring_cqe_get_data(cqe));
+        const int res = cqe->res;
+        io_uring_cqe_seen(&_ring, cqe);
+
+        // The NOP submitted on destruction.
+        if (aio_tsk == nullptr) {
+            if (_stopped.load()) {
+                return;
+            }
+            continue;
+        }
+
+        const aio_context *aio_ctx = aio_tsk->get_aio_context();
+        error_code err = ERR_OK;
+        uint64_t processed_bytes = 0;
+        if (res < 0) {
+            LOG_ERROR("{} file failed, err = {}",
+                      aio_ctx->type == AIO_Read ? "read" : "write",
+                      utils::safe_strerror(-res));
+            err = ERR_FILE_OPERATION_FAILED;
+        } else if (aio_ctx->type == AIO_Read) {
+            if (res == 0) {
+                err = ERR_HANDLE_EOF;
+            }
+            processed_bytes = static_cast<uint64_t>(res);
+        } else if (static_cast<uint64_t>(res) != aio_ctx->buffer_size) {
+            // A short write on a regular file means there is no more space on the disk.
+            LOG_ERROR("write file failed, written size = {} vs {}", res, aio_ctx->buffer_size);
+            err = ERR_FILE_OPERATION_FAILED;
+        } else {
+            processed_bytes = static_cast<uint64_t>(res);
+        }
+
+        ADD_CUSTOM_POINT(aio_tsk->_tracer, "completed");
+
+        complete_io(aio_tsk, err, processed_bytes);
+    }
+}
+
+} // namespace dsn
+
+#endif // DSN_HAS_IO_URING
@@ -0,0 +1,113 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#ifdef DSN_HAS_IO_URING
+
+#include <liburing.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "aio/aio_task.h"
+#include "native_linux_aio_provider.h"
+
+namespace rocksdb {
+class RandomAccessFile;
+class RandomRWFile;
+} // namespace rocksdb
+
+namespace dsn {
+class disk_engine;
+
+// The aio_context used by io_uring_aio_provider, which holds the iovecs of a vectored
+// write until the corresponding completion is reaped.
+class io_uring_aio_context : public aio_context
+{
+public:
+    std::vector<iovec> iovs;
+};
+
+// An aio provider based on io_uring, which submits the reads and writes to the kernel
+// and reaps their completions on a dedicated thread, rather than occupying a worker of
+// the thread pool for each in-flight I/O as native_linux_aio_provider does.
+//
+// The batched writes of contiguous log blocks (see disk_write_queue) are submitted as a
+// single IORING_OP_WRITEV, so the buffers are not required to be collapsed into one.
+//
+// Files opened by the encrypted env (i.e. FLAGS_encrypt_data_at_rest is enabled) have no
+// raw file descriptor, thus I/Os on them fall back to native_linux_aio_provider. So do all
+// I/Os if the io_uring instance failed to be set up, e.g. it's not supported by the kernel.
+class io_uring_aio_provider : public native_linux_aio_provider
+{
+public:
+    explicit io_uring_aio_provider(disk_engine *disk);
+    ~io_uring_aio_provider() override;
+
+    std::unique_ptr<rocksdb::RandomAccessFile> open_read_file(const std::string &fname) override;
+    std::unique_ptr<rocksdb::RandomRWFile> open_write_file(const std::string &fname) override;
+
+    void submit_aio_task(aio_task *aio) override;
+    aio_context *prepare_aio_context(aio_task *tsk) override { return new io_uring_aio_context; }
+    bool support_vectored_write() const override { return true; }
+
+private:
+    // Returns the raw file descriptor of the file to be operated by `aio`, or -1 if the file
+    // is not opened by this provider.
+    static int get_fd(aio_task *aio);
+
+    // Fill the SQE to describe the I/O of `aio`.
+    void prepare_sqe(io_uring_sqe *sqe, aio_task *aio, int fd);
+
+    // Fill the SQEs of all the pending aio tasks and submit them to the kernel by a single
+    // io_uring_submit, until there are no more pending ones.
+    void drain_pending_tasks();
+
+    // Submit the prepared SQEs to the kernel, retrying on the transient failures.
+    void submit_sqes();
+
+    // Run by the reaper thread to wait for and dispatch the completions.
+    void reap_completions();
+
+    io_uring _ring;
+    bool _ring_ready{false};
+
+    // The aio tasks submitted from multiple threads are queued into `_pending_tasks`, and
+    // drained by the thread which finds no one else is draining, i.e. `_draining` is false.
+    // Thus the tasks submitted while a drain is in progress are submitted to the kernel
+    // together by one system call.
+    std::mutex _pending_lock;
+    std::vector<std::pair<aio_task *, int>> _pending_tasks;
+    bool _draining{false};
+
+    // Protect the submission queue, which is operated by the draining thread and on
+    // destruction.
+    std::mutex _sq_lock;
+
+    std::atomic<bool> _stopped{false};
+    std::thread _reaper;
+};
+
+} // namespace dsn
+
+#endif // DSN_HAS_IO_URING
@@ -26,6 +26,9 @@
 
 #include "native_linux_aio_provider.h"
 
+#include <string>
+#include <vector>
+
 #include "aio/aio_provider.h"
 #include "aio/disk_engine.h"
 #include "rocksdb/env.h"
@@ -34,10 +37,20 @@
 #include "runtime/service_engine.h"
 #include "task/async_calls.h"
 #include "utils/env.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/latency_tracer.h"
 #include "utils/ports.h"
 
+DSN_DEFINE_uint32(aio,
+                  vectored_write_direct_min_bytes,
+                  32 * 1024,
+                  "For the vectored writes (e.g. the batched writes of the log blocks), the "
+                  "buffers whose sizes are not less than this are written directly without being "
+                  "copied, while the smaller adjacent ones are gathered into a staging buffer to "
+                  "be written together, to avoid issuing too many small writes");
+DSN_TAG_VARIABLE(vectored_write_direct_min_bytes, FT_MUTABLE);
+
 namespace dsn {
 
 native_linux_aio_provider::native_linux_aio_provider(disk_engine *disk) : aio_provider(disk) {}
@@ -124,6 +137,53 @@ error_code native_linux_aio_provider::write(const aio_context &aio_ctx,
     return ERR_OK;
 }
 
+error_code native_linux_aio_provider::write_vector(aio_task *aio_tsk,
+                                                   /*out*/ uint64_t *processed_bytes)
+{
+    const aio_context *aio_ctx = aio_tsk->get_aio_context();
+    auto *wfile = aio_ctx->dfile->wfile();
+
+    uint64_t offset = aio_ctx->file_offset;
+    std::string staging;
+    const auto flush_staging = [&]() -> rocksdb::Status {
+        if (staging.empty()) {
+            return rocksdb::Status::OK();
+        }
+        auto s = wfile->Write(offset, rocksdb::Slice(staging));
+        offset += staging.size();
+        staging.clear();
+        return s;
+    };
+
+    for (const auto &buf : aio_tsk->_unmerged_write_buffers) {
+        rocksdb::Status s;
+        if (buf.size < FLAGS_vectored_write_direct_min_bytes) {
+            staging.append(static_cast<const char *>(buf.buffer), buf.size);
+        } else {
+            s = flush_staging();
+            if (s.ok()) {
+                s = wfile->Write(offset,
+                                 rocksdb::Slice(static_cast<const char *>(buf.buffer), buf.size));
+                offset += buf.size;
+            }
+        }
+        if (!s.ok()) {
+            LOG_ERROR("write file failed, err = {}", s.ToString());
+            return ERR_FILE_OPERATION_FAILED;
+        }
+    }
+
+    auto s = flush_staging();
+    if (!s.ok()) {
+        LOG_ERROR("write file failed, err = {}", s.ToString());
+        return ERR_FILE_OPERATION_FAILED;
+    }
+
+    CHECK_EQ(offset - aio_ctx->file_offset, aio_ctx->buffer_size);
+    *processed_bytes = aio_ctx->buffer_size;
+    return ERR_OK;
+}
+
 error_code native_linux_aio_provider::read(const aio_context &aio_ctx,
                                            /*out*/ uint64_t *processed_bytes)
 {
@@ -166,7 +226,13 @@ error_code native_linux_aio_provider::aio_internal(aio_task *aio_tsk)
         err = read(*aio_ctx, &processed_bytes);
         break;
     case AIO_Write:
-        err = write(*aio_ctx, &processed_bytes);
+        // The buffers of a vectored write are not collapsed by disk_engine, see
+        // support_vectored_write().
+        if (aio_ctx->buffer == nullptr && !aio_tsk->_unmerged_write_buffers.empty()) {
+            err = write_vector(aio_tsk, &processed_bytes);
+        } else {
+            err = write(*aio_ctx, &processed_bytes);
+        }
         break;
     default:
         return err;
@@ -58,9 +58,14 @@ public:
 
     void submit_aio_task(aio_task *aio) override;
     aio_context *prepare_aio_context(aio_task *tsk) override { return new aio_context; }
+    bool support_vectored_write() const override { return true; }
 
 private:
     error_code aio_internal(aio_task *aio);
+
+    // Write the `_unmerged_write_buffers` of `aio_tsk` in order, without collapsing them into
+    // a single buffer first.
+    error_code write_vector(aio_task *aio_tsk, /*out*/ uint64_t *processed_bytes);
 };
 
 } // namespace dsn
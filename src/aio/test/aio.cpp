@@ -65,6 +65,8 @@ DSN_DEFINE_uint32(
     10,
     "The operation count of per read or write batch operation for the aio_test.basic");
 
+DSN_DECLARE_uint32(vectored_write_direct_min_bytes);
+
 using namespace ::dsn;
 
 DEFINE_THREAD_POOL_CODE(THREAD_POOL_TEST_SERVER)
@@ -293,6 +295,56 @@ TEST_P(aio_test, basic)
     NO_FATALS(verify_data());
 }
 
+TEST_P(aio_test, vector_write_mixed_buffers)
+{
+    // Mix the small buffers which would be staged with the large ones which would be written
+    // directly.
+    const size_t kMinDirectBytes = FLAGS_vectored_write_direct_min_bytes;
+    const std::vector<std::string> kBuffers = {std::string(16, 'a'),
+                                               std::string(7, 'b'),
+                                               std::string(kMinDirectBytes, 'c'),
+                                               std::string(3, 'd'),
+                                               std::string(128 * 1024, 'e'),
+                                               std::string(256 * 1024, 'f'),
+                                               std::string(1, 'g')};
+    std::vector<dsn_file_buffer_t> buffers;
+    std::string expected;
+    for (const auto &buf : kBuffers) {
+        buffers.push_back({const_cast<char *>(buf.data()), static_cast<int>(buf.size())});
+        expected += buf;
+    }
+
+    auto wfile = file::open(kTestFileName, file::FileOpenType::kWriteOnly);
+    ASSERT_NE(wfile, nullptr);
+    const auto check_callback = [](::dsn::error_code err, size_t) { CHECK_EQ(ERR_OK, err); };
+    auto t = ::dsn::file::write_vector(wfile,
+                                       buffers.data(),
+                                       static_cast<int>(buffers.size()),
+                                       0,
+                                       LPC_AIO_TEST,
+                                       nullptr,
+                                       check_callback);
+    t->wait();
+    ASSERT_EQ(expected.size(), t->get_transferred_size());
+    ASSERT_EQ(ERR_OK, file::flush(wfile));
+    ASSERT_EQ(ERR_OK, file::close(wfile));
+
+    auto rfile = file::open(kTestFileName, file::FileOpenType::kReadOnly);
+    ASSERT_NE(rfile, nullptr);
+    std::string actual(expected.size(), '\0');
+    t = ::dsn::file::read(rfile,
+                          const_cast<char *>(actual.data()),
+                          static_cast<int>(actual.size()),
+                          0,
+                          LPC_AIO_TEST,
+                          nullptr,
+                          check_callback);
+    t->wait();
+    ASSERT_EQ(expected.size(), t->get_transferred_size());
+    ASSERT_EQ(expected, actual);
+    ASSERT_EQ(ERR_OK, file::close(rfile));
+}
+
 TEST_P(aio_test, aio_share)
 {
     auto wfile = file::open(kTestFileName, file::FileOpenType::kWriteOnly);
@@ -24,4 +24,4 @@
 # THE SOFTWARE.
 
 
-rm -rf data dsn_aio_test.xml copy_dest.txt
+rm -rf data dsn_aio_test.xml dsn_aio_test_io_uring.xml copy_dest.txt
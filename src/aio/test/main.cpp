@@ -22,7 +22,12 @@
 GTEST_API_ int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
-    dsn_run_config("config.ini", false);
+    // The aio providers are tested by running with different config files.
+    if (argc < 2) {
+        dsn_run_config("config.ini", false);
+    } else {
+        dsn_run_config(argv[1], false);
+    }
     int g_test_ret = RUN_ALL_TESTS();
 #ifndef ENABLE_GCOV
     dsn_exit(g_test_ret);
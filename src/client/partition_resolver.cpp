@@ -26,6 +26,9 @@
 
 #include "client/partition_resolver.h"
 
+#include <algorithm>
+#include <atomic>
+
 // IWYU pragma: no_include <type_traits>
 
 #include "partition_resolver_manager.h"
@@ -33,11 +36,113 @@
 #include "runtime/api_task.h"
 #include "rpc/dns_resolver.h"
 #include "task/task_spec.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/threadpool_code.h"
+#include "utils/zlocks.h"
+
+METRIC_DEFINE_counter(server,
+                      hedged_read_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of hedged read requests sent to another replica since the "
+                      "read is not replied in time");
+
+METRIC_DEFINE_counter(server,
+                      won_hedged_read_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of hedged read requests replied before the original requests");
+
+METRIC_DEFINE_counter(server,
+                      throttled_hedged_read_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of hedged read requests not sent since the ratio of the hedged "
+                      "requests exceeds hedged_read_max_ratio_percent");
+
+DSN_DEFINE_uint32(pegasus.client,
+                  hedged_read_delay_percentile,
+                  95,
+                  "The hedged request of a read is sent once the read has not been replied "
+                  "within this percentile of the recent latencies of the target replica");
+DSN_TAG_VARIABLE(hedged_read_delay_percentile, FT_MUTABLE);
+DSN_DEFINE_validator(hedged_read_delay_percentile,
+                     [](uint32_t value) -> bool { return value > 0 && value <= 100; });
+
+DSN_DEFINE_uint32(pegasus.client,
+                  hedged_read_min_delay_ms,
+                  2,
+                  "The min delay in milliseconds before the hedged request of a read is sent");
+DSN_TAG_VARIABLE(hedged_read_min_delay_ms, FT_MUTABLE);
+
+DSN_DEFINE_uint32(pegasus.client,
+                  hedged_read_max_ratio_percent,
+                  5,
+                  "The max ratio in percent of the hedged requests to the reads allowed to be "
+                  "hedged, which bounds the extra load brought by the hedged requests");
+DSN_TAG_VARIABLE(hedged_read_max_ratio_percent, FT_MUTABLE);
 
 namespace dsn {
 namespace replication {
+
+// The state shared by a read and its hedged request, the one replied first wins.
+struct partition_resolver::hedge_context : public ref_counter
+{
+    hedge_context(rpc_response_handler &&cb, uint64_t deadline)
+        : callback(std::move(cb)), deadline_ms(deadline)
+    {
+    }
+
+    bool replied() const { return _replied.load(std::memory_order_acquire); }
+
+    // Reply the read, returns false if it has been replied.
+    bool reply(error_code err, message_ex *req, message_ex *resp)
+    {
+        if (_replied.exchange(true, std::memory_order_acq_rel)) {
+            return false;
+        }
+
+        // The hedged request is not needed any more.
+        reset_timer();
+        if (callback) {
+            callback(err, req, resp);
+        }
+        return true;
+    }
+
+    void set_timer(task_ptr &&timer)
+    {
+        zauto_lock l(_lock);
+        _timer = std::move(timer);
+    }
+
+    void reset_timer()
+    {
+        zauto_lock l(_lock);
+        if (_timer != nullptr) {
+            _timer->cancel(false);
+            _timer = nullptr;
+        }
+    }
+
+    const rpc_response_handler callback;
+    const uint64_t deadline_ms;
+
+private:
+    std::atomic<bool> _replied{false};
+    zlock _lock;
+    // The timer to send the hedged request, which is reset once fired or the read is replied to
+    // break the reference cycle.
+    task_ptr _timer;
+};
+
+partition_resolver::partition_resolver(host_port meta_server, const char *app_name)
+    : _app_name(app_name),
+      _meta_server(meta_server),
+      METRIC_VAR_INIT_server(hedged_read_requests),
+      METRIC_VAR_INIT_server(won_hedged_read_requests),
+      METRIC_VAR_INIT_server(throttled_hedged_read_requests)
+{
+}
+
 /*static*/
 partition_resolver_ptr partition_resolver::get_resolver(const char *cluster_name,
                                                         const std::vector<host_port> &meta_list,
@@ -52,6 +157,7 @@ int partition_resolver::get_partition_index(int partition_count, uint64_t partit
 }
 
 DEFINE_TASK_CODE(LPC_RPC_DELAY_CALL, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE(LPC_HEDGED_READ, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
 
 static inline bool error_retry(error_code err)
 {
@@ -60,20 +166,64 @@ static inline bool error_retry(error_code err)
             err != ERR_DISK_INSUFFICIENT);
 }
 
-void partition_resolver::call_task(const rpc_response_task_ptr &t)
+void partition_resolver::call_task(const rpc_response_task_ptr &t, bool hedged)
 {
     auto &hdr = *(t->get_request()->header);
-    uint64_t deadline_ms = dsn_now_ms() + hdr.client.timeout_ms;
+    const uint64_t start_us = dsn_now_us();
+    uint64_t deadline_ms = start_us / 1000 + hdr.client.timeout_ms;
+    const bool latency_tracked = hedged || hdr.context.u.max_read_staleness > 0;
 
     rpc_response_handler old_callback;
     t->fetch_current_handler(old_callback);
-    auto new_callback = [this, deadline_ms, oc = std::move(old_callback)](
+
+    // The read is replied through the hedge context, by either the original request or the
+    // hedged one.
+    ref_ptr<hedge_context> hedge;
+    if (hedged) {
+        add_hedge_budget();
+        hedge = new hedge_context(std::move(old_callback), deadline_ms);
+        old_callback = [hedge](dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) {
+            hedge->reply(err, req, resp);
+        };
+    }
+
+    auto new_callback = [this,
+                         start_us,
+                         deadline_ms,
+                         latency_tracked,
+                         hedge,
+                         oc = std::move(old_callback)](
                             dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) {
-        if (req->header->gpid.value() != 0 && err != ERR_OK && error_retry(err)) {
-            on_access_failure(req->header->gpid.get_partition_index(), err);
+        bool secondary_read_failed = false;
+        if (err == ERR_OK) {
+            if (latency_tracked) {
+                _replica_selector.record(req->server_host_port, dsn_now_us() - start_us);
+            }
+        } else if (req->max_read_staleness() > 0 && req->is_backup_request()) {
+            // The secondary might be too stale or unavailable, penalize it and fall back to the
+            // primary.
+            _replica_selector.record(
+                req->server_host_port,
+                static_cast<uint64_t>(std::max(req->header->client.timeout_ms, 1)) * 1000);
+            req->header->context.u.is_backup_request = false;
+            req->header->context.u.max_read_staleness = 0;
+            secondary_read_failed = true;
+        }
+
+        // The hedged request has won, no need to retry.
+        if (hedge != nullptr && hedge->replied()) {
+            return;
+        }
+
+        if (req->header->gpid.value() != 0 && err != ERR_OK &&
+            (secondary_read_failed || error_retry(err))) {
+            // The failure of a secondary doesn't mean the route cache is out of date.
+            if (!secondary_read_failed) {
+                on_access_failure(req->header->gpid.get_partition_index(), err);
+            }
             // still got time, retry
             uint64_t nms = dsn_now_ms();
-            uint64_t gap = 8 << req->send_retry_count;
+            uint64_t gap = secondary_read_failed ? 0 : 8 << req->send_retry_count;
             if (gap > 1000)
                 gap = 1000;
             if (nms + gap < deadline_ms) {
@@ -114,7 +264,7 @@ void partition_resolver::call_task(const rpc_response_task_ptr &t)
 
     resolve(
         hdr.client.partition_hash,
-        [t](resolve_result &&result) mutable {
+        [this, t, hedge](resolve_result &&result) mutable {
             if (result.err != ERR_OK) {
                 t->enqueue(result.err, nullptr);
                 return;
@@ -130,9 +280,153 @@ void partition_resolver::call_task(const rpc_response_task_ptr &t)
                 }
                 hdr.gpid = result.pid;
             }
-            dsn_rpc_call(dns_resolver::instance().resolve_address(result.hp), t.get());
+
+            auto target = result.hp;
+            if (hdr.context.u.max_read_staleness > 0) {
+                target = select_read_replica(result.pid.get_partition_index(), target);
+                // The reads served by the secondaries are sent as the backup requests.
+                hdr.context.u.is_backup_request = (target != result.hp);
+            }
+            if (hedge != nullptr) {
+                hedge_read(t, hedge, result.hp, target);
+            }
+            dsn_rpc_call(dns_resolver::instance().resolve_address(target), t.get());
         },
         hdr.client.timeout_ms);
 }
+
+host_port partition_resolver::select_read_replica(int partition_index,
+                                                  const host_port &primary) const
+{
+    std::vector<host_port> candidates;
+    if (!get_secondaries(partition_index, candidates) || candidates.empty()) {
+        return primary;
+    }
+    candidates.push_back(primary);
+    return _replica_selector.select(candidates);
+}
+
+uint64_t partition_resolver::hedge_delay_ms(const host_port &target) const
+{
+    const auto percentile_us =
+        _replica_selector.latency_percentile_us(target, FLAGS_hedged_read_delay_percentile);
+    if (percentile_us == 0) {
+        return 0;
+    }
+
+    return std::max<uint64_t>((percentile_us + 999) / 1000, FLAGS_hedged_read_min_delay_ms);
+}
+
+void partition_resolver::hedge_read(const rpc_response_task_ptr &task,
+                                    const ref_ptr<hedge_context> &context,
+                                    const host_port &primary,
+                                    const host_port &target)
+{
+    // Not hedge the reads until the latencies of the target are known.
+    const auto delay_ms = hedge_delay_ms(target);
+    if (delay_ms == 0) {
+        return;
+    }
+
+    if (dsn_now_ms() + delay_ms >= context->deadline_ms) {
+        return;
+    }
+
+    partition_resolver_ptr r(this);
+    context->set_timer(tasking::enqueue(
+        LPC_HEDGED_READ,
+        nullptr,
+        [r, task, context, primary, target]() {
+            context->reset_timer();
+            r->send_hedged_read(task, context, primary, target);
+        },
+        0,
+        std::chrono::milliseconds(delay_ms)));
+}
+
+void partition_resolver::send_hedged_read(const rpc_response_task_ptr &task,
+                                          const ref_ptr<hedge_context> &context,
+                                          const host_port &primary,
+                                          const host_port &target)
+{
+    if (context->replied()) {
+        return;
+    }
+
+    const auto now_ms = dsn_now_ms();
+    if (now_ms >= context->deadline_ms) {
+        return;
+    }
+
+    auto *request = task->get_request();
+    std::vector<host_port> candidates;
+    get_secondaries(request->header->gpid.get_partition_index(), candidates);
+    candidates.push_back(primary);
+    candidates.erase(std::remove(candidates.begin(), candidates.end(), target), candidates.end());
+    if (candidates.empty()) {
+        return;
+    }
+
+    if (!consume_hedge_budget()) {
+        METRIC_VAR_INCREMENT(throttled_hedged_read_requests);
+        return;
+    }
+
+    const auto &hedge_target = _replica_selector.select(candidates);
+    auto *msg = request->copy_and_prepare_send(true);
+    // The hedged requests served by the secondaries are sent as the backup requests, with the
+    // same staleness bound as the original request.
+    msg->header->context.u.is_backup_request = (hedge_target != primary);
+    msg->header->client.timeout_ms = static_cast<int>(context->deadline_ms - now_ms);
+
+    partition_resolver_ptr r(this);
+    const auto start_us = dsn_now_us();
+    auto hedge_task = rpc::create_rpc_response_task(
+        msg,
+        nullptr,
+        rpc_response_handler([this, r, context, start_us](
+                                 dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) {
+            // Leave the failures to the original request, which would be retried if necessary.
+            if (err != ERR_OK) {
+                return;
+            }
+
+            _replica_selector.record(req->server_host_port, dsn_now_us() - start_us);
+            if (context->reply(err, req, resp)) {
+                METRIC_VAR_INCREMENT(won_hedged_read_requests);
+            }
+        }),
+        request->header->client.thread_hash);
+
+    METRIC_VAR_INCREMENT(hedged_read_requests);
+    dsn_rpc_call(dns_resolver::instance().resolve_address(hedge_target), hedge_task.get());
+}
+
+void partition_resolver::add_hedge_budget()
+{
+    // At most kMaxHedgeBurst hedged requests could be sent in a burst.
+    static constexpr int64_t kMaxHedgeBurst = 10;
+    static constexpr int64_t kMaxHedgeBudget = kMaxHedgeBurst * 100;
+
+    auto budget = _hedge_budget.load(std::memory_order_relaxed);
+    while (budget < kMaxHedgeBudget &&
+           !_hedge_budget.compare_exchange_weak(
+               budget,
+               std::min<int64_t>(budget + FLAGS_hedged_read_max_ratio_percent, kMaxHedgeBudget),
+               std::memory_order_relaxed)) {
+    }
+}
+
+bool partition_resolver::consume_hedge_budget()
+{
+    auto budget = _hedge_budget.load(std::memory_order_relaxed);
+    while (budget >= 100) {
+        if (_hedge_budget.compare_exchange_weak(budget, budget - 100, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace replication
 } // namespace dsn
@@ -27,12 +27,14 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "client/replica_selector.h"
 #include "common/gpid.h"
 #include "rpc/rpc_host_port.h"
 #include "rpc/rpc_message.h"
@@ -42,12 +44,23 @@
 #include "task/task_code.h"
 #include "utils/autoref_ptr.h"
 #include "utils/error_code.h"
+#include "utils/metrics.h"
 
 namespace dsn {
 class task_tracker;
 
 namespace replication {
 
+// The options to route a read to the replicas.
+struct read_options
+{
+    // The max number of decrees the secondary which serves the read could lag behind the
+    // primary, 0 means the read is served by the primary.
+    uint16_t max_read_staleness{0};
+    // Whether to send a hedged request to another replica if the read is not replied in time.
+    bool hedged{false};
+};
+
 class partition_resolver : public ref_counter
 {
 public:
@@ -73,14 +86,16 @@ public:
                                        TCallback &&callback,
                                        std::chrono::milliseconds timeout,
                                        uint64_t partition_hash,
-                                       int reply_hash = 0)
+                                       int reply_hash = 0,
+                                       const read_options &options = read_options())
     {
         dsn::message_ex *msg = dsn::message_ex::create_request(
             code, static_cast<int>(timeout.count()), 0, partition_hash);
+        msg->header->context.u.max_read_staleness = options.max_read_staleness;
         marshall(msg, std::forward<TReq>(request));
         dsn::rpc_response_task_ptr response_task = rpc::create_rpc_response_task(
             msg, tracker, std::forward<TCallback>(callback), reply_hash);
-        call_task(response_task);
+        call_task(response_task, options.hedged);
         return response_task;
     }
 
@@ -89,19 +104,32 @@ public:
     // if got reply or error, call the callback.
     // parameters like request data, timeout, callback handler are all wrapped
     // into "task", you may want to refer to dsn::rpc_response_task for details.
-    void call_task(const dsn::rpc_response_task_ptr &task);
+    //
+    // If max_read_staleness is set in the header of the request, the read might be served by
+    // a secondary selected by the latencies observed, and falls back to the primary once the
+    // secondary fails, e.g. it lags behind the primary more than max_read_staleness decrees.
+    //
+    // If `hedged` is set and the read is not replied within the percentile of the latencies of
+    // the target replica, a hedged request is sent to another replica, and the reply which
+    // arrives first is taken.
+    void call_task(const dsn::rpc_response_task_ptr &task, bool hedged = false);
 
     std::string get_app_name() const { return _app_name; }
 
     const dsn::host_port &get_meta_server() const { return _meta_server; }
 
+    // Get the partition count of the app, or -1 if it's still unknown, e.g. the partition
+    // configuration has not been queried from the meta server.
+    virtual int get_partition_count() const = 0;
+
     const char *log_prefix() const { return _app_name.c_str(); }
 
+    METRIC_DEFINE_VALUE(hedged_read_requests, int64_t)
+    METRIC_DEFINE_VALUE(won_hedged_read_requests, int64_t)
+    METRIC_DEFINE_VALUE(throttled_hedged_read_requests, int64_t)
+
 protected:
-    partition_resolver(host_port meta_server, const char *app_name)
-        : _app_name(app_name), _meta_server(meta_server)
-    {
-    }
+    partition_resolver(host_port meta_server, const char *app_name);
 
     virtual ~partition_resolver() {}
 
@@ -141,9 +169,48 @@ protected:
      */
     virtual void on_access_failure(int partition_index, error_code err) = 0;
 
+    // Get the secondaries of the partition from the local route cache, returns false if the
+    // partition configuration is not cached.
+    virtual bool get_secondaries(int partition_index,
+                                 /*out*/ std::vector<host_port> &secondaries) const = 0;
+
+    // Select the replica to serve the read among the primary and the secondaries.
+    host_port select_read_replica(int partition_index, const host_port &primary) const;
+
     std::string _cluster_name;
     std::string _app_name;
     host_port _meta_server;
+    replica_selector _replica_selector;
+
+private:
+    friend class partition_resolver_test;
+
+    struct hedge_context;
+
+    // Get the delay in milliseconds before the hedged request of the read sent to `target` is
+    // sent, which follows the percentile of the recent latencies of the target, 0 if they are
+    // not known yet.
+    uint64_t hedge_delay_ms(const host_port &target) const;
+
+    // Schedule the hedged request for the read sent to `target`.
+    void hedge_read(const dsn::rpc_response_task_ptr &task,
+                    const ref_ptr<hedge_context> &context,
+                    const host_port &primary,
+                    const host_port &target);
+    void send_hedged_read(const dsn::rpc_response_task_ptr &task,
+                          const ref_ptr<hedge_context> &context,
+                          const host_port &primary,
+                          const host_port &target);
+
+    // Each read allowed to be hedged adds FLAGS_hedged_read_max_ratio_percent to the budget,
+    // and each hedged request consumes 100 of it.
+    void add_hedge_budget();
+    bool consume_hedge_budget();
+    std::atomic<int64_t> _hedge_budget{0};
+
+    METRIC_VAR_DECLARE_counter(hedged_read_requests);
+    METRIC_VAR_DECLARE_counter(won_hedged_read_requests);
+    METRIC_VAR_DECLARE_counter(throttled_hedged_read_requests);
 };
 
 typedef ref_ptr<partition_resolver> partition_resolver_ptr;
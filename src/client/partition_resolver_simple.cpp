@@ -113,6 +113,18 @@ void partition_resolver_simple::on_access_failure(int partition_index, error_cod
     }
 }
 
+bool partition_resolver_simple::get_secondaries(int partition_index,
+                                                std::vector<host_port> &secondaries) const
+{
+    zauto_read_lock l(_config_lock);
+    const auto it = _config_cache.find(partition_index);
+    if (it == _config_cache.end() || !_app_is_stateful) {
+        return false;
+    }
+    secondaries = it->second->pc.hp_secondaries;
+    return true;
+}
+
 partition_resolver_simple::~partition_resolver_simple()
 {
     _tracker.cancel_outstanding_tasks();
@@ -31,6 +31,7 @@
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "client/partition_resolver.h"
 #include "common/serialization_helper/dsn.layer2_types.h"
@@ -59,7 +60,10 @@ public:
 
     virtual void on_access_failure(int partition_index, error_code err) override;
 
-    int get_partition_count() const { return _app_partition_count; }
+    bool get_secondaries(int partition_index,
+                         /*out*/ std::vector<host_port> &secondaries) const override;
+
+    int get_partition_count() const override { return _app_partition_count; }
 
 private:
     struct partition_info
@@ -0,0 +1,102 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "client/replica_selector.h"
+
+#include <algorithm>
+
+#include "utils/fmt_logging.h"
+#include "utils/rand.h"
+
+namespace dsn {
+namespace replication {
+
+void replica_selector::record(const host_port &hp, uint64_t latency_us)
+{
+    // Treat 0 as 1 since 0 means no latency observed.
+    latency_us = std::max<uint64_t>(latency_us, 1);
+
+    zauto_write_lock l(_lock);
+    auto &latencies = _latencies[hp];
+    latencies.samples_us[latencies.next_sample] = latency_us;
+    latencies.next_sample = (latencies.next_sample + 1) % kLatencySampleCount;
+    latencies.sample_count = std::min(latencies.sample_count + 1, kLatencySampleCount);
+
+    auto &average = latencies.average_us;
+    if (average == 0) {
+        average = latency_us;
+        return;
+    }
+    average = std::max<uint64_t>(
+        (average * (kLatencyWeightDivisor - 1) + latency_us) / kLatencyWeightDivisor, 1);
+}
+
+const host_port &replica_selector::select(const std::vector<host_port> &candidates) const
+{
+    CHECK(!candidates.empty(), "");
+    if (candidates.size() == 1) {
+        return candidates.front();
+    }
+
+    const auto count = static_cast<uint32_t>(candidates.size());
+    const auto first = rand::next_u32(count);
+    if (rand::next_u32(kRandomSelectionPeriod) == 0) {
+        return candidates[first];
+    }
+
+    // Pick another candidate distinct from the first one.
+    auto second = rand::next_u32(count - 1);
+    if (second >= first) {
+        ++second;
+    }
+
+    return average_latency_us(candidates[second]) < average_latency_us(candidates[first])
+               ? candidates[second]
+               : candidates[first];
+}
+
+uint64_t replica_selector::average_latency_us(const host_port &hp) const
+{
+    zauto_read_lock l(_lock);
+    const auto iter = _latencies.find(hp);
+    return iter == _latencies.end() ? 0 : iter->second.average_us;
+}
+
+uint64_t replica_selector::latency_percentile_us(const host_port &hp, uint32_t percentile) const
+{
+    CHECK_LE(percentile, 100);
+
+    std::array<uint64_t, kLatencySampleCount> samples_us;
+    uint32_t sample_count = 0;
+    {
+        zauto_read_lock l(_lock);
+        const auto iter = _latencies.find(hp);
+        if (iter == _latencies.end() || iter->second.sample_count < kMinLatencySampleCount) {
+            return 0;
+        }
+        sample_count = iter->second.sample_count;
+        std::copy_n(iter->second.samples_us.begin(), sample_count, samples_us.begin());
+    }
+
+    const auto nth =
+        samples_us.begin() + std::min(sample_count * percentile / 100, sample_count - 1);
+    std::nth_element(samples_us.begin(), nth, samples_us.begin() + sample_count);
+    return *nth;
+}
+
+} // namespace replication
+} // namespace dsn
@@ -0,0 +1,82 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "rpc/rpc_host_port.h"
+#include "utils/zlocks.h"
+
+namespace dsn {
+namespace replication {
+
+// Select the replica to serve a read among the primary and the secondaries by the "power of
+// two choices" on the latencies observed by this client: two distinct candidates are picked at
+// random and the one with the lower moving average of latencies wins, so that the reads are
+// spread across all the replicas while the slow ones are avoided.
+//
+// The nodes without any latency observed are preferred, and a small fraction of the reads are
+// sent to a random candidate, thus the latencies of the nodes which always lose are refreshed
+// from time to time.
+class replica_selector
+{
+public:
+    // Record the latency of a read served by the node.
+    void record(const host_port &hp, uint64_t latency_us);
+
+    // Select a node among the candidates, which must not be empty.
+    const host_port &select(const std::vector<host_port> &candidates) const;
+
+    // Get the moving average of the latencies of the reads served by the node, 0 if no read has
+    // been observed.
+    uint64_t average_latency_us(const host_port &hp) const;
+
+    // Get the percentile of the latencies of the recent reads served by the node, 0 if the reads
+    // observed are not enough to tell.
+    uint64_t latency_percentile_us(const host_port &hp, uint32_t percentile) const;
+
+private:
+    // The weight of a new latency in the moving average is 1 / kLatencyWeightDivisor.
+    static constexpr uint64_t kLatencyWeightDivisor = 8;
+
+    // One of kRandomSelectionPeriod selections is random.
+    static constexpr uint32_t kRandomSelectionPeriod = 32;
+
+    // The percentiles are calculated over the latest kLatencySampleCount latencies, and only if
+    // there are at least kMinLatencySampleCount ones.
+    static constexpr uint32_t kLatencySampleCount = 128;
+    static constexpr uint32_t kMinLatencySampleCount = 16;
+
+    struct node_latencies
+    {
+        uint64_t average_us{0};
+        // The ring buffer of the latest latencies.
+        std::array<uint64_t, kLatencySampleCount> samples_us{};
+        uint32_t sample_count{0};
+        uint32_t next_sample{0};
+    };
+
+    mutable zrwlock_nr _lock;
+    std::unordered_map<host_port, node_latencies> _latencies;
+};
+
+} // namespace replication
+} // namespace dsn
@@ -0,0 +1,275 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "client/partition_resolver.h"
+#include "common/gpid.h"
+#include "common/replication.codes.h"
+#include "gtest/gtest.h"
+#include "rpc/rpc_host_port.h"
+#include "rpc/rpc_message.h"
+#include "runtime/api_layer1.h"
+#include "task/async_calls.h"
+#include "task/task.h"
+#include "task/task_code.h"
+#include "task/task_spec.h"
+#include "utils/autoref_ptr.h"
+#include "utils/error_code.h"
+#include "utils/flags.h"
+#include "utils/threadpool_code.h"
+
+DSN_DECLARE_uint32(hedged_read_delay_percentile);
+DSN_DECLARE_uint32(hedged_read_min_delay_ms);
+DSN_DECLARE_uint32(hedged_read_max_ratio_percent);
+
+namespace dsn {
+namespace replication {
+
+DEFINE_TASK_CODE(LPC_PARTITION_RESOLVER_TEST, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+// The resolver with the fixed secondaries, which never resolves any request.
+class mock_partition_resolver : public partition_resolver
+{
+public:
+    explicit mock_partition_resolver(std::vector<host_port> secondaries)
+        : partition_resolver(host_port("localhost", 34601), "test_app"),
+          _secondaries(std::move(secondaries))
+    {
+    }
+
+    int get_partition_count() const override { return 1; }
+
+protected:
+    void resolve(uint64_t partition_hash,
+                 std::function<void(resolve_result &&)> &&callback,
+                 int timeout_ms) override
+    {
+    }
+
+    void on_access_failure(int partition_index, error_code err) override {}
+
+    bool get_secondaries(int partition_index,
+                         std::vector<host_port> &secondaries) const override
+    {
+        secondaries = _secondaries;
+        return true;
+    }
+
+private:
+    const std::vector<host_port> _secondaries;
+};
+
+class partition_resolver_test : public testing::Test
+{
+public:
+    partition_resolver_test()
+        : _reserved_delay_percentile(FLAGS_hedged_read_delay_percentile),
+          _reserved_min_delay_ms(FLAGS_hedged_read_min_delay_ms),
+          _reserved_max_ratio_percent(FLAGS_hedged_read_max_ratio_percent)
+    {
+        FLAGS_hedged_read_delay_percentile = 95;
+        FLAGS_hedged_read_min_delay_ms = 2;
+        FLAGS_hedged_read_max_ratio_percent = 5;
+    }
+
+    ~partition_resolver_test() override
+    {
+        FLAGS_hedged_read_delay_percentile = _reserved_delay_percentile;
+        FLAGS_hedged_read_min_delay_ms = _reserved_min_delay_ms;
+        FLAGS_hedged_read_max_ratio_percent = _reserved_max_ratio_percent;
+    }
+
+    void reset_resolver(std::vector<host_port> secondaries)
+    {
+        _resolver = new mock_partition_resolver(std::move(secondaries));
+    }
+
+    // Record the latencies of `from` * `unit_us`, ..., `to` * `unit_us`.
+    void record_latencies(const host_port &hp, uint64_t unit_us, uint64_t from, uint64_t to)
+    {
+        for (auto i = from; i <= to; ++i) {
+            _resolver->_replica_selector.record(hp, unit_us * i);
+        }
+    }
+
+    uint64_t hedge_delay_ms(const host_port &target) const
+    {
+        return _resolver->hedge_delay_ms(target);
+    }
+
+    void add_hedge_budget(int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            _resolver->add_hedge_budget();
+        }
+    }
+
+    bool consume_hedge_budget() { return _resolver->consume_hedge_budget(); }
+
+    int64_t hedge_budget() const { return _resolver->_hedge_budget.load(); }
+
+    // Create the read whose reply is counted, and send the hedged request of it, which is
+    // supposed to be skipped.
+    void send_hedged_read(const host_port &target, bool replied)
+    {
+        auto *msg = message_ex::create_request(RPC_TEST, 10000, 0, 0);
+        msg->header->gpid = gpid(1, 0);
+        auto task = rpc::create_rpc_response_task(msg, nullptr, rpc_response_handler());
+
+        ref_ptr<partition_resolver::hedge_context> context(new partition_resolver::hedge_context(
+            [this](error_code, message_ex *, message_ex *) { ++_reply_count; },
+            dsn_now_ms() + 10000));
+        if (replied) {
+            ASSERT_TRUE(context->reply(ERR_OK, msg, nullptr));
+        }
+
+        _resolver->send_hedged_read(task, context, _primary, target);
+    }
+
+    void test_first_reply_wins()
+    {
+        error_code replied_err = ERR_UNKNOWN;
+        ref_ptr<partition_resolver::hedge_context> context(new partition_resolver::hedge_context(
+            [this, &replied_err](error_code err, message_ex *, message_ex *) {
+                ++_reply_count;
+                replied_err = err;
+            },
+            dsn_now_ms() + 10000));
+
+        // The timer to send the hedged request.
+        task_ptr timer = tasking::enqueue(
+            LPC_PARTITION_RESOLVER_TEST, nullptr, []() {}, 0, std::chrono::hours(1));
+        context->set_timer(task_ptr(timer));
+        ASSERT_FALSE(context->replied());
+
+        // The first reply is taken, and the pending hedged request is cancelled.
+        ASSERT_TRUE(context->reply(ERR_OK, nullptr, nullptr));
+        ASSERT_TRUE(context->replied());
+        ASSERT_EQ(1, _reply_count);
+        ASSERT_EQ(ERR_OK, replied_err);
+        ASSERT_EQ(TASK_STATE_CANCELLED, timer->state());
+
+        // The late reply is dropped.
+        ASSERT_FALSE(context->reply(ERR_TIMEOUT, nullptr, nullptr));
+        ASSERT_EQ(1, _reply_count);
+        ASSERT_EQ(ERR_OK, replied_err);
+    }
+
+    const host_port _primary{"localhost", 34801};
+    const host_port _secondary{"localhost", 34802};
+    ref_ptr<mock_partition_resolver> _resolver;
+    int _reply_count{0};
+
+private:
+    const uint32_t _reserved_delay_percentile;
+    const uint32_t _reserved_min_delay_ms;
+    const uint32_t _reserved_max_ratio_percent;
+};
+
+TEST_F(partition_resolver_test, hedge_delay)
+{
+    reset_resolver({_secondary});
+
+    // Not hedge the reads until enough latencies of the target are observed.
+    ASSERT_EQ(0U, hedge_delay_ms(_primary));
+    record_latencies(_primary, 1000, 1, 15);
+    ASSERT_EQ(0U, hedge_delay_ms(_primary));
+
+    // 1ms, 2ms, ..., 100ms.
+    record_latencies(_primary, 1000, 16, 100);
+    ASSERT_EQ(96U, hedge_delay_ms(_primary));
+
+    // The delay follows the percentile.
+    FLAGS_hedged_read_delay_percentile = 50;
+    ASSERT_EQ(51U, hedge_delay_ms(_primary));
+
+    // The latencies of each target are tracked separately: 1us, 2us, ..., 100us, whose
+    // percentile is rounded up to 1ms, and then bounded by the min delay.
+    ASSERT_EQ(0U, hedge_delay_ms(_secondary));
+    record_latencies(_secondary, 1, 1, 100);
+    ASSERT_EQ(2U, hedge_delay_ms(_secondary));
+    FLAGS_hedged_read_min_delay_ms = 0;
+    ASSERT_EQ(1U, hedge_delay_ms(_secondary));
+}
+
+TEST_F(partition_resolver_test, hedge_budget)
+{
+    reset_resolver({_secondary});
+    ASSERT_FALSE(consume_hedge_budget());
+
+    // Each read adds 5 to the budget, and each hedged request consumes 100 of it, thus at most
+    // one of 20 reads could be hedged.
+    add_hedge_budget(19);
+    ASSERT_FALSE(consume_hedge_budget());
+    add_hedge_budget(1);
+    ASSERT_TRUE(consume_hedge_budget());
+    ASSERT_FALSE(consume_hedge_budget());
+    ASSERT_EQ(0, hedge_budget());
+
+    // The budget is capped to allow at most 10 hedged requests in a burst.
+    add_hedge_budget(1000);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(consume_hedge_budget());
+    }
+    ASSERT_FALSE(consume_hedge_budget());
+
+    // The hedged request is throttled once the budget is used up.
+    const auto hedged_count = METRIC_VALUE(*_resolver, hedged_read_requests);
+    const auto throttled_count = METRIC_VALUE(*_resolver, throttled_hedged_read_requests);
+    send_hedged_read(_primary, false);
+    ASSERT_EQ(hedged_count, METRIC_VALUE(*_resolver, hedged_read_requests));
+    ASSERT_EQ(throttled_count + 1, METRIC_VALUE(*_resolver, throttled_hedged_read_requests));
+}
+
+TEST_F(partition_resolver_test, first_reply_wins) { test_first_reply_wins(); }
+
+TEST_F(partition_resolver_test, no_hedge_after_replied)
+{
+    reset_resolver({_secondary});
+    add_hedge_budget(20);
+
+    // The hedged request is not sent once the read has been replied, and the budget is kept.
+    const auto hedged_count = METRIC_VALUE(*_resolver, hedged_read_requests);
+    send_hedged_read(_primary, true);
+    ASSERT_EQ(1, _reply_count);
+    ASSERT_EQ(hedged_count, METRIC_VALUE(*_resolver, hedged_read_requests));
+    ASSERT_EQ(100, hedge_budget());
+}
+
+TEST_F(partition_resolver_test, no_hedge_without_secondaries)
+{
+    reset_resolver({});
+    add_hedge_budget(20);
+
+    // There is no other replica than the target to send the hedged request to, thus the read
+    // is only served by the primary, and the budget is kept.
+    const auto hedged_count = METRIC_VALUE(*_resolver, hedged_read_requests);
+    const auto throttled_count = METRIC_VALUE(*_resolver, throttled_hedged_read_requests);
+    send_hedged_read(_primary, false);
+    ASSERT_EQ(0, _reply_count);
+    ASSERT_EQ(hedged_count, METRIC_VALUE(*_resolver, hedged_read_requests));
+    ASSERT_EQ(throttled_count, METRIC_VALUE(*_resolver, throttled_hedged_read_requests));
+    ASSERT_EQ(100, hedge_budget());
+}
+
+} // namespace replication
+} // namespace dsn
@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "client/replica_selector.h"
+#include "gtest/gtest.h"
+#include "rpc/rpc_host_port.h"
+
+namespace dsn {
+namespace replication {
+
+TEST(replica_selector_test, average_latency)
+{
+    replica_selector selector;
+    const host_port node("localhost", 34801);
+    ASSERT_EQ(0u, selector.average_latency_us(node));
+
+    selector.record(node, 100);
+    ASSERT_EQ(100u, selector.average_latency_us(node));
+
+    selector.record(node, 900);
+    ASSERT_EQ(200u, selector.average_latency_us(node));
+
+    // 0 is reserved for the nodes without any latency observed.
+    const host_port other("localhost", 34802);
+    selector.record(other, 0);
+    ASSERT_EQ(1u, selector.average_latency_us(other));
+}
+
+TEST(replica_selector_test, latency_percentile)
+{
+    replica_selector selector;
+    const host_port node("localhost", 34801);
+
+    // Not enough latencies observed.
+    for (uint64_t latency_us = 1; latency_us < 16; ++latency_us) {
+        selector.record(node, latency_us);
+    }
+    ASSERT_EQ(0u, selector.latency_percentile_us(node, 95));
+
+    for (uint64_t latency_us = 16; latency_us <= 100; ++latency_us) {
+        selector.record(node, latency_us);
+    }
+    ASSERT_EQ(51u, selector.latency_percentile_us(node, 50));
+    ASSERT_EQ(96u, selector.latency_percentile_us(node, 95));
+    ASSERT_EQ(100u, selector.latency_percentile_us(node, 100));
+
+    // Only the recent latencies are taken into account.
+    for (int i = 0; i < 128; ++i) {
+        selector.record(node, 1000);
+    }
+    ASSERT_EQ(1000u, selector.latency_percentile_us(node, 50));
+}
+
+TEST(replica_selector_test, select)
+{
+    replica_selector selector;
+    const host_port fast("localhost", 34801);
+    const host_port slow("localhost", 34802);
+    const host_port unknown("localhost", 34803);
+
+    ASSERT_EQ(fast, selector.select({fast}));
+
+    selector.record(fast, 100);
+    selector.record(slow, 10000);
+
+    // The slow node is selected only by the random selections.
+    const int kSelectCount = 10000;
+    std::unordered_map<host_port, int> selected_counts;
+    for (int i = 0; i < kSelectCount; ++i) {
+        ++selected_counts[selector.select({fast, slow})];
+    }
+    ASSERT_GT(selected_counts[fast], kSelectCount * 9 / 10);
+    ASSERT_LT(selected_counts[slow], kSelectCount / 10);
+
+    // The node without any latency observed is preferred.
+    selected_counts.clear();
+    for (int i = 0; i < kSelectCount; ++i) {
+        ++selected_counts[selector.select({fast, slow, unknown})];
+    }
+    ASSERT_GT(selected_counts[unknown], kSelectCount / 2);
+    ASSERT_GT(selected_counts[fast], selected_counts[slow]);
+}
+
+} // namespace replication
+} // namespace dsn
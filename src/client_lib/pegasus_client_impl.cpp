@@ -20,13 +20,18 @@
 #include <fmt/core.h>
 #include <pegasus/error.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "client/partition_resolver.h"
 #include "common/common.h"
 #include "common/replication_other_types.h"
 #include "common/serialization_helper/dsn.layer2_types.h"
@@ -36,6 +41,7 @@
 #include "pegasus_utils.h"
 #include "rpc/dns_resolver.h"
 #include "rpc/group_host_port.h"
+#include "rpc/rpc_message.h"
 #include "rpc/serialization.h"
 #include "rrdb/rrdb.client.h"
 #include "task/async_calls.h"
@@ -288,6 +294,7 @@ void pegasus_client_impl::async_get(const std::string &hash_key,
             info.app_id = response.app_id;
             info.partition_index = response.partition_index;
             info.server = response.server;
+            info.read_staleness = resp->header->context.u.read_staleness;
         }
         int ret =
             get_client_error(err == ERR_OK ? get_rocksdb_server_error(response.error) : int(err));
@@ -374,6 +381,7 @@ void pegasus_client_impl::async_multi_get(const std::string &hash_key,
             info.app_id = response.app_id;
             info.partition_index = response.partition_index;
             info.server = response.server;
+            info.read_staleness = resp->header->context.u.read_staleness;
             for (auto &kv : response.kvs)
                 values.emplace(std::string(kv.key.data(), kv.key.length()),
                                std::string(kv.value.data(), kv.value.length()));
@@ -473,6 +481,7 @@ void pegasus_client_impl::async_multi_get(const std::string &hash_key,
             info.app_id = response.app_id;
             info.partition_index = response.partition_index;
             info.server = response.server;
+            info.read_staleness = resp->header->context.u.read_staleness;
             for (auto &kv : response.kvs)
                 values.emplace(std::string(kv.key.data(), kv.key.length()),
                                std::string(kv.value.data(), kv.value.length()));
@@ -551,6 +560,7 @@ void pegasus_client_impl::async_multi_get_sortkeys(const std::string &hash_key,
             info.app_id = response.app_id;
             info.partition_index = response.partition_index;
             info.server = response.server;
+            info.read_staleness = resp->header->context.u.read_staleness;
             for (auto &kv : response.kvs)
                 sort_keys.insert(std::string(kv.key.data(), kv.key.length()));
         }
@@ -564,6 +574,151 @@ void pegasus_client_impl::async_multi_get_sortkeys(const std::string &hash_key,
                        partition_hash);
 }
 
+int pegasus_client_impl::batch_get(const std::vector<std::pair<std::string, std::string>> &keys,
+                                   std::vector<batch_get_result> &results,
+                                   int timeout_milliseconds)
+{
+    ::dsn::utils::notify_event op_completed;
+    int ret = -1;
+    auto callback = [&](int err, std::vector<batch_get_result> &&_results) {
+        ret = err;
+        results = std::move(_results);
+        op_completed.notify();
+    };
+    async_batch_get(keys, std::move(callback), timeout_milliseconds);
+    op_completed.wait();
+    return ret;
+}
+
+void pegasus_client_impl::async_batch_get(
+    const std::vector<std::pair<std::string, std::string>> &keys,
+    async_batch_get_callback_t &&callback,
+    int timeout_milliseconds)
+{
+    // check params
+    for (const auto &key : keys) {
+        if (key.first.size() >= UINT16_MAX) {
+            LOG_ERROR("invalid hash key: hash key length should be less than UINT16_MAX, but {}",
+                      key.first.size());
+            if (callback != nullptr)
+                callback(PERR_INVALID_HASH_KEY, std::vector<batch_get_result>());
+            return;
+        }
+    }
+    if (keys.empty()) {
+        if (callback != nullptr)
+            callback(PERR_OK, std::vector<batch_get_result>());
+        return;
+    }
+
+    // The results are merged into the context shared by the requests of all the partitions,
+    // each of which only fills the results of its own keys.
+    struct batch_get_context
+    {
+        std::vector<std::pair<std::string, std::string>> keys;
+        std::vector<batch_get_result> results;
+        std::atomic<size_t> pending_count;
+        std::atomic<int> error{PERR_OK};
+        async_batch_get_callback_t user_callback;
+    };
+    auto context = std::make_shared<batch_get_context>();
+    context->keys = keys;
+    context->results.resize(keys.size());
+    context->user_callback = std::move(callback);
+
+    // Group the keys by partition, thus only one request is sent to each partition. Before the
+    // partition count is known, the keys are grouped by the partition hash, which still routes
+    // each request to the right partition.
+    struct partition_batch
+    {
+        uint64_t partition_hash;
+        ::dsn::apps::batch_get_request request;
+        // The indexes of the keys of the request in `keys`.
+        std::vector<size_t> key_indexes;
+    };
+    const int partition_count = _client->get_partition_count();
+    std::unordered_map<uint64_t, partition_batch> batches;
+    for (size_t i = 0; i < context->keys.size(); ++i) {
+        const auto &[hash_key, sort_key] = context->keys[i];
+        ::dsn::apps::full_key key;
+        key.hash_key = ::dsn::blob(hash_key.data(), 0, hash_key.size());
+        key.sort_key = ::dsn::blob(sort_key.data(), 0, sort_key.size());
+        ::dsn::blob tmp_key;
+        pegasus_generate_key(tmp_key, key.hash_key, key.sort_key);
+        const auto partition_hash = pegasus_key_hash(tmp_key);
+        const uint64_t group =
+            partition_count > 0 ? dsn::replication::partition_resolver::get_partition_index(
+                                      partition_count, partition_hash)
+                                : partition_hash;
+
+        auto &batch = batches[group];
+        if (batch.key_indexes.empty()) {
+            batch.partition_hash = partition_hash;
+        }
+        batch.request.keys.emplace_back(std::move(key));
+        batch.key_indexes.push_back(i);
+    }
+    context->pending_count.store(batches.size());
+
+    // All the requests are issued at once, and the ones to the same replica server share the
+    // connection.
+    for (auto &[_, batch] : batches) {
+        auto new_callback = [context, key_indexes = std::move(batch.key_indexes)](
+                                ::dsn::error_code err,
+                                dsn::message_ex *req,
+                                dsn::message_ex *resp) {
+            internal_info info;
+            ::dsn::apps::batch_get_response response;
+            if (err == ::dsn::ERR_OK) {
+                ::dsn::unmarshall(resp, response);
+                info.app_id = response.app_id;
+                info.partition_index = response.partition_index;
+                info.server = response.server;
+                info.read_staleness = resp->header->context.u.read_staleness;
+            }
+            int ret = get_client_error(err == ERR_OK ? get_rocksdb_server_error(response.error)
+                                                     : int(err));
+
+            if (ret == PERR_OK) {
+                // The found keys are returned in the same order as they are requested.
+                size_t j = 0;
+                for (const auto index : key_indexes) {
+                    const auto &[hash_key, sort_key] = context->keys[index];
+                    auto &result = context->results[index];
+                    result.info = info;
+                    if (j < response.data.size() &&
+                        response.data[j].hash_key.to_string_view() == hash_key &&
+                        response.data[j].sort_key.to_string_view() == sort_key) {
+                        result.error = PERR_OK;
+                        result.value.assign(response.data[j].value.data(),
+                                            response.data[j].value.length());
+                        ++j;
+                    } else {
+                        result.error = PERR_NOT_FOUND;
+                    }
+                }
+            } else {
+                for (const auto index : key_indexes) {
+                    auto &result = context->results[index];
+                    result.error = ret;
+                    result.info = info;
+                }
+                int expected = PERR_OK;
+                context->error.compare_exchange_strong(expected, ret);
+            }
+
+            if (context->pending_count.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+                context->user_callback != nullptr) {
+                context->user_callback(context->error.load(), std::move(context->results));
+            }
+        };
+        _client->batch_get(batch.request,
+                           std::move(new_callback),
+                           std::chrono::milliseconds(timeout_milliseconds),
+                           batch.partition_hash);
+    }
+}
+
 int pegasus_client_impl::exist(const std::string &hash_key,
                                const std::string &sort_key,
                                int timeout_milliseconds,
@@ -763,6 +918,31 @@ int pegasus_client_impl::incr(const std::string &hash_key,
                               int timeout_milliseconds,
                               int ttl_seconds,
                               internal_info *info)
+{
+    incr_options options;
+    options.ttl_seconds = ttl_seconds;
+    return incr(hash_key, sort_key, increment, options, new_value, timeout_milliseconds, info);
+}
+
+void pegasus_client_impl::async_incr(const std::string &hash_key,
+                                     const std::string &sort_key,
+                                     int64_t increment,
+                                     async_incr_callback_t &&callback,
+                                     int timeout_milliseconds,
+                                     int ttl_seconds)
+{
+    incr_options options;
+    options.ttl_seconds = ttl_seconds;
+    async_incr(hash_key, sort_key, increment, options, std::move(callback), timeout_milliseconds);
+}
+
+int pegasus_client_impl::incr(const std::string &hash_key,
+                              const std::string &sort_key,
+                              int64_t increment,
+                              const incr_options &options,
+                              int64_t &new_value,
+                              int timeout_milliseconds,
+                              internal_info *info)
 {
     ::dsn::utils::notify_event op_completed;
     int ret = -1;
@@ -773,8 +953,7 @@ int pegasus_client_impl::incr(const std::string &hash_key,
             (*info) = std::move(_info);
         op_completed.notify();
     };
-    async_incr(
-        hash_key, sort_key, increment, std::move(callback), timeout_milliseconds, ttl_seconds);
+    async_incr(hash_key, sort_key, increment, options, std::move(callback), timeout_milliseconds);
     op_completed.wait();
     return ret;
 }
@@ -782,9 +961,9 @@ int pegasus_client_impl::incr(const std::string &hash_key,
 void pegasus_client_impl::async_incr(const std::string &hash_key,
                                      const std::string &sort_key,
                                      int64_t increment,
+                                     const incr_options &options,
                                      async_incr_callback_t &&callback,
-                                     int timeout_milliseconds,
-                                     int ttl_seconds)
+                                     int timeout_milliseconds)
 {
     // check params
     if (hash_key.size() >= UINT16_MAX) {
@@ -794,8 +973,8 @@ void pegasus_client_impl::async_incr(const std::string &hash_key,
             callback(PERR_INVALID_HASH_KEY, 0, internal_info());
         return;
     }
-    if (ttl_seconds < -1) {
-        LOG_ERROR("invalid ttl seconds: should be no less than -1, but {}", ttl_seconds);
+    if (options.ttl_seconds < -1) {
+        LOG_ERROR("invalid ttl seconds: should be no less than -1, but {}", options.ttl_seconds);
         if (callback != nullptr)
             callback(PERR_INVALID_ARGUMENT, 0, internal_info());
         return;
@@ -804,10 +983,15 @@ void pegasus_client_impl::async_incr(const std::string &hash_key,
     ::dsn::apps::incr_request req;
     pegasus_generate_key(req.key, hash_key, sort_key);
     req.increment = increment;
-    if (ttl_seconds <= 0)
-        req.expire_ts_seconds = ttl_seconds;
+    if (options.ttl_seconds <= 0)
+        req.expire_ts_seconds = options.ttl_seconds;
     else
-        req.expire_ts_seconds = ttl_seconds + utils::epoch_now();
+        req.expire_ts_seconds = options.ttl_seconds + utils::epoch_now();
+    // Only set while the new value is not needed, to keep the request unchanged for the servers
+    // that do not know the field.
+    if (!options.return_new_value) {
+        req.__set_return_new_value(false);
+    }
     auto partition_hash = pegasus_key_hash(req.key);
 
     auto new_callback = [user_callback = std::move(callback)](
@@ -1275,6 +1459,16 @@ void pegasus_client_impl::async_duplicate(dsn::apps::duplicate_rpc rpc,
     _client->duplicate(rpc, std::move(callback), tracker);
 }
 
+void pegasus_client_impl::set_max_read_staleness(uint16_t max_read_staleness)
+{
+    _client->set_max_read_staleness(max_read_staleness);
+}
+
+void pegasus_client_impl::set_hedged_read_enabled(bool enabled)
+{
+    _client->set_hedged_read_enabled(enabled);
+}
+
 const char *pegasus_client_impl::get_error_string(int error_code) const
 {
     auto it = _client_error_to_string.find(error_code);
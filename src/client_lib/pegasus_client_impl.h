@@ -29,15 +29,16 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "rpc/rpc_host_port.h"
 #include "rrdb/rrdb_types.h"
 #include "utils/blob.h"
+#include "utils/error_code.h"
 #include "utils/zlocks.h"
 
 namespace dsn {
-class error_code;
 class message_ex;
 class task_tracker;
 } // namespace dsn
@@ -139,6 +140,14 @@ public:
                                           int max_fetch_size = 1000000,
                                           int timeout_milliseconds = 5000) override;
 
+    virtual int batch_get(const std::vector<std::pair<std::string, std::string>> &keys,
+                          std::vector<batch_get_result> &results,
+                          int timeout_milliseconds = 5000) override;
+
+    virtual void async_batch_get(const std::vector<std::pair<std::string, std::string>> &keys,
+                                 async_batch_get_callback_t &&callback = nullptr,
+                                 int timeout_milliseconds = 5000) override;
+
     virtual int exist(const std::string &hashkey,
                       const std::string &sortkey,
                       int timeout_milliseconds = 5000,
@@ -185,6 +194,21 @@ public:
                             int timeout_milliseconds = 5000,
                             int ttl_seconds = 0) override;
 
+    virtual int incr(const std::string &hashkey,
+                     const std::string &sortkey,
+                     int64_t increment,
+                     const incr_options &options,
+                     int64_t &new_value,
+                     int timeout_milliseconds = 5000,
+                     internal_info *info = nullptr) override;
+
+    virtual void async_incr(const std::string &hashkey,
+                            const std::string &sortkey,
+                            int64_t increment,
+                            const incr_options &options,
+                            async_incr_callback_t &&callback = nullptr,
+                            int timeout_milliseconds = 5000) override;
+
     virtual int check_and_set(const std::string &hash_key,
                               const std::string &check_sort_key,
                               cas_check_type check_type,
@@ -259,6 +283,10 @@ public:
                          std::function<void(dsn::error_code)> &&callback,
                          dsn::task_tracker *tracker);
 
+    void set_max_read_staleness(uint16_t max_read_staleness) override;
+
+    void set_hedged_read_enabled(bool enabled) override;
+
     virtual const char *get_error_string(int error_code) const override;
 
     static void init_error();
@@ -273,6 +301,8 @@ public:
 
         int next(int32_t &count, internal_info *info = nullptr) override;
 
+        int next(scan_aggregation_result &result, internal_info *info = nullptr) override;
+
         void async_next(async_scan_next_callback_t &&) override;
 
         bool safe_destructible() const override;
@@ -322,11 +352,40 @@ public:
         bool _full_scan;
         async_scan_type _type;
 
+        // The next batch fetched in advance while the current one is consumed, which is shared
+        // with the RPC callback since the scanner might be destructed before it's received.
+        struct prefetch_state
+        {
+            ::dsn::zlock lock;
+            bool in_flight{false};
+            bool received{false};
+            // The scanner is waiting for the batch, thus it's alive until the batch is handled.
+            bool waited{false};
+            // The scanner has been destructed.
+            bool abandoned{false};
+            ::dsn::error_code err;
+            ::dsn::apps::scan_response response;
+        };
+        std::shared_ptr<prefetch_state> _prefetch;
+
+        // The aggregated result of the current batch, valid only if _aggregation_received.
+        ::dsn::apps::scan_aggregation_result _aggregation;
+        bool _aggregation_received;
+
         void _async_next_internal();
         void _start_scan();
         void _next_batch();
+        void _prefetch_next_batch();
+        // Returns false if the prefetched batch is not received yet, then it would be handled
+        // once received.
+        bool _take_prefetched_batch(::dsn::error_code &err, ::dsn::apps::scan_response &response);
         void _on_scan_response(::dsn::error_code, dsn::message_ex *, dsn::message_ex *);
+        void _handle_scan_response(::dsn::error_code err, ::dsn::apps::scan_response &&response);
+        void _apply_scan_response(::dsn::apps::scan_response &&response);
         void _split_reset();
+        // Move out the aggregated result of the current batch, returns PERR_NOT_SUPPORTED if
+        // there's none.
+        int _take_aggregation_result(scan_aggregation_result &result);
 
     private:
         static const char _holder[];
@@ -352,6 +411,11 @@ private:
             return _p->next(count, info);
         }
 
+        int next(scan_aggregation_result &result, internal_info *info = nullptr) override
+        {
+            return _p->next(result, info);
+        }
+
         int next(std::string &hashkey,
                  std::string &sortkey,
                  std::string &value,
@@ -18,6 +18,7 @@
  */
 
 #include <stdint.h>
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <list>
@@ -57,6 +58,8 @@ namespace client {
 static const int SCAN_CONTEXT_ID_VALID_MIN = 0;
 static const int SCAN_CONTEXT_ID_COMPLETED = -1;
 static const int SCAN_CONTEXT_ID_NOT_EXIST = -2;
+// Only used by the client: the next batch is being or has been fetched in advance.
+static const int SCAN_CONTEXT_ID_PREFETCHING = -3;
 
 pegasus_client_impl::pegasus_scanner_impl::pegasus_scanner_impl(::dsn::apps::rrdb_client *client,
                                                                 std::vector<uint64_t> &&hash,
@@ -88,8 +91,18 @@ pegasus_client_impl::pegasus_scanner_impl::pegasus_scanner_impl(::dsn::apps::rrd
       _rpc_started(false),
       _validate_partition_hash(validate_partition_hash),
       _full_scan(full_scan),
-      _type(async_scan_type::NORMAL)
+      _type(async_scan_type::NORMAL),
+      _aggregation_received(false)
 {
+    // Like counting, only the aggregated result of each batch is returned.
+    if (_options.aggregation.enabled) {
+        _options.only_return_count = true;
+    }
+
+    // Counting only needs one batch for each partition.
+    if (_options.prefetch && !_options.only_return_count) {
+        _prefetch = std::make_shared<prefetch_state>();
+    }
 }
 
 int pegasus_client_impl::pegasus_scanner_impl::next(int32_t &count, internal_info *info)
@@ -115,6 +128,33 @@ int pegasus_client_impl::pegasus_scanner_impl::next(int32_t &count, internal_inf
     return ret;
 }
 
+int pegasus_client_impl::pegasus_scanner_impl::next(scan_aggregation_result &result,
+                                                    internal_info *info)
+{
+    if (!_options.aggregation.enabled) {
+        return PERR_INVALID_ARGUMENT;
+    }
+
+    ::dsn::utils::notify_event op_completed;
+    int ret = -1;
+    auto callback = [&](int err,
+                        std::string &&hash,
+                        std::string &&sort,
+                        std::string &&val,
+                        internal_info &&ii,
+                        uint32_t expire_ts_seconds,
+                        int32_t kv_count) {
+        ret = err == PERR_OK ? _take_aggregation_result(result) : err;
+        if (info != nullptr) {
+            *info = std::move(ii);
+        }
+        op_completed.notify();
+    };
+    async_next(std::move(callback));
+    op_completed.wait();
+    return ret;
+}
+
 int pegasus_client_impl::pegasus_scanner_impl::next(std::string &hashkey,
                                                     std::string &sortkey,
                                                     std::string &value,
@@ -208,6 +248,21 @@ void pegasus_client_impl::pegasus_scanner_impl::_async_next_internal()
                     _splits_hash.pop_back();
                     _split_reset();
                 }
+            } else if (_context == SCAN_CONTEXT_ID_PREFETCHING) {
+                ::dsn::error_code err;
+                ::dsn::apps::scan_response response;
+                if (!_take_prefetched_batch(err, response)) {
+                    // would be continued once the batch is received
+                    _lock.unlock();
+                    return;
+                }
+                if (err == ERR_OK && response.error == 0) {
+                    _apply_scan_response(std::move(response));
+                    continue;
+                }
+                _lock.unlock();
+                _handle_scan_response(err, std::move(response));
+                return;
             } else if (_context == SCAN_CONTEXT_ID_NOT_EXIST) {
                 // no valid context_id found
                 _lock.unlock();
@@ -275,6 +330,70 @@ void pegasus_client_impl::pegasus_scanner_impl::_next_batch()
         _hash);
 }
 
+void pegasus_client_impl::pegasus_scanner_impl::_prefetch_next_batch()
+{
+    ::dsn::apps::scan_request req;
+    req.context_id = _context;
+    _context = SCAN_CONTEXT_ID_PREFETCHING;
+
+    {
+        ::dsn::zauto_lock l(_prefetch->lock);
+        CHECK(!_prefetch->in_flight && !_prefetch->received, "");
+        _prefetch->in_flight = true;
+    }
+    _client->scan(
+        req,
+        [this, state = _prefetch, client = _client, hash = _hash](
+            ::dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) mutable {
+            ::dsn::apps::scan_response response;
+            if (err == ERR_OK) {
+                ::dsn::unmarshall(resp, response);
+            }
+
+            {
+                ::dsn::zauto_lock l(state->lock);
+                state->in_flight = false;
+                if (state->abandoned) {
+                    // The scanner is destructed, thus the context is useless any more.
+                    if (err == ERR_OK && response.error == 0 &&
+                        response.context_id >= SCAN_CONTEXT_ID_VALID_MIN) {
+                        client->clear_scanner(response.context_id, hash);
+                    }
+                    return;
+                }
+                if (!state->waited) {
+                    // Kept until the current batch is consumed.
+                    state->received = true;
+                    state->err = err;
+                    state->response = std::move(response);
+                    return;
+                }
+                state->waited = false;
+            }
+
+            // ATTENTION: the scanner is alive since there are callbacks waiting for the batch.
+            _handle_scan_response(err, std::move(response));
+        },
+        std::chrono::milliseconds(_options.timeout_ms),
+        _hash);
+}
+
+bool pegasus_client_impl::pegasus_scanner_impl::_take_prefetched_batch(
+    ::dsn::error_code &err, ::dsn::apps::scan_response &response)
+{
+    ::dsn::zauto_lock l(_prefetch->lock);
+    if (!_prefetch->received) {
+        CHECK(_prefetch->in_flight, "");
+        _prefetch->waited = true;
+        return false;
+    }
+
+    _prefetch->received = false;
+    err = _prefetch->err;
+    response = std::move(_prefetch->response);
+    return true;
+}
+
 void pegasus_client_impl::pegasus_scanner_impl::_start_scan()
 {
     ::dsn::apps::get_scanner_request req;
@@ -299,6 +418,26 @@ void pegasus_client_impl::pegasus_scanner_impl::_start_scan()
     req.__set_return_expire_ts(_options.return_expire_ts);
     req.__set_full_scan(_full_scan);
     req.__set_only_return_count(_options.only_return_count);
+    if (_options.batch_bytes > 0) {
+        req.__set_batch_bytes(_options.batch_bytes);
+    }
+    if (_options.aggregation.enabled) {
+        ::dsn::apps::scan_aggregation_request aggregation;
+        aggregation.numeric_value_stats = _options.aggregation.numeric_value_stats;
+        aggregation.value_size_buckets = _options.aggregation.value_size_buckets;
+        aggregation.top_k_by_value_size = _options.aggregation.top_k_by_value_size;
+        req.__set_aggregation(std::move(aggregation));
+    }
+    if (_options.geo_filter.enabled) {
+        ::dsn::apps::scan_geo_filter geo_filter;
+        geo_filter.lat_degrees = _options.geo_filter.lat_degrees;
+        geo_filter.lng_degrees = _options.geo_filter.lng_degrees;
+        geo_filter.radius_m = _options.geo_filter.radius_m;
+        geo_filter.latitude_index = _options.geo_filter.latitude_index;
+        geo_filter.longitude_index = _options.geo_filter.longitude_index;
+        geo_filter.top_k_nearest = _options.geo_filter.top_k_nearest;
+        req.__set_geo_filter(std::move(geo_filter));
+    }
 
     CHECK(!_rpc_started, "");
     _rpc_started = true;
@@ -320,26 +459,26 @@ void pegasus_client_impl::pegasus_scanner_impl::_on_scan_response(::dsn::error_c
     ::dsn::apps::scan_response response;
     if (err == ERR_OK) {
         ::dsn::unmarshall(resp, response);
-        _info.app_id = response.app_id;
-        _info.partition_index = response.partition_index;
-        _info.decree = -1;
-        _info.server = response.server;
+    }
+    _handle_scan_response(err, std::move(response));
+}
 
+void pegasus_client_impl::pegasus_scanner_impl::_handle_scan_response(
+    ::dsn::error_code err, ::dsn::apps::scan_response &&response)
+{
+    if (err == ERR_OK) {
         if (response.error == 0) {
             _lock.lock();
-            _kvs = std::move(response.kvs);
-            _p = -1;
-            _context = response.context_id;
-            // If `kv_count` exists in response, then:
-            //   1) server side supports only counting size, and
-            //   2) `kvs` in response must be empty
-            if (response.__isset.kv_count) {
-                _type = async_scan_type::COUNT_ONLY;
-                _kv_count = response.kv_count;
-            }
+            _apply_scan_response(std::move(response));
             _async_next_internal();
             return;
-        } else if (get_rocksdb_server_error(response.error) == PERR_NOT_FOUND) {
+        }
+
+        _info.app_id = response.app_id;
+        _info.partition_index = response.partition_index;
+        _info.decree = -1;
+        _info.server = response.server;
+        if (get_rocksdb_server_error(response.error) == PERR_NOT_FOUND) {
             _lock.lock();
             _context = SCAN_CONTEXT_ID_NOT_EXIST;
             _async_next_internal();
@@ -358,6 +497,11 @@ void pegasus_client_impl::pegasus_scanner_impl::_on_scan_response(::dsn::error_c
     internal_info info = _info;
     std::list<async_scan_next_callback_t> temp;
     _lock.lock();
+    if (_context == SCAN_CONTEXT_ID_PREFETCHING) {
+        // The context might have been consumed by the failed request, thus the next scan would
+        // be restarted from the last key received.
+        _context = SCAN_CONTEXT_ID_NOT_EXIST;
+    }
     std::swap(_queue, temp);
     _lock.unlock();
     // ATTENTION: after unlock with empty queue,  memebers variables can not be used anymore
@@ -369,6 +513,35 @@ void pegasus_client_impl::pegasus_scanner_impl::_on_scan_response(::dsn::error_c
     }
 }
 
+void pegasus_client_impl::pegasus_scanner_impl::_apply_scan_response(
+    ::dsn::apps::scan_response &&response)
+{
+    _info.app_id = response.app_id;
+    _info.partition_index = response.partition_index;
+    _info.decree = -1;
+    _info.server = response.server;
+
+    _kvs = std::move(response.kvs);
+    _p = -1;
+    _context = response.context_id;
+    // If `kv_count` exists in response, then:
+    //   1) server side supports only counting size, and
+    //   2) `kvs` in response must be empty
+    if (response.__isset.kv_count) {
+        _type = async_scan_type::COUNT_ONLY;
+        _kv_count = response.kv_count;
+    }
+    _aggregation_received = response.__isset.aggregation;
+    if (_aggregation_received) {
+        _aggregation = std::move(response.aggregation);
+    }
+
+    // Fetch the next batch of the partition while the current one is consumed.
+    if (_prefetch != nullptr && _context >= SCAN_CONTEXT_ID_VALID_MIN) {
+        _prefetch_next_batch();
+    }
+}
+
 void pegasus_client_impl::pegasus_scanner_impl::_split_reset()
 {
     _kvs.clear();
@@ -376,6 +549,38 @@ void pegasus_client_impl::pegasus_scanner_impl::_split_reset()
     _context = SCAN_CONTEXT_ID_NOT_EXIST;
 }
 
+int pegasus_client_impl::pegasus_scanner_impl::_take_aggregation_result(
+    scan_aggregation_result &result)
+{
+    ::dsn::zauto_lock l(_lock);
+    if (!_aggregation_received) {
+        // The server does not support aggregation, which only returns the count.
+        return PERR_NOT_SUPPORTED;
+    }
+    _aggregation_received = false;
+
+    result = scan_aggregation_result();
+    result.count = _aggregation.count;
+    result.total_key_size = _aggregation.total_key_size;
+    result.total_value_size = _aggregation.total_value_size;
+    result.numeric_count = _aggregation.numeric_count;
+    result.non_numeric_count = _aggregation.non_numeric_count;
+    result.sum = _aggregation.sum;
+    result.sum_overflow = _aggregation.sum_overflow;
+    result.min = _aggregation.min;
+    result.max = _aggregation.max;
+    result.value_size_histogram = std::move(_aggregation.value_size_histogram);
+    result.top_k.reserve(_aggregation.top_k.size());
+    for (const auto &entry : _aggregation.top_k) {
+        scan_aggregation_result::value_size_entry e;
+        pegasus_restore_key(entry.key, e.hash_key, e.sort_key);
+        e.value_size = entry.value_size;
+        result.top_k.emplace_back(std::move(e));
+    }
+    _aggregation = ::dsn::apps::scan_aggregation_result();
+    return PERR_OK;
+}
+
 pegasus_client_impl::pegasus_scanner_impl::~pegasus_scanner_impl()
 {
     dsn::zauto_lock l(_lock);
@@ -386,6 +591,17 @@ pegasus_client_impl::pegasus_scanner_impl::~pegasus_scanner_impl()
     if (_client) {
         if (_context >= SCAN_CONTEXT_ID_VALID_MIN)
             _client->clear_scanner(_context, _hash);
+        if (_prefetch != nullptr) {
+            ::dsn::zauto_lock pl(_prefetch->lock);
+            if (_prefetch->in_flight) {
+                // The context would be cleared once the batch is received.
+                _prefetch->abandoned = true;
+            } else if (_prefetch->received && _prefetch->err == ERR_OK &&
+                       _prefetch->response.error == 0 &&
+                       _prefetch->response.context_id >= SCAN_CONTEXT_ID_VALID_MIN) {
+                _client->clear_scanner(_prefetch->response.context_id, _hash);
+            }
+        }
         _client = nullptr;
     }
 }
@@ -411,6 +627,59 @@ void pegasus_client_impl::pegasus_scanner_impl_wrapper::async_next(
     });
 }
 
+int pegasus_client::scan_aggregation_result::merge(const scan_aggregation_result &other,
+                                                   int top_k_by_value_size)
+{
+    if (!value_size_histogram.empty() && !other.value_size_histogram.empty() &&
+        value_size_histogram.size() != other.value_size_histogram.size()) {
+        LOG_ERROR("can't merge the value size histograms of different sizes: {} vs {}",
+                  value_size_histogram.size(),
+                  other.value_size_histogram.size());
+        return PERR_INVALID_ARGUMENT;
+    }
+
+    if (other.numeric_count > 0) {
+        if (numeric_count == 0) {
+            min = other.min;
+            max = other.max;
+        } else {
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+        }
+    }
+
+    count += other.count;
+    total_key_size += other.total_key_size;
+    total_value_size += other.total_value_size;
+    numeric_count += other.numeric_count;
+    non_numeric_count += other.non_numeric_count;
+    if (other.sum_overflow || __builtin_add_overflow(sum, other.sum, &sum)) {
+        sum_overflow = true;
+    }
+
+    if (value_size_histogram.empty()) {
+        value_size_histogram = other.value_size_histogram;
+    } else if (!other.value_size_histogram.empty()) {
+        for (size_t i = 0; i < value_size_histogram.size(); ++i) {
+            value_size_histogram[i] += other.value_size_histogram[i];
+        }
+    }
+
+    if (top_k_by_value_size > 0 && !other.top_k.empty()) {
+        top_k.insert(top_k.end(), other.top_k.begin(), other.top_k.end());
+        std::stable_sort(top_k.begin(),
+                         top_k.end(),
+                         [](const value_size_entry &lhs, const value_size_entry &rhs) {
+                             return lhs.value_size > rhs.value_size;
+                         });
+        if (top_k.size() > static_cast<size_t>(top_k_by_value_size)) {
+            top_k.resize(top_k_by_value_size);
+        }
+    }
+
+    return PERR_OK;
+}
+
 const char pegasus_client_impl::pegasus_scanner_impl::_holder[] = {'\x00', '\x00', '\xFF', '\xFF'};
 const ::dsn::blob pegasus_client_impl::pegasus_scanner_impl::_min = ::dsn::blob(_holder, 0, 2);
 const ::dsn::blob pegasus_client_impl::pegasus_scanner_impl::_max = ::dsn::blob(_holder, 2, 2);
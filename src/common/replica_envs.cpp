@@ -87,6 +87,10 @@ const std::string replica_envs::ROCKSDB_CHECKPOINT_RESERVE_TIME_SECONDS(
 const std::string replica_envs::ROCKSDB_ITERATION_THRESHOLD_TIME_MS(
     "replica.rocksdb_iteration_threshold_time_ms");
 const std::string replica_envs::ROCKSDB_BLOCK_CACHE_ENABLED("replica.rocksdb_block_cache_enabled");
+
+/// true means the incr requests not asking for the new value are written as merge operands
+/// without read-before-write, otherwise false
+const std::string replica_envs::INCR_MERGE_ENABLED("replica.incr_merge_enabled");
 const std::string replica_envs::BUSINESS_INFO("business.info");
 const std::string replica_envs::REPLICA_ACCESS_CONTROLLER_ALLOWED_USERS(
     "replica_access_controller.allowed_users");
@@ -107,8 +111,28 @@ const std::string replica_envs::UPDATE_MAX_REPLICA_COUNT("max_replica_count.upda
 const std::string replica_envs::ROCKSDB_WRITE_BUFFER_SIZE("rocksdb.write_buffer_size");
 const std::string replica_envs::ROCKSDB_NUM_LEVELS("rocksdb.num_levels");
 
+/// options of the key-value separation (i.e. the integrated BlobDB) of RocksDB, by which the
+/// values not smaller than min_blob_size are stored in the blob files rather than the sst files
+const std::string replica_envs::ROCKSDB_ENABLE_BLOB_FILES("rocksdb.enable_blob_files");
+const std::string replica_envs::ROCKSDB_MIN_BLOB_SIZE("rocksdb.min_blob_size");
+const std::string replica_envs::ROCKSDB_BLOB_FILE_SIZE("rocksdb.blob_file_size");
+const std::string replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE("rocksdb.blob_compression_type");
+const std::string
+    replica_envs::ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION("rocksdb.enable_blob_garbage_collection");
+const std::string replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF(
+    "rocksdb.blob_garbage_collection_age_cutoff");
+const std::string replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_FORCE_THRESHOLD(
+    "rocksdb.blob_garbage_collection_force_threshold");
+
 const std::set<std::string> replica_envs::ROCKSDB_DYNAMIC_OPTIONS = {
     replica_envs::ROCKSDB_WRITE_BUFFER_SIZE,
+    replica_envs::ROCKSDB_ENABLE_BLOB_FILES,
+    replica_envs::ROCKSDB_MIN_BLOB_SIZE,
+    replica_envs::ROCKSDB_BLOB_FILE_SIZE,
+    replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE,
+    replica_envs::ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION,
+    replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF,
+    replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_FORCE_THRESHOLD,
 };
 const std::set<std::string> replica_envs::ROCKSDB_STATIC_OPTIONS = {
     replica_envs::ROCKSDB_NUM_LEVELS,
@@ -46,6 +46,7 @@ public:
     static const std::string ROCKSDB_CHECKPOINT_RESERVE_TIME_SECONDS;
     static const std::string ROCKSDB_ITERATION_THRESHOLD_TIME_MS;
     static const std::string ROCKSDB_BLOCK_CACHE_ENABLED;
+    static const std::string INCR_MERGE_ENABLED;
     static const std::string MANUAL_COMPACT_ONCE_PREFIX;
     static const std::string MANUAL_COMPACT_PERIODIC_PREFIX;
     static const std::string MANUAL_COMPACT_DISABLED;
@@ -70,6 +71,13 @@ public:
     static const std::string UPDATE_MAX_REPLICA_COUNT;
     static const std::string ROCKSDB_WRITE_BUFFER_SIZE;
     static const std::string ROCKSDB_NUM_LEVELS;
+    static const std::string ROCKSDB_ENABLE_BLOB_FILES;
+    static const std::string ROCKSDB_MIN_BLOB_SIZE;
+    static const std::string ROCKSDB_BLOB_FILE_SIZE;
+    static const std::string ROCKSDB_BLOB_COMPRESSION_TYPE;
+    static const std::string ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION;
+    static const std::string ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF;
+    static const std::string ROCKSDB_BLOB_GARBAGE_COLLECTION_FORCE_THRESHOLD;
 
     static const std::set<std::string> ROCKSDB_DYNAMIC_OPTIONS;
     static const std::set<std::string> ROCKSDB_STATIC_OPTIONS;
@@ -154,6 +154,7 @@ MAKE_EVENT_CODE(LPC_QUERY_NODE_CONFIGURATION_SCATTER2, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE(LPC_DELAY_UPDATE_CONFIG, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE(LPC_DELAY_LEARN, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE(LPC_LEARN_REMOTE_DELTA_FILES_COMPLETED, TASK_PRIORITY_HIGH)
+MAKE_EVENT_CODE(LPC_PREPARE_APP_LEARN_REQUEST_COMPLETED, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE(LPC_CHECKPOINT_REPLICA_COMPLETED, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE(LPC_SIM_UPDATE_PARTITION_CONFIGURATION_REPLY, TASK_PRIORITY_COMMON)
 MAKE_EVENT_CODE_AIO(LPC_WRITE_REPLICATION_LOG, TASK_PRIORITY_HIGH)
@@ -163,7 +164,9 @@ MAKE_EVENT_CODE_RPC(RPC_QUERY_PN_DECREE, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE_RPC(RPC_QUERY_REPLICA_INFO, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE_RPC(RPC_QUERY_LAST_CHECKPOINT_INFO, TASK_PRIORITY_COMMON)
 MAKE_EVENT_CODE_RPC(RPC_PREPARE, TASK_PRIORITY_HIGH)
+MAKE_EVENT_CODE_RPC(RPC_PREPARE_BATCH, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE(LPC_DELAY_PREPARE, TASK_PRIORITY_HIGH)
+MAKE_EVENT_CODE(LPC_FLUSH_PREPARE_BATCH, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE_RPC(RPC_GROUP_CHECK, TASK_PRIORITY_HIGH)
 MAKE_EVENT_CODE_RPC(RPC_QUERY_APP_INFO, TASK_PRIORITY_COMMON)
 MAKE_EVENT_CODE_RPC(RPC_LEARN, TASK_PRIORITY_HIGH)
@@ -195,6 +198,7 @@ MAKE_EVENT_CODE(LPC_read_THROTTLING_DELAY, TASK_PRIORITY_COMMON)
 // THREAD_POOL_REPLICATION_LONG
 #define CURRENT_THREAD_POOL THREAD_POOL_REPLICATION_LONG
 MAKE_EVENT_CODE(LPC_LEARN_REMOTE_DELTA_FILES, TASK_PRIORITY_COMMON)
+MAKE_EVENT_CODE(LPC_PREPARE_APP_LEARN_REQUEST, TASK_PRIORITY_COMMON)
 MAKE_EVENT_CODE_AIO(LPC_REPLICATION_COPY_REMOTE_FILES, TASK_PRIORITY_COMMON)
 MAKE_EVENT_CODE(LPC_GARBAGE_COLLECT_LOGS_AND_REPLICAS, TASK_PRIORITY_COMMON)
 MAKE_EVENT_CODE(LPC_OPEN_REPLICA, TASK_PRIORITY_COMMON)
@@ -212,6 +216,8 @@ MAKE_EVENT_CODE(LPC_REPLICATION_LONG_HIGH, TASK_PRIORITY_HIGH)
 
 #define CURRENT_THREAD_POOL THREAD_POOL_PLOG
 MAKE_EVENT_CODE_AIO(LPC_WRITE_REPLICATION_LOG_PRIVATE, TASK_PRIORITY_HIGH)
+MAKE_EVENT_CODE(LPC_PLOG_GROUP_COMMIT, TASK_PRIORITY_HIGH)
+MAKE_EVENT_CODE(LPC_PLOG_GROUP_COMMIT_COMPLETED, TASK_PRIORITY_HIGH)
 #undef CURRENT_THREAD_POOL
 
 // bulk load ingestion request
@@ -76,6 +76,14 @@ DSN_DEFINE_group_validator(min_max_level, [](std::string &message) -> bool {
 });
 DSN_DEFINE_uint32(geo_client.lib, latitude_index, 5, "latitude index in value");
 DSN_DEFINE_uint32(geo_client.lib, longitude_index, 4, "longitude index in value");
+DSN_DEFINE_bool(geo_client.lib,
+                server_side_filter_enabled,
+                true,
+                "Whether to filter the points out of the radius, and to pick the nearest ones "
+                "when sorted in ascending order, on the server side while scanning, so that "
+                "only the matched points are returned. The points are still checked on the "
+                "client side, thus it works with the servers not supporting it");
+DSN_TAG_VARIABLE(server_side_filter_enabled, FT_MUTABLE);
 
 namespace pegasus {
 namespace geo {
@@ -597,6 +605,10 @@ void geo_client::async_get_result_from_cells(const S2CellUnion &cids,
     if (sort_type == SortType::asc || sort_type == SortType::desc) {
         single_scan_count = -1; // scan all data to make full sort
     }
+    // The nearest `count` points of each scan are enough to pick the nearest ones of all. The
+    // server accepts at most 10000 nearest points for a scan.
+    const int top_k_nearest =
+        (sort_type == SortType::asc && count > 0 && count <= 10000) ? count : 0;
 
     // scan all cell ids
     std::shared_ptr<std::list<std::list<SearchResult>>> results =
@@ -622,6 +634,7 @@ void geo_client::async_get_result_from_cells(const S2CellUnion &cids,
                        "",
                        cap_ptr,
                        single_scan_count,
+                       top_k_nearest,
                        timeout_ms,
                        single_scan_finish_callback,
                        results->back());
@@ -655,6 +668,7 @@ void geo_client::async_get_result_from_cells(const S2CellUnion &cids,
                                        std::move(start_stop_sort_keys.second),
                                        cap_ptr,
                                        single_scan_count,
+                                       top_k_nearest,
                                        timeout_ms,
                                        single_scan_finish_callback,
                                        results->back());
@@ -679,6 +693,7 @@ void geo_client::async_get_result_from_cells(const S2CellUnion &cids,
                            std::move(start_stop_sort_keys.second),
                            cap_ptr,
                            single_scan_count,
+                           top_k_nearest,
                            timeout_ms,
                            single_scan_finish_callback,
                            results->back());
@@ -856,6 +871,7 @@ void geo_client::start_scan(const std::string &hash_key,
                             std::string &&stop_sort_key,
                             std::shared_ptr<S2Cap> cap_ptr,
                             int count,
+                            int top_k_nearest,
                             int timeout_ms,
                             scan_one_area_callback_t &&callback,
                             std::list<SearchResult> &result)
@@ -865,6 +881,16 @@ void geo_client::start_scan(const std::string &hash_key,
     options.stop_inclusive = true;
     options.batch_size = 1000;
     options.timeout_ms = timeout_ms;
+    if (FLAGS_server_side_filter_enabled) {
+        const S2LatLng center(cap_ptr->center());
+        options.geo_filter.enabled = true;
+        options.geo_filter.lat_degrees = center.lat().degrees();
+        options.geo_filter.lng_degrees = center.lng().degrees();
+        options.geo_filter.radius_m = S2Earth::ToMeters(cap_ptr->radius());
+        options.geo_filter.latitude_index = FLAGS_latitude_index;
+        options.geo_filter.longitude_index = FLAGS_longitude_index;
+        options.geo_filter.top_k_nearest = top_k_nearest;
+    }
 
     _geo_data_client->async_get_scanner(
         hash_key,
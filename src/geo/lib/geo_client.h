@@ -470,6 +470,7 @@ private:
                     std::string &&stop_sort_key,
                     std::shared_ptr<S2Cap> cap_ptr,
                     int count,
+                    int top_k_nearest,
                     int timeout_ms,
                     scan_one_area_callback_t &&callback,
                     std::list<SearchResult> &result);
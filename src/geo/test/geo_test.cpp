@@ -48,6 +48,7 @@
 #include "utils/string_conv.h"
 
 DSN_DECLARE_int32(min_level);
+DSN_DECLARE_bool(server_side_filter_enabled);
 
 namespace pegasus {
 namespace geo {
@@ -654,5 +655,60 @@ TEST_F(geo_client_test, large_cap)
         ASSERT_EQ(ret, pegasus::PERR_OK);
     }
 }
+
+TEST_F(geo_client_test, server_side_filter)
+{
+    double lat_degrees = 39.904202;
+    double lng_degrees = 116.407394;
+    double radius_m = 3000;
+    int test_data_count = 1000;
+
+    S2Cap cap;
+    gen_search_cap(S2LatLng::FromDegrees(lat_degrees, lng_degrees), radius_m * 2, cap);
+    for (int i = 0; i < test_data_count; ++i) {
+        S2LatLng latlng(S2Testing::SamplePoint(cap));
+        int ret = _geo_client->set("server_side_filter_" + std::to_string(i),
+                                   "",
+                                   gen_value(latlng.lat().degrees(), latlng.lng().degrees()),
+                                   5000);
+        ASSERT_EQ(ret, pegasus::PERR_OK);
+    }
+
+    // The points found with the server side filter are the same as the ones filtered on the
+    // client side.
+    const bool origin_server_side_filter_enabled = FLAGS_server_side_filter_enabled;
+    for (const auto &[count, sort_type] :
+         std::vector<std::pair<int, geo::geo_client::SortType>>{
+             {-1, geo::geo_client::SortType::asc},
+             {10, geo::geo_client::SortType::asc},
+             {10, geo::geo_client::SortType::desc},
+             {-1, geo::geo_client::SortType::random}}) {
+        std::list<geo::SearchResult> results[2];
+        for (int i = 0; i < 2; ++i) {
+            FLAGS_server_side_filter_enabled = (i == 0);
+            int ret = _geo_client->search_radial(
+                lat_degrees, lng_degrees, radius_m, count, sort_type, 5000, results[i]);
+            ASSERT_EQ(ret, pegasus::PERR_OK);
+        }
+        FLAGS_server_side_filter_enabled = origin_server_side_filter_enabled;
+
+        ASSERT_EQ(results[1].size(), results[0].size());
+        if (sort_type == geo::geo_client::SortType::random) {
+            continue;
+        }
+        auto iter = results[1].begin();
+        for (const auto &r : results[0]) {
+            ASSERT_LE(r.distance, radius_m);
+            ASSERT_EQ(iter->hash_key, r.hash_key);
+            ASSERT_DOUBLE_EQ(iter->distance, r.distance);
+            ++iter;
+        }
+    }
+
+    for (int i = 0; i < test_data_count; ++i) {
+        ASSERT_EQ(pegasus::PERR_OK,
+                  _geo_client->del("server_side_filter_" + std::to_string(i), "", 5000));
+    }
+}
 } // namespace geo
 } // namespace pegasus
@@ -27,6 +27,7 @@
 #include <pegasus/error.h>
 #include <functional>
 #include <memory>
+#include <utility>
 
 #include "utils/fmt_utils.h"
 
@@ -48,13 +49,17 @@ public:
         int32_t partition_index;
         int64_t decree;
         std::string server;
-        internal_info() : app_id(-1), partition_index(-1), decree(-1) {}
+        // For the reads, the number of decrees the replica which served the read could lag
+        // behind the primary, see set_max_read_staleness().
+        int32_t read_staleness;
+        internal_info() : app_id(-1), partition_index(-1), decree(-1), read_staleness(0) {}
         internal_info(internal_info &&_info)
         {
             app_id = _info.app_id;
             partition_index = _info.partition_index;
             decree = _info.decree;
             server = std::move(_info.server);
+            read_staleness = _info.read_staleness;
         }
         internal_info(const internal_info &_info)
         {
@@ -62,6 +67,7 @@ public:
             partition_index = _info.partition_index;
             decree = _info.decree;
             server = _info.server;
+            read_staleness = _info.read_staleness;
         }
         const internal_info &operator=(const internal_info &other)
         {
@@ -69,6 +75,7 @@ public:
             partition_index = other.partition_index;
             decree = other.decree;
             server = other.server;
+            read_staleness = other.read_staleness;
             return *this;
         }
         const internal_info &operator=(internal_info &&_info)
@@ -77,6 +84,7 @@ public:
             partition_index = _info.partition_index;
             decree = _info.decree;
             server = std::move(_info.server);
+            read_staleness = _info.read_staleness;
             return *this;
         }
     };
@@ -160,6 +168,21 @@ public:
         }
     };
 
+    struct incr_options
+    {
+        int ttl_seconds;       // the same as `ttl_seconds' of incr(), 0 means keep original ttl.
+        bool return_new_value; // if return the new value in `new_value'. if false, the incr could
+                               // be written without read-before-write on the tables whose
+                               // "replica.incr_merge_enabled" env is true, thus `new_value' would
+                               // always be 0, and an incr on invalid old data or overflowing would
+                               // be ignored rather than failed.
+        incr_options() : ttl_seconds(0), return_new_value(true) {}
+        incr_options(const incr_options &o)
+            : ttl_seconds(o.ttl_seconds), return_new_value(o.return_new_value)
+        {
+        }
+    };
+
     struct check_and_set_results
     {
         bool set_succeed;          // if set value succeed.
@@ -243,6 +266,103 @@ public:
         }
     };
 
+    struct batch_get_result
+    {
+        int error;         // PERR_OK if found, PERR_NOT_FOUND if not found, otherwise failed.
+        std::string value; // can be used only when error is PERR_OK.
+        internal_info info;
+        batch_get_result() : error(PERR_OK) {}
+    };
+
+    // The aggregations evaluated on the server side while scanning, so that only the
+    // aggregated results are returned instead of all the records.
+    struct scan_aggregation_options
+    {
+        bool enabled;             // aggregate the records instead of returning them
+        bool numeric_value_stats; // parse the values as decimal int64 to get sum/min/max
+        std::vector<int64_t> value_size_buckets; // ascending upper bounds of the value size
+                                                 // histogram, empty means no histogram
+        int top_k_by_value_size; // number of the records with the largest values to return
+        scan_aggregation_options()
+            : enabled(false), numeric_value_stats(false), top_k_by_value_size(0)
+        {
+        }
+    };
+
+    // The filter evaluated on the server side while scanning, so that only the records whose
+    // values hold a point within the circle are returned. The point is decoded from the fields
+    // of the value split by '|', the same as the values written by the geo client.
+    struct scan_geo_filter_options
+    {
+        bool enabled;
+        double lat_degrees; // the center of the circle
+        double lng_degrees;
+        double radius_m;
+        int latitude_index; // the indices of the latitude and longitude in the value
+        int longitude_index;
+        int top_k_nearest; // only return the nearest ones of the scanner in ascending order of
+                           // the distance, 0 means all
+        scan_geo_filter_options()
+            : enabled(false),
+              lat_degrees(0),
+              lng_degrees(0),
+              radius_m(0),
+              latitude_index(0),
+              longitude_index(1),
+              top_k_nearest(0)
+        {
+        }
+    };
+
+    struct scan_aggregation_result
+    {
+        struct value_size_entry
+        {
+            std::string hash_key;
+            std::string sort_key;
+            int64_t value_size;
+        };
+
+        int64_t count;
+        int64_t total_key_size;
+        int64_t total_value_size;
+        // the following are set only if numeric_value_stats is enabled, and min/max can be
+        // used only when numeric_count > 0.
+        int64_t numeric_count;
+        int64_t non_numeric_count;
+        int64_t sum;
+        bool sum_overflow;
+        int64_t min;
+        int64_t max;
+        // value_size_histogram[i] is the count of the values whose size is in
+        // [value_size_buckets[i-1], value_size_buckets[i]), with the last one for the sizes
+        // no less than the last bound.
+        std::vector<int64_t> value_size_histogram;
+        std::vector<value_size_entry> top_k; // sorted by value_size in descending order
+        scan_aggregation_result()
+            : count(0),
+              total_key_size(0),
+              total_value_size(0),
+              numeric_count(0),
+              non_numeric_count(0),
+              sum(0),
+              sum_overflow(false),
+              min(0),
+              max(0)
+        {
+        }
+
+        ///
+        /// \brief merge the result of another batch or scanner into this one
+        /// \param top_k_by_value_size
+        /// the max number of the entries kept in top_k
+        /// \return
+        /// int, PERR_OK if merged, or PERR_INVALID_ARGUMENT if the value size histograms
+        /// are of different sizes, in which case this result is left unchanged
+        ///
+        int merge(const scan_aggregation_result &other, int top_k_by_value_size);
+    };
+
     struct scan_options
     {
         int timeout_ms;       // RPC call timeout param, in milliseconds
@@ -256,6 +376,10 @@ public:
         bool no_value; // only fetch hash_key and sort_key, but not fetch value
         bool return_expire_ts;
         bool only_return_count;
+        int batch_bytes; // max bytes of k-v one RPC call, 0 means no limit
+        bool prefetch;   // fetch the next batch in advance while the current one is consumed
+        scan_aggregation_options aggregation; // results are got by next(scan_aggregation_result&)
+        scan_geo_filter_options geo_filter;
         scan_options()
             : timeout_ms(5000),
               batch_size(100),
@@ -265,7 +389,9 @@ public:
               sort_key_filter_type(FT_NO_FILTER),
               no_value(false),
               return_expire_ts(false),
-              only_return_count(false)
+              only_return_count(false),
+              batch_bytes(0),
+              prefetch(false)
         {
         }
         scan_options(const scan_options &o)
@@ -279,7 +405,11 @@ public:
               sort_key_filter_pattern(o.sort_key_filter_pattern),
               no_value(o.no_value),
               return_expire_ts(o.return_expire_ts),
-              only_return_count(o.only_return_count)
+              only_return_count(o.only_return_count),
+              batch_bytes(o.batch_bytes),
+              prefetch(o.prefetch),
+              aggregation(o.aggregation),
+              geo_filter(o.geo_filter)
         {
         }
     };
@@ -300,6 +430,9 @@ public:
     typedef std::function<void(
         int /*error_code*/, std::set<std::string> && /*sortkeys*/, internal_info && /*info*/)>
         async_multi_get_sortkeys_callback_t;
+    typedef std::function<void(int /*error_code*/,
+                               std::vector<batch_get_result> && /*results*/)>
+        async_batch_get_callback_t;
     typedef std::function<void(int /*error_code*/, internal_info && /*info*/)> async_del_callback_t;
     typedef std::function<void(
         int /*error_code*/, int64_t /*deleted_count*/, internal_info && /*info*/)>
@@ -365,6 +498,23 @@ public:
         ///
         virtual int next(int32_t &count, internal_info *info = nullptr) = 0;
 
+        ///
+        /// \brief get the aggregated result of the next batch of this scanner
+        //  only used for scanner which option aggregation.enabled is true
+        /// thread-safe
+        /// \param result
+        /// the aggregated result of the batch, which could be merged by
+        /// scan_aggregation_result::merge() to get the result of the whole scan
+        /// \return
+        /// int, the error indicates whether or not the operation is succeeded.
+        /// this error can be converted to a string using get_error_string()
+        /// PERR_OK means a valid result got
+        /// PERR_SCAN_COMPLETE means the results of all batches have been returned before
+        /// PERR_NOT_SUPPORTED means the server does not support aggregation
+        /// otherwise some error orrured
+        ///
+        virtual int next(scan_aggregation_result &result, internal_info *info = nullptr) = 0;
+
         ///
         /// \brief async get the next key-value pair of this scanner
         /// thread-safe
@@ -734,6 +884,45 @@ public:
                                           int max_fetch_size = 1000000,
                                           int timeout_milliseconds = 5000) = 0;
 
+    ///
+    /// \brief batch_get
+    ///     get the values of multiple keys under different hash keys from the cluster.
+    ///     the keys are grouped by partition, and the requests of all the partitions are
+    ///     sent in parallel.
+    /// \param keys
+    /// the <hashkey,sortkey> pairs to get, the hashkeys could be different.
+    /// \param results
+    /// the results of the keys, in the same order as `keys`.
+    /// \param timeout_milliseconds
+    /// if wait longer than this value, will return time out error
+    /// \return
+    /// int, the error indicates whether or not the operation is succeeded.
+    /// this error can be converted to a string using get_error_string().
+    /// returns PERR_OK if the requests of all the partitions succeed, even no data is found.
+    /// otherwise returns the error of one failed partition, the error of each key could be
+    /// found in `results`.
+    ///
+    virtual int batch_get(const std::vector<std::pair<std::string, std::string>> &keys,
+                          std::vector<batch_get_result> &results,
+                          int timeout_milliseconds = 5000) = 0;
+
+    ///
+    /// \brief asynchronous batch_get
+    ///     get the values of multiple keys under different hash keys from the cluster.
+    ///     will not be blocked, return immediately.
+    /// \param keys
+    /// the <hashkey,sortkey> pairs to get, the hashkeys could be different.
+    /// \param callback
+    /// the callback function will be invoked after operation finished or error occurred.
+    /// \param timeout_milliseconds
+    /// if wait longer than this value, will return time out error
+    /// \return
+    /// void.
+    ///
+    virtual void async_batch_get(const std::vector<std::pair<std::string, std::string>> &keys,
+                                 async_batch_get_callback_t &&callback = nullptr,
+                                 int timeout_milliseconds = 5000) = 0;
+
     ///
     /// \brief exist
     ///     check value exist by key from the cluster.
@@ -935,6 +1124,63 @@ public:
                             int timeout_milliseconds = 5000,
                             int ttl_seconds = 0) = 0;
 
+    ///
+    /// \brief incr with options
+    ///     the same as incr() above, except that the ttl and whether to return the new value
+    ///     are specified by `options'.
+    ///
+    /// \param hashkey
+    /// used to decide which partition to get this k-v
+    /// \param sortkey
+    /// all the k-v under hashkey will be sorted by sortkey.
+    /// \param increment
+    /// the value we want to increment.
+    /// \param options
+    /// the incr options.
+    /// \param new_value
+    /// out param to return the new value if increment succeed and options.return_new_value is
+    /// true.
+    /// \param timeout_milliseconds
+    /// if wait longer than this value, will return time out error
+    /// \return
+    /// int, the error indicates whether or not the operation is succeeded.
+    /// this error can be converted to a string using get_error_string().
+    ///
+    virtual int incr(const std::string &hashkey,
+                     const std::string &sortkey,
+                     int64_t increment,
+                     const incr_options &options,
+                     int64_t &new_value,
+                     int timeout_milliseconds = 5000,
+                     internal_info *info = nullptr) = 0;
+
+    ///
+    /// \brief asynchronous incr with options
+    ///     the same as async_incr() above, except that the ttl and whether to return the new
+    ///     value are specified by `options'.
+    ///
+    /// \param hashkey
+    /// used to decide which partition to get this k-v
+    /// \param sortkey
+    /// all the k-v under hashkey will be sorted by sortkey.
+    /// \param increment
+    /// the value we want to increment.
+    /// \param options
+    /// the incr options.
+    /// \param callback
+    /// the callback function will be invoked after operation finished or error occurred.
+    /// \param timeout_milliseconds
+    /// if wait longer than this value, will return time out error
+    /// \return
+    /// void.
+    ///
+    virtual void async_incr(const std::string &hashkey,
+                            const std::string &sortkey,
+                            int64_t increment,
+                            const incr_options &options,
+                            async_incr_callback_t &&callback = nullptr,
+                            int timeout_milliseconds = 5000) = 0;
+
     ///
     /// \brief check_and_set
     ///     atomically check and set value by key from the cluster.
@@ -1101,6 +1347,42 @@ public:
                     int timeout_milliseconds = 5000,
                     internal_info *info = nullptr) = 0;
 
+    ///
+    /// \brief set_max_read_staleness
+    ///     allow the point reads, i.e. get/multi_get/multi_get_sortkeys/batch_get/exist/
+    ///     sortkey_count/ttl, to be served by the secondaries which lag behind the primary by at
+    ///     most max_read_staleness decrees, to spread the reads of the read-heavy tables across
+    ///     all the replicas. The replica is selected by the latencies observed by the client,
+    ///     and the read falls back to the primary if the secondary fails or is too stale. The
+    ///     scans are always served by the primaries.
+    ///     A secondary counts its lag by the mutations it has prepared, thus a secondary which
+    ///     has been removed by the primary doesn't know it is lagging. Such a secondary keeps
+    ///     serving the reads until [replication]secondary_read_lease_ms passes without any
+    ///     request from the primary, so the reads might be staler than the bound in that window.
+    ///     The client returned by pegasus_client_factory is shared by the whole process, so is
+    ///     this setting.
+    /// \param max_read_staleness
+    /// the max number of decrees the secondaries could lag behind, 0 means reading from the
+    /// primaries only, which is the default.
+    ///
+    virtual void set_max_read_staleness(uint16_t max_read_staleness) = 0;
+
+    ///
+    /// \brief set_hedged_read_enabled
+    ///     if a point read is not replied within the percentile (see
+    ///     [pegasus.client]hedged_read_delay_percentile) of the recent latencies of the target
+    ///     replica, send a hedged request to another replica and take the reply which arrives
+    ///     first, to cut the tail latencies caused by the stalls of a single node. The hedged
+    ///     requests are limited by [pegasus.client]hedged_read_max_ratio_percent.
+    ///     the hedged requests served by the secondaries are bounded by the staleness set by
+    ///     set_max_read_staleness(), or unbounded if it's 0, just like the backup requests.
+    ///     only the asynchronous reads and the synchronous ones built on them, i.e. get/multi_get/
+    ///     multi_get_sortkeys/batch_get, are hedged.
+    /// \param enabled
+    /// false by default.
+    ///
+    virtual void set_hedged_read_enabled(bool enabled) = 0;
+
     ///
     /// \brief get hash scanner
     ///     get scanner for [start_sortkey, stop_sortkey) of hashkey
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 
 #include "client/partition_resolver.h"
@@ -50,6 +51,20 @@ public:
     }
     ~rrdb_client() { _tracker.cancel_outstanding_tasks(); }
 
+    // Get the partition count of the app, or -1 if it's still unknown.
+    int get_partition_count() const { return _resolver->get_partition_count(); }
+
+    // Allow the point reads to be served by the secondaries which lag behind the primaries by
+    // at most `max_read_staleness` decrees, 0 means reading from the primaries only.
+    void set_max_read_staleness(uint16_t max_read_staleness)
+    {
+        _max_read_staleness = max_read_staleness;
+    }
+
+    // Send a hedged request to another replica if an asynchronous point read is not replied in
+    // time. The synchronous reads are not hedged since they wait for the original requests.
+    void set_hedged_read_enabled(bool enabled) { _hedged_read_enabled = enabled; }
+
     // ---------- call RPC_RRDB_RRDB_PUT ------------
     // - synchronous
     std::pair<::dsn::error_code, update_response>
@@ -259,8 +274,15 @@ public:
     std::pair<::dsn::error_code, read_response>
     get_sync(const ::dsn::blob &args, std::chrono::milliseconds timeout, uint64_t partition_hash)
     {
-        return ::dsn::rpc::wait_and_unwrap<read_response>(_resolver->call_op(
-            RPC_RRDB_RRDB_GET, args, &_tracker, empty_rpc_handler, timeout, partition_hash));
+        return ::dsn::rpc::wait_and_unwrap<read_response>(
+            _resolver->call_op(RPC_RRDB_RRDB_GET,
+                               args,
+                               &_tracker,
+                               empty_rpc_handler,
+                               timeout,
+                               partition_hash,
+                               0,
+                               get_read_options(false)));
     }
 
     // - asynchronous with on-stack ::dsn::blob and read_response
@@ -277,7 +299,8 @@ public:
                                   std::forward<TCallback>(callback),
                                   timeout,
                                   request_partition_hash,
-                                  reply_thread_hash);
+                                  reply_thread_hash,
+                                  get_read_options(true));
     }
 
     // ---------- call RPC_RRDB_RRDB_MULTI_GET ------------
@@ -285,8 +308,15 @@ public:
     std::pair<::dsn::error_code, multi_get_response> multi_get_sync(
         const multi_get_request &args, std::chrono::milliseconds timeout, uint64_t partition_hash)
     {
-        return ::dsn::rpc::wait_and_unwrap<multi_get_response>(_resolver->call_op(
-            RPC_RRDB_RRDB_MULTI_GET, args, &_tracker, empty_rpc_handler, timeout, partition_hash));
+        return ::dsn::rpc::wait_and_unwrap<multi_get_response>(
+            _resolver->call_op(RPC_RRDB_RRDB_MULTI_GET,
+                               args,
+                               &_tracker,
+                               empty_rpc_handler,
+                               timeout,
+                               partition_hash,
+                               0,
+                               get_read_options(false)));
     }
 
     // - asynchronous with on-stack multi_get_request and multi_get_response
@@ -303,7 +333,8 @@ public:
                                   std::forward<TCallback>(callback),
                                   timeout,
                                   request_partition_hash,
-                                  reply_thread_hash);
+                                  reply_thread_hash,
+                                  get_read_options(true));
     }
 
     // ---------- call RPC_RRDB_RRDB_BATCH_GET ------------
@@ -311,8 +342,15 @@ public:
     std::pair<::dsn::error_code, batch_get_response> batch_get_sync(
         const batch_get_request &args, std::chrono::milliseconds timeout, uint64_t partition_hash)
     {
-        return ::dsn::rpc::wait_and_unwrap<batch_get_response>(_resolver->call_op(
-            RPC_RRDB_RRDB_BATCH_GET, args, &_tracker, empty_rpc_handler, timeout, partition_hash));
+        return ::dsn::rpc::wait_and_unwrap<batch_get_response>(
+            _resolver->call_op(RPC_RRDB_RRDB_BATCH_GET,
+                               args,
+                               &_tracker,
+                               empty_rpc_handler,
+                               timeout,
+                               partition_hash,
+                               0,
+                               get_read_options(false)));
     }
 
     // - asynchronous with on-stack BatchGetRequest and BatchGetResponse
@@ -329,7 +367,8 @@ public:
                                   std::forward<TCallback>(callback),
                                   timeout,
                                   request_partition_hash,
-                                  reply_thread_hash);
+                                  reply_thread_hash,
+                                  get_read_options(true));
     }
 
     // ---------- call RPC_RRDB_RRDB_SORTKEY_COUNT ------------
@@ -343,7 +382,9 @@ public:
                                &_tracker,
                                empty_rpc_handler,
                                timeout,
-                               partition_hash));
+                               partition_hash,
+                               0,
+                               get_read_options(false)));
     }
 
     // - asynchronous with on-stack ::dsn::blob and count_response
@@ -360,7 +401,8 @@ public:
                                   std::forward<TCallback>(callback),
                                   timeout,
                                   request_partition_hash,
-                                  reply_thread_hash);
+                                  reply_thread_hash,
+                                  get_read_options(true));
     }
 
     // ---------- call RPC_RRDB_RRDB_TTL ------------
@@ -368,8 +410,15 @@ public:
     std::pair<::dsn::error_code, ttl_response>
     ttl_sync(const ::dsn::blob &args, std::chrono::milliseconds timeout, uint64_t partition_hash)
     {
-        return ::dsn::rpc::wait_and_unwrap<ttl_response>(_resolver->call_op(
-            RPC_RRDB_RRDB_TTL, args, &_tracker, empty_rpc_handler, timeout, partition_hash));
+        return ::dsn::rpc::wait_and_unwrap<ttl_response>(
+            _resolver->call_op(RPC_RRDB_RRDB_TTL,
+                               args,
+                               &_tracker,
+                               empty_rpc_handler,
+                               timeout,
+                               partition_hash,
+                               0,
+                               get_read_options(false)));
     }
 
     // - asynchronous with on-stack ::dsn::blob and ttl_response
@@ -386,7 +435,8 @@ public:
                                   std::forward<TCallback>(callback),
                                   timeout,
                                   request_partition_hash,
-                                  reply_thread_hash);
+                                  reply_thread_hash,
+                                  get_read_options(true));
     }
 
     // ---------- call RPC_RRDB_RRDB_GET_SCANNER ------------
@@ -470,7 +520,17 @@ public:
     }
 
 private:
+    dsn::replication::read_options get_read_options(bool async) const
+    {
+        dsn::replication::read_options options;
+        options.max_read_staleness = _max_read_staleness;
+        options.hedged = async && _hedged_read_enabled;
+        return options;
+    }
+
     dsn::replication::partition_resolver_ptr _resolver;
+    std::atomic<uint16_t> _max_read_staleness{0};
+    std::atomic<bool> _hedged_read_enabled{false};
     dsn::task_tracker _tracker;
 };
 } // namespace apps
@@ -225,6 +225,8 @@ void app_env_validator::register_all_validators()
     static const auto kMaxWriteBufferSize = 512 << 20;
     static const auto kMinLevel = 1;
     static const auto kMaxLevel = 10;
+    static const auto kMinBlobFileSize = 1 << 20;
+    static const auto kMaxBlobFileSize = 1 << 30;
     static const std::string check_throttling_limit = "<size[K|M]>*<delay|reject>*<milliseconds>";
     static const std::string check_throttling_sample = "10000*delay*100,20000*reject*100";
 
@@ -263,6 +265,36 @@ void app_env_validator::register_all_validators()
             return true;
         });
 
+    // EnvInfo for ROCKSDB_BLOB_COMPRESSION_TYPE.
+    const std::set<std::string> valid_bcts({"none", "snappy", "lz4", "zstd"});
+    const std::string bct_sample(fmt::format("{}", fmt::join(valid_bcts, " | ")));
+    const app_env_validator::EnvInfo bct(
+        app_env_validator::ValueType::kString,
+        bct_sample,
+        "lz4",
+        [=](const std::string &new_value, std::string &hint_message) {
+            if (valid_bcts.count(new_value) == 0) {
+                hint_message = bct_sample;
+                return false;
+            }
+            return true;
+        });
+
+    // EnvInfo for the ratios of ROCKSDB_BLOB_GARBAGE_COLLECTION_*.
+    const app_env_validator::EnvInfo blob_gc_ratio(
+        app_env_validator::ValueType::kString,
+        "In range [0.0, 1.0]",
+        "0.25",
+        [](const std::string &new_value, std::string &hint_message) {
+            double ratio = 0;
+            if (!dsn::buf2double(new_value, ratio) || ratio < 0 || ratio > 1) {
+                hint_message =
+                    fmt::format("invalid value '{}', should be 'In range [0.0, 1.0]'", new_value);
+                return false;
+            }
+            return true;
+        });
+
     _validator_funcs = {
         {replica_envs::SLOW_QUERY_THRESHOLD,
          {ValueType::kInt64,
@@ -278,6 +310,7 @@ void app_env_validator::register_all_validators()
         {replica_envs::ROCKSDB_ITERATION_THRESHOLD_TIME_MS,
          {ValueType::kInt64, ">= 0", "1000", [](int64_t new_value) { return new_value >= 0; }}},
         {replica_envs::ROCKSDB_BLOCK_CACHE_ENABLED, {ValueType::kBool}},
+        {replica_envs::INCR_MERGE_ENABLED, {ValueType::kBool}},
         {replica_envs::READ_QPS_THROTTLING,
          {ValueType::kString, check_throttling_limit, check_throttling_sample, &check_throttling}},
         {replica_envs::READ_SIZE_THROTTLING,
@@ -308,6 +341,20 @@ void app_env_validator::register_all_validators()
           fmt::format("In range [{}, {}]", kMinLevel, kMaxLevel),
           "6",
           [](int64_t new_value) { return kMinLevel <= new_value && new_value <= kMaxLevel; }}},
+        {replica_envs::ROCKSDB_ENABLE_BLOB_FILES, {ValueType::kBool}},
+        {replica_envs::ROCKSDB_MIN_BLOB_SIZE,
+         {ValueType::kInt64, ">= 0", "4096", [](int64_t new_value) { return new_value >= 0; }}},
+        {replica_envs::ROCKSDB_BLOB_FILE_SIZE,
+         {ValueType::kInt64,
+          fmt::format("In range [{}, {}]", kMinBlobFileSize, kMaxBlobFileSize),
+          "268435456",
+          [](int64_t new_value) {
+              return kMinBlobFileSize <= new_value && new_value <= kMaxBlobFileSize;
+          }}},
+        {replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE, bct},
+        {replica_envs::ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION, {ValueType::kBool}},
+        {replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF, blob_gc_ratio},
+        {replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_FORCE_THRESHOLD, blob_gc_ratio},
         {replica_envs::BUSINESS_INFO, {ValueType::kString}},
         {replica_envs::TABLE_LEVEL_DEFAULT_TTL,
          {ValueType::kInt32, ">= 0", "86400", [](int64_t new_value) { return new_value >= 0; }}},
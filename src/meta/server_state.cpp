@@ -35,6 +35,7 @@
 #include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iterator>
 #include <set>
 #include <sstream> // IWYU pragma: keep
@@ -81,6 +82,8 @@
 #include "utils/blob.h"
 #include "utils/command_manager.h"
 #include "utils/config_api.h"
+#include "utils/crc.h"
+#include "utils/defer.h"
 #include "utils/errors.h"
 #include "utils/fail_point.h"
 #include "utils/flags.h"
@@ -132,8 +135,34 @@ DSN_DEFINE_int32(meta_server,
                  10,
                  "add secondary max count for one node when flow control enabled");
 
+DSN_DEFINE_uint32(meta_server,
+                  max_client_config_snapshot_staleness_ms,
+                  1000,
+                  "The max staleness in milliseconds of the snapshot of the app configs that is "
+                  "served to the clients while the meta state is being updated by a writer. 0 "
+                  "means the client queries always wait for the writers");
+DSN_TAG_VARIABLE(max_client_config_snapshot_staleness_ms, FT_MUTABLE);
+
 DSN_DECLARE_bool(recover_from_replica_server);
 
+METRIC_DEFINE_counter(server,
+                      config_sync_sent_partitions,
+                      dsn::metric_unit::kPartitions,
+                      "The number of the partitions whose configs are sent to the replica servers "
+                      "by config sync");
+
+METRIC_DEFINE_counter(server,
+                      config_sync_unchanged_partitions,
+                      dsn::metric_unit::kPartitions,
+                      "The number of the partitions whose configs are not sent to the replica "
+                      "servers by config sync since they have not been changed");
+
+METRIC_DEFINE_counter(server,
+                      client_config_queries_served_by_snapshot,
+                      dsn::metric_unit::kRequests,
+                      "The number of the client queries for the app configs that are served by "
+                      "the snapshots without waiting for the writers of the meta state");
+
 namespace dsn::replication {
 
 // Reply to the client with specified response.
@@ -146,13 +175,38 @@ namespace dsn::replication {
     REPLY_TO_CLIENT(msg, response);                                                                \
     return
 
+// The digest of the app info, which is shared by all partitions of the app.
+static uint64_t get_app_info_digest(const app_info &info)
+{
+    binary_writer writer;
+    dsn::marshall(writer, info, DSF_THRIFT_BINARY);
+    const auto buf = writer.get_buffer();
+    return utils::crc64_calc(buf.data(), buf.length(), 0);
+}
+
+// The digest of all the configs sent to a replica by config sync, the replica would get them
+// again once any of them is changed.
+static int64_t get_config_digest(uint64_t app_digest,
+                                 const partition_configuration &pc,
+                                 split_status::type meta_split_status)
+{
+    binary_writer writer;
+    dsn::marshall(writer, pc, DSF_THRIFT_BINARY);
+    writer.write(static_cast<int32_t>(meta_split_status));
+    const auto buf = writer.get_buffer();
+    return static_cast<int64_t>(utils::crc64_calc(buf.data(), buf.length(), app_digest));
+}
+
 static const char *lock_state = "lock";
 static const char *unlock_state = "unlock";
 
 server_state::server_state()
     : _meta_svc(nullptr),
       _add_secondary_enable_flow_control(false),
-      _add_secondary_max_count_for_one_node(0)
+      _add_secondary_max_count_for_one_node(0),
+      METRIC_VAR_INIT_server(config_sync_sent_partitions),
+      METRIC_VAR_INIT_server(config_sync_unchanged_partitions),
+      METRIC_VAR_INIT_server(client_config_queries_served_by_snapshot)
 {
 }
 
@@ -856,7 +910,21 @@ void server_state::on_config_sync(configuration_query_by_node_rpc rpc)
             response.err = ERR_OBJECT_NOT_FOUND;
         } else {
             response.err = ERR_OK;
+            std::unordered_map<gpid, int64_t> synced_digests;
+            if (request.__isset.synced_digests) {
+                synced_digests.reserve(request.synced_digests.size());
+                for (const auto &d : request.synced_digests) {
+                    synced_digests.emplace(d.pid, d.digest);
+                }
+                response.__isset.digests = true;
+                response.__isset.unchanged_partitions = true;
+            }
+            // The digests of the app infos are computed only once for all partitions of the
+            // same app, which are the most expensive part of the configs due to the envs.
+            std::unordered_map<int32_t, uint64_t> app_digests;
+
             unsigned int i = 0;
+            unsigned int sent = 0;
             response.partitions.resize(ns->partition_count());
             ns->for_each_partition([&, this](const gpid &pid) {
                 std::shared_ptr<app_state> app = get_app(pid.get_app_id());
@@ -882,23 +950,51 @@ void server_state::on_config_sync(configuration_query_by_node_rpc rpc)
                     }
                 }
 
-                response.partitions[i].info = *app;
-                response.partitions[i].config = app->pcs[pid.get_partition_index()];
-                response.partitions[i].host_node = request.node;
-                // set meta_split_status
+                const auto &pc = app->pcs[pid.get_partition_index()];
+                auto meta_split_status = split_status::NOT_SPLIT;
                 const split_state &app_split_states = app->helpers->split_states;
                 if (app->splitting()) {
                     auto iter = app_split_states.status.find(pid.get_partition_index());
                     if (iter != app_split_states.status.end()) {
-                        response.partitions[i].__set_meta_split_status(iter->second);
+                        meta_split_status = iter->second;
                     }
                 }
+
                 ++i;
+                if (response.__isset.digests) {
+                    auto app_digest = app_digests.find(pid.get_app_id());
+                    if (app_digest == app_digests.end()) {
+                        app_digest =
+                            app_digests.emplace(pid.get_app_id(), get_app_info_digest(*app)).first;
+                    }
+                    const auto digest =
+                        get_config_digest(app_digest->second, pc, meta_split_status);
+                    const auto synced = synced_digests.find(pid);
+                    if (synced != synced_digests.end() && synced->second == digest) {
+                        response.unchanged_partitions.push_back(pid);
+                        return true;
+                    }
+
+                    config_sync_digest d;
+                    d.pid = pid;
+                    d.digest = digest;
+                    response.digests.push_back(d);
+                }
+
+                auto &config_update = response.partitions[sent++];
+                config_update.info = *app;
+                config_update.config = pc;
+                config_update.host_node = request.node;
+                // set meta_split_status
+                if (meta_split_status != split_status::NOT_SPLIT) {
+                    config_update.__set_meta_split_status(meta_split_status);
+                }
                 return true;
             });
             if (i < response.partitions.size()) {
                 reject_this_request = true;
             }
+            response.partitions.resize(sent);
         }
 
         // handle the stored replicas & the gc replicas
@@ -987,12 +1083,19 @@ void server_state::on_config_sync(configuration_query_by_node_rpc rpc)
     if (reject_this_request) {
         response.err = ERR_BUSY;
         response.partitions.clear();
+        response.digests.clear();
+        response.unchanged_partitions.clear();
+    } else if (response.err == ERR_OK) {
+        METRIC_VAR_INCREMENT_BY(config_sync_sent_partitions, response.partitions.size());
+        METRIC_VAR_INCREMENT_BY(config_sync_unchanged_partitions,
+                                response.unchanged_partitions.size());
     }
     LOG_INFO("send config sync response to {}, err({}), partitions_count({}), "
-             "gc_replicas_count({})",
+             "unchanged_partitions_count({}), gc_replicas_count({})",
              node,
              response.err,
              response.partitions.size(),
+             response.unchanged_partitions.size(),
              response.gc_replicas.size());
 }
 
@@ -1023,17 +1126,17 @@ bool server_state::query_configuration_by_gpid(const dsn::gpid &id,
     return false;
 }
 
-void server_state::query_configuration_by_index(const query_cfg_request &request,
-                                                /*out*/ query_cfg_response &response)
+std::shared_ptr<query_cfg_response>
+server_state::build_app_config(const std::string &app_name) const
 {
-    zauto_read_lock l(_lock);
-    auto iter = _exist_apps.find(request.app_name);
+    auto app_config = std::make_shared<query_cfg_response>();
+    auto iter = _exist_apps.find(app_name);
     if (iter == _exist_apps.end()) {
-        response.err = ERR_OBJECT_NOT_FOUND;
-        return;
+        app_config->err = ERR_OBJECT_NOT_FOUND;
+        return app_config;
     }
 
-    std::shared_ptr<app_state> &app = iter->second;
+    const std::shared_ptr<app_state> &app = iter->second;
     if (app->status != app_status::AS_AVAILABLE) {
         LOG_ERROR("invalid status({}) in exist app({}), app_id({})",
                   enum_to_string(app->status),
@@ -1043,29 +1146,117 @@ void server_state::query_configuration_by_index(const query_cfg_request &request
         switch (app->status) {
         case app_status::AS_CREATING:
         case app_status::AS_RECALLING:
-            response.err = ERR_BUSY_CREATING;
+            app_config->err = ERR_BUSY_CREATING;
             break;
         case app_status::AS_DROPPING:
-            response.err = ERR_BUSY_DROPPING;
+            app_config->err = ERR_BUSY_DROPPING;
             break;
         default:
-            response.err = ERR_UNKNOWN;
+            app_config->err = ERR_UNKNOWN;
+        }
+        return app_config;
+    }
+
+    app_config->err = ERR_OK;
+    app_config->app_id = app->app_id;
+    app_config->partition_count = app->partition_count;
+    app_config->is_stateful = app->is_stateful;
+    app_config->partitions = app->pcs;
+    return app_config;
+}
+
+std::shared_ptr<const query_cfg_response>
+server_state::get_app_config_snapshot(const std::string &app_name) const
+{
+    const auto &shard =
+        _app_config_snapshot_shards[std::hash<std::string>()(app_name) %
+                                    kAppConfigSnapshotShardCount];
+    zauto_lock l(shard.lock);
+    const auto iter = shard.snapshots.find(app_name);
+    if (iter == shard.snapshots.end() ||
+        iter->second.build_time_ms + FLAGS_max_client_config_snapshot_staleness_ms <
+            dsn_now_ms()) {
+        return nullptr;
+    }
+    return iter->second.app_config;
+}
+
+void server_state::update_app_config_snapshot(
+    const std::string &app_name,
+    const std::shared_ptr<const query_cfg_response> &app_config,
+    uint64_t build_time_ms)
+{
+    auto &shard = _app_config_snapshot_shards[std::hash<std::string>()(app_name) %
+                                              kAppConfigSnapshotShardCount];
+    zauto_lock l(shard.lock);
+    auto iter = shard.snapshots.find(app_name);
+    if (app_config->err != ERR_OK) {
+        if (iter != shard.snapshots.end() && iter->second.build_time_ms <= build_time_ms) {
+            shard.snapshots.erase(iter);
         }
         return;
     }
 
-    response.err = ERR_OK;
-    response.app_id = app->app_id;
-    response.partition_count = app->partition_count;
-    response.is_stateful = app->is_stateful;
+    if (iter == shard.snapshots.end()) {
+        shard.snapshots.emplace(app_name, app_config_snapshot{app_config, build_time_ms});
+        return;
+    }
+
+    // The snapshots might be published out of order by the concurrent queries, never replace
+    // a snapshot with an older one.
+    if (iter->second.build_time_ms <= build_time_ms) {
+        iter->second = app_config_snapshot{app_config, build_time_ms};
+    }
+}
+
+void server_state::query_configuration_by_index(const query_cfg_request &request,
+                                                /*out*/ query_cfg_response &response)
+{
+    std::shared_ptr<const query_cfg_response> app_config;
+    uint64_t build_time_ms = 0;
+    if (FLAGS_max_client_config_snapshot_staleness_ms == 0) {
+        zauto_read_lock l(_lock);
+        app_config = build_app_config(request.app_name);
+    } else if (_lock.try_lock_read()) {
+        auto unlock = dsn::defer([this]() { _lock.unlock_read(); });
+        build_time_ms = dsn_now_ms();
+        app_config = build_app_config(request.app_name);
+    } else {
+        // The meta state is being updated by a writer. Rather than waiting for it, serve the
+        // query with the latest snapshot of the app: the configs returned to the client could
+        // become outdated anyway right after the writer finishes, and the client would query
+        // again once it finds the configs outdated.
+        app_config = get_app_config_snapshot(request.app_name);
+        if (app_config) {
+            METRIC_VAR_INCREMENT(client_config_queries_served_by_snapshot);
+        } else {
+            zauto_read_lock l(_lock);
+            build_time_ms = dsn_now_ms();
+            app_config = build_app_config(request.app_name);
+        }
+    }
+
+    if (build_time_ms > 0) {
+        update_app_config_snapshot(request.app_name, app_config, build_time_ms);
+    }
+
+    response.err = app_config->err;
+    if (response.err != ERR_OK) {
+        return;
+    }
+
+    response.app_id = app_config->app_id;
+    response.partition_count = app_config->partition_count;
+    response.is_stateful = app_config->is_stateful;
 
+    const auto &pcs = app_config->partitions;
     for (const int32_t &index : request.partition_indices) {
-        if (index >= 0 && index < app->pcs.size()) {
-            response.partitions.push_back(app->pcs[index]);
+        if (index >= 0 && index < pcs.size()) {
+            response.partitions.push_back(pcs[index]);
         }
     }
     if (response.partitions.empty()) {
-        response.partitions = app->pcs;
+        response.partitions = pcs;
     }
 }
 
@@ -29,12 +29,15 @@
 // IWYU pragma: no_include <boost/detail/basic_pointerbuf.hpp>
 #include <boost/lexical_cast.hpp>
 #include <gtest/gtest_prod.h>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -48,6 +51,7 @@
 #include "task/task.h"
 #include "task/task_tracker.h"
 #include "utils/error_code.h"
+#include "utils/metrics.h"
 #include "utils/zlocks.h"
 
 namespace dsn {
@@ -370,6 +374,18 @@ private:
                                            std::string &hint_message) const;
     bool validate_target_max_replica_count(int32_t max_replica_count) const;
 
+    // Build the configs of the app for the client queries, which should be called with `_lock`
+    // held.
+    std::shared_ptr<query_cfg_response> build_app_config(const std::string &app_name) const;
+
+    // Get the snapshot of the configs of the app which is not older than
+    // `max_client_config_snapshot_staleness_ms`, or nullptr if not found.
+    std::shared_ptr<const query_cfg_response>
+    get_app_config_snapshot(const std::string &app_name) const;
+    void update_app_config_snapshot(const std::string &app_name,
+                                    const std::shared_ptr<const query_cfg_response> &app_config,
+                                    uint64_t build_time_ms);
+
     template <typename Response>
     std::shared_ptr<app_state> get_app_and_check_exist(const std::string &app_name,
                                                        Response &response) const;
@@ -469,6 +485,27 @@ private:
     app_env_validator _app_env_validator;
 
     table_metric_entities _table_metric_entities;
+
+    // The snapshots of the configs of the apps queried by the clients. They are published by
+    // the queries holding `_lock` and served while `_lock` is held by a writer, thus the client
+    // queries would not be blocked by the writers such as the balancer and the DDL. The
+    // snapshots are sharded by the app names to reduce the contention among the readers.
+    struct app_config_snapshot
+    {
+        std::shared_ptr<const query_cfg_response> app_config;
+        uint64_t build_time_ms{0};
+    };
+    struct app_config_snapshot_shard
+    {
+        mutable zlock lock;
+        std::unordered_map<std::string, app_config_snapshot> snapshots;
+    };
+    static constexpr size_t kAppConfigSnapshotShardCount = 16;
+    std::array<app_config_snapshot_shard, kAppConfigSnapshotShardCount> _app_config_snapshot_shards;
+
+    METRIC_VAR_DECLARE_counter(config_sync_sent_partitions);
+    METRIC_VAR_DECLARE_counter(config_sync_unchanged_partitions);
+    METRIC_VAR_DECLARE_counter(client_config_queries_served_by_snapshot);
 };
 
 } // namespace replication
@@ -24,17 +24,23 @@
  * THE SOFTWARE.
  */
 
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
 #include <utility>
 
+#include "common/gpid.h"
 #include "common/replica_envs.h"
+#include "common/replication.codes.h"
 #include "gtest/gtest.h"
 #include "meta/meta_data.h"
+#include "meta/meta_rpc_types.h"
+#include "meta/server_state.h"
 #include "meta_admin_types.h"
 #include "meta_test_base.h"
+#include "rpc/rpc_host_port.h"
 #include "utils/error_code.h"
 #include "utils/test_macros.h"
 
@@ -154,6 +160,42 @@ TEST_F(meta_app_envs_test, update_app_envs_test)
          "invalid value '636870912', should be 'In range [16777216, 536870912]'",
          "536870912"},
         {replica_envs::ROCKSDB_WRITE_BUFFER_SIZE, "67108864", ERR_OK, "", "67108864"},
+        {replica_envs::ROCKSDB_ENABLE_BLOB_FILES,
+         "yes",
+         ERR_INVALID_PARAMETERS,
+         "invalid value 'yes', should be a boolean",
+         ""},
+        {replica_envs::ROCKSDB_ENABLE_BLOB_FILES, "true", ERR_OK, "", "true"},
+        {replica_envs::ROCKSDB_MIN_BLOB_SIZE,
+         "-1",
+         ERR_INVALID_PARAMETERS,
+         "invalid value '-1', should be '>= 0'",
+         ""},
+        {replica_envs::ROCKSDB_MIN_BLOB_SIZE, "4096", ERR_OK, "", "4096"},
+        {replica_envs::ROCKSDB_BLOB_FILE_SIZE,
+         "1024",
+         ERR_INVALID_PARAMETERS,
+         "invalid value '1024', should be 'In range [1048576, 1073741824]'",
+         ""},
+        {replica_envs::ROCKSDB_BLOB_FILE_SIZE, "268435456", ERR_OK, "", "268435456"},
+        {replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE,
+         "gzip",
+         ERR_INVALID_PARAMETERS,
+         "lz4 | none | snappy | zstd",
+         ""},
+        {replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE, "zstd", ERR_OK, "", "zstd"},
+        {replica_envs::ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION, "true", ERR_OK, "", "true"},
+        {replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF,
+         "1.5",
+         ERR_INVALID_PARAMETERS,
+         "invalid value '1.5', should be 'In range [0.0, 1.0]'",
+         ""},
+        {replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF, "0.5", ERR_OK, "", "0.5"},
+        {replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_FORCE_THRESHOLD,
+         "0.8",
+         ERR_OK,
+         "",
+         "0.8"},
         {replica_envs::MANUAL_COMPACT_PERIODIC_BOTTOMMOST_LEVEL_COMPACTION,
          replica_envs::MANUAL_COMPACT_BOTTOMMOST_LEVEL_COMPACTION_SKIP,
          ERR_OK,
@@ -219,4 +261,72 @@ TEST_F(meta_app_envs_test, update_app_envs_test)
     }
 }
 
+TEST_F(meta_app_envs_test, config_sync_by_digest)
+{
+    const host_port node_hp("localhost", 10086);
+    auto app = find_app(app_name);
+    node_state node;
+    node.put_partition(gpid(app->app_id, 0), true);
+    node.put_partition(gpid(app->app_id, 1), false);
+    mock_node_state(node_hp, node);
+
+    auto config_sync = [&](const configuration_query_by_node_request &req) {
+        configuration_query_by_node_rpc rpc(
+            std::make_unique<configuration_query_by_node_request>(req), RPC_CM_CONFIG_SYNC);
+        _ss->on_config_sync(rpc);
+        wait_all();
+        return rpc.response();
+    };
+
+    configuration_query_by_node_request req;
+    SET_IP_AND_HOST_PORT_BY_DNS(req, node, node_hp);
+
+    // Full config sync without the digests.
+    auto resp = config_sync(req);
+    ASSERT_EQ(ERR_OK, resp.err);
+    ASSERT_EQ(2u, resp.partitions.size());
+    ASSERT_FALSE(resp.__isset.digests);
+    ASSERT_FALSE(resp.__isset.unchanged_partitions);
+
+    // All the configs with the digests are sent for the first time.
+    req.__isset.synced_digests = true;
+    resp = config_sync(req);
+    ASSERT_EQ(ERR_OK, resp.err);
+    ASSERT_EQ(2u, resp.partitions.size());
+    ASSERT_EQ(2u, resp.digests.size());
+    ASSERT_TRUE(resp.unchanged_partitions.empty());
+    for (size_t i = 0; i < resp.partitions.size(); ++i) {
+        ASSERT_EQ(resp.partitions[i].config.pid, resp.digests[i].pid);
+    }
+    ASSERT_NE(resp.digests[0].digest, resp.digests[1].digest);
+
+    // The unchanged configs are not sent again.
+    req.synced_digests = resp.digests;
+    resp = config_sync(req);
+    ASSERT_EQ(ERR_OK, resp.err);
+    ASSERT_TRUE(resp.partitions.empty());
+    ASSERT_EQ(2u, resp.unchanged_partitions.size());
+
+    // Only the changed configs are sent.
+    req.synced_digests[0].digest = 0;
+    resp = config_sync(req);
+    ASSERT_EQ(1u, resp.partitions.size());
+    ASSERT_EQ(req.synced_digests[0].pid, resp.partitions[0].config.pid);
+    ASSERT_EQ(1u, resp.unchanged_partitions.size());
+    ASSERT_EQ(req.synced_digests[1].pid, resp.unchanged_partitions[0]);
+    req.synced_digests[0].digest = resp.digests[0].digest;
+
+    // All the partitions are sent once the envs of the app are changed.
+    ASSERT_EQ(ERR_OK,
+              update_app_envs(app_name, {replica_envs::WRITE_QPS_THROTTLING}, {"100*delay*100"})
+                  .err);
+    resp = config_sync(req);
+    ASSERT_EQ(2u, resp.partitions.size());
+    ASSERT_TRUE(resp.unchanged_partitions.empty());
+    ASSERT_EQ("100*delay*100", resp.partitions[0].info.envs[replica_envs::WRITE_QPS_THROTTLING]);
+    for (size_t i = 0; i < resp.digests.size(); ++i) {
+        ASSERT_NE(req.synced_digests[i].digest, resp.digests[i].digest);
+    }
+}
+
 } // namespace dsn::replication
@@ -18,12 +18,15 @@
 #include <fmt/core.h>
 #include <cstdint>
 #include <algorithm>
+#include <chrono>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -47,15 +50,18 @@
 #include "rpc/rpc_host_port.h"
 #include "rpc/rpc_message.h"
 #include "task/task_tracker.h"
+#include "test_util/test_util.h"
 #include "utils/defer.h"
 #include "utils/error_code.h"
 #include "utils/errors.h"
 #include "utils/flags.h"
 #include "utils/fmt_logging.h"
+#include "utils/zlocks.h"
 
 DSN_DECLARE_int32(max_allowed_replica_count);
 DSN_DECLARE_int32(min_allowed_replica_count);
 DSN_DECLARE_uint64(min_live_node_count_for_unfreeze);
+DSN_DECLARE_uint32(max_client_config_snapshot_staleness_ms);
 
 namespace dsn {
 class blob;
@@ -140,6 +146,18 @@ public:
 
     void clear_nodes() { _ss->_nodes.clear(); }
 
+    bool has_app_config_snapshot(const std::string &app_name) const
+    {
+        return _ss->get_app_config_snapshot(app_name) != nullptr;
+    }
+
+    // Run `func` while the state is locked by a writer.
+    void run_while_state_write_locked(const std::function<void()> &func)
+    {
+        zauto_write_lock l(_ss->_lock);
+        func();
+    }
+
     configuration_get_max_replica_count_response get_max_replica_count(const std::string &app_name)
     {
         auto req = std::make_unique<configuration_get_max_replica_count_request>();
@@ -901,6 +919,53 @@ TEST_F(meta_app_operation_test, drop_app)
     }
 }
 
+TEST_F(meta_app_operation_test, query_config_while_state_updating)
+{
+    const int32_t partition_count = 4;
+    create_app(APP_NAME, partition_count);
+
+    const auto query_config = [this]() {
+        query_cfg_request request;
+        request.app_name = APP_NAME;
+        query_cfg_response response;
+        _ss->query_configuration_by_index(request, response);
+        return response;
+    };
+
+    // The snapshot of the app is published by the query.
+    auto response = query_config();
+    ASSERT_EQ(ERR_OK, response.err);
+    ASSERT_EQ(partition_count, response.partition_count);
+    ASSERT_TRUE(has_app_config_snapshot(APP_NAME));
+
+    // The query is served by the snapshot rather than blocked while the state is being
+    // updated by a writer.
+    std::future<query_cfg_response> result;
+    run_while_state_write_locked([&result, &query_config]() {
+        result = std::async(std::launch::async, query_config);
+        ASSERT_EQ(std::future_status::ready, result.wait_for(std::chrono::seconds(10)));
+    });
+    response = result.get();
+    ASSERT_EQ(ERR_OK, response.err);
+    ASSERT_EQ(partition_count, response.partition_count);
+    ASSERT_EQ(partition_count, static_cast<int32_t>(response.partitions.size()));
+
+    // The outdated snapshot is not served.
+    {
+        PRESERVE_FLAG(max_client_config_snapshot_staleness_ms);
+        FLAGS_max_client_config_snapshot_staleness_ms = 1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ASSERT_FALSE(has_app_config_snapshot(APP_NAME));
+    }
+    ASSERT_TRUE(has_app_config_snapshot(APP_NAME));
+
+    // The snapshot is removed once the app becomes unavailable.
+    update_app_status(app_status::AS_DROPPING);
+    ASSERT_EQ(ERR_BUSY_DROPPING, query_config().err);
+    ASSERT_FALSE(has_app_config_snapshot(APP_NAME));
+    update_app_status(app_status::AS_AVAILABLE);
+}
+
 TEST_F(meta_app_operation_test, recall_app)
 {
     create_app(OLD_APP_NAME);
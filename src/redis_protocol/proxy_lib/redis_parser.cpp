@@ -33,6 +33,7 @@
 #include <cstdint>
 #include <string_view>
 
+#include "client/partition_resolver.h"
 #include "common/common.h"
 #include "common/replication_other_types.h"
 #include "pegasus/client.h"
@@ -43,12 +44,26 @@
 #include "utils/api_utilities.h"
 #include "utils/binary_writer.h"
 #include "utils/error_code.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/ports.h"
 #include "utils/string_conv.h"
 #include "utils/strings.h"
 #include "utils/utils.h"
 
+// MIGRATION ATTENTION:
+// The proxy used to route all the requests of the plain key-value commands to partition 0 of
+// the table, thus the data written by an old proxy could only be read with this flag false. To
+// enable it on a table with more than one partition, migrate the data to the partitions of
+// their keys first, e.g. copy the data of partition 0 into a new table by the shell command
+// `copy_data`, which writes each key into its own partition, and then switch the proxies to
+// the new table with this flag true.
+DSN_DEFINE_bool(pegasus.proxy,
+                route_by_key_hash,
+                false,
+                "Whether to route the requests to the partitions of their keys, rather than to "
+                "partition 0 of the table as the legacy proxy did");
+
 namespace pegasus {
 namespace proxy {
 
@@ -72,6 +87,14 @@ std::unordered_map<std::string, redis_parser::redis_call_handler> redis_parser::
     {"INCRBY", redis_parser::g_incr_by},
     {"DECR", redis_parser::g_decr},
     {"DECRBY", redis_parser::g_decr_by},
+    {"MGET", redis_parser::g_mget},
+    {"MSET", redis_parser::g_mset},
+    {"HGET", redis_parser::g_hget},
+    {"HSET", redis_parser::g_hset},
+    {"HMSET", redis_parser::g_hset},
+    {"HMGET", redis_parser::g_hmget},
+    {"HGETALL", redis_parser::g_hgetall},
+    {"HDEL", redis_parser::g_hdel},
 };
 
 redis_parser::redis_call_handler redis_parser::get_handler(const char *command, unsigned int length)
@@ -416,6 +439,15 @@ void redis_parser::simple_integer_reply(message_entry &entry, int64_t value)
     reply_message(entry, redis_integer(value));
 }
 
+void redis_parser::reply_array(message_entry &entry,
+                               std::vector<std::shared_ptr<redis_base_type>> &&elems)
+{
+    redis_array result;
+    result.count = elems.size();
+    result.array = std::move(elems);
+    reply_message(entry, result);
+}
+
 void redis_parser::default_handler(redis_parser::message_entry &entry)
 {
     ::dsn::blob &cmd = entry.request.sub_requests[0].data;
@@ -489,7 +521,11 @@ void redis_parser::set_internal(redis_parser::message_entry &entry)
             req.expire_ts_seconds = ttl_seconds + utils::epoch_now();
         auto partition_hash = pegasus_key_hash(req.key);
         // TODO: set the timeout
-        client->put(req, on_set_reply, std::chrono::milliseconds(2000), 0, partition_hash);
+        client->put(req,
+                    on_set_reply,
+                    std::chrono::milliseconds(2000),
+                    get_request_partition_hash(partition_hash),
+                    partition_hash);
     }
 }
 
@@ -588,7 +624,11 @@ void redis_parser::setex(message_entry &entry)
         auto partition_hash = pegasus_key_hash(req.key);
 
         // TODO: set the timeout
-        client->put(req, on_setex_reply, std::chrono::milliseconds(2000), 0, partition_hash);
+        client->put(req,
+                    on_setex_reply,
+                    std::chrono::milliseconds(2000),
+                    get_request_partition_hash(partition_hash),
+                    partition_hash);
     }
 }
 
@@ -634,7 +674,11 @@ void redis_parser::get(message_entry &entry)
         pegasus_generate_key(req, redis_req.sub_requests[1].data, null_blob);
         auto partition_hash = pegasus_key_hash(req);
         // TODO: set the timeout
-        client->get(req, on_get_reply, std::chrono::milliseconds(2000), 0, partition_hash);
+        client->get(req,
+                    on_get_reply,
+                    std::chrono::milliseconds(2000),
+                    get_request_partition_hash(partition_hash),
+                    partition_hash);
     }
 }
 
@@ -691,7 +735,11 @@ void redis_parser::del_internal(message_entry &entry)
         pegasus_generate_key(req, redis_req.sub_requests[1].data, null_blob);
         auto partition_hash = pegasus_key_hash(req);
         // TODO: set the timeout
-        client->remove(req, on_del_reply, std::chrono::milliseconds(2000), 0, partition_hash);
+        client->remove(req,
+                       on_del_reply,
+                       std::chrono::milliseconds(2000),
+                       get_request_partition_hash(partition_hash),
+                       partition_hash);
     }
 }
 
@@ -778,7 +826,11 @@ void redis_parser::ttl(message_entry &entry)
         pegasus_generate_key(req, redis_req.sub_requests[1].data, null_blob);
         auto partition_hash = pegasus_key_hash(req);
         // TODO: set the timeout
-        client->ttl(req, on_ttl_reply, std::chrono::milliseconds(2000), 0, partition_hash);
+        client->ttl(req,
+                    on_ttl_reply,
+                    std::chrono::milliseconds(2000),
+                    get_request_partition_hash(partition_hash),
+                    partition_hash);
     }
 }
 
@@ -975,7 +1027,530 @@ void redis_parser::counter_internal(message_entry &entry)
     dsn::apps::incr_request req;
     pegasus_generate_key(req.key, entry.request.sub_requests[1].data, dsn::blob());
     req.increment = increment;
-    client->incr(req, on_incr_reply, std::chrono::milliseconds(2000), 0, pegasus_key_hash(req.key));
+    const auto partition_hash = pegasus_key_hash(req.key);
+    client->incr(req,
+                 on_incr_reply,
+                 std::chrono::milliseconds(2000),
+                 get_request_partition_hash(partition_hash),
+                 partition_hash);
+}
+
+/*static*/ uint64_t redis_parser::get_request_partition_hash(uint64_t key_hash)
+{
+    return FLAGS_route_by_key_hash ? key_hash : 0;
+}
+
+std::vector<redis_parser::partition_batch>
+redis_parser::group_keys_by_partition(const std::vector<dsn::blob> &keys, int partition_count)
+{
+    std::vector<partition_batch> batches;
+    std::unordered_map<uint64_t, size_t> batch_indexes;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const auto partition_hash = get_request_partition_hash(pegasus_key_hash(keys[i]));
+        const uint64_t group =
+            partition_count > 0 ? dsn::replication::partition_resolver::get_partition_index(
+                                      partition_count, partition_hash)
+                                : partition_hash;
+        const auto iter = batch_indexes.emplace(group, batches.size()).first;
+        if (iter->second == batches.size()) {
+            batches.emplace_back();
+            batches.back().partition_hash = partition_hash;
+        }
+        batches[iter->second].key_indexes.push_back(i);
+    }
+    return batches;
+}
+
+// origin command format:
+// MGET key [key ...]
+// NOTE: the keys are grouped by partition, and only one BATCH_GET request is sent to each
+// partition.
+void redis_parser::mget(message_entry &entry)
+{
+    redis_request &redis_req = entry.request;
+    if (redis_req.sub_requests.size() < 2) {
+        LOG_INFO_PREFIX("MGET command seqid({}) with invalid arguments", entry.sequence_id);
+        simple_error_reply(entry, "wrong number of arguments for 'mget' command");
+        return;
+    }
+
+    // The results are merged into the context shared by the requests of all the partitions,
+    // each of which only fills the results of its own keys, and the last one replies.
+    struct mget_context
+    {
+        std::vector<dsn::blob> keys;
+        std::vector<std::shared_ptr<redis_base_type>> results;
+        std::atomic<size_t> pending_count{0};
+        dsn::zlock lock;
+        std::string error_message;
+    };
+    auto context = std::make_shared<mget_context>();
+    context->keys.resize(redis_req.sub_requests.size() - 1);
+    context->results.resize(context->keys.size());
+    for (size_t i = 0; i < context->keys.size(); ++i) {
+        pegasus_generate_key(context->keys[i], redis_req.sub_requests[i + 1].data, dsn::blob());
+    }
+
+    auto batches = group_keys_by_partition(context->keys, client->get_partition_count());
+    context->pending_count.store(batches.size());
+    LOG_DEBUG_PREFIX("send MGET command seqid({}) with {} keys to {} partitions",
+                     entry.sequence_id,
+                     context->keys.size(),
+                     batches.size());
+
+    std::shared_ptr<proxy_session> ref_this = shared_from_this();
+    for (auto &batch : batches) {
+        ::dsn::apps::batch_get_request req;
+        for (const auto index : batch.key_indexes) {
+            ::dsn::apps::full_key key;
+            key.hash_key = redis_req.sub_requests[index + 1].data;
+            req.keys.emplace_back(std::move(key));
+        }
+
+        auto on_batch_get_reply = [ref_this,
+                                   this,
+                                   &entry,
+                                   context,
+                                   key_indexes = std::move(batch.key_indexes)](
+                                      ::dsn::error_code ec,
+                                      dsn::message_ex *,
+                                      dsn::message_ex *response) {
+            if (::dsn::ERR_OK != ec) {
+                LOG_INFO_PREFIX(
+                    "MGET command seqid({}) got reply with error = {}", entry.sequence_id, ec);
+                dsn::zauto_lock l(context->lock);
+                context->error_message = ec.to_string();
+            } else {
+                ::dsn::apps::batch_get_response rrdb_response;
+                ::dsn::unmarshall(response, rrdb_response);
+                if (rrdb_response.error != 0) {
+                    dsn::zauto_lock l(context->lock);
+                    context->error_message =
+                        "internal error " + std::to_string(rrdb_response.error);
+                } else {
+                    // The found keys are returned in the same order as they are requested.
+                    size_t j = 0;
+                    for (const auto index : key_indexes) {
+                        const auto &key = entry.request.sub_requests[index + 1].data;
+                        if (j < rrdb_response.data.size() &&
+                            rrdb_response.data[j].hash_key.to_string_view() ==
+                                key.to_string_view()) {
+                            context->results[index] =
+                                std::make_shared<redis_bulk_string>(rrdb_response.data[j].value);
+                            ++j;
+                        } else {
+                            context->results[index] = std::make_shared<redis_bulk_string>();
+                        }
+                    }
+                }
+            }
+
+            if (context->pending_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+
+            if (_is_session_reset.load(std::memory_order_acquire)) {
+                LOG_INFO_PREFIX("MGET command seqid({}) got reply, but session has reset",
+                                entry.sequence_id);
+                return;
+            }
+
+            if (!context->error_message.empty()) {
+                simple_error_reply(entry, context->error_message);
+            } else {
+                reply_array(entry, std::move(context->results));
+            }
+        };
+        // TODO: set the timeout
+        client->batch_get(
+            req, on_batch_get_reply, std::chrono::milliseconds(2000), batch.partition_hash);
+    }
+}
+
+// origin command format:
+// MSET key value [key value ...]
+// NOTE: each key is a different hash key in Pegasus, thus the keys are written by the PUT
+// requests issued at once rather than atomically, and OK is replied only if all of them succeed.
+void redis_parser::mset(message_entry &entry)
+{
+    if (_geo_client != nullptr) {
+        return simple_error_reply(entry, "MSET is not supported on GEO mode");
+    }
+    redis_request &redis_req = entry.request;
+    if (redis_req.sub_requests.size() < 3 || redis_req.sub_requests.size() % 2 != 1) {
+        LOG_INFO_PREFIX("MSET command seqid({}) with invalid arguments", entry.sequence_id);
+        simple_error_reply(entry, "wrong number of arguments for 'mset' command");
+        return;
+    }
+
+    struct mset_context
+    {
+        std::atomic<size_t> pending_count{0};
+        dsn::zlock lock;
+        std::string error_message;
+    };
+    auto context = std::make_shared<mset_context>();
+    const size_t kv_count = (redis_req.sub_requests.size() - 1) / 2;
+    context->pending_count.store(kv_count);
+    LOG_DEBUG_PREFIX("send MSET command seqid({}) with {} keys", entry.sequence_id, kv_count);
+
+    std::shared_ptr<proxy_session> ref_this = shared_from_this();
+    auto on_set_reply = [ref_this, this, &entry, context](
+                            ::dsn::error_code ec, dsn::message_ex *, dsn::message_ex *response) {
+        if (::dsn::ERR_OK != ec) {
+            LOG_INFO_PREFIX(
+                "MSET command seqid({}) got reply with error = {}", entry.sequence_id, ec);
+            dsn::zauto_lock l(context->lock);
+            context->error_message = ec.to_string();
+        } else {
+            ::dsn::apps::update_response rrdb_response;
+            ::dsn::unmarshall(response, rrdb_response);
+            if (rrdb_response.error != 0) {
+                dsn::zauto_lock l(context->lock);
+                context->error_message = "internal error " + std::to_string(rrdb_response.error);
+            }
+        }
+
+        if (context->pending_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        if (_is_session_reset.load(std::memory_order_acquire)) {
+            LOG_INFO_PREFIX("MSET command seqid({}) got reply, but session has reset",
+                            entry.sequence_id);
+            return;
+        }
+
+        if (!context->error_message.empty()) {
+            simple_error_reply(entry, context->error_message);
+        } else {
+            simple_ok_reply(entry);
+        }
+    };
+
+    for (size_t i = 1; i < redis_req.sub_requests.size(); i += 2) {
+        ::dsn::apps::update_request req;
+        pegasus_generate_key(req.key, redis_req.sub_requests[i].data, dsn::blob());
+        req.value = redis_req.sub_requests[i + 1].data;
+        req.expire_ts_seconds = 0;
+        // TODO: set the timeout
+        const auto partition_hash = pegasus_key_hash(req.key);
+        client->put(req,
+                    on_set_reply,
+                    std::chrono::milliseconds(2000),
+                    get_request_partition_hash(partition_hash),
+                    partition_hash);
+    }
+}
+
+// origin command format:
+// HGET key field
+// NOTE: the key is mapped to the hash key, and the field is mapped to the sort key.
+void redis_parser::hget(message_entry &entry)
+{
+    redis_request &redis_req = entry.request;
+    if (redis_req.sub_requests.size() != 3) {
+        LOG_INFO_PREFIX("HGET command seqid({}) with invalid arguments", entry.sequence_id);
+        simple_error_reply(entry, "wrong number of arguments for 'hget' command");
+        return;
+    }
+
+    LOG_DEBUG_PREFIX("send HGET command seqid({})", entry.sequence_id);
+    std::shared_ptr<proxy_session> ref_this = shared_from_this();
+    auto on_get_reply = [ref_this, this, &entry](
+                            ::dsn::error_code ec, dsn::message_ex *, dsn::message_ex *response) {
+        if (_is_session_reset.load(std::memory_order_acquire)) {
+            LOG_INFO_PREFIX("HGET command seqid({}) got reply, but session has reset",
+                            entry.sequence_id);
+            return;
+        }
+
+        if (::dsn::ERR_OK != ec) {
+            LOG_INFO_PREFIX(
+                "HGET command seqid({}) got reply with error = {}", entry.sequence_id, ec);
+            simple_error_reply(entry, ec.to_string());
+            return;
+        }
+
+        ::dsn::apps::read_response rrdb_response;
+        ::dsn::unmarshall(response, rrdb_response);
+        if (rrdb_response.error == rocksdb::Status::kNotFound) {
+            reply_message(entry, redis_bulk_string());
+        } else if (rrdb_response.error != 0) {
+            simple_error_reply(entry, "internal error " + std::to_string(rrdb_response.error));
+        } else {
+            reply_message(entry, redis_bulk_string(rrdb_response.value));
+        }
+    };
+    ::dsn::blob req;
+    pegasus_generate_key(req, redis_req.sub_requests[1].data, redis_req.sub_requests[2].data);
+    // TODO: set the timeout
+    const auto partition_hash = pegasus_key_hash(req);
+    client->get(req,
+                on_get_reply,
+                std::chrono::milliseconds(2000),
+                get_request_partition_hash(partition_hash),
+                partition_hash);
+}
+
+// origin command format:
+// HSET key field value [field value ...]
+// NOTE: all the fields are written by one MULTI_PUT request. Like DEL, the count of the written
+// fields is returned rather than the count of the newly added ones, since checking the existence
+// would need an extra read.
+void redis_parser::hset(message_entry &entry)
+{
+    if (_geo_client != nullptr) {
+        return simple_error_reply(entry, "HSET is not supported on GEO mode");
+    }
+    redis_request &redis_req = entry.request;
+    if (redis_req.sub_requests.size() < 4 || redis_req.sub_requests.size() % 2 != 0) {
+        LOG_INFO_PREFIX("HSET command seqid({}) with invalid arguments", entry.sequence_id);
+        simple_error_reply(entry, "wrong number of arguments for 'hset' command");
+        return;
+    }
+
+    ::dsn::apps::multi_put_request req;
+    req.hash_key = redis_req.sub_requests[1].data;
+    req.expire_ts_seconds = 0;
+    for (size_t i = 2; i < redis_req.sub_requests.size(); i += 2) {
+        ::dsn::apps::key_value kv;
+        kv.key = redis_req.sub_requests[i].data;
+        kv.value = redis_req.sub_requests[i + 1].data;
+        req.kvs.emplace_back(std::move(kv));
+    }
+
+    LOG_DEBUG_PREFIX("send HSET command seqid({})", entry.sequence_id);
+    std::shared_ptr<proxy_session> ref_this = shared_from_this();
+    const auto &command = redis_req.sub_requests[0].data;
+    const bool is_hmset =
+        command.length() == 5 && dsn::utils::iequals(command.data(), "HMSET", command.length());
+    auto on_multi_put_reply = [ref_this, this, &entry, is_hmset, count = req.kvs.size()](
+                                  ::dsn::error_code ec,
+                                  dsn::message_ex *,
+                                  dsn::message_ex *response) {
+        if (_is_session_reset.load(std::memory_order_acquire)) {
+            LOG_INFO_PREFIX("HSET command seqid({}) got reply, but session has reset",
+                            entry.sequence_id);
+            return;
+        }
+
+        if (::dsn::ERR_OK != ec) {
+            LOG_INFO_PREFIX(
+                "HSET command seqid({}) got reply with error = {}", entry.sequence_id, ec);
+            simple_error_reply(entry, ec.to_string());
+            return;
+        }
+
+        ::dsn::apps::update_response rrdb_response;
+        ::dsn::unmarshall(response, rrdb_response);
+        if (rrdb_response.error != 0) {
+            simple_error_reply(entry, "internal error " + std::to_string(rrdb_response.error));
+        } else if (is_hmset) {
+            simple_ok_reply(entry);
+        } else {
+            simple_integer_reply(entry, count);
+        }
+    };
+    // TODO: set the timeout
+    client->multi_put(req,
+                      on_multi_put_reply,
+                      std::chrono::milliseconds(2000),
+                      get_request_partition_hash(pegasus_hash_key_hash(req.hash_key)));
+}
+
+// origin command format:
+// HMGET key field [field ...]
+// NOTE: all the fields are read by one MULTI_GET request.
+void redis_parser::hmget(message_entry &entry)
+{
+    redis_request &redis_req = entry.request;
+    if (redis_req.sub_requests.size() < 3) {
+        LOG_INFO_PREFIX("HMGET command seqid({}) with invalid arguments", entry.sequence_id);
+        simple_error_reply(entry, "wrong number of arguments for 'hmget' command");
+        return;
+    }
+
+    ::dsn::apps::multi_get_request req;
+    req.hash_key = redis_req.sub_requests[1].data;
+    for (size_t i = 2; i < redis_req.sub_requests.size(); ++i) {
+        req.sort_keys.emplace_back(redis_req.sub_requests[i].data);
+    }
+    req.max_kv_count = -1;
+    req.max_kv_size = -1;
+    req.no_value = false;
+
+    LOG_DEBUG_PREFIX("send HMGET command seqid({})", entry.sequence_id);
+    std::shared_ptr<proxy_session> ref_this = shared_from_this();
+    auto on_multi_get_reply = [ref_this, this, &entry](
+                                  ::dsn::error_code ec,
+                                  dsn::message_ex *,
+                                  dsn::message_ex *response) {
+        if (_is_session_reset.load(std::memory_order_acquire)) {
+            LOG_INFO_PREFIX("HMGET command seqid({}) got reply, but session has reset",
+                            entry.sequence_id);
+            return;
+        }
+
+        if (::dsn::ERR_OK != ec) {
+            LOG_INFO_PREFIX(
+                "HMGET command seqid({}) got reply with error = {}", entry.sequence_id, ec);
+            simple_error_reply(entry, ec.to_string());
+            return;
+        }
+
+        ::dsn::apps::multi_get_response rrdb_response;
+        ::dsn::unmarshall(response, rrdb_response);
+        if (rrdb_response.error != 0) {
+            simple_error_reply(entry, "internal error " + std::to_string(rrdb_response.error));
+            return;
+        }
+
+        // The found fields are returned ordered by the sort key, reply them in the requested
+        // order, and nil for the ones not found.
+        std::unordered_map<std::string_view, const dsn::blob *> values;
+        for (const auto &kv : rrdb_response.kvs) {
+            values.emplace(kv.key.to_string_view(), &kv.value);
+        }
+        std::vector<std::shared_ptr<redis_base_type>> results;
+        results.reserve(entry.request.sub_requests.size() - 2);
+        for (size_t i = 2; i < entry.request.sub_requests.size(); ++i) {
+            const auto iter = values.find(entry.request.sub_requests[i].data.to_string_view());
+            if (iter == values.end()) {
+                results.emplace_back(std::make_shared<redis_bulk_string>());
+            } else {
+                results.emplace_back(std::make_shared<redis_bulk_string>(*iter->second));
+            }
+        }
+        reply_array(entry, std::move(results));
+    };
+    // TODO: set the timeout
+    client->multi_get(req,
+                      on_multi_get_reply,
+                      std::chrono::milliseconds(2000),
+                      get_request_partition_hash(pegasus_hash_key_hash(req.hash_key)));
+}
+
+// origin command format:
+// HGETALL key
+// NOTE: all the fields are read by one MULTI_GET request. If the hash key holds more data than
+// the replica server allows to return at once, an error is replied rather than partial fields.
+void redis_parser::hgetall(message_entry &entry)
+{
+    redis_request &redis_req = entry.request;
+    if (redis_req.sub_requests.size() != 2) {
+        LOG_INFO_PREFIX("HGETALL command seqid({}) with invalid arguments", entry.sequence_id);
+        simple_error_reply(entry, "wrong number of arguments for 'hgetall' command");
+        return;
+    }
+
+    ::dsn::apps::multi_get_request req;
+    req.hash_key = redis_req.sub_requests[1].data;
+    req.max_kv_count = -1;
+    req.max_kv_size = -1;
+    req.no_value = false;
+    req.start_inclusive = true;
+    req.stop_inclusive = false;
+    req.sort_key_filter_type = ::dsn::apps::filter_type::FT_NO_FILTER;
+
+    LOG_DEBUG_PREFIX("send HGETALL command seqid({})", entry.sequence_id);
+    std::shared_ptr<proxy_session> ref_this = shared_from_this();
+    auto on_multi_get_reply = [ref_this, this, &entry](
+                                  ::dsn::error_code ec,
+                                  dsn::message_ex *,
+                                  dsn::message_ex *response) {
+        if (_is_session_reset.load(std::memory_order_acquire)) {
+            LOG_INFO_PREFIX("HGETALL command seqid({}) got reply, but session has reset",
+                            entry.sequence_id);
+            return;
+        }
+
+        if (::dsn::ERR_OK != ec) {
+            LOG_INFO_PREFIX(
+                "HGETALL command seqid({}) got reply with error = {}", entry.sequence_id, ec);
+            simple_error_reply(entry, ec.to_string());
+            return;
+        }
+
+        ::dsn::apps::multi_get_response rrdb_response;
+        ::dsn::unmarshall(response, rrdb_response);
+        if (rrdb_response.error == rocksdb::Status::kIncomplete) {
+            simple_error_reply(entry, "too many fields to return, use HMGET instead");
+            return;
+        }
+        if (rrdb_response.error != 0) {
+            simple_error_reply(entry, "internal error " + std::to_string(rrdb_response.error));
+            return;
+        }
+
+        std::vector<std::shared_ptr<redis_base_type>> results;
+        results.reserve(rrdb_response.kvs.size() * 2);
+        for (const auto &kv : rrdb_response.kvs) {
+            results.emplace_back(std::make_shared<redis_bulk_string>(kv.key));
+            results.emplace_back(std::make_shared<redis_bulk_string>(kv.value));
+        }
+        reply_array(entry, std::move(results));
+    };
+    // TODO: set the timeout
+    client->multi_get(req,
+                      on_multi_get_reply,
+                      std::chrono::milliseconds(2000),
+                      get_request_partition_hash(pegasus_hash_key_hash(req.hash_key)));
+}
+
+// origin command format:
+// HDEL key field [field ...]
+// NOTE: all the fields are removed by one MULTI_REMOVE request.
+void redis_parser::hdel(message_entry &entry)
+{
+    if (_geo_client != nullptr) {
+        return simple_error_reply(entry, "HDEL is not supported on GEO mode");
+    }
+    redis_request &redis_req = entry.request;
+    if (redis_req.sub_requests.size() < 3) {
+        LOG_INFO_PREFIX("HDEL command seqid({}) with invalid arguments", entry.sequence_id);
+        simple_error_reply(entry, "wrong number of arguments for 'hdel' command");
+        return;
+    }
+
+    ::dsn::apps::multi_remove_request req;
+    req.hash_key = redis_req.sub_requests[1].data;
+    for (size_t i = 2; i < redis_req.sub_requests.size(); ++i) {
+        req.sort_keys.emplace_back(redis_req.sub_requests[i].data);
+    }
+
+    LOG_DEBUG_PREFIX("send HDEL command seqid({})", entry.sequence_id);
+    std::shared_ptr<proxy_session> ref_this = shared_from_this();
+    auto on_multi_remove_reply = [ref_this, this, &entry](
+                                     ::dsn::error_code ec,
+                                     dsn::message_ex *,
+                                     dsn::message_ex *response) {
+        if (_is_session_reset.load(std::memory_order_acquire)) {
+            LOG_INFO_PREFIX("HDEL command seqid({}) got reply, but session has reset",
+                            entry.sequence_id);
+            return;
+        }
+
+        if (::dsn::ERR_OK != ec) {
+            LOG_INFO_PREFIX(
+                "HDEL command seqid({}) got reply with error = {}", entry.sequence_id, ec);
+            simple_error_reply(entry, ec.to_string());
+            return;
+        }
+
+        ::dsn::apps::multi_remove_response rrdb_response;
+        ::dsn::unmarshall(response, rrdb_response);
+        if (rrdb_response.error != 0) {
+            simple_error_reply(entry, "internal error " + std::to_string(rrdb_response.error));
+        } else {
+            simple_integer_reply(entry, rrdb_response.count);
+        }
+    };
+    // TODO: set the timeout
+    client->multi_remove(req,
+                         on_multi_remove_reply,
+                         std::chrono::milliseconds(2000),
+                         get_request_partition_hash(pegasus_hash_key_hash(req.hash_key)));
 }
 
 void redis_parser::parse_set_parameters(const std::vector<redis_bulk_string> &opts,
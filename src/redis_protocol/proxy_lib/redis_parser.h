@@ -201,6 +201,13 @@ protected:
     DECLARE_REDIS_HANDLER(incr_by)
     DECLARE_REDIS_HANDLER(decr)
     DECLARE_REDIS_HANDLER(decr_by)
+    DECLARE_REDIS_HANDLER(mget)
+    DECLARE_REDIS_HANDLER(mset)
+    DECLARE_REDIS_HANDLER(hget)
+    DECLARE_REDIS_HANDLER(hset)
+    DECLARE_REDIS_HANDLER(hmget)
+    DECLARE_REDIS_HANDLER(hgetall)
+    DECLARE_REDIS_HANDLER(hdel)
     DECLARE_REDIS_HANDLER(default_handler)
 
     void set_internal(message_entry &entry);
@@ -209,6 +216,25 @@ protected:
     void del_geo_internal(message_entry &entry);
     void counter_internal(message_entry &entry);
     static void parse_set_parameters(const std::vector<redis_bulk_string> &opts, int &ttl_seconds);
+
+    // Get the partition hash by which the request on the key whose hash is `key_hash` is
+    // routed. All the requests are routed to partition 0 unless [pegasus.proxy]
+    // route_by_key_hash is true, to be compatible with the data written by the legacy proxy.
+    static uint64_t get_request_partition_hash(uint64_t key_hash);
+
+    // The keys of a multi-key command sent to the same partition by one request.
+    struct partition_batch
+    {
+        uint64_t partition_hash = 0;
+        // The indexes of the keys of this batch.
+        std::vector<size_t> key_indexes;
+    };
+    // Group the keys by the partition they are routed to (see get_request_partition_hash()).
+    // Before the partition count is known (i.e. 'partition_count' is not positive), the keys are
+    // grouped by the partition hash, which still routes each batch to the right partition.
+    static std::vector<partition_batch> group_keys_by_partition(const std::vector<dsn::blob> &keys,
+                                                                int partition_count);
+    void reply_array(message_entry &entry, std::vector<std::shared_ptr<redis_base_type>> &&elems);
     static void parse_geo_radius_parameters(const std::vector<redis_bulk_string> &opts,
                                             int base_index,
                                             double &radius_m,
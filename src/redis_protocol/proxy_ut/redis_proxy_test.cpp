@@ -36,6 +36,7 @@
 #include <boost/asio/socket_base.hpp>
 #include <boost/system/detail/error_code.hpp>
 #include <gtest/gtest_prod.h>
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <memory>
@@ -45,6 +46,8 @@
 #include <utility>
 #include <vector>
 
+#include "base/pegasus_key_schema.h"
+#include "client/partition_resolver.h"
 #include "geo/lib/geo_client.h"
 #include "gtest/gtest.h"
 #include "proxy_layer.h"
@@ -55,12 +58,16 @@
 #include "runtime/app_model.h"
 #include "runtime/service_app.h"
 #include "task/task_spec.h"
+#include "test_util/test_util.h"
 #include "utils/blob.h"
 #include "utils/error_code.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/rand.h"
 #include "utils/strings.h"
 
+DSN_DECLARE_bool(route_by_key_hash);
+
 using namespace boost::asio;
 using namespace ::pegasus::proxy;
 
@@ -177,6 +184,8 @@ private:
     FRIEND_TEST(proxy_test, test_nil_bulk_string);
     FRIEND_TEST(proxy_test, test_random_cases);
     FRIEND_TEST(proxy_test, test_parse_parameters);
+    FRIEND_TEST(proxy_test, test_group_keys_by_partition);
+    FRIEND_TEST(proxy_test, test_get_request_partition_hash);
 
     std::vector<std::unique_ptr<message_entry>> _reserved_entry;
     int _entry_index;
@@ -529,6 +538,79 @@ TEST_F(proxy_test, test_parse_parameters)
     }
 }
 
+TEST_F(proxy_test, test_group_keys_by_partition)
+{
+    std::vector<dsn::blob> keys;
+    for (const auto &hash_key : {"key1", "key2", "key3", "key1", "key4", "key5"}) {
+        dsn::blob key;
+        pegasus_generate_key(key, dsn::blob::create_from_bytes(hash_key), dsn::blob());
+        keys.emplace_back(std::move(key));
+    }
+
+    const auto check = [&keys](int partition_count, size_t &batch_count) {
+        const auto batches = redis_test_parser::group_keys_by_partition(keys, partition_count);
+        std::vector<bool> grouped(keys.size(), false);
+        std::set<uint64_t> groups;
+        for (const auto &batch : batches) {
+            ASSERT_FALSE(batch.key_indexes.empty());
+            const auto group = [partition_count](uint64_t partition_hash) -> uint64_t {
+                return partition_count > 0
+                           ? dsn::replication::partition_resolver::get_partition_index(
+                                 partition_count, partition_hash)
+                           : partition_hash;
+            };
+            // All the keys of a batch are sent to the same partition with the batch.
+            const auto batch_group = group(batch.partition_hash);
+            ASSERT_TRUE(groups.insert(batch_group).second);
+            for (const auto index : batch.key_indexes) {
+                ASSERT_FALSE(grouped[index]);
+                grouped[index] = true;
+                ASSERT_EQ(batch_group,
+                          group(redis_test_parser::get_request_partition_hash(
+                              pegasus_key_hash(keys[index]))));
+            }
+            // The keys of a batch are in the same order as they are requested.
+            ASSERT_TRUE(std::is_sorted(batch.key_indexes.begin(), batch.key_indexes.end()));
+        }
+        ASSERT_EQ(std::vector<bool>(keys.size(), true), grouped);
+        batch_count = batches.size();
+    };
+
+    PRESERVE_FLAG(route_by_key_hash);
+
+    // All the keys are sent to partition 0 by the legacy routing.
+    FLAGS_route_by_key_hash = false;
+    size_t batch_count = 0;
+    for (const auto partition_count : {-1, 1, 2}) {
+        ASSERT_NO_FATAL_FAILURE(check(partition_count, batch_count));
+        ASSERT_EQ(1u, batch_count);
+    }
+
+    // The same keys are in the same batch before the partition count is known.
+    FLAGS_route_by_key_hash = true;
+    ASSERT_NO_FATAL_FAILURE(check(-1, batch_count));
+    ASSERT_EQ(5u, batch_count);
+    ASSERT_NO_FATAL_FAILURE(check(1, batch_count));
+    ASSERT_EQ(1u, batch_count);
+    ASSERT_NO_FATAL_FAILURE(check(2, batch_count));
+    ASSERT_GE(2u, batch_count);
+}
+
+TEST_F(proxy_test, test_get_request_partition_hash)
+{
+    PRESERVE_FLAG(route_by_key_hash);
+
+    dsn::blob key;
+    pegasus_generate_key(key, dsn::blob::create_from_bytes("key"), dsn::blob());
+    const auto key_hash = pegasus_key_hash(key);
+
+    FLAGS_route_by_key_hash = false;
+    ASSERT_EQ(0U, redis_test_parser::get_request_partition_hash(key_hash));
+
+    FLAGS_route_by_key_hash = true;
+    ASSERT_EQ(key_hash, redis_test_parser::get_request_partition_hash(key_hash));
+}
+
 TEST(proxy, connection)
 {
     const auto redis_address = dsn::rpc_address::from_ip_port("127.0.0.1", 12345);
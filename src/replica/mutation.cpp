@@ -197,7 +197,14 @@ void mutation::add_client_request(dsn::message_ex *request)
 
 void mutation::write_to(const std::function<void(const blob &)> &inserter) const
 {
-    binary_writer writer(1024);
+    // The serialized header is held by the log block until the block is written, thus allocate
+    // exactly what it needs. The payloads of the updates are referenced rather than copied.
+    size_t header_size = kMutationHeaderSize + sizeof(int);
+    for (const mutation_update &update : data.updates) {
+        header_size += sizeof(int) + strlen(update.code.to_string()) + sizeof(int) + sizeof(int);
+    }
+
+    binary_writer writer(static_cast<int>(header_size));
     write_mutation_header(writer, data.header);
     writer.write_pod(static_cast<int>(data.updates.size()));
     for (const mutation_update &update : data.updates) {
@@ -213,7 +220,9 @@ void mutation::write_to(const std::function<void(const blob &)> &inserter) const
 
         writer.write_pod(static_cast<int>(update.data.length()));
     }
-    inserter(writer.get_buffer());
+    const blob header = writer.get_buffer();
+    CHECK_EQ(static_cast<size_t>(header.length()), header_size);
+    inserter(header);
     for (const mutation_update &update : data.updates) {
         inserter(update.data);
     }
@@ -387,14 +396,18 @@ void mutation_queue::try_promote_pending(task_spec *spec)
     // performance by short-circuit evaluation since it is actually FLAGS_batch_write_disabled
     // which is mostly set false by default while other conditions vary with different incoming
     // client requests.
-    if (spec->rpc_request_is_write_allow_batch && !_pending_mutation->is_full() &&
-        !_batch_write_disabled) {
+    if (allow_batch(spec) && !_pending_mutation->is_full() && !_batch_write_disabled) {
         return;
     }
 
     promote_pending();
 }
 
+bool mutation_queue::allow_batch(const task_spec *spec) const
+{
+    return spec->rpc_request_is_write_allow_batch && !_replica->need_make_idempotent(spec);
+}
+
 #define CHECK_RPC_REQUEST_IS_WRITE(request)                                                        \
     do {                                                                                           \
         const auto *__spec = task_spec::get(request->rpc_code());                                  \
@@ -560,7 +573,7 @@ mutation_ptr mutation_queue::add_work(message_ex *request)
     // If this request is not allowed to be batched, promote `_pending_mutation` if it is
     // non-null. We don't check `_batch_write_disabled` since `_pending_mutation` must be
     // null now if it is true.
-    if (_pending_mutation != nullptr && !spec->rpc_request_is_write_allow_batch) {
+    if (_pending_mutation != nullptr && !allow_batch(spec)) {
         promote_pending();
     }
 
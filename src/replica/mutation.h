@@ -31,6 +31,7 @@
 #include <boost/intrusive/slist_hook.hpp>
 #include <boost/unordered/unordered_flat_map.hpp>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <list>
@@ -165,6 +166,8 @@ public:
     void write_to(binary_writer &writer, dsn::message_ex *to) const;
     static mutation_ptr read_from(binary_reader &reader, dsn::message_ex *from);
 
+    // The serialized size of mutation_header, see write_mutation_header().
+    static constexpr size_t kMutationHeaderSize = 7 * sizeof(int64_t);
     static void write_mutation_header(binary_writer &writer, const mutation_header &header);
     static void read_mutation_header(binary_reader &reader, mutation_header &header);
 
@@ -202,6 +205,13 @@ public:
     // the storage engine and the client has been responded to.
     pegasus::idempotent_writer_ptr idem_writer;
 
+    // Whether the mutation is received in an RPC_PREPARE_BATCH request, whose request is only
+    // attached to the last mutation appended for the batch, thus the others are never acked
+    // by themselves.
+    //
+    // This field is only used by secondary replicas.
+    bool is_received_in_batch{false};
+
     std::shared_ptr<dsn::utils::latency_tracer> _tracer;
 
     void set_is_sync_to_child(bool sync_to_child) { _is_sync_to_child = sync_to_child; }
@@ -351,6 +361,12 @@ private:
     // request is allowed to be batched.
     void try_promote_pending(task_spec *spec);
 
+    // Return true if the client request (whose specification is `spec`) is allowed to be
+    // batched with other requests into a mutation. The request that needs to be translated
+    // into idempotent updates must be the only one in its mutation, even if its RPC code is
+    // declared as batchable.
+    [[nodiscard]] bool allow_batch(const task_spec *spec) const;
+
     // Return true if the decree `d` has been applied into storage engine; otherwise return
     // false.
     [[nodiscard]] bool applied(decree d) const;
@@ -41,10 +41,12 @@
 #include "consensus_types.h"
 #include "mutation_log_utils.h"
 #include "replica.h"
+#include "replica/plog_group_committer.h"
 #include "replica/log_block.h"
 #include "replica/log_file.h"
 #include "replica/mutation.h"
 #include "runtime/api_layer1.h"
+#include "task/async_calls.h"
 #include "utils/binary_writer.h"
 #include "utils/blob.h"
 #include "utils/defer.h"
@@ -59,6 +61,8 @@ DSN_DEFINE_bool(replication,
                 false,
                 "when write private log, whether to flush file after write done");
 
+DSN_DECLARE_bool(plog_group_commit_enabled);
+
 namespace dsn {
 namespace replication {
 
@@ -69,6 +73,11 @@ mutation_log_private::mutation_log_private(const std::string &dir,
     : mutation_log(dir, max_log_file_mb, gpid, r), replica_base(r)
 {
     mutation_log_private::init_states();
+
+    if (FLAGS_plog_force_flush && FLAGS_plog_group_commit_enabled && r != nullptr &&
+        r->get_dir_node() != nullptr) {
+        _group_committer = plog_group_committer::get_or_create(r->get_dir_node());
+    }
 }
 
 ::dsn::task_ptr mutation_log_private::append(mutation_ptr &mu,
@@ -205,8 +214,14 @@ void mutation_log_private::flush_internal(int max_count)
                 continue;
             }
             if (!_pending_write) {
-                // !_is_writing && !_pending_write, means flush done
                 _plock.unlock();
+                if (_pending_sync_count.load(std::memory_order_acquire) > 0) {
+                    // The written mutations are still waiting for the group committer to
+                    // sync the log file.
+                    _tracker.wait_outstanding_tasks();
+                    continue;
+                }
+                // !_is_writing && !_pending_write && no pending sync, means flush done
                 break;
             }
             // !_is_writing && _pending_write, start next write
@@ -221,6 +236,7 @@ void mutation_log_private::init_states()
     mutation_log::init_states();
 
     _is_writing.store(false, std::memory_order_release);
+    _pending_sync_count.store(0, std::memory_order_release);
     _issued_write.reset();
     _pending_write = nullptr;
     _pending_write_max_commit = 0;
@@ -283,6 +299,33 @@ void mutation_log_private::commit_pending_mutations(log_file_ptr &lf,
                 }
             }
 
+            if (err == ERR_OK && _group_committer != nullptr) {
+                CHECK_EQ(sz, pending->size());
+
+                // The log file is synced together with the private logs on the same disk,
+                // and the callbacks would not be notified until the sync is finished. The
+                // completion tasks are enqueued in the order of the submissions, thus the
+                // callbacks are still notified in the order of the writes.
+                _pending_sync_count.fetch_add(1, std::memory_order_relaxed);
+                auto on_synced = tasking::create_task(
+                    LPC_PLOG_GROUP_COMMIT_COMPLETED,
+                    &_tracker,
+                    [this, pending, max_decree, max_commit, sz]() {
+                        for (auto &c : pending->callbacks()) {
+                            c->enqueue(ERR_OK, sz);
+                        }
+                        update_max_decree_on_disk(max_decree, max_commit);
+                        _pending_sync_count.fetch_sub(1, std::memory_order_release);
+                    },
+                    get_gpid().thread_hash());
+                _group_committer->submit(lf, std::move(on_synced));
+
+                // Do not wait for the sync to start the next write, so that the consecutive
+                // writes of this log could be submitted into the same batch and synced once.
+                start_next_write();
+                return;
+            }
+
             // notify the callbacks
             // ATTENTION: callback may be called before this code block executed
             // done.
@@ -309,22 +352,32 @@ void mutation_log_private::commit_pending_mutations(log_file_ptr &lf,
                 lf->flush();
             }
 
-            // Update both _plog_max_decree_on_disk and _plog_max_commit_on_disk
-            // after written into log file done.
-            update_max_decree_on_disk(max_decree, max_commit);
+            on_pending_mutations_committed(max_decree, max_commit);
+        },
+        get_gpid().thread_hash());
+}
 
-            _is_writing.store(false, std::memory_order_relaxed);
+void mutation_log_private::on_pending_mutations_committed(decree max_decree, decree max_commit)
+{
+    // Update both _plog_max_decree_on_disk and _plog_max_commit_on_disk
+    // after written into log file done.
+    update_max_decree_on_disk(max_decree, max_commit);
 
-            // start to write if possible
-            _plock.lock();
+    start_next_write();
+}
 
-            if (!_is_writing.load(std::memory_order_acquire) && _pending_write) {
-                write_pending_mutations(true);
-            } else {
-                _plock.unlock();
-            }
-        },
-        get_gpid().thread_hash());
+void mutation_log_private::start_next_write()
+{
+    _is_writing.store(false, std::memory_order_relaxed);
+
+    // start to write if possible
+    _plock.lock();
+
+    if (!_is_writing.load(std::memory_order_acquire) && _pending_write) {
+        write_pending_mutations(true);
+    } else {
+        _plock.unlock();
+    }
 }
 
 ///////////////////////////////////////////////////////////////
@@ -58,6 +58,7 @@ namespace replication {
 
 class learn_state;
 class log_appender;
+class plog_group_committer;
 //
 // manage a sequence of continuous mutation log files
 // each log file name is: log.{index}.{global_start_offset}
@@ -451,6 +452,13 @@ private:
                                   decree max_decree,
                                   decree max_commit);
 
+    // Called once the pending mutations have been written (and synced if required) into
+    // the log file, to start the next write if possible.
+    void on_pending_mutations_committed(decree max_decree, decree max_commit);
+
+    // Clear _is_writing and start to write the pending mutations if any.
+    void start_next_write();
+
     void init_states() override;
 
     // flush at most count times
@@ -458,6 +466,8 @@ private:
     void flush_internal(int max_count);
 
 private:
+    friend class mutation_log_test;
+
     // bufferring - only one concurrent write is allowed
     typedef std::vector<mutation_ptr> mutations;
     std::atomic_bool _is_writing;
@@ -469,6 +479,14 @@ private:
     decree _pending_write_max_commit;
     decree _pending_write_max_decree;
     mutable zlock _plock;
+
+    // Used to sync the log file with the private logs on the same disk in batches, only
+    // when both FLAGS_plog_force_flush and FLAGS_plog_group_commit_enabled are set.
+    plog_group_committer *_group_committer{nullptr};
+
+    // The number of the writes which have been submitted to the group committer but not
+    // synced yet.
+    std::atomic<int> _pending_sync_count{0};
 };
 
 } // namespace replication
@@ -0,0 +1,228 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "replica/plog_group_committer.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+#include "common/fs_manager.h"
+#include "common/replication.codes.h"
+#include "runtime/api_layer1.h"
+#include "task/async_calls.h"
+#include "utils/autoref_ptr.h"
+#include "utils/fail_point.h"
+#include "utils/flags.h"
+#include "utils/fmt_logging.h"
+
+DSN_DEFINE_bool(replication,
+                plog_group_commit_enabled,
+                false,
+                "Whether to coalesce the syncs of the private logs placed on the same disk into "
+                "batches, only works when plog_force_flush is enabled");
+
+DSN_DEFINE_uint32(replication,
+                  plog_group_commit_window_ms,
+                  0,
+                  "The time window in milliseconds to collect the private logs to be synced in "
+                  "a batch once the disk is idle. While a batch is being synced, the private logs "
+                  "submitted in the meantime are always collected into the next batch");
+DSN_TAG_VARIABLE(plog_group_commit_window_ms, FT_MUTABLE);
+
+DSN_DEFINE_uint32(replication,
+                  plog_group_commit_max_batch_size,
+                  512,
+                  "The max number of the sync requests of the private logs in a batch");
+DSN_TAG_VARIABLE(plog_group_commit_max_batch_size, FT_MUTABLE);
+DSN_DEFINE_validator(plog_group_commit_max_batch_size,
+                     [](uint32_t value) -> bool { return value > 0; });
+
+METRIC_DECLARE_entity(disk);
+
+METRIC_DEFINE_counter(disk,
+                      plog_group_commit_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of the sync requests of the private logs submitted to the "
+                      "group committer");
+
+METRIC_DEFINE_counter(disk,
+                      plog_group_commit_batches,
+                      dsn::metric_unit::kRounds,
+                      "The number of batches synced by the private log group committer");
+
+METRIC_DEFINE_counter(disk,
+                      plog_group_commit_synced_files,
+                      dsn::metric_unit::kFiles,
+                      "The number of private log files synced by the group committer, each "
+                      "file is synced at most once in a batch");
+
+METRIC_DEFINE_percentile_int64(disk,
+                               plog_group_commit_batch_size,
+                               dsn::metric_unit::kRequests,
+                               "The number of the sync requests of the private logs in a batch");
+
+METRIC_DEFINE_percentile_int64(disk,
+                               plog_group_commit_sync_latency_ns,
+                               dsn::metric_unit::kNanoSeconds,
+                               "The duration of syncing all the private log files in a batch");
+
+namespace dsn {
+namespace replication {
+
+namespace {
+
+metric_entity_ptr instantiate_disk_metric_entity(const std::string &tag,
+                                                 const std::string &data_dir)
+{
+    auto entity_id = fmt::format("disk@{}", tag);
+
+    return METRIC_ENTITY_disk.instantiate(entity_id, {{"tag", tag}, {"data_dir", data_dir}});
+}
+
+} // anonymous namespace
+
+/*static*/ plog_group_committer *plog_group_committer::get_or_create(const dir_node *dn)
+{
+    CHECK_NOTNULL(dn, "");
+
+    static std::mutex committers_lock;
+    static std::map<std::string, std::unique_ptr<plog_group_committer>> committers;
+
+    std::lock_guard<std::mutex> l(committers_lock);
+    auto &committer = committers[dn->tag];
+    if (committer == nullptr) {
+        // Spread the syncs of different disks onto different workers.
+        committer = std::make_unique<plog_group_committer>(
+            dn->tag, dn->full_dir, static_cast<int>(committers.size()));
+    }
+    return committer.get();
+}
+
+plog_group_committer::plog_group_committer(const std::string &tag,
+                                           const std::string &data_dir,
+                                           int thread_hash)
+    : _tag(tag),
+      _data_dir(data_dir),
+      _thread_hash(thread_hash),
+      _disk_metric_entity(instantiate_disk_metric_entity(tag, data_dir)),
+      METRIC_VAR_INIT_disk(plog_group_commit_requests),
+      METRIC_VAR_INIT_disk(plog_group_commit_batches),
+      METRIC_VAR_INIT_disk(plog_group_commit_synced_files),
+      METRIC_VAR_INIT_disk(plog_group_commit_batch_size),
+      METRIC_VAR_INIT_disk(plog_group_commit_sync_latency_ns)
+{
+}
+
+plog_group_committer::~plog_group_committer() { _tracker.cancel_outstanding_tasks(); }
+
+const metric_entity_ptr &plog_group_committer::disk_metric_entity() const
+{
+    CHECK_NOTNULL(_disk_metric_entity,
+                  "disk metric entity (tag={}, data_dir={}) should has been instantiated: "
+                  "uninitialized entity cannot be used to instantiate metric",
+                  _tag,
+                  _data_dir);
+    return _disk_metric_entity;
+}
+
+void plog_group_committer::submit(const log_file_ptr &lf, task_ptr &&on_synced)
+{
+    zauto_lock l(_lock);
+    _pending_requests.push_back({lf, std::move(on_synced)});
+    if (_is_syncing) {
+        // Would be synced in the next batch once the current one is finished.
+        return;
+    }
+
+    _is_syncing = true;
+    tasking::enqueue(LPC_PLOG_GROUP_COMMIT,
+                     &_tracker,
+                     [this]() { sync_batch(); },
+                     _thread_hash,
+                     std::chrono::milliseconds(FLAGS_plog_group_commit_window_ms));
+}
+
+void plog_group_committer::sync_batch()
+{
+    // Postpone the batch to collect the requests submitted in the meantime, which is used to
+    // make the batches deterministic in tests.
+    FAIL_POINT_INJECT_F("plog_group_commit_postpone_sync", [this](std::string_view) {
+        tasking::enqueue(LPC_PLOG_GROUP_COMMIT,
+                         &_tracker,
+                         [this]() { sync_batch(); },
+                         _thread_hash,
+                         std::chrono::milliseconds(1));
+    });
+
+    std::vector<sync_request> batch;
+    {
+        zauto_lock l(_lock);
+        CHECK(_is_syncing, "");
+        const size_t batch_size =
+            std::min(_pending_requests.size(),
+                     static_cast<size_t>(FLAGS_plog_group_commit_max_batch_size));
+        batch.reserve(batch_size);
+        std::move(_pending_requests.begin(),
+                  _pending_requests.begin() + batch_size,
+                  std::back_inserter(batch));
+        _pending_requests.erase(_pending_requests.begin(),
+                                _pending_requests.begin() + batch_size);
+    }
+
+    {
+        METRIC_VAR_AUTO_LATENCY(plog_group_commit_sync_latency_ns);
+
+        // The consecutive writes of a private log might be submitted in the same batch,
+        // while syncing the file once is enough.
+        std::unordered_set<log_file *> synced_files;
+        for (const auto &req : batch) {
+            if (synced_files.insert(req.file.get()).second) {
+                req.file->flush();
+            }
+        }
+        METRIC_VAR_INCREMENT_BY(plog_group_commit_synced_files, synced_files.size());
+    }
+    METRIC_VAR_INCREMENT(plog_group_commit_batches);
+    METRIC_VAR_INCREMENT_BY(plog_group_commit_requests, batch.size());
+    METRIC_VAR_SET(plog_group_commit_batch_size, batch.size());
+
+    for (auto &req : batch) {
+        req.on_synced->enqueue();
+    }
+
+    zauto_lock l(_lock);
+    if (_pending_requests.empty()) {
+        _is_syncing = false;
+        return;
+    }
+
+    // The requests submitted during the sync have been waiting long enough, thus sync them
+    // immediately without the window.
+    tasking::enqueue(
+        LPC_PLOG_GROUP_COMMIT, &_tracker, [this]() { sync_batch(); }, _thread_hash);
+}
+
+} // namespace replication
+} // namespace dsn
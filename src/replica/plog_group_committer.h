@@ -0,0 +1,100 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "replica/log_file.h"
+#include "task/task.h"
+#include "task/task_tracker.h"
+#include "utils/metrics.h"
+#include "utils/ports.h"
+#include "utils/zlocks.h"
+
+namespace dsn {
+namespace replication {
+struct dir_node;
+
+// Coalesce the syncs of the private logs placed on the same disk, to reduce the IOPS of the
+// durable writes (i.e. FLAGS_plog_force_flush is enabled) on the disk which hosts a large
+// number of replicas.
+//
+// Once the pending mutations of a private log have been written into the log file, the file
+// is submitted to the group committer of its disk together with a completion task. The files
+// submitted within a window are synced in one batch, each file only once no matter how many
+// times it is submitted, and then all the completion tasks of the batch are enqueued together.
+//
+// There is at most one batch being synced for each disk at the same time, while the files
+// submitted in the meantime are accumulated into the next batch. A private log does not wait
+// for its file to be synced before writing the next pending mutations, thus the consecutive
+// writes of a busy private log are usually submitted into the same batch.
+class plog_group_committer
+{
+public:
+    // Get the group committer of the disk, create one if not found.
+    //
+    // Thread safe.
+    static plog_group_committer *get_or_create(const dir_node *dn);
+
+    plog_group_committer(const std::string &tag, const std::string &data_dir, int thread_hash);
+    ~plog_group_committer();
+
+    // Submit the log file to be synced, `on_synced` will be enqueued after that.
+    //
+    // Thread safe.
+    void submit(const log_file_ptr &lf, task_ptr &&on_synced);
+
+    const metric_entity_ptr &disk_metric_entity() const;
+
+    METRIC_DEFINE_VALUE(plog_group_commit_requests, int64_t)
+    METRIC_DEFINE_VALUE(plog_group_commit_batches, int64_t)
+    METRIC_DEFINE_VALUE(plog_group_commit_synced_files, int64_t)
+
+private:
+    // Sync the files submitted to the current batch.
+    void sync_batch();
+
+    struct sync_request
+    {
+        log_file_ptr file;
+        task_ptr on_synced;
+    };
+
+    const std::string _tag;
+    const std::string _data_dir;
+    const int _thread_hash;
+
+    mutable zlock _lock;
+    std::vector<sync_request> _pending_requests;
+    bool _is_syncing{false};
+
+    task_tracker _tracker;
+
+    const metric_entity_ptr _disk_metric_entity;
+    METRIC_VAR_DECLARE_counter(plog_group_commit_requests);
+    METRIC_VAR_DECLARE_counter(plog_group_commit_batches);
+    METRIC_VAR_DECLARE_counter(plog_group_commit_synced_files);
+    METRIC_VAR_DECLARE_percentile_int64(plog_group_commit_batch_size);
+    METRIC_VAR_DECLARE_percentile_int64(plog_group_commit_sync_latency_ns);
+
+    DISALLOW_COPY_AND_ASSIGN(plog_group_committer);
+};
+
+} // namespace replication
+} // namespace dsn
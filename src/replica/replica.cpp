@@ -29,7 +29,9 @@
 #include <string_view>
 #include <fmt/core.h>
 #include <rocksdb/status.h>
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include <vector>
 
 #include "backup/replica_backup_manager.h"
@@ -83,7 +85,19 @@ DSN_DEFINE_group_validator(max_mutation_count_in_prepare_list, [](std::string &m
     return true;
 });
 
+DSN_DEFINE_uint32(replication,
+                  secondary_read_lease_ms,
+                  0,
+                  "The bounded stale reads (see max_read_staleness in the request header) are "
+                  "rejected by a secondary which hasn't received any prepare or group check "
+                  "request from the primary for longer than this, since it might have been "
+                  "removed from the membership without knowing it, 0 means twice "
+                  "group_check_interval_ms. Note that within the lease such a secondary might "
+                  "still serve reads staler than the bound");
+DSN_TAG_VARIABLE(secondary_read_lease_ms, FT_MUTABLE);
+
 DSN_DECLARE_int32(checkpoint_max_interval_hours);
+DSN_DECLARE_int32(group_check_interval_ms);
 
 METRIC_DEFINE_gauge_int64(replica,
                           private_log_size_mb,
@@ -125,6 +139,11 @@ METRIC_DEFINE_counter(replica,
                       dsn::metric_unit::kRequests,
                       "The number of rejected backup requests by throttling");
 
+METRIC_DEFINE_counter(replica,
+                      stale_rejected_backup_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of rejected backup requests since the replica is too stale");
+
 METRIC_DEFINE_counter(replica,
                       splitting_rejected_write_requests,
                       dsn::metric_unit::kRequests,
@@ -207,6 +226,16 @@ METRIC_DEFINE_counter(replica,
                       dsn::metric_unit::kLearns,
                       "The number of successful learns launched by learner");
 
+METRIC_DEFINE_counter(replica,
+                      prepare_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of RPC_PREPARE requests sent by the primary replica");
+
+METRIC_DEFINE_counter(replica,
+                      prepare_batch_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of RPC_PREPARE_BATCH requests sent by the primary replica");
+
 METRIC_DEFINE_counter(replica,
                       prepare_failed_requests,
                       dsn::metric_unit::kRequests,
@@ -293,6 +322,7 @@ replica::replica(replica_stub *stub,
       METRIC_VAR_INIT_replica(backup_requests),
       METRIC_VAR_INIT_replica(throttling_delayed_backup_requests),
       METRIC_VAR_INIT_replica(throttling_rejected_backup_requests),
+      METRIC_VAR_INIT_replica(stale_rejected_backup_requests),
       METRIC_VAR_INIT_replica(splitting_rejected_write_requests),
       METRIC_VAR_INIT_replica(splitting_rejected_read_requests),
       METRIC_VAR_INIT_replica(bulk_load_ingestion_rejected_write_requests),
@@ -308,6 +338,8 @@ replica::replica(replica_stub *stub,
       METRIC_VAR_INIT_replica(learn_resets),
       METRIC_VAR_INIT_replica(learn_failed_count),
       METRIC_VAR_INIT_replica(learn_successful_count),
+      METRIC_VAR_INIT_replica(prepare_requests),
+      METRIC_VAR_INIT_replica(prepare_batch_requests),
       METRIC_VAR_INIT_replica(prepare_failed_requests),
       METRIC_VAR_INIT_replica(group_check_failed_requests),
       METRIC_VAR_INIT_replica(emergency_checkpoints),
@@ -434,6 +466,32 @@ void replica::on_client_read(dsn::message_ex *request, bool ignore_throttling)
         if (!ignore_throttling && throttle_backup_request(request)) {
             return;
         }
+
+        // The primary could not commit a mutation before all the secondaries have prepared it,
+        // thus the mutations prepared but not committed yet bound how many decrees this replica
+        // lags behind the primary.
+        const decree staleness = status() == partition_status::PS_PRIMARY
+                                     ? 0
+                                     : max_prepared_decree() - last_committed_decree();
+        const auto max_staleness = request->max_read_staleness();
+        if (max_staleness > 0) {
+            if (status() != partition_status::PS_PRIMARY &&
+                status() != partition_status::PS_SECONDARY) {
+                response_client_read(request, ERR_INVALID_STATE);
+                return;
+            }
+            // The lag is only meaningful if the secondary is still in the membership, which
+            // is proved by the recent requests from the primary.
+            if (staleness > static_cast<decree>(max_staleness) ||
+                (status() == partition_status::PS_SECONDARY && secondary_read_lease_expired())) {
+                METRIC_VAR_INCREMENT(stale_rejected_backup_requests);
+                response_client_read(request, ERR_TRY_AGAIN);
+                return;
+            }
+        }
+        // The response inherits the header of the request.
+        request->header->context.u.read_staleness =
+            std::min<decree>(staleness, std::numeric_limits<uint16_t>::max());
         METRIC_VAR_INCREMENT(backup_requests);
     }
 
@@ -753,6 +811,14 @@ bool replica::access_controller_allowed(message_ex *msg, const ranger::access_ty
 
 int64_t replica::get_backup_request_count() const { return METRIC_VAR_VALUE(backup_requests); }
 
+bool replica::secondary_read_lease_expired() const
+{
+    const uint64_t lease_ms = FLAGS_secondary_read_lease_ms > 0
+                                  ? FLAGS_secondary_read_lease_ms
+                                  : 2 * static_cast<uint64_t>(FLAGS_group_check_interval_ms);
+    return dsn_now_ms() > _secondary_states.last_primary_contact_ms + lease_ms;
+}
+
 void replica::METRIC_FUNC_NAME_SET(dup_pending_mutations)()
 {
     METRIC_SET(*_duplication_mgr, dup_pending_mutations);
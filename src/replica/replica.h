@@ -36,6 +36,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "common/json_helper.h"
 #include "common/replication_other_types.h"
@@ -97,6 +98,7 @@ class learn_request;
 class learn_response;
 class learn_state;
 class mutation_log_tool;
+class prepare_ack;
 class replica;
 class replica_backup_manager;
 class replica_bulk_loader;
@@ -189,7 +191,9 @@ public:
     //    messages and tools from/for meta server
     //
     void on_config_proposal(configuration_update_request &proposal);
-    void on_config_sync(const app_info &info,
+    // Returns true if the replica has been serving with the synced configs, thus the following
+    // config syncs could be skipped unless the configs are changed.
+    bool on_config_sync(const app_info &info,
                         const partition_configuration &pc,
                         split_status::type meta_split_status);
     void on_cold_backup(const backup_request &request, /*out*/ backup_response &response);
@@ -198,6 +202,9 @@ public:
     //    messages from peers (primary or secondary)
     //
     void on_prepare(dsn::message_ex *request);
+    // Prepare the consecutive mutations sent by the primary in one RPC_PREPARE_BATCH request,
+    // and reply one cumulative ack once all of them have been logged.
+    void on_prepare_batch(dsn::message_ex *request);
     void on_learn(dsn::message_ex *msg, const learn_request &request);
     void on_learn_completion_notification(const group_check_response &report,
                                           /*out*/ learn_notify_response &response);
@@ -353,6 +360,10 @@ public:
     const dir_node *get_dir_node() const { return _dir_node; }
 
     METRIC_DEFINE_VALUE(write_size_exceed_threshold_requests, int64_t)
+    METRIC_DEFINE_VALUE(stale_rejected_backup_requests, int64_t)
+    METRIC_DEFINE_VALUE(prepare_requests, int64_t)
+    METRIC_DEFINE_VALUE(prepare_batch_requests, int64_t)
+    METRIC_DEFINE_VALUE(prepare_failed_requests, int64_t)
     void METRIC_FUNC_NAME_SET(dup_pending_mutations)();
     METRIC_DEFINE_INCREMENT(backup_failed_count)
     METRIC_DEFINE_INCREMENT(backup_successful_count)
@@ -488,11 +499,27 @@ private:
                               int timeout_milliseconds,
                               bool pop_all_committed_mutations,
                               int64_t learn_signature);
+    // Add the mutation into the prepare batch of the secondary, which would be sent once the
+    // limits are reached or after all the mutations prepared in the same round are batched.
+    void add_to_prepare_batch(const host_port &secondary, const mutation_ptr &mu);
+    void flush_prepare_batches();
+    // Send the mutations batched for the secondary immediately if any.
+    void flush_prepare_batch(const host_port &secondary);
+    void send_prepare_batch_message(const host_port &secondary,
+                                    std::vector<mutation_ptr> &&mutations);
     void on_append_log_completed(mutation_ptr &mu, error_code err, size_t size);
     void on_prepare_reply(std::pair<mutation_ptr, partition_status::type> pr,
                           error_code err,
                           dsn::message_ex *request,
                           dsn::message_ex *reply);
+    void on_prepare_batch_reply(const std::vector<mutation_ptr> &mutations,
+                                error_code err,
+                                dsn::message_ex *request,
+                                dsn::message_ex *reply);
+    void handle_prepare_ack(mutation_ptr mu,
+                            partition_status::type target_status,
+                            const host_port &node,
+                            const prepare_ack &resp);
     void do_possible_commit_on_primary(mutation_ptr &mu);
     void ack_prepare_message(error_code err, mutation_ptr &mu);
     void cleanup_preparing_mutations(bool wait);
@@ -500,6 +527,8 @@ private:
     /////////////////////////////////////////////////////////////////
     // learning
     void init_learn(uint64_t signature);
+    void prepare_app_learn_request(uint64_t signature);
+    void on_prepare_app_learn_request_completed(uint64_t signature, blob &&learn_req);
     void on_learn_reply(error_code err, learn_request &&req, learn_response &&resp);
     void on_copy_remote_state_completed(error_code err,
                                         size_t size,
@@ -716,6 +745,10 @@ private:
     // Currently only used for unit test to get the count of backup requests.
     int64_t get_backup_request_count() const;
 
+    // Whether the secondary hasn't heard from the primary for longer than the lease, thus it
+    // might have been removed from the membership and shouldn't serve the bounded stale reads.
+    bool secondary_read_lease_expired() const;
+
     // Support self-defined `replication_app_base` at runtime which is only used for test.
     template <typename TApp,
               typename... Args,
@@ -739,6 +772,7 @@ private:
     friend class replica_split_test;
     friend class replica_test_base;
     friend class replica_test;
+    friend class replica_2pc_test;
     friend class replica_backup_manager;
     friend class replica_bulk_loader;
     friend class replica_split_manager;
@@ -858,6 +892,7 @@ private:
     METRIC_VAR_DECLARE_counter(backup_requests);
     METRIC_VAR_DECLARE_counter(throttling_delayed_backup_requests);
     METRIC_VAR_DECLARE_counter(throttling_rejected_backup_requests);
+    METRIC_VAR_DECLARE_counter(stale_rejected_backup_requests);
     METRIC_VAR_DECLARE_counter(splitting_rejected_write_requests);
     METRIC_VAR_DECLARE_counter(splitting_rejected_read_requests);
     METRIC_VAR_DECLARE_counter(bulk_load_ingestion_rejected_write_requests);
@@ -875,6 +910,8 @@ private:
     METRIC_VAR_DECLARE_counter(learn_failed_count);
     METRIC_VAR_DECLARE_counter(learn_successful_count);
 
+    METRIC_VAR_DECLARE_counter(prepare_requests);
+    METRIC_VAR_DECLARE_counter(prepare_batch_requests);
     METRIC_VAR_DECLARE_counter(prepare_failed_requests);
 
     METRIC_VAR_DECLARE_counter(group_check_failed_requests);
@@ -26,6 +26,7 @@
 
 #include <fmt/core.h>
 #include <rocksdb/status.h>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cinttypes>
@@ -33,6 +34,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -72,6 +74,7 @@
 #include "utils/api_utilities.h"
 #include "utils/autoref_ptr.h"
 #include "utils/error_code.h"
+#include "utils/fail_point.h"
 #include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/latency_tracer.h"
@@ -96,6 +99,25 @@ DSN_DEFINE_int32(replication,
                  5000,
                  "The timeout in millisecond for the primary replicas to send prepare requests to "
                  "the learners in two phase commit");
+DSN_DEFINE_bool(replication,
+                prepare_batch_enabled,
+                false,
+                "Whether the primary replicas send the consecutive mutations to be prepared on the "
+                "same secondary in one RPC_PREPARE_BATCH request. It should not be enabled until "
+                "all the replica servers in the cluster support RPC_PREPARE_BATCH");
+DSN_TAG_VARIABLE(prepare_batch_enabled, FT_MUTABLE);
+DSN_DEFINE_uint32(replication,
+                  prepare_batch_max_count,
+                  16,
+                  "The max count of the mutations sent in one RPC_PREPARE_BATCH request");
+DSN_TAG_VARIABLE(prepare_batch_max_count, FT_MUTABLE);
+DSN_DEFINE_validator(prepare_batch_max_count, [](uint32_t value) -> bool { return value > 0; });
+DSN_DEFINE_uint32(replication,
+                  prepare_batch_max_bytes,
+                  1 << 20,
+                  "The max approximate size in bytes of the mutations sent in one "
+                  "RPC_PREPARE_BATCH request");
+DSN_TAG_VARIABLE(prepare_batch_max_bytes, FT_MUTABLE);
 DSN_DEFINE_int32(replication,
                  prepare_decree_gap_for_debug_logging,
                  10000,
@@ -416,6 +438,13 @@ void replica::init_prepare(mutation_ptr &mu, bool reconciliation, bool pop_all_c
     mu->set_left_secondary_ack_count(
         static_cast<unsigned int>(_primary_states.pc.hp_secondaries.size()));
     for (const auto &secondary : _primary_states.pc.hp_secondaries) {
+        // The mutations which require the secondaries to pop all committed mutations or to be
+        // sent to the child synchronously are never batched.
+        if (FLAGS_prepare_batch_enabled && !pop_all_committed_mutations &&
+            !_primary_states.sync_send_write_request) {
+            add_to_prepare_batch(secondary, mu);
+            continue;
+        }
         send_prepare_message(secondary,
                              partition_status::PS_SECONDARY,
                              mu,
@@ -486,6 +515,16 @@ void replica::send_prepare_message(const host_port &hp,
                                    bool pop_all_committed_mutations,
                                    int64_t learn_signature)
 {
+    if (status == partition_status::PS_SECONDARY) {
+        // The mutations batched for the secondary must be sent ahead, otherwise they might be
+        // overtaken by this one (e.g. the one popping all committed mutations, or the retried
+        // one).
+        flush_prepare_batch(hp);
+    }
+
+    METRIC_VAR_INCREMENT(prepare_requests);
+    FAIL_POINT_INJECT_F("replica_send_prepare_message", [](std::string_view) {});
+
     mu->_tracer->add_sub_tracer(hp.to_string());
     ADD_POINT(mu->_tracer->sub_tracer(hp.to_string()));
 
@@ -520,6 +559,131 @@ void replica::send_prepare_message(const host_port &hp,
                      enum_to_string(rconfig.status));
 }
 
+void replica::add_to_prepare_batch(const host_port &secondary, const mutation_ptr &mu)
+{
+    auto &batch = _primary_states.prepare_batches[secondary];
+    batch.mutations.push_back(mu);
+    batch.bytes += mu->appro_data_bytes();
+    if (batch.mutations.size() >= FLAGS_prepare_batch_max_count ||
+        batch.bytes >= FLAGS_prepare_batch_max_bytes) {
+        auto mutations = std::move(batch.mutations);
+        _primary_states.prepare_batches.erase(secondary);
+        send_prepare_batch_message(secondary, std::move(mutations));
+        return;
+    }
+
+    // The flush task is put at the tail of the replica thread, thus the batch is not delayed by
+    // any timer: it just collects the mutations prepared by the tasks queued ahead of it, which
+    // are exactly the ones that would wait in the queue when the replica is busy.
+    if (_primary_states.prepare_batch_flush_task == nullptr) {
+        _primary_states.prepare_batch_flush_task = tasking::enqueue(
+            LPC_FLUSH_PREPARE_BATCH,
+            &_tracker,
+            [this]() {
+                _primary_states.prepare_batch_flush_task = nullptr;
+                flush_prepare_batches();
+            },
+            get_gpid().thread_hash());
+    }
+}
+
+void replica::flush_prepare_batches()
+{
+    _checker.only_one_thread_access();
+
+    auto batches = std::move(_primary_states.prepare_batches);
+    _primary_states.prepare_batches.clear();
+    if (status() != partition_status::PS_PRIMARY) {
+        return;
+    }
+
+    for (auto &kv : batches) {
+        send_prepare_batch_message(kv.first, std::move(kv.second.mutations));
+    }
+}
+
+void replica::flush_prepare_batch(const host_port &secondary)
+{
+    auto iter = _primary_states.prepare_batches.find(secondary);
+    if (iter == _primary_states.prepare_batches.end()) {
+        return;
+    }
+
+    auto mutations = std::move(iter->second.mutations);
+    _primary_states.prepare_batches.erase(iter);
+    if (status() != partition_status::PS_PRIMARY) {
+        return;
+    }
+
+    send_prepare_batch_message(secondary, std::move(mutations));
+}
+
+void replica::send_prepare_batch_message(const host_port &secondary,
+                                         std::vector<mutation_ptr> &&mutations)
+{
+    // The configuration may have been changed while the mutations are being batched.
+    mutations.erase(std::remove_if(mutations.begin(),
+                                   mutations.end(),
+                                   [this](const mutation_ptr &mu) {
+                                       return mu->data.header.ballot != get_ballot() ||
+                                              mu->get_decree() <= last_committed_decree();
+                                   }),
+                    mutations.end());
+    if (mutations.empty()) {
+        return;
+    }
+
+    if (mutations.size() == 1) {
+        send_prepare_message(secondary,
+                             partition_status::PS_SECONDARY,
+                             mutations.front(),
+                             FLAGS_prepare_timeout_ms_for_secondaries,
+                             false,
+                             invalid_signature);
+        return;
+    }
+
+    METRIC_VAR_INCREMENT(prepare_batch_requests);
+    FAIL_POINT_INJECT_F("replica_send_prepare_batch_message", [](std::string_view) {});
+
+    for (const auto &mu : mutations) {
+        mu->_tracer->add_sub_tracer(secondary.to_string());
+        ADD_POINT(mu->_tracer->sub_tracer(secondary.to_string()));
+    }
+
+    dsn::message_ex *msg = dsn::message_ex::create_request(
+        RPC_PREPARE_BATCH, FLAGS_prepare_timeout_ms_for_secondaries, get_gpid().thread_hash());
+    replica_configuration rconfig;
+    _primary_states.get_replica_config(partition_status::PS_SECONDARY, rconfig);
+
+    {
+        rpc_write_stream writer(msg);
+        marshall(writer, get_gpid(), DSF_THRIFT_BINARY);
+        marshall(writer, rconfig, DSF_THRIFT_BINARY);
+        writer.write_pod(static_cast<int>(mutations.size()));
+        for (const auto &mu : mutations) {
+            mu->write_to(writer, msg);
+        }
+    }
+
+    dsn::task_ptr task = rpc::call(
+        dsn::dns_resolver::instance().resolve_address(secondary),
+        msg,
+        &_tracker,
+        [this, mutations](error_code err, dsn::message_ex *request, dsn::message_ex *reply) {
+            on_prepare_batch_reply(mutations, err, request, reply);
+        },
+        get_gpid().thread_hash());
+    for (const auto &mu : mutations) {
+        mu->remote_tasks()[secondary] = task;
+    }
+
+    LOG_DEBUG_PREFIX("mutations {} ~ {} send_prepare_batch_message to {}",
+                     mutations.front()->name(),
+                     mutations.back()->name(),
+                     secondary);
+}
+
 void replica::do_possible_commit_on_primary(mutation_ptr &mu)
 {
     CHECK_EQ(_config.ballot, mu->data.header.ballot);
@@ -620,6 +784,9 @@ void replica::on_prepare(dsn::message_ex *request)
     }
 
     CHECK_EQ(rconfig.status, status());
+    if (partition_status::PS_SECONDARY == status()) {
+        _secondary_states.last_primary_contact_ms = dsn_now_ms();
+    }
     if (decree <= last_committed_decree()) {
         ack_prepare_message(ERR_OK, mu);
         return;
@@ -674,6 +841,139 @@ void replica::on_prepare(dsn::message_ex *request)
     CHECK_NOTNULL(mu->log_task(), "");
 }
 
+void replica::on_prepare_batch(dsn::message_ex *request)
+{
+    _checker.only_one_thread_access();
+
+    replica_configuration rconfig;
+    std::vector<mutation_ptr> mutations;
+
+    {
+        rpc_read_stream reader(request);
+        unmarshall(reader, rconfig, DSF_THRIFT_BINARY);
+        int count = 0;
+        reader.read_pod(count);
+        mutations.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            // Since only one cumulative ack is replied for the whole batch, the request is not
+            // attached to each mutation but only to the one acking the batch.
+            mutations.push_back(mutation::read_from(reader, nullptr));
+            mutations.back()->is_received_in_batch = true;
+        }
+    }
+    CHECK(!mutations.empty(), "");
+
+    for (auto &mu : mutations) {
+        mu->_tracer->set_name(fmt::format("mutation[{}]", mu->name()));
+        mu->_tracer->set_description("secondary");
+        ADD_POINT(mu->_tracer);
+
+        CHECK_EQ(mu->data.header.pid, rconfig.pid);
+        CHECK_EQ(mu->data.header.ballot, rconfig.ballot);
+    }
+
+    LOG_DEBUG_PREFIX("mutations {} ~ {} on_prepare_batch",
+                     mutations.front()->name(),
+                     mutations.back()->name());
+
+    const auto ack_batch = [this, request, &mutations](error_code err) {
+        auto &mu = mutations.back();
+        mu->add_prepare_request(request);
+        ack_prepare_message(err, mu);
+    };
+
+    if (rconfig.ballot < get_ballot()) {
+        LOG_ERROR_PREFIX("mutations {} ~ {} on_prepare_batch skipped due to old view",
+                         mutations.front()->name(),
+                         mutations.back()->name());
+        // no need response because the rpc should have been cancelled on primary in this case
+        return;
+    }
+
+    // update configuration when necessary
+    else if (rconfig.ballot > get_ballot()) {
+        if (!update_local_configuration(rconfig)) {
+            LOG_ERROR_PREFIX("mutations {} ~ {} on_prepare_batch failed as update local "
+                             "configuration failed, state = {}",
+                             mutations.front()->name(),
+                             mutations.back()->name(),
+                             enum_to_string(status()));
+            ack_batch(ERR_INVALID_STATE);
+            return;
+        }
+    }
+
+    // Only the secondaries are sent the batched prepare requests.
+    if (partition_status::PS_SECONDARY != status()) {
+        LOG_ERROR_PREFIX(
+            "mutations {} ~ {} on_prepare_batch failed as invalid replica state, state = {}",
+            mutations.front()->name(),
+            mutations.back()->name(),
+            enum_to_string(status()));
+        ack_batch((partition_status::PS_INACTIVE == status() && _inactive_is_transient)
+                      ? ERR_INACTIVE_STATE
+                      : ERR_INVALID_STATE);
+        return;
+    }
+    _secondary_states.last_primary_contact_ms = dsn_now_ms();
+
+    mutation_ptr last_appended;
+    bool has_unlogged_duplicate = false;
+    for (auto &mu : mutations) {
+        const decree decree = mu->data.header.decree;
+        if (decree <= last_committed_decree()) {
+            continue;
+        }
+
+        _uniq_timestamp_us.try_update(mu->data.header.timestamp);
+        auto mu2 = _prepare_list->get_mutation_by_decree(decree);
+        if (mu2 != nullptr && mu2->data.header.ballot == mu->data.header.ballot) {
+            if (!mu2->is_logged()) {
+                has_unlogged_duplicate = true;
+            }
+            continue;
+        }
+
+        error_code err = _prepare_list->prepare(mu, status(), false);
+        CHECK_EQ_MSG(err, ERR_OK, "prepare mutation failed");
+        CHECK_LE_MSG(mu->data.header.decree,
+                     last_committed_decree() + FLAGS_max_mutation_count_in_prepare_list,
+                     "last_committed_decree: {}, FLAGS_max_mutation_count_in_prepare_list: {}",
+                     last_committed_decree(),
+                     FLAGS_max_mutation_count_in_prepare_list);
+
+        if (_split_mgr->is_splitting()) {
+            _split_mgr->copy_mutation(mu);
+        }
+
+        CHECK(mu->log_task() == nullptr, "");
+        mu->log_task() = _private_log->append(mu,
+                                              LPC_WRITE_REPLICATION_LOG,
+                                              &_tracker,
+                                              std::bind(&replica::on_append_log_completed,
+                                                        this,
+                                                        mu,
+                                                        std::placeholders::_1,
+                                                        std::placeholders::_2),
+                                              get_gpid().thread_hash());
+        CHECK_NOTNULL(mu->log_task(), "");
+        last_appended = mu;
+    }
+
+    // The mutations are appended to the private log and called back in order, thus once the
+    // last appended one is logged, all the mutations in the batch have been logged, including
+    // the duplicate ones appended before. Then it acks the whole batch.
+    if (last_appended != nullptr) {
+        last_appended->add_prepare_request(request);
+        return;
+    }
+
+    // Nothing is appended: either all the mutations are logged or committed, or some of them
+    // are still being logged for the previous requests, which let the primary retry them one by
+    // one.
+    ack_batch(has_unlogged_duplicate ? ERR_TRY_AGAIN : ERR_OK);
+}
+
 void replica::on_append_log_completed(mutation_ptr &mu, error_code err, size_t size)
 {
     _checker.only_one_thread_access();
@@ -736,30 +1036,57 @@ void replica::on_prepare_reply(std::pair<mutation_ptr, partition_status::type> p
 {
     _checker.only_one_thread_access();
 
-    mutation_ptr mu = pr.first;
-    partition_status::type target_status = pr.second;
+    // handle reply
+    prepare_ack resp;
 
-    // skip callback for old mutations
-    if (partition_status::PS_PRIMARY != status() || mu->data.header.ballot < get_ballot() ||
-        mu->get_decree() <= last_committed_decree())
-        return;
+    // handle error
+    if (err != ERR_OK) {
+        resp.err = err;
+    } else {
+        ::dsn::unmarshall(reply, resp);
+    }
 
-    CHECK_EQ_MSG(mu->data.header.ballot, get_ballot(), "{}: invalid mutation ballot", mu->name());
+    handle_prepare_ack(pr.first, pr.second, request->to_host_port, resp);
+}
 
-    const auto &node = request->to_host_port;
-    partition_status::type st = _primary_states.get_node_status(node);
+void replica::on_prepare_batch_reply(const std::vector<mutation_ptr> &mutations,
+                                     error_code err,
+                                     dsn::message_ex *request,
+                                     dsn::message_ex *reply)
+{
+    _checker.only_one_thread_access();
 
-    // handle reply
     prepare_ack resp;
-
-    // handle error
     if (err != ERR_OK) {
         resp.err = err;
     } else {
         ::dsn::unmarshall(reply, resp);
     }
 
-    auto send_prepare_tracer = mu->_tracer->sub_tracer(request->to_host_port.to_string());
+    // The cumulative ack tells that all the mutations in the batch have been logged on the
+    // secondary (or none of them would be), thus it's handled as the ack of each of them.
+    for (const auto &mu : mutations) {
+        prepare_ack ack = resp;
+        ack.decree = mu->get_decree();
+        handle_prepare_ack(mu, partition_status::PS_SECONDARY, request->to_host_port, ack);
+    }
+}
+
+void replica::handle_prepare_ack(mutation_ptr mu,
+                                 partition_status::type target_status,
+                                 const host_port &node,
+                                 const prepare_ack &resp)
+{
+    // skip callback for old mutations
+    if (partition_status::PS_PRIMARY != status() || mu->data.header.ballot < get_ballot() ||
+        mu->get_decree() <= last_committed_decree())
+        return;
+
+    CHECK_EQ_MSG(mu->data.header.ballot, get_ballot(), "{}: invalid mutation ballot", mu->name());
+
+    partition_status::type st = _primary_states.get_node_status(node);
+
+    auto send_prepare_tracer = mu->_tracer->sub_tracer(node.to_string());
     APPEND_EXTERN_POINT(send_prepare_tracer, resp.receive_timestamp, "remote_receive");
     APPEND_EXTERN_POINT(send_prepare_tracer, resp.response_timestamp, "remote_reply");
     ADD_CUSTOM_POINT(send_prepare_tracer, resp.err.to_string());
@@ -893,7 +1220,12 @@ void replica::ack_prepare_message(error_code err, mutation_ptr &mu)
     resp.last_committed_decree_in_prepare_list = last_committed_decree();
 
     const std::vector<dsn::message_ex *> &prepare_requests = mu->prepare_requests();
-    CHECK(!prepare_requests.empty(), "mutation = {}", mu->name());
+    if (prepare_requests.empty()) {
+        // The mutations received by RPC_PREPARE_BATCH are acked by the one carrying the
+        // request of the batch, see on_prepare_batch().
+        CHECK(mu->is_received_in_batch, "mutation = {}", mu->name());
+        return;
+    }
 
     if (err == ERR_OK) {
         if (mu->is_child_acked()) {
@@ -209,6 +209,7 @@ void replica::on_group_check(const group_check_request &request,
     case partition_status::PS_INACTIVE:
         break;
     case partition_status::PS_SECONDARY:
+        _secondary_states.last_primary_contact_ms = dsn_now_ms();
         if (request.last_committed_decree > last_committed_decree()) {
             _prepare_list->commit(request.last_committed_decree, COMMIT_TO_DECREE_HARD);
         }
@@ -1066,14 +1066,14 @@ bool replica::update_local_configuration_with_no_ballot_change(partition_status:
 }
 
 // ThreadPool: THREAD_POOL_REPLICATION
-void replica::on_config_sync(const app_info &info,
+bool replica::on_config_sync(const app_info &info,
                              const partition_configuration &pc,
                              split_status::type meta_split_status)
 {
     LOG_DEBUG_PREFIX("configuration sync");
     // no outdated update
     if (pc.ballot < get_ballot()) {
-        return;
+        return false;
     }
 
     update_app_max_replica_count(info.max_replica_count);
@@ -1085,8 +1085,10 @@ void replica::on_config_sync(const app_info &info,
     if (status() == partition_status::PS_PRIMARY) {
         if (nullptr != _primary_states.reconfiguration_task) {
             // already under reconfiguration, skip configuration sync
+            return false;
         } else if (info.partition_count != _app_info.partition_count) {
             _split_mgr->trigger_primary_parent_split(info.partition_count, meta_split_status);
+            return false;
         }
     } else {
         if (_is_initializing) {
@@ -1096,7 +1098,7 @@ void replica::on_config_sync(const app_info &info,
                 update_configuration_on_meta_server(config_type::CT_PRIMARY_FORCE_UPDATE_BALLOT,
                                                     pc.hp_primary,
                                                     const_cast<partition_configuration &>(pc));
-                return;
+                return false;
             }
             _is_initializing = false;
         }
@@ -1113,8 +1115,15 @@ void replica::on_config_sync(const app_info &info,
             } else {
                 LOG_INFO_PREFIX("state is non-transient inactive, waiting primary to remove me");
             }
+            return false;
         }
     }
+
+    // Only the replica serving with the same configs as meta server could skip the following
+    // config syncs, the others may need the same configs to be synced again to make progress.
+    return meta_split_status == split_status::NOT_SPLIT && pc.ballot == get_ballot() &&
+           (status() == partition_status::PS_PRIMARY ||
+            status() == partition_status::PS_SECONDARY);
 }
 
 void replica::update_app_name(const std::string &app_name)
@@ -44,6 +44,10 @@ void primary_context::cleanup(bool clean_pending_mutations)
 {
     do_cleanup_pending_mutations(clean_pending_mutations);
 
+    // clean up batched prepare
+    CLEANUP_TASK_ALWAYS(prepare_batch_flush_task)
+    prepare_batches.clear();
+
     // clean up group check
     CLEANUP_TASK_ALWAYS(group_check_task)
 
@@ -207,6 +211,7 @@ bool secondary_context::cleanup(bool force)
     CLEANUP_TASK(catchup_with_private_log_task, force)
 
     checkpoint_is_running = false;
+    last_primary_contact_ms = 0;
     return true;
 }
 
@@ -234,6 +239,8 @@ bool potential_secondary_context::cleanup(bool force)
         CLEANUP_TASK(completion_notify_task, true)
     }
 
+    CLEANUP_TASK(prepare_app_learn_request_task, force)
+
     CLEANUP_TASK(learn_remote_files_task, force)
 
     CLEANUP_TASK(catchup_with_private_log_task, force)
@@ -250,6 +257,8 @@ bool potential_secondary_context::cleanup(bool force)
     }
     learning_start_prepare_decree = invalid_decree;
     first_learn_start_decree = invalid_decree;
+    app_learn_request_prepared = false;
+    app_learn_request = blob();
     learning_status = learner_status::LearningInvalid;
     return true;
 }
@@ -257,7 +266,8 @@ bool potential_secondary_context::cleanup(bool force)
 bool potential_secondary_context::is_cleaned()
 {
     return nullptr == delay_learning_task && nullptr == learning_task &&
-           nullptr == learn_remote_files_task && nullptr == learn_remote_files_completed_task &&
+           nullptr == prepare_app_learn_request_task && nullptr == learn_remote_files_task &&
+           nullptr == learn_remote_files_completed_task &&
            nullptr == catchup_with_private_log_task && nullptr == completion_notify_task;
 }
 
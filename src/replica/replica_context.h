@@ -31,6 +31,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "bulk_load_types.h"
 #include "common/gpid.h"
@@ -44,6 +45,7 @@
 #include "runtime/api_layer1.h"
 #include "task/task.h"
 #include "utils/autoref_ptr.h"
+#include "utils/blob.h"
 #include "utils/fmt_logging.h"
 
 namespace dsn {
@@ -127,6 +129,19 @@ public:
     // 2pc batching
     mutation_queue write_queue;
 
+    // Used for batched prepare
+    // the mutations waiting to be sent to each secondary in one RPC_PREPARE_BATCH request,
+    // which are flushed once the limits are reached or by `prepare_batch_flush_task`
+    struct prepare_batch
+    {
+        std::vector<mutation_ptr> mutations;
+        int64_t bytes{0};
+    };
+    std::unordered_map<host_port, prepare_batch> prepare_batches;
+    // the task of LPC_FLUSH_PREPARE_BATCH, which is enqueued into the replica thread once the
+    // first mutation is batched, thus all the mutations prepared before it runs are batched
+    dsn::task_ptr prepare_batch_flush_task;
+
     // group check
     dsn::task_ptr group_check_task; // the repeated group check task of LPC_GROUP_CHECK
     // calls broadcast_group_check() to check all replicas separately
@@ -199,6 +214,9 @@ public:
 
 public:
     bool checkpoint_is_running;
+    // The last time in milliseconds the prepare or group check request from the primary was
+    // received, which is the lease to serve the bounded stale reads.
+    uint64_t last_primary_contact_ms{0};
     ::dsn::task_ptr checkpoint_task;
     ::dsn::task_ptr checkpoint_completed_task;
     ::dsn::task_ptr catchup_with_private_log_task;
@@ -245,8 +263,14 @@ public:
     // It indicates the minimum decree under `learn/` dir.
     decree first_learn_start_decree{invalid_decree};
 
+    // The app specific learn request, which is prepared off the replica thread only once for
+    // each learning, since it's only used by the learnee to learn the app.
+    bool app_learn_request_prepared{false};
+    blob app_learn_request;
+
     ::dsn::task_ptr delay_learning_task;
     ::dsn::task_ptr learning_task;
+    ::dsn::task_ptr prepare_app_learn_request_task;
     ::dsn::task_ptr learn_remote_files_task;
     ::dsn::task_ptr learn_remote_files_completed_task;
     ::dsn::task_ptr catchup_with_private_log_task;
@@ -226,6 +226,17 @@ void replica::init_learn(uint64_t signature)
         return;
     }
 
+    // The app specific learn request is only used by the learnee to learn the app, which only
+    // happens before the learned state is connected with the prepare list. Since preparing it
+    // might read the local files of the app, it's done off the replica thread, and only once
+    // for each learning.
+    const bool app_learn_request_needed =
+        _potential_secondary_states.learning_status == learner_status::LearningWithoutPrepare;
+    if (app_learn_request_needed && !_potential_secondary_states.app_learn_request_prepared) {
+        prepare_app_learn_request(signature);
+        return;
+    }
+
     METRIC_VAR_INCREMENT(learn_rounds);
     _potential_secondary_states.learning_round_is_running = true;
 
@@ -236,7 +247,9 @@ void replica::init_learn(uint64_t signature)
     request.last_committed_decree_in_prepare_list = _prepare_list->last_committed_decree();
     SET_IP_AND_HOST_PORT(request, learner, _stub->primary_address(), _stub->primary_host_port());
     request.signature = _potential_secondary_states.learning_version;
-    _app->prepare_get_checkpoint(request.app_specific_learn_request);
+    if (app_learn_request_needed) {
+        request.app_specific_learn_request = _potential_secondary_states.app_learn_request;
+    }
 
     LOG_INFO_PREFIX("init_learn[{:#018x}]: learnee = {}, learn_duration = {} ms, max_gced_decree = "
                     "{}, local_committed_decree = {}, app_committed_decree = {}, "
@@ -267,6 +280,61 @@ void replica::init_learn(uint64_t signature)
         });
 }
 
+// ThreadPool: THREAD_POOL_REPLICATION
+void replica::prepare_app_learn_request(uint64_t signature) // on learner
+{
+    _checker.only_one_thread_access();
+
+    _potential_secondary_states.learning_round_is_running = true;
+    _potential_secondary_states.prepare_app_learn_request_task = tasking::create_task(
+        LPC_PREPARE_APP_LEARN_REQUEST, &_tracker, [this, signature]() {
+            blob learn_req;
+            const auto err = _app->prepare_get_checkpoint(learn_req);
+            if (err != ERR_OK && err != ERR_NOT_IMPLEMENTED) {
+                // Just learn without the app specific request.
+                LOG_WARNING_PREFIX(
+                    "prepare_app_learn_request[{:#018x}]: prepare the app specific learn "
+                    "request failed, error = {}",
+                    signature,
+                    err);
+                learn_req = blob();
+            }
+
+            _potential_secondary_states.learning_task = tasking::create_task(
+                LPC_PREPARE_APP_LEARN_REQUEST_COMPLETED,
+                &_tracker,
+                [this, signature, req_cap = std::move(learn_req)]() mutable {
+                    on_prepare_app_learn_request_completed(signature, std::move(req_cap));
+                },
+                get_gpid().thread_hash());
+            _potential_secondary_states.learning_task->enqueue();
+        });
+    _potential_secondary_states.prepare_app_learn_request_task->enqueue();
+}
+
+// ThreadPool: THREAD_POOL_REPLICATION
+void replica::on_prepare_app_learn_request_completed(uint64_t signature,
+                                                     blob &&learn_req) // on learner
+{
+    _checker.only_one_thread_access();
+
+    if (status() != partition_status::PS_POTENTIAL_SECONDARY ||
+        signature != _potential_secondary_states.learning_version) {
+        LOG_WARNING_PREFIX("on_prepare_app_learn_request_completed[{:#018x}]: the learning is "
+                           "out-dated, current status = {}, current signature = {:#018x}, ignore",
+                           signature,
+                           enum_to_string(status()),
+                           _potential_secondary_states.learning_version);
+        return;
+    }
+
+    _potential_secondary_states.prepare_app_learn_request_task = nullptr;
+    _potential_secondary_states.app_learn_request_prepared = true;
+    _potential_secondary_states.app_learn_request = std::move(learn_req);
+    _potential_secondary_states.learning_round_is_running = false;
+    init_learn(signature);
+}
+
 // ThreadPool: THREAD_POOL_REPLICATION
 decree replica::get_max_gced_decree_for_learn() const // on learner
 {
@@ -738,6 +806,13 @@ void replica::on_learn_reply(error_code err, learn_request &&req, learn_response
         }
     }
 
+    if (resp.type == learn_type::LT_APP) {
+        // The local files of the app will be replaced by the learned ones, thus the app
+        // specific learn request has to be prepared again if the app is learned once more.
+        _potential_secondary_states.app_learn_request_prepared = false;
+        _potential_secondary_states.app_learn_request = blob();
+    }
+
     switch (resp.type) {
     case learn_type::LT_CACHE:
         METRIC_VAR_INCREMENT(learn_lt_cache_responses);
@@ -258,6 +258,11 @@ METRIC_DEFINE_gauge_int64(server,
                           dsn::metric_unit::kBytes,
                           "The max size of copied files among all splitting replicas");
 
+METRIC_DEFINE_gauge_int64(server,
+                          config_sync_response_bytes,
+                          dsn::metric_unit::kBytes,
+                          "The size of the last config sync response from meta server");
+
 DSN_DECLARE_bool(duplication_enabled);
 DSN_DECLARE_bool(empty_write_disabled);
 DSN_DECLARE_bool(enable_acl);
@@ -339,6 +344,21 @@ DSN_DEFINE_uint32(replication,
 DSN_TAG_VARIABLE(config_sync_interval_ms, FT_MUTABLE);
 DSN_DEFINE_validator(config_sync_interval_ms, [](uint32_t value) -> bool { return value > 0; });
 
+DSN_DEFINE_bool(replication,
+                config_sync_by_digest,
+                true,
+                "Whether to send the digests of the synced configs to meta server by config sync, "
+                "so that only the changed configs are sent back instead of all the configs of the "
+                "replicas on the node");
+DSN_TAG_VARIABLE(config_sync_by_digest, FT_MUTABLE);
+
+DSN_DEFINE_uint32(replication,
+                  full_config_sync_interval,
+                  10,
+                  "Every how many config syncs a full config sync without the digests is sent, "
+                  "in case some changes are missed by the digests. 0 means never");
+DSN_TAG_VARIABLE(full_config_sync_interval, FT_MUTABLE);
+
 DSN_DEFINE_int32(replication,
                  disk_stat_interval_seconds,
                  600,
@@ -494,7 +514,8 @@ replica_stub::replica_stub(replica_state_subscriber subscriber /*= nullptr*/,
       METRIC_VAR_INIT_server(splitting_replicas),
       METRIC_VAR_INIT_server(splitting_replicas_max_duration_ms),
       METRIC_VAR_INIT_server(splitting_replicas_async_learn_max_duration_ms),
-      METRIC_VAR_INIT_server(splitting_replicas_max_copy_file_bytes)
+      METRIC_VAR_INIT_server(splitting_replicas_max_copy_file_bytes),
+      METRIC_VAR_INIT_server(config_sync_response_bytes)
 {
     // Some flags might need to be tuned on the stage of loading replicas (during
     // replica_stub::initialize()), thus register their control command just in the
@@ -1366,7 +1387,11 @@ void replica_stub::on_prepare(dsn::message_ex *request)
     dsn::unmarshall(request, id);
     replica_ptr rep = get_replica(id);
     if (rep != nullptr) {
-        rep->on_prepare(request);
+        if (request->rpc_code() == RPC_PREPARE_BATCH) {
+            rep->on_prepare_batch(request);
+        } else {
+            rep->on_prepare(request);
+        }
     } else {
         prepare_ack resp;
         resp.pid = id;
@@ -1524,6 +1549,46 @@ void replica_stub::get_local_replicas(std::vector<replica_info> &replicas)
     }
 }
 
+// run in THREAD_POOL_META_SERVER
+// assert(_state_lock.locked())
+void replica_stub::fill_synced_config_digests(configuration_query_by_node_request &req)
+{
+    const bool full_sync = !FLAGS_config_sync_by_digest ||
+                           (FLAGS_full_config_sync_interval > 0 &&
+                            _config_syncs_since_full >= FLAGS_full_config_sync_interval);
+    if (full_sync) {
+        _config_syncs_since_full = 0;
+    } else {
+        ++_config_syncs_since_full;
+    }
+
+    zauto_lock l(_synced_config_digests_lock);
+    std::unordered_map<gpid, synced_config_digest> digests;
+    for (const auto &info : req.stored_replicas) {
+        const auto iter = _synced_config_digests.find(info.pid);
+        if (iter == _synced_config_digests.end()) {
+            continue;
+        }
+
+        // The digests of the replicas which have been closed are dropped.
+        digests.emplace(iter->first, iter->second);
+        if (full_sync || iter->second.config_ballot != info.ballot ||
+            (info.status != partition_status::PS_PRIMARY &&
+             info.status != partition_status::PS_SECONDARY)) {
+            continue;
+        }
+
+        config_sync_digest d;
+        d.pid = info.pid;
+        d.digest = iter->second.digest;
+        req.synced_digests.push_back(d);
+    }
+    _synced_config_digests.swap(digests);
+
+    // Always set even if empty, to tell meta server to reply with the digests.
+    req.__isset.synced_digests = FLAGS_config_sync_by_digest;
+}
+
 // run in THREAD_POOL_META_SERVER
 // assert(_state_lock.locked())
 void replica_stub::query_configuration_by_node()
@@ -1545,10 +1610,14 @@ void replica_stub::query_configuration_by_node()
     get_local_replicas(req.stored_replicas);
     req.__isset.stored_replicas = true;
 
+    fill_synced_config_digests(req);
+
     ::dsn::marshall(msg, req);
 
-    LOG_INFO("send query node partitions request to meta server, stored_replicas_count = {}",
-             req.stored_replicas.size());
+    LOG_INFO("send query node partitions request to meta server, stored_replicas_count = {}, "
+             "synced_digests_count = {}",
+             req.stored_replicas.size(),
+             req.synced_digests.size());
 
     const auto &target =
         dsn::dns_resolver::instance().resolve_address(_failure_detector->get_servers());
@@ -1621,9 +1690,11 @@ void replica_stub::on_node_query_reply(error_code err,
             return;
         }
 
+        METRIC_VAR_SET(config_sync_response_bytes, response->body_size());
         LOG_INFO("process query node partitions response for resp.err = ERR_OK, "
-                 "partitions_count({}), gc_replicas_count({})",
+                 "partitions_count({}), unchanged_partitions_count({}), gc_replicas_count({})",
                  resp.partitions.size(),
+                 resp.unchanged_partitions.size(),
                  resp.gc_replicas.size());
 
         replica_map_by_gpid reps;
@@ -1632,13 +1703,27 @@ void replica_stub::on_node_query_reply(error_code err,
             reps = _replicas;
         }
 
-        for (const auto &config_update : resp.partitions) {
+        const bool has_digests =
+            resp.__isset.digests && resp.digests.size() == resp.partitions.size();
+        for (size_t i = 0; i < resp.partitions.size(); ++i) {
+            const auto &config_update = resp.partitions[i];
             reps.erase(config_update.config.pid);
-            tasking::enqueue(
-                LPC_QUERY_NODE_CONFIGURATION_SCATTER,
-                &_tracker,
-                std::bind(&replica_stub::on_node_query_reply_scatter, this, this, config_update),
-                config_update.config.pid.thread_hash());
+            const bool has_digest = has_digests && resp.digests[i].pid == config_update.config.pid;
+            tasking::enqueue(LPC_QUERY_NODE_CONFIGURATION_SCATTER,
+                             &_tracker,
+                             std::bind(&replica_stub::on_node_query_reply_scatter,
+                                       this,
+                                       this,
+                                       config_update,
+                                       has_digest,
+                                       has_digest ? resp.digests[i].digest : 0),
+                             config_update.config.pid.thread_hash());
+        }
+
+        // The replicas whose configs are not changed since the last sync are still served by
+        // this node.
+        for (const auto &pid : resp.unchanged_partitions) {
+            reps.erase(pid);
         }
 
         // For the replicas that do not exist on meta_servers.
@@ -1673,10 +1758,11 @@ void replica_stub::set_meta_server_connected_for_test(
     _state = NS_Connected;
 
     for (auto it = resp.partitions.begin(); it != resp.partitions.end(); ++it) {
-        tasking::enqueue(LPC_QUERY_NODE_CONFIGURATION_SCATTER,
-                         &_tracker,
-                         std::bind(&replica_stub::on_node_query_reply_scatter, this, this, *it),
-                         it->config.pid.thread_hash());
+        tasking::enqueue(
+            LPC_QUERY_NODE_CONFIGURATION_SCATTER,
+            &_tracker,
+            std::bind(&replica_stub::on_node_query_reply_scatter, this, this, *it, false, 0),
+            it->config.pid.thread_hash());
     }
 }
 
@@ -1691,15 +1777,31 @@ void replica_stub::set_replica_state_subscriber_for_test(replica_state_subscribe
 // replica_stub::close
 // ThreadPool: THREAD_POOL_REPLICATION
 void replica_stub::on_node_query_reply_scatter(replica_stub_ptr this_,
-                                               const configuration_update_request &req)
+                                               const configuration_update_request &req,
+                                               bool has_digest,
+                                               int64_t digest)
 {
     replica_ptr replica = get_replica(req.config.pid);
+    bool synced = false;
     if (replica != nullptr) {
-        replica->on_config_sync(req.info,
-                                req.config,
-                                req.__isset.meta_split_status ? req.meta_split_status
-                                                              : split_status::NOT_SPLIT);
-    } else {
+        synced = replica->on_config_sync(req.info,
+                                         req.config,
+                                         req.__isset.meta_split_status ? req.meta_split_status
+                                                                       : split_status::NOT_SPLIT);
+    }
+
+    {
+        // The configs would be synced again by the next config sync if they have not been
+        // applied completely.
+        zauto_lock l(_synced_config_digests_lock);
+        if (has_digest && synced) {
+            _synced_config_digests[req.config.pid] = {digest, req.config.ballot};
+        } else {
+            _synced_config_digests.erase(req.config.pid);
+        }
+    }
+
+    if (replica == nullptr) {
         host_port primary;
         GET_HOST_PORT(req.config, primary, primary);
         if (primary == _primary_host_port) {
@@ -1780,6 +1882,13 @@ void replica_stub::on_meta_server_disconnected()
 
     _state = NS_Disconnected;
 
+    // The changes of the configs might be missed during the disconnection, sync all of them
+    // once connected again.
+    {
+        zauto_lock l(_synced_config_digests_lock);
+        _synced_config_digests.clear();
+    }
+
     replica_map_by_gpid reps;
     {
         zauto_read_lock rl(_replicas_lock);
@@ -2490,6 +2599,7 @@ void replica_stub::open_service()
 {
     register_rpc_handler(RPC_CONFIG_PROPOSAL, "ProposeConfig", &replica_stub::on_config_proposal);
     register_rpc_handler(RPC_PREPARE, "prepare", &replica_stub::on_prepare);
+    register_rpc_handler(RPC_PREPARE_BATCH, "prepare_batch", &replica_stub::on_prepare);
     register_rpc_handler(RPC_LEARN, "Learn", &replica_stub::on_learn);
     register_rpc_handler_with_rpc_holder(RPC_LEARN_COMPLETION_NOTIFY,
                                          "LearnNotify",
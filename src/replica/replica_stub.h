@@ -102,6 +102,7 @@ class get_file_size_response;
 } // namespace service
 
 namespace replication {
+class configuration_query_by_node_request;
 class configuration_query_by_node_response;
 class configuration_update_request;
 class potential_secondary_context;
@@ -350,10 +351,17 @@ private:
 
     void initialize_start();
     void query_configuration_by_node();
+    // Fill the digests of the synced configs of the replicas into the config sync request,
+    // unless it's time for a full config sync.
+    void fill_synced_config_digests(configuration_query_by_node_request &req);
     void on_meta_server_disconnected_scatter(replica_stub_ptr this_, gpid id);
     void on_node_query_reply(error_code err, dsn::message_ex *request, dsn::message_ex *response);
+    // `has_digest` is true if the digest of the configs is provided by meta server, which will
+    // be recorded once the configs are applied.
     void on_node_query_reply_scatter(replica_stub_ptr this_,
-                                     const configuration_update_request &config);
+                                     const configuration_update_request &config,
+                                     bool has_digest,
+                                     int64_t digest);
     void on_node_query_reply_scatter2(replica_stub_ptr this_, gpid id);
     void remove_replica_on_meta_server(const app_info &info, const partition_configuration &pc);
     task_ptr begin_open_replica(const app_info &app,
@@ -539,6 +547,20 @@ private:
     replica_state_subscriber _replica_state_subscriber;
     bool _is_long_subscriber;
 
+    // The digests of the configs synced from meta server, which are sent back to meta server
+    // by the following config syncs to avoid getting the unchanged configs again.
+    struct synced_config_digest
+    {
+        int64_t digest;
+        // The ballot of the synced config, the digest is no longer reported once the ballot
+        // of the replica is changed.
+        ballot config_ballot;
+    };
+    mutable zlock _synced_config_digests_lock;
+    std::unordered_map<gpid, synced_config_digest> _synced_config_digests;
+    // The number of the config syncs sent since the last full one, protected by _state_lock.
+    uint32_t _config_syncs_since_full{0};
+
     // temproal states
     ::dsn::task_ptr _config_query_task;
     ::dsn::timer_task_ptr _config_sync_timer_task;
@@ -628,6 +650,8 @@ private:
     METRIC_VAR_DECLARE_gauge_int64(splitting_replicas_async_learn_max_duration_ms);
     METRIC_VAR_DECLARE_gauge_int64(splitting_replicas_max_copy_file_bytes);
 
+    METRIC_VAR_DECLARE_gauge_int64(config_sync_response_bytes);
+
     dsn::task_tracker _tracker;
 };
 
@@ -28,7 +28,11 @@
 
 // IWYU pragma: no_include <ext/alloc_traits.h>
 #include <sys/types.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "aio/aio_task.h"
 #include "aio/file_io.h"
@@ -39,17 +43,25 @@
 #include "replica/log_block.h"
 #include "replica/log_file.h"
 #include "replica/mutation.h"
+#include "replica/plog_group_committer.h"
 #include "replica/test/mock_utils.h"
 #include "replica_test_base.h"
+#include "task/async_calls.h"
+#include "task/task_tracker.h"
 #include "test_util/test_util.h"
 #include "utils/binary_reader.h"
 #include "utils/binary_writer.h"
 #include "utils/blob.h"
 #include "utils/env.h"
+#include "utils/fail_point.h"
 #include "utils/filesystem.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/ports.h"
 
+DSN_DECLARE_bool(plog_force_flush);
+DSN_DECLARE_bool(plog_group_commit_enabled);
+
 namespace dsn {
 class message_ex;
 } // namespace dsn
@@ -319,6 +331,11 @@ public:
         return mutation_log_test::create_test_mutation(decree, decree - 1, data);
     }
 
+    static bool is_writing(const mutation_log_private *mlog)
+    {
+        return mlog->_is_writing.load(std::memory_order_acquire);
+    }
+
     static void ASSERT_BLOB_EQ(const blob &lhs, const blob &rhs)
     {
         ASSERT_EQ(std::string(lhs.data(), lhs.length()), std::string(rhs.data(), rhs.length()));
@@ -560,6 +577,159 @@ TEST_P(mutation_log_test, reset_from)
     ASSERT_TRUE(utils::filesystem::directory_exists(_log_dir));
 }
 
+TEST_P(mutation_log_test, group_commit)
+{
+    PRESERVE_FLAG(plog_force_flush);
+    PRESERVE_FLAG(plog_group_commit_enabled);
+    FLAGS_plog_force_flush = true;
+    FLAGS_plog_group_commit_enabled = true;
+
+    const int kMutationCount = 1000;
+    std::vector<mutation_ptr> mutations;
+    std::atomic<int> committed_count(0);
+    { // writing logs
+        mutation_log_ptr mlog = new mutation_log_private(_log_dir, 4, get_gpid(), _replica.get());
+        EXPECT_EQ(mlog->open(nullptr, nullptr), ERR_OK);
+
+        for (int i = 0; i < kMutationCount; i++) {
+            mutation_ptr mu = create_test_mutation(2 + i, "hello!");
+            mutations.push_back(mu);
+            mlog->append(mu,
+                         LPC_AIO_IMMEDIATE_CALLBACK,
+                         mlog->tracker(),
+                         [&committed_count](error_code err, size_t) {
+                             ASSERT_EQ(ERR_OK, err);
+                             ++committed_count;
+                         },
+                         0);
+        }
+
+        // All the mutations are on disk once flushed, including the ones waiting for the
+        // group committer to sync the log file.
+        mlog->flush();
+        mlog->tracker()->wait_outstanding_tasks();
+        ASSERT_EQ(kMutationCount, committed_count.load());
+        ASSERT_EQ(2 + kMutationCount - 1, mlog->max_decree_on_disk());
+        mlog->close();
+    }
+
+    { // reading logs
+        mutation_log_ptr mlog = new mutation_log_private(_log_dir, 4, get_gpid(), _replica.get());
+
+        int mutation_index = -1;
+        mlog->open(
+            [&mutations, &mutation_index](int log_length, mutation_ptr &mu) -> bool {
+                mutation_ptr wmu = mutations[++mutation_index];
+                EXPECT_EQ(wmu->data.header, mu->data.header);
+                ASSERT_BLOB_EQ(wmu->data.updates[0].data, mu->data.updates[0].data);
+                return true;
+            },
+            nullptr);
+        ASSERT_EQ(kMutationCount, mutation_index + 1);
+    }
+}
+
+TEST_P(mutation_log_test, group_commit_coalesce_syncs)
+{
+    plog_group_committer committer("group_commit_test", _log_dir, 0);
+    const int kFileCount = 2;
+    std::vector<log_file_ptr> files;
+    for (int i = 1; i <= kFileCount; ++i) {
+        auto lf = log_file::create_write(_log_dir.c_str(), i, 0);
+        ASSERT_NE(nullptr, lf);
+        files.push_back(lf);
+    }
+
+    // Hold the sync until all the requests below have been submitted.
+    fail::setup();
+    fail::cfg("plog_group_commit_postpone_sync", "return()");
+
+    // Each file is submitted several times, as if the consecutive writes of a private log.
+    const int kRequestCount = 10;
+    task_tracker tracker;
+    std::atomic<int> synced_count(0);
+    for (int i = 0; i < kRequestCount; ++i) {
+        committer.submit(files[i % kFileCount],
+                         tasking::create_task(LPC_PLOG_GROUP_COMMIT_COMPLETED,
+                                              &tracker,
+                                              [&synced_count]() { ++synced_count; }));
+    }
+    ASSERT_EQ(0, synced_count.load());
+
+    fail::cfg("plog_group_commit_postpone_sync", "off");
+    tracker.wait_outstanding_tasks();
+    fail::teardown();
+
+    // M requests are served by N syncs, where N is the number of the distinct files.
+    ASSERT_EQ(kRequestCount, synced_count.load());
+    ASSERT_EQ(kRequestCount, METRIC_VALUE(committer, plog_group_commit_requests));
+    ASSERT_EQ(1, METRIC_VALUE(committer, plog_group_commit_batches));
+    ASSERT_EQ(kFileCount, METRIC_VALUE(committer, plog_group_commit_synced_files));
+
+    for (auto &lf : files) {
+        lf->close();
+    }
+}
+
+TEST_P(mutation_log_test, group_commit_write_while_syncing)
+{
+    PRESERVE_FLAG(plog_force_flush);
+    PRESERVE_FLAG(plog_group_commit_enabled);
+    FLAGS_plog_force_flush = true;
+    FLAGS_plog_group_commit_enabled = true;
+
+    auto *committer = plog_group_committer::get_or_create(_replica->get_dir_node());
+    const auto old_requests = METRIC_VALUE(*committer, plog_group_commit_requests);
+    const auto old_batches = METRIC_VALUE(*committer, plog_group_commit_batches);
+    const auto old_synced_files = METRIC_VALUE(*committer, plog_group_commit_synced_files);
+
+    // Hold the sync until all the writes have been submitted.
+    fail::setup();
+    fail::cfg("plog_group_commit_postpone_sync", "return()");
+
+    const int kWriteCount = 5;
+    std::atomic<int> committed_count(0);
+    {
+        auto *plog = new mutation_log_private(_log_dir, 4, get_gpid(), _replica.get());
+        mutation_log_ptr mlog = plog;
+        ASSERT_EQ(ERR_OK, mlog->open(nullptr, nullptr));
+
+        for (int i = 0; i < kWriteCount; ++i) {
+            mutation_ptr mu = create_test_mutation(2 + i, "hello!");
+            mlog->append(mu,
+                         LPC_AIO_IMMEDIATE_CALLBACK,
+                         mlog->tracker(),
+                         [&committed_count](error_code err, size_t) {
+                             ASSERT_EQ(ERR_OK, err);
+                             ++committed_count;
+                         },
+                         0);
+
+            // Each mutation is written separately, and the next write is able to be issued
+            // once the previous one has been written, without waiting for the sync.
+            while (is_writing(plog)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        ASSERT_EQ(0, committed_count.load());
+
+        // Release the sync of the writes.
+        fail::cfg("plog_group_commit_postpone_sync", "off");
+        mlog->flush();
+        ASSERT_EQ(kWriteCount, committed_count.load());
+        ASSERT_EQ(2 + kWriteCount - 1, mlog->max_decree_on_disk());
+        mlog->close();
+    }
+    fail::teardown();
+
+    // All the writes of the log file are submitted into the same batch, thus the file is
+    // synced only once.
+    ASSERT_EQ(kWriteCount,
+              METRIC_VALUE(*committer, plog_group_commit_requests) - old_requests);
+    ASSERT_EQ(1, METRIC_VALUE(*committer, plog_group_commit_batches) - old_batches);
+    ASSERT_EQ(1, METRIC_VALUE(*committer, plog_group_commit_synced_files) - old_synced_files);
+}
+
 // multi-threaded testing. ensure reset_from will wait until
 // all previous writes complete.
 TEST_P(mutation_log_test, reset_from_while_writing)
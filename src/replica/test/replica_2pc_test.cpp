@@ -0,0 +1,379 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/gpid.h"
+#include "common/replication.codes.h"
+#include "common/replication_other_types.h"
+#include "consensus_types.h"
+#include "dsn.layer2_types.h"
+#include "gtest/gtest.h"
+#include "metadata_types.h"
+#include "replica/mutation.h"
+#include "replica/prepare_list.h"
+#include "replica/replica.h"
+#include "replica/replica_context.h"
+#include "replica/test/mock_utils.h"
+#include "replica_test_base.h"
+#include "rpc/rpc_host_port.h"
+#include "rpc/rpc_message.h"
+#include "rpc/serialization.h"
+#include "runtime/message_utils.h"
+#include "task/async_calls.h"
+#include "test_util/test_util.h"
+#include "utils/autoref_ptr.h"
+#include "utils/binary_writer.h"
+#include "utils/blob.h"
+#include "utils/error_code.h"
+#include "utils/fail_point.h"
+#include "utils/metrics.h"
+
+using pegasus::AssertEventually;
+
+namespace dsn {
+namespace replication {
+
+class replica_2pc_test : public replica_test_base
+{
+public:
+    replica_2pc_test()
+    {
+        // Never send the prepare requests to the fake secondaries, while the counters of the
+        // requests are still updated.
+        fail::setup();
+        fail::cfg("replica_send_prepare_message", "return()");
+        fail::cfg("replica_send_prepare_batch_message", "return()");
+
+        _replica->init_private_log(_log_dir);
+    }
+
+    ~replica_2pc_test() { fail::teardown(); }
+
+    // The replica is assumed to be accessed only by its own thread.
+    void run_on_replica_thread(std::function<void()> &&func)
+    {
+        tasking::enqueue(LPC_REPLICATION_COMMON,
+                         _replica->tracker(),
+                         std::move(func),
+                         _replica->get_gpid().thread_hash())
+            ->wait();
+    }
+
+    void mock_config(partition_status::type status, ballot b)
+    {
+        replica_configuration rconfig;
+        rconfig.pid = _replica->get_gpid();
+        rconfig.ballot = b;
+        rconfig.status = status;
+        _replica->set_replica_config(rconfig);
+    }
+
+    void mock_primary()
+    {
+        mock_config(partition_status::PS_PRIMARY, kBallot);
+
+        partition_configuration pc;
+        pc.max_replica_count = 3;
+        pc.pid = _replica->get_gpid();
+        pc.ballot = kBallot;
+        SET_IP_AND_HOST_PORT_BY_DNS(pc, primary, kPrimary);
+        ADD_IP_AND_HOST_PORT_BY_DNS(pc, secondaries, kSecondary1);
+        ADD_IP_AND_HOST_PORT_BY_DNS(pc, secondaries, kSecondary2);
+        _replica->set_primary_partition_configuration(pc);
+
+        _replica->_primary_states.statuses.clear();
+        _replica->_primary_states.statuses[kPrimary] = partition_status::PS_PRIMARY;
+        _replica->_primary_states.statuses[kSecondary1] = partition_status::PS_SECONDARY;
+        _replica->_primary_states.statuses[kSecondary2] = partition_status::PS_SECONDARY;
+    }
+
+    mutation_ptr create_mutation(decree d)
+    {
+        auto mu = _replica->new_mutation(d);
+        mu->data.header.last_committed_decree = _replica->last_committed_decree();
+        mu->data.updates.emplace_back(mutation_update());
+        mu->data.updates.back().code = RPC_REPLICATION_WRITE_EMPTY;
+        mu->data.updates.back().data = blob::create_from_bytes(std::string("hello"));
+        return mu;
+    }
+
+    // Prepare the mutations [start, end] on the primary as if they are going to be sent to
+    // all the secondaries. The mutations are never logged on the primary, thus would never be
+    // committed.
+    std::vector<mutation_ptr> prepare_on_primary(decree start, decree end)
+    {
+        std::vector<mutation_ptr> mutations;
+        for (decree d = start; d <= end; ++d) {
+            auto mu = create_mutation(d);
+            EXPECT_EQ(ERR_OK, _replica->_prepare_list->prepare(mu, partition_status::PS_PRIMARY));
+            mu->set_prepare_ts();
+            mu->set_left_secondary_ack_count(2);
+            mutations.push_back(mu);
+        }
+        return mutations;
+    }
+
+    void add_to_prepare_batch(const host_port &secondary, const std::vector<mutation_ptr> &muts)
+    {
+        for (const auto &mu : muts) {
+            _replica->add_to_prepare_batch(secondary, mu);
+        }
+    }
+
+    size_t prepare_batch_count() const { return _replica->_primary_states.prepare_batches.size(); }
+
+    // Reply the batch sent to the secondary with `err` for all the mutations.
+    void reply_prepare_batch(const host_port &secondary,
+                             const std::vector<mutation_ptr> &mutations,
+                             error_code err)
+    {
+        prepare_ack resp;
+        resp.pid = _replica->get_gpid();
+        resp.err = err;
+        resp.ballot = _replica->get_ballot();
+        resp.decree = mutations.back()->get_decree();
+
+        message_ptr request = message_ex::create_request(RPC_PREPARE_BATCH);
+        request->to_host_port = secondary;
+        message_ptr reply = from_thrift_request_to_received_message(resp, RPC_PREPARE_BATCH);
+        _replica->on_prepare_batch_reply(mutations, ERR_OK, request, reply);
+    }
+
+    // Build the RPC_PREPARE_BATCH request received by the secondary, whose gpid has been
+    // consumed by the replica stub.
+    message_ex *create_prepare_batch_request(const std::vector<mutation_ptr> &mutations)
+    {
+        replica_configuration rconfig;
+        rconfig.pid = _replica->get_gpid();
+        rconfig.ballot = _replica->get_ballot();
+        rconfig.status = partition_status::PS_SECONDARY;
+
+        binary_writer writer;
+        marshall(writer, rconfig, DSF_THRIFT_BINARY);
+        writer.write_pod(static_cast<int>(mutations.size()));
+        for (const auto &mu : mutations) {
+            mu->write_to(writer, nullptr);
+        }
+        return from_blob_to_received_msg(RPC_PREPARE_BATCH, writer.get_buffer());
+    }
+
+    int64_t prepare_requests() { return METRIC_VALUE(*_replica, prepare_requests); }
+    int64_t prepare_batch_requests() { return METRIC_VALUE(*_replica, prepare_batch_requests); }
+    int64_t prepare_failed_requests() { return METRIC_VALUE(*_replica, prepare_failed_requests); }
+
+    void test_full_batch_ack()
+    {
+        const auto old_prepare_requests = prepare_requests();
+        const auto old_prepare_batch_requests = prepare_batch_requests();
+
+        std::vector<mutation_ptr> mutations;
+        run_on_replica_thread([&]() {
+            mock_primary();
+            mutations = prepare_on_primary(1, 3);
+            add_to_prepare_batch(kSecondary1, mutations);
+            add_to_prepare_batch(kSecondary2, mutations);
+            ASSERT_EQ(2U, prepare_batch_count());
+        });
+
+        // The batches are flushed by the task queued after the one preparing the mutations.
+        run_on_replica_thread([&]() {
+            ASSERT_EQ(0U, prepare_batch_count());
+            ASSERT_EQ(old_prepare_batch_requests + 2, prepare_batch_requests());
+            ASSERT_EQ(old_prepare_requests, prepare_requests());
+
+            // The cumulative ack of a batch is the ack of each mutation in the batch.
+            reply_prepare_batch(kSecondary1, mutations, ERR_OK);
+            for (const auto &mu : mutations) {
+                ASSERT_EQ(1U, mu->left_secondary_ack_count());
+            }
+            reply_prepare_batch(kSecondary2, mutations, ERR_OK);
+            for (const auto &mu : mutations) {
+                ASSERT_EQ(0U, mu->left_secondary_ack_count());
+            }
+        });
+    }
+
+    void test_partially_duplicate_batch()
+    {
+        std::vector<mutation_ptr> received;
+        run_on_replica_thread([&]() {
+            mock_config(partition_status::PS_SECONDARY, kBallot);
+
+            // Decree 1 has been prepared by a previous request of the same ballot.
+            received.push_back(create_mutation(1));
+            auto prepared = create_mutation(1);
+            ASSERT_EQ(ERR_OK,
+                      _replica->_prepare_list->prepare(prepared, partition_status::PS_SECONDARY));
+            prepared->set_logged();
+            for (decree d = 2; d <= 3; ++d) {
+                received.push_back(create_mutation(d));
+            }
+
+            message_ptr request = create_prepare_batch_request(received);
+            _replica->on_prepare_batch(request);
+
+            // The duplicate one is skipped, while the others are appended.
+            ASSERT_EQ(prepared, _replica->_prepare_list->get_mutation_by_decree(1));
+            ASSERT_EQ(3, _replica->_prepare_list->max_decree());
+        });
+        _replica->tracker()->wait_outstanding_tasks();
+
+        run_on_replica_thread([&]() {
+            auto mu2 = _replica->_prepare_list->get_mutation_by_decree(2);
+            auto mu3 = _replica->_prepare_list->get_mutation_by_decree(3);
+            ASSERT_TRUE(mu2->is_logged());
+            ASSERT_TRUE(mu3->is_logged());
+            ASSERT_TRUE(mu2->is_received_in_batch);
+            ASSERT_TRUE(mu3->is_received_in_batch);
+
+            // Only the last appended mutation carries the request, to ack the whole batch.
+            ASSERT_TRUE(mu2->prepare_requests().empty());
+            ASSERT_EQ(1U, mu3->prepare_requests().size());
+        });
+
+        run_on_replica_thread([&]() {
+            // Decree 4 is still being logged for a previous request, thus nothing in the batch
+            // is appended, and the primary would retry them one by one.
+            auto logging = create_mutation(4);
+            ASSERT_EQ(ERR_OK,
+                      _replica->_prepare_list->prepare(logging, partition_status::PS_SECONDARY));
+
+            message_ptr request =
+                create_prepare_batch_request({create_mutation(3), create_mutation(4)});
+            _replica->on_prepare_batch(request);
+            ASSERT_EQ(logging, _replica->_prepare_list->get_mutation_by_decree(4));
+            ASSERT_FALSE(logging->is_logged());
+            ASSERT_TRUE(logging->prepare_requests().empty());
+        });
+    }
+
+    void test_try_again_fallback()
+    {
+        const auto old_prepare_requests = prepare_requests();
+        const auto old_prepare_batch_requests = prepare_batch_requests();
+        const auto old_prepare_failed_requests = prepare_failed_requests();
+
+        std::vector<mutation_ptr> mutations;
+        run_on_replica_thread([&]() {
+            mock_primary();
+            mutations = prepare_on_primary(1, 3);
+            add_to_prepare_batch(kSecondary1, mutations);
+        });
+
+        run_on_replica_thread([&]() {
+            ASSERT_EQ(old_prepare_batch_requests + 1, prepare_batch_requests());
+            reply_prepare_batch(kSecondary1, mutations, ERR_TRY_AGAIN);
+            for (const auto &mu : mutations) {
+                ASSERT_EQ(2U, mu->left_secondary_ack_count());
+            }
+        });
+
+        // Each mutation of the batch is retried by a single prepare after a short delay.
+        ASSERT_IN_TIME(
+            [&]() {
+                ASSERT_EQ(old_prepare_requests + static_cast<int64_t>(mutations.size()),
+                          prepare_requests());
+            },
+            10);
+        ASSERT_EQ(old_prepare_batch_requests + 1, prepare_batch_requests());
+        ASSERT_EQ(old_prepare_failed_requests, prepare_failed_requests());
+    }
+
+    void test_single_prepare_after_batch()
+    {
+        const auto old_prepare_requests = prepare_requests();
+        const auto old_prepare_batch_requests = prepare_batch_requests();
+
+        run_on_replica_thread([&]() {
+            mock_primary();
+            auto mutations = prepare_on_primary(1, 3);
+            add_to_prepare_batch(kSecondary1, {mutations[0], mutations[1]});
+            ASSERT_EQ(1U, prepare_batch_count());
+
+            // The pending batch is sent before the single prepare, which would otherwise
+            // overtake the batched mutations.
+            _replica->send_prepare_message(kSecondary1,
+                                           partition_status::PS_SECONDARY,
+                                           mutations[2],
+                                           1000,
+                                           true,
+                                           invalid_signature);
+            ASSERT_EQ(0U, prepare_batch_count());
+            ASSERT_EQ(old_prepare_batch_requests + 1, prepare_batch_requests());
+            ASSERT_EQ(old_prepare_requests + 1, prepare_requests());
+        });
+    }
+
+    void test_config_changed_while_batching()
+    {
+        const auto old_prepare_requests = prepare_requests();
+        const auto old_prepare_batch_requests = prepare_batch_requests();
+
+        run_on_replica_thread([&]() {
+            mock_primary();
+            add_to_prepare_batch(kSecondary1, prepare_on_primary(1, 3));
+
+            // The ballot is changed before the batch is flushed.
+            mock_config(partition_status::PS_PRIMARY, kBallot + 1);
+        });
+
+        run_on_replica_thread([&]() {
+            // The mutations of the old ballot are never sent.
+            ASSERT_EQ(0U, prepare_batch_count());
+            ASSERT_EQ(old_prepare_batch_requests, prepare_batch_requests());
+            ASSERT_EQ(old_prepare_requests, prepare_requests());
+
+            mock_primary();
+            add_to_prepare_batch(kSecondary1, prepare_on_primary(4, 6));
+
+            // The replica is no longer the primary before the batch is flushed.
+            mock_config(partition_status::PS_SECONDARY, kBallot + 1);
+        });
+
+        run_on_replica_thread([&]() {
+            ASSERT_EQ(0U, prepare_batch_count());
+            ASSERT_EQ(old_prepare_batch_requests, prepare_batch_requests());
+            ASSERT_EQ(old_prepare_requests, prepare_requests());
+        });
+    }
+
+    const ballot kBallot = 3;
+    const host_port kPrimary = host_port("localhost", 34801);
+    const host_port kSecondary1 = host_port("localhost", 34802);
+    const host_port kSecondary2 = host_port("localhost", 34803);
+};
+
+INSTANTIATE_TEST_SUITE_P(, replica_2pc_test, ::testing::Values(false, true));
+
+TEST_P(replica_2pc_test, full_batch_ack) { test_full_batch_ack(); }
+
+TEST_P(replica_2pc_test, partially_duplicate_batch) { test_partially_duplicate_batch(); }
+
+TEST_P(replica_2pc_test, try_again_fallback) { test_try_again_fallback(); }
+
+TEST_P(replica_2pc_test, single_prepare_after_batch) { test_single_prepare_after_batch(); }
+
+TEST_P(replica_2pc_test, config_changed_while_batching) { test_config_changed_while_batching(); }
+
+} // namespace replication
+} // namespace dsn
@@ -30,6 +30,7 @@
 #include "replica/duplication/test/duplication_test_base.h"
 #include "replica/prepare_list.h"
 #include "replica/replica_context.h"
+#include "utils/blob.h"
 #include "utils/fmt_logging.h"
 
 namespace dsn {
@@ -175,6 +176,26 @@ public:
             ASSERT_EQ(_replica->get_max_gced_decree_for_learn(), tt.want);
         }
     }
+
+    void test_prepare_app_learn_request_out_dated()
+    {
+        _replica = create_duplicating_replica();
+        auto &states = _replica->_potential_secondary_states;
+        states.learning_version = 2;
+        states.learning_round_is_running = true;
+
+        // The request prepared for the previous learning should be ignored, and should not
+        // interfere with the current one.
+        _replica->on_prepare_app_learn_request_completed(1, blob::create_from_bytes("manifest"));
+        ASSERT_FALSE(states.app_learn_request_prepared);
+        ASSERT_EQ(0, states.app_learn_request.length());
+        ASSERT_TRUE(states.learning_round_is_running);
+
+        // The request is also ignored once the replica is no longer a learner.
+        _replica->on_prepare_app_learn_request_completed(2, blob::create_from_bytes("manifest"));
+        ASSERT_FALSE(states.app_learn_request_prepared);
+        ASSERT_EQ(0, states.app_learn_request.length());
+    }
 };
 
 INSTANTIATE_TEST_SUITE_P(, replica_learn_test, ::testing::Values(false, true));
@@ -183,5 +204,10 @@ TEST_P(replica_learn_test, get_learn_start_decree) { test_get_learn_start_decree
 
 TEST_P(replica_learn_test, get_max_gced_decree_for_learn) { test_get_max_gced_decree_for_learn(); }
 
+TEST_P(replica_learn_test, prepare_app_learn_request_out_dated)
+{
+    test_prepare_app_learn_request_out_dated();
+}
+
 } // namespace replication
 } // namespace dsn
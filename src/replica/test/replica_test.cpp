@@ -43,7 +43,9 @@
 #include "http/http_status_code.h"
 #include "metadata_types.h"
 #include "replica/disk_cleaner.h"
+#include "replica/prepare_list.h"
 #include "replica/replica.h"
+#include "replica/replica_context.h"
 #include "replica/replica_http_service.h"
 #include "replica/replica_stub.h"
 #include "replica/test/mock_utils.h"
@@ -110,6 +112,22 @@ public:
         return _mock_replica->get_backup_request_count();
     }
 
+    void set_last_primary_contact_ms(uint64_t contact_ms) const
+    {
+        _mock_replica->_secondary_states.last_primary_contact_ms = contact_ms;
+    }
+
+    // Prepare the mutations of [1, `count`] on the secondary without committing them.
+    void prepare_uncommitted_mutations(decree count)
+    {
+        for (decree d = 1; d <= count; ++d) {
+            auto mu = create_test_mutation(d, 0, "test");
+            ASSERT_EQ(ERR_OK,
+                      _mock_replica->_prepare_list->prepare(
+                          mu, partition_status::PS_SECONDARY, false, false));
+        }
+    }
+
     [[nodiscard]] bool get_validate_partition_hash() const
     {
         return _mock_replica->_validate_partition_hash;
@@ -346,6 +364,59 @@ TEST_P(replica_test, backup_request_count)
     ASSERT_EQ(initial_backup_request_count + 1, get_backup_request_count());
 }
 
+TEST_P(replica_test, stale_backup_request_rejected)
+{
+    // create backup request bounded by the staleness
+    struct dsn::message_header header;
+    header.context.u.is_backup_request = true;
+    header.context.u.max_read_staleness = 2;
+    message_ptr backup_request = dsn::message_ex::create_request(task_code());
+    backup_request->header = &header;
+    std::unique_ptr<tools::sim_network_provider> sim_net(
+        new tools::sim_network_provider(nullptr, nullptr));
+    backup_request->io_session = sim_net->create_client_session(rpc_address());
+
+    _mock_replica->as_secondary();
+    set_last_primary_contact_ms(dsn_now_ms());
+
+    // 3 mutations have been prepared but not committed yet.
+    prepare_uncommitted_mutations(3);
+    ASSERT_EQ(3, _mock_replica->max_prepared_decree() - _mock_replica->last_committed_decree());
+
+    const auto initial_backup_request_count = get_backup_request_count();
+    const auto initial_stale_rejected_count =
+        METRIC_VALUE(*_mock_replica, stale_rejected_backup_requests);
+
+    // The lag exceeds the bound, thus the read is rejected with ERR_TRY_AGAIN.
+    _mock_replica->on_client_read(backup_request, false);
+    ASSERT_EQ(initial_stale_rejected_count + 1,
+              METRIC_VALUE(*_mock_replica, stale_rejected_backup_requests));
+    ASSERT_EQ(initial_backup_request_count, get_backup_request_count());
+
+    // The read is served once the bound covers the lag.
+    header.context.u.max_read_staleness = 3;
+    _mock_replica->on_client_read(backup_request, false);
+    ASSERT_EQ(initial_stale_rejected_count + 1,
+              METRIC_VALUE(*_mock_replica, stale_rejected_backup_requests));
+    ASSERT_EQ(initial_backup_request_count + 1, get_backup_request_count());
+    ASSERT_EQ(3, header.context.u.read_staleness);
+
+    // The secondary might have been removed by the primary once the lease expires, thus the
+    // read is rejected even if the lag is within the bound.
+    set_last_primary_contact_ms(0);
+    _mock_replica->on_client_read(backup_request, false);
+    ASSERT_EQ(initial_stale_rejected_count + 2,
+              METRIC_VALUE(*_mock_replica, stale_rejected_backup_requests));
+    ASSERT_EQ(initial_backup_request_count + 1, get_backup_request_count());
+
+    // The backup requests without the bound are not affected.
+    header.context.u.max_read_staleness = 0;
+    _mock_replica->on_client_read(backup_request, false);
+    ASSERT_EQ(initial_stale_rejected_count + 2,
+              METRIC_VALUE(*_mock_replica, stale_rejected_backup_requests));
+    ASSERT_EQ(initial_backup_request_count + 2, get_backup_request_count());
+}
+
 TEST_P(replica_test, query_data_version_test)
 {
     replica_http_service http_svc(stub.get());
@@ -620,10 +620,30 @@ bool rpc_session::is_negotiation_succeed() const
 void rpc_session::set_client_username(const std::string &user_name)
 {
     _client_username = user_name;
+    for (auto &decision : _acl_decisions) {
+        decision.store(0, std::memory_order_relaxed);
+    }
 }
 
 const std::string &rpc_session::get_client_username() const { return _client_username; }
 
+bool rpc_session::get_cached_acl_decision(uint64_t key, bool &allowed) const
+{
+    const auto decision = _acl_decisions[acl_decision_slot(key)].load(std::memory_order_relaxed);
+    if ((decision >> 1) != key) {
+        return false;
+    }
+
+    allowed = (decision & 1) != 0;
+    return true;
+}
+
+void rpc_session::set_cached_acl_decision(uint64_t key, bool allowed)
+{
+    _acl_decisions[acl_decision_slot(key)].store(key << 1 | (allowed ? 1 : 0),
+                                                 std::memory_order_relaxed);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 network::network(rpc_engine *srv, network *inner_provider)
     : _engine(srv), _client_hdr_format(NET_HDR_DSN), _unknown_msg_header_format(NET_HDR_INVALID)
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -298,6 +299,15 @@ public:
     void set_client_username(const std::string &user_name);
     const std::string &get_client_username() const;
 
+    // A tiny cache of the access control decisions made for the client of this server session,
+    // so that checking the ACL of a request is usually a single atomic load and compare. The
+    // `key` is opaque to the session and must be non-zero; it's up to the access controller to
+    // encode everything that the decision depends on (e.g. the version of the policies and the
+    // access type) into it, so that the stale entries are never matched again. The cache is
+    // cleared once the client username is changed.
+    bool get_cached_acl_decision(uint64_t key, /*out*/ bool &allowed) const;
+    void set_cached_acl_decision(uint64_t key, bool allowed);
+
     ///
     /// for subclass to implement receiving message
     ///
@@ -394,6 +404,18 @@ private:
     // it represents the name of the corresponding client
     std::string _client_username;
 
+    // Each slot holds `key << 1 | allowed`, 0 means the slot is empty. The slot of a key is
+    // chosen by the high bits of its Fibonacci hash rather than its low bits, since the keys of
+    // the different tables usually differ only in the high bits (i.e. the policy versions).
+    static constexpr size_t kAclDecisionCacheSlotBits = 3;
+    static constexpr size_t kAclDecisionCacheSlots = 1 << kAclDecisionCacheSlotBits;
+    static size_t acl_decision_slot(uint64_t key)
+    {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >>
+                                   (64 - kAclDecisionCacheSlotBits));
+    }
+    std::array<std::atomic<uint64_t>, kAclDecisionCacheSlots> _acl_decisions{};
+
     DISALLOW_COPY_AND_ASSIGN(rpc_session);
     DISALLOW_MOVE_AND_ASSIGN(rpc_session);
 };
@@ -73,7 +73,12 @@ typedef union msg_context
         uint64_t serialize_format : 4;     ///< dsn_msg_serialize_format
         uint64_t is_forward_supported : 1; ///< whether support forwarding a message to real leader
         uint64_t is_backup_request : 1;    ///< whether the RPC is a backup request
-        uint64_t reserved : 52;
+        uint64_t max_read_staleness : 16;  ///< for the read requests, the max number of decrees
+                                           ///< the serving secondary could lag behind the primary,
+                                           ///< 0 means unbounded
+        uint64_t read_staleness : 16;      ///< for the read responses, the number of decrees the
+                                           ///< serving replica could lag behind the primary
+        uint64_t reserved : 20;
     } u;
     uint64_t context; ///< msg_context is of sizeof(uint64_t)
 } msg_context_t;
@@ -248,6 +253,7 @@ public:
     void restore_read();
 
     bool is_backup_request() const { return header->context.u.is_backup_request; }
+    uint32_t max_read_staleness() const { return header->context.u.max_read_staleness; }
 
 private:
     message_ex();
@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <atomic>
 #include <utility>
 
 // Disable class-memaccess warning to facilitate compilation with gcc>7
@@ -41,9 +42,75 @@ DSN_DECLARE_bool(enable_ranger_acl);
 
 namespace dsn {
 namespace security {
+
+namespace {
+
+// The version of the compiled policies is at most 55 bits, so that it could be encoded into the
+// key of the decisions cached in the sessions along with the access type.
+std::atomic<uint64_t> s_next_compiled_ranger_policies_version{1};
+
+uint64_t acl_decision_cache_key(uint64_t version, ranger::access_type req_type)
+{
+    return version << 8 | static_cast<ranger::act>(req_type);
+}
+
+} // anonymous namespace
+
+std::shared_ptr<const compiled_ranger_policies>
+compiled_ranger_policies::compile(const matched_database_table_policies &policies)
+{
+    auto compiled = std::make_shared<compiled_ranger_policies>();
+    compiled->version = s_next_compiled_ranger_policies_version.fetch_add(1);
+
+    // The users who are not mentioned by any policy item never match any policy, thus are
+    // always denied. For the others, evaluate each access type once here rather than on every
+    // request.
+    std::unordered_set<std::string> users;
+    for (const auto &policy : policies) {
+        for (const auto *items : {&policy.policies.allow_policies,
+                                  &policy.policies.allow_policies_exclude,
+                                  &policy.policies.deny_policies,
+                                  &policy.policies.deny_policies_exclude}) {
+            for (const auto &item : *items) {
+                users.insert(item.users.begin(), item.users.end());
+            }
+        }
+    }
+
+    for (const auto &user : users) {
+        auto allowed_types = ranger::kAccessTypeNone;
+        for (const auto type : {ranger::access_type::kRead,
+                                ranger::access_type::kWrite,
+                                ranger::access_type::kCreate,
+                                ranger::access_type::kDrop,
+                                ranger::access_type::kList,
+                                ranger::access_type::kMetadata,
+                                ranger::access_type::kControl}) {
+            if (ranger::check_ranger_database_table_policy_allowed(policies, type, user) ==
+                ranger::access_control_result::kAllowed) {
+                allowed_types |= type;
+            }
+        }
+        if (allowed_types != ranger::kAccessTypeNone) {
+            compiled->allowed_access_types.emplace(user, allowed_types);
+        }
+    }
+    return compiled;
+}
+
+bool compiled_ranger_policies::allowed(const std::string &user_name,
+                                       ranger::access_type req_type) const
+{
+    const auto iter = allowed_access_types.find(user_name);
+    return iter != allowed_access_types.end() && (iter->second & req_type) == req_type &&
+           req_type != ranger::kAccessTypeNone;
+}
+
 replica_access_controller::replica_access_controller(const std::string &replica_name)
+    : _compiled_ranger_policies(compiled_ranger_policies::compile({}))
 {
     _name = replica_name;
+    _compiled_ranger_policies_version.store(_compiled_ranger_policies->version);
 }
 
 bool replica_access_controller::allowed(message_ex *msg, ranger::access_type req_type) const
@@ -68,11 +135,24 @@ bool replica_access_controller::allowed(message_ex *msg, ranger::access_type req
     }
 
     // use Ranger policy for ACL.
-    {
-        utils::auto_read_lock l(_lock);
-        return check_ranger_database_table_policy_allowed(_ranger_policies, req_type, user_name) ==
-               ranger::access_control_result::kAllowed;
+    return ranger_allowed(msg, req_type);
+}
+
+bool replica_access_controller::ranger_allowed(message_ex *msg, ranger::access_type req_type) const
+{
+    // The decision cached with the current version could be used directly. Even if the policies
+    // are being updated concurrently, it's the same as if the request came a little earlier.
+    bool allowed = false;
+    if (msg->io_session->get_cached_acl_decision(
+            acl_decision_cache_key(_compiled_ranger_policies_version.load(), req_type), allowed)) {
+        return allowed;
     }
+
+    const auto compiled = std::atomic_load(&_compiled_ranger_policies);
+    allowed = compiled->allowed(msg->io_session->get_client_username(), req_type);
+    msg->io_session->set_cached_acl_decision(acl_decision_cache_key(compiled->version, req_type),
+                                             allowed);
+    return allowed;
 }
 
 void replica_access_controller::update_allowed_users(const std::string &users)
@@ -108,10 +188,16 @@ void replica_access_controller::update_ranger_policies(const std::string &polici
     auto tmp_policies_str = policies;
     dsn::json::json_forwarder<matched_database_table_policies>::decode(
         dsn::blob::create_from_bytes(std::move(tmp_policies_str)), tmp_policies);
+    auto compiled = compiled_ranger_policies::compile(tmp_policies);
     {
         utils::auto_write_lock l(_lock);
         _env_policies = policies;
         _ranger_policies = std::move(tmp_policies);
+        // Publish the version after the policies, so that a request which has seen the new
+        // version never evaluates the old policies.
+        const auto version = compiled->version;
+        std::atomic_store(&_compiled_ranger_policies, std::move(compiled));
+        _compiled_ranger_policies_version.store(version);
     }
 }
 
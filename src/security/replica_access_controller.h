@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -34,6 +38,23 @@ namespace security {
 
 using matched_database_table_policies = std::vector<ranger::matched_database_table_policy>;
 
+// The Ranger policies compiled into the access types allowed for each user, which is immutable
+// once built and replaced as a whole when the policies are updated.
+struct compiled_ranger_policies
+{
+    // Unique among all the compiled policies of the process, thus the decisions cached in the
+    // sessions for one table never match the ones of the other tables.
+    uint64_t version{0};
+
+    // The users not found here are not allowed to access the table at all.
+    std::unordered_map<std::string, ranger::access_type> allowed_access_types;
+
+    static std::shared_ptr<const compiled_ranger_policies>
+    compile(const matched_database_table_policies &policies);
+
+    bool allowed(const std::string &user_name, ranger::access_type req_type) const;
+};
+
 class replica_access_controller : public access_controller
 {
 public:
@@ -57,6 +78,10 @@ private:
     // Security check to avoid allowed_users is not empty in special scenarios.
     void check_allowed_users_valid() const;
 
+    // Check the request by the compiled Ranger policies, the decision is cached in the session
+    // of the request until the policies are updated.
+    bool ranger_allowed(message_ex *msg, ranger::access_type req_type) const;
+
     mutable utils::rw_lock_nr _lock;
     // Users will pass the access control in the legacy ACL.
     std::unordered_set<std::string> _allowed_users;
@@ -72,6 +97,11 @@ private:
     // The Ranger policies for ACL.
     matched_database_table_policies _ranger_policies;
 
+    // The compiled '_ranger_policies', which is accessed by std::atomic_load/atomic_store rather
+    // than under '_lock', along with its version to look up the cached decisions in the sessions.
+    std::shared_ptr<const compiled_ranger_policies> _compiled_ranger_policies;
+    std::atomic<uint64_t> _compiled_ranger_policies_version{0};
+
     std::string _name;
 
     friend class replica_access_controller_test;
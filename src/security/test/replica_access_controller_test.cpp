@@ -20,18 +20,23 @@
 #include <unordered_set>
 #include <utility>
 
+#include "common/json_helper.h"
 #include "common/replication.codes.h"
 #include "gtest/gtest.h"
 #include "ranger/access_type.h"
+#include "ranger/ranger_resource_policy.h"
 #include "rpc/network.h"
 #include "rpc/network.sim.h"
 #include "rpc/rpc_address.h"
 #include "rpc/rpc_message.h"
 #include "security/replica_access_controller.h"
+#include "test_util/test_util.h"
 #include "utils/autoref_ptr.h"
+#include "utils/blob.h"
 #include "utils/flags.h"
 
 DSN_DECLARE_bool(enable_acl);
+DSN_DECLARE_bool(enable_ranger_acl);
 
 namespace dsn {
 namespace security {
@@ -54,6 +59,13 @@ public:
         _replica_access_controller->_allowed_users.swap(replica_users);
     }
 
+    void update_ranger_policies(const matched_database_table_policies &policies)
+    {
+        const auto policies_str =
+            dsn::json::json_forwarder<matched_database_table_policies>::encode(policies);
+        _replica_access_controller->update_ranger_policies(policies_str.to_string());
+    }
+
     std::unique_ptr<replica_access_controller> _replica_access_controller;
 };
 
@@ -87,5 +99,111 @@ TEST_F(replica_access_controller_test, allowed)
 
     FLAGS_enable_acl = origin_enable_acl;
 }
+
+TEST_F(replica_access_controller_test, ranger_allowed)
+{
+    PRESERVE_FLAG(enable_acl);
+    PRESERVE_FLAG(enable_ranger_acl);
+    FLAGS_enable_acl = true;
+    FLAGS_enable_ranger_acl = true;
+
+    std::unique_ptr<tools::sim_network_provider> sim_net(
+        new tools::sim_network_provider(nullptr, nullptr));
+    auto sim_session =
+        sim_net->create_client_session(rpc_address::from_host_port("localhost", 10086));
+    dsn::message_ptr msg = message_ex::create_request(RPC_CM_LIST_APPS);
+    msg->io_session = sim_session;
+    sim_session->set_client_username("user1");
+
+    const auto check = [&](bool read_allowed, bool write_allowed) {
+        // The second check of each type is served by the decision cached in the session.
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_EQ(read_allowed,
+                      _replica_access_controller->allowed(msg, ranger::access_type::kRead));
+            ASSERT_EQ(write_allowed,
+                      _replica_access_controller->allowed(msg, ranger::access_type::kWrite));
+        }
+    };
+
+    // No policy is set, all the users are denied.
+    check(false, false);
+
+    ranger::matched_database_table_policy policy;
+    policy.matched_database_name = "db";
+    policy.matched_table_name = "table";
+    policy.policies.allow_policies = {
+        {ranger::access_type::kRead | ranger::access_type::kWrite, {"user1", "user2"}}};
+    update_ranger_policies({policy});
+    check(true, true);
+
+    // The cached decisions are invalidated once the policies are updated.
+    policy.policies.deny_policies = {{ranger::access_type::kWrite, {"user1"}}};
+    update_ranger_policies({policy});
+    check(true, false);
+
+    // The cached decisions are invalidated once the client username is changed.
+    sim_session->set_client_username("user3");
+    check(false, false);
+    sim_session->set_client_username("user2");
+    check(true, true);
+
+    // The decisions cached for a table are never used for the other tables.
+    replica_access_controller other("other");
+    ASSERT_FALSE(other.allowed(msg, ranger::access_type::kRead));
+    ASSERT_FALSE(other.allowed(msg, ranger::access_type::kWrite));
+    check(true, true);
+}
+
+TEST_F(replica_access_controller_test, acl_decision_cache)
+{
+    std::unique_ptr<tools::sim_network_provider> sim_net(
+        new tools::sim_network_provider(nullptr, nullptr));
+    auto sim_session =
+        sim_net->create_client_session(rpc_address::from_host_port("localhost", 10086));
+
+    // The keys are encoded as `version << 8 | access type`, the decisions of the same access
+    // type on the tables with consecutive policy versions should not evict each other.
+    const auto key = [](uint64_t version, ranger::access_type req_type) {
+        return version << 8 | static_cast<ranger::act>(req_type);
+    };
+    for (uint64_t version = 1; version <= 2; ++version) {
+        sim_session->set_cached_acl_decision(key(version, ranger::access_type::kRead), true);
+        sim_session->set_cached_acl_decision(key(version, ranger::access_type::kWrite), false);
+    }
+    for (uint64_t version = 1; version <= 2; ++version) {
+        bool allowed = false;
+        const auto read_key = key(version, ranger::access_type::kRead);
+        ASSERT_TRUE(sim_session->get_cached_acl_decision(read_key, allowed));
+        ASSERT_TRUE(allowed);
+        const auto write_key = key(version, ranger::access_type::kWrite);
+        ASSERT_TRUE(sim_session->get_cached_acl_decision(write_key, allowed));
+        ASSERT_FALSE(allowed);
+    }
+
+    // Most of the decisions of many tables are kept rather than only the last one.
+    for (uint64_t version = 1; version <= 8; ++version) {
+        sim_session->set_cached_acl_decision(key(version, ranger::access_type::kRead), true);
+    }
+    int cached = 0;
+    for (uint64_t version = 1; version <= 8; ++version) {
+        bool allowed = false;
+        if (sim_session->get_cached_acl_decision(key(version, ranger::access_type::kRead),
+                                                 allowed)) {
+            ASSERT_TRUE(allowed);
+            ++cached;
+        }
+    }
+    ASSERT_GT(cached, 4);
+
+    // A cached decision is never matched by the other keys.
+    bool allowed = false;
+    ASSERT_FALSE(
+        sim_session->get_cached_acl_decision(key(9, ranger::access_type::kRead), allowed));
+
+    // All the cached decisions are cleared once the client username is changed.
+    sim_session->set_client_username("user1");
+    ASSERT_FALSE(
+        sim_session->get_cached_acl_decision(key(8, ranger::access_type::kRead), allowed));
+}
 } // namespace security
 } // namespace dsn
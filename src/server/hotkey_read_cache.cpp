@@ -0,0 +1,299 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hotkey_read_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "base/pegasus_utils.h"
+#include "base/pegasus_value_schema.h"
+#include "utils/fmt_logging.h"
+
+METRIC_DEFINE_counter(replica,
+                      read_cache_hits,
+                      dsn::metric_unit::kKeys,
+                      "The number of the keys found in the hotkey read cache");
+
+METRIC_DEFINE_counter(replica,
+                      read_cache_misses,
+                      dsn::metric_unit::kKeys,
+                      "The number of the keys not found in the hotkey read cache");
+
+METRIC_DEFINE_counter(replica,
+                      read_cache_evictions,
+                      dsn::metric_unit::kKeys,
+                      "The number of the keys evicted from the hotkey read cache to make room for "
+                      "the more frequently accessed ones");
+
+METRIC_DEFINE_counter(replica,
+                      read_cache_rejected_admissions,
+                      dsn::metric_unit::kKeys,
+                      "The number of the keys rejected to be admitted into the hotkey read cache "
+                      "since they are accessed less frequently than the keys to be evicted");
+
+METRIC_DEFINE_gauge_int64(replica,
+                          read_cache_mem_usage_bytes,
+                          dsn::metric_unit::kBytes,
+                          "The memory usage of the hotkey read cache");
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+// The assumed average charge of an entry, only used to size the frequency sketch.
+constexpr size_t kAssumedEntryBytes = 256;
+
+// The finalizer of MurmurHash3, to spread the bits of the hash well.
+uint64_t mix_hash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+} // anonymous namespace
+
+frequency_sketch::frequency_sketch(size_t capacity)
+    : _sample_size(10 * std::max<size_t>(capacity, 1))
+{
+    size_t table_size = 16;
+    while (table_size < capacity) {
+        table_size <<= 1;
+    }
+    _table.resize(table_size, 0);
+    _table_mask = table_size - 1;
+}
+
+size_t frequency_sketch::index_of(uint64_t hash, int depth) const
+{
+    static constexpr uint64_t kSeeds[kDepth] = {
+        0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+    return static_cast<size_t>(mix_hash(hash + kSeeds[depth])) & _table_mask;
+}
+
+void frequency_sketch::increment(uint64_t hash)
+{
+    bool incremented = false;
+    for (int i = 0; i < kDepth; ++i) {
+        auto &counter = _table[index_of(hash, i)];
+        if (counter < kMaxCount) {
+            ++counter;
+            incremented = true;
+        }
+    }
+
+    if (incremented && ++_increments >= _sample_size) {
+        reset();
+    }
+}
+
+uint32_t frequency_sketch::estimate(uint64_t hash) const
+{
+    uint32_t freq = kMaxCount;
+    for (int i = 0; i < kDepth; ++i) {
+        freq = std::min<uint32_t>(freq, _table[index_of(hash, i)]);
+    }
+    return freq;
+}
+
+void frequency_sketch::reset()
+{
+    for (auto &counter : _table) {
+        counter >>= 1;
+    }
+    _increments /= 2;
+}
+
+hotkey_read_cache::shard::shard(size_t capacity_bytes)
+    : sketch(std::max<size_t>(capacity_bytes / kAssumedEntryBytes, 1))
+{
+}
+
+hotkey_read_cache::hotkey_read_cache(replica_base *r, size_t capacity_bytes)
+    : replica_base(r),
+      _capacity_bytes(capacity_bytes),
+      _shard_capacity_bytes(capacity_bytes / kShardCount),
+      METRIC_VAR_INIT_replica(read_cache_hits),
+      METRIC_VAR_INIT_replica(read_cache_misses),
+      METRIC_VAR_INIT_replica(read_cache_evictions),
+      METRIC_VAR_INIT_replica(read_cache_rejected_admissions),
+      METRIC_VAR_INIT_replica(read_cache_mem_usage_bytes)
+{
+    for (auto &s : _shards) {
+        s = std::make_unique<shard>(_shard_capacity_bytes);
+    }
+}
+
+/*static*/ uint64_t hotkey_read_cache::hash_of(std::string_view key)
+{
+    return mix_hash(std::hash<std::string_view>()(key));
+}
+
+bool hotkey_read_cache::get(std::string_view raw_key, uint32_t epoch_now, dsn::blob &value)
+{
+    if (_suspended.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    const uint64_t hash = hash_of(raw_key);
+    auto &s = shard_of(hash);
+    {
+        std::lock_guard<std::mutex> l(s.mtx);
+        s.sketch.increment(hash);
+
+        auto iter = s.index.find(raw_key);
+        if (iter != s.index.end()) {
+            auto it = iter->second;
+            if (!check_if_ts_expired(epoch_now, it->expire_ts)) {
+                s.lru.splice(s.lru.begin(), s.lru, it);
+                value = it->value;
+                METRIC_VAR_INCREMENT(read_cache_hits);
+                return true;
+            }
+
+            // The expired entry is useless any more.
+            erase(s, it);
+        }
+    }
+
+    METRIC_VAR_INCREMENT(read_cache_misses);
+    return false;
+}
+
+uint64_t hotkey_read_cache::acquire_fill_ticket(std::string_view raw_key) const
+{
+    return shard_of(hash_of(raw_key)).epoch.load(std::memory_order_acquire);
+}
+
+void hotkey_read_cache::put(std::string_view raw_key,
+                            const dsn::blob &value,
+                            uint32_t expire_ts,
+                            uint64_t ticket)
+{
+    if (_suspended.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const size_t charge = raw_key.size() + value.size() + sizeof(entry);
+    if (charge > _shard_capacity_bytes) {
+        return;
+    }
+
+    const uint32_t default_ttl = _default_ttl.load(std::memory_order_relaxed);
+    if (expire_ts == 0 && default_ttl != 0) {
+        expire_ts = utils::epoch_now() + default_ttl;
+    }
+
+    const uint64_t hash = hash_of(raw_key);
+    auto &s = shard_of(hash);
+    std::lock_guard<std::mutex> l(s.mtx);
+    if (s.epoch.load(std::memory_order_relaxed) != ticket) {
+        // The key might have been written after the value was read.
+        return;
+    }
+
+    auto iter = s.index.find(raw_key);
+    if (iter != s.index.end()) {
+        // Filled by another reader concurrently, both values are up to date.
+        return;
+    }
+
+    if (s.usage_bytes + charge > _shard_capacity_bytes) {
+        // TinyLFU admission: the candidate is admitted only if it's accessed more frequently
+        // than the victims.
+        const uint32_t candidate_freq = s.sketch.estimate(hash);
+        size_t freed_bytes = 0;
+        auto victim = s.lru.end();
+        while (s.usage_bytes - freed_bytes + charge > _shard_capacity_bytes) {
+            CHECK(victim != s.lru.begin(), "");
+            --victim;
+            if (s.sketch.estimate(hash_of(victim->key)) >= candidate_freq) {
+                METRIC_VAR_INCREMENT(read_cache_rejected_admissions);
+                return;
+            }
+            freed_bytes += victim->charge();
+        }
+
+        while (s.usage_bytes + charge > _shard_capacity_bytes) {
+            erase(s, std::prev(s.lru.end()));
+            METRIC_VAR_INCREMENT(read_cache_evictions);
+        }
+    }
+
+    s.lru.push_front(entry{std::string(raw_key), value, expire_ts});
+    s.index.emplace(std::string_view(s.lru.front().key), s.lru.begin());
+    s.usage_bytes += charge;
+    METRIC_VAR_INCREMENT_BY(read_cache_mem_usage_bytes, charge);
+}
+
+void hotkey_read_cache::invalidate(std::string_view raw_key)
+{
+    auto &s = shard_of(hash_of(raw_key));
+    std::lock_guard<std::mutex> l(s.mtx);
+    s.epoch.fetch_add(1, std::memory_order_release);
+
+    auto iter = s.index.find(raw_key);
+    if (iter != s.index.end()) {
+        erase(s, iter->second);
+    }
+}
+
+void hotkey_read_cache::clear()
+{
+    for (auto &s : _shards) {
+        std::lock_guard<std::mutex> l(s->mtx);
+        s->epoch.fetch_add(1, std::memory_order_release);
+        s->index.clear();
+        s->lru.clear();
+        METRIC_VAR_DECREMENT_BY(read_cache_mem_usage_bytes, s->usage_bytes);
+        s->usage_bytes = 0;
+    }
+}
+
+void hotkey_read_cache::set_default_ttl(uint32_t ttl)
+{
+    if (_default_ttl.exchange(ttl) != ttl) {
+        clear();
+    }
+}
+
+void hotkey_read_cache::set_suspended(bool suspended)
+{
+    if (_suspended.exchange(suspended) != suspended) {
+        LOG_INFO_PREFIX("hotkey read cache is {}", suspended ? "suspended" : "resumed");
+        clear();
+    }
+}
+
+void hotkey_read_cache::erase(shard &s, std::list<entry>::iterator it)
+{
+    const size_t charge = it->charge();
+    s.index.erase(std::string_view(it->key));
+    s.lru.erase(it);
+    s.usage_bytes -= charge;
+    METRIC_VAR_DECREMENT_BY(read_cache_mem_usage_bytes, charge);
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,171 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "replica/replica_base.h"
+#include "utils/blob.h"
+#include "utils/metrics.h"
+#include "utils/ports.h"
+
+namespace pegasus {
+namespace server {
+
+// A TinyLFU frequency sketch (count-min sketch whose counters saturate at 15), which
+// estimates how often a key has been accessed recently. All the counters are halved
+// periodically to let the frequencies of the keys which are no longer hot decay.
+//
+// Not thread safe.
+class frequency_sketch
+{
+public:
+    // `capacity` is the expected max number of the entries in the cache.
+    explicit frequency_sketch(size_t capacity);
+
+    void increment(uint64_t hash);
+    uint32_t estimate(uint64_t hash) const;
+
+private:
+    static constexpr int kDepth = 4;
+    static constexpr uint8_t kMaxCount = 15;
+
+    size_t index_of(uint64_t hash, int depth) const;
+    void reset();
+
+    std::vector<uint8_t> _table;
+    size_t _table_mask;
+    size_t _increments{0};
+    const size_t _sample_size;
+
+    DISALLOW_COPY_AND_ASSIGN(frequency_sketch);
+};
+
+// A memory-bounded cache of the decoded values (i.e. the user data) of the hot keys of a
+// replica, which serves GET and BATCH_GET in front of RocksDB.
+//
+// The cache is an LRU split into shards by the raw key. A new key is only admitted into a
+// full shard while it has been accessed more often than the LRU victim, according to the
+// TinyLFU sketch of the shard, thus a scan-like workload can't flush the hot keys out.
+//
+// The entries are kept consistent with RocksDB as below:
+// - Each write invalidates the written keys once it's applied into RocksDB, see
+//   rocksdb_wrapper::write();
+// - The whole cache is cleared once the data is changed in other ways, e.g. ingestion,
+//   manual compaction, or the change of the default ttl;
+// - A reader acquires a fill ticket before reading RocksDB, and the value read is only filled
+//   into the cache if no invalidation happened on the shard since then, otherwise the value
+//   might have been stale.
+// The expire_ts of the value is kept with the entry, thus the expired entry would never
+// be returned. Since the compaction filter might set the default ttl for the values without
+// ttl, such entries are considered to expire after the default ttl since they are filled.
+//
+// Thread safe.
+class hotkey_read_cache : public dsn::replication::replica_base
+{
+public:
+    hotkey_read_cache(replica_base *r, size_t capacity_bytes);
+    ~hotkey_read_cache() = default;
+
+    // Look up the value of `raw_key` whose expire_ts is not before `epoch_now`.
+    // Returns true if found.
+    bool get(std::string_view raw_key, uint32_t epoch_now, /*out*/ dsn::blob &value);
+
+    // Should be called before reading the value of `raw_key` from RocksDB, and the returned
+    // ticket should be passed to put() to fill the value read.
+    uint64_t acquire_fill_ticket(std::string_view raw_key) const;
+
+    // Fill the value of `raw_key`, which was read from RocksDB after `ticket` was acquired.
+    void
+    put(std::string_view raw_key, const dsn::blob &value, uint32_t expire_ts, uint64_t ticket);
+
+    // Invalidate the entry of `raw_key` if any.
+    void invalidate(std::string_view raw_key);
+
+    // Invalidate all entries.
+    void clear();
+
+    // Set the default ttl of the table, all entries are invalidated once it's changed.
+    void set_default_ttl(uint32_t ttl);
+
+    // Once suspended, all the lookups miss and nothing is filled. Used while the data might be
+    // changed by the compaction filter without any write, e.g. the user specified compaction
+    // rules are set.
+    void set_suspended(bool suspended);
+
+    size_t capacity_bytes() const { return _capacity_bytes; }
+
+private:
+    struct entry
+    {
+        std::string key;
+        dsn::blob value;
+        uint32_t expire_ts;
+
+        size_t charge() const { return key.size() + value.size() + sizeof(entry); }
+    };
+
+    struct shard
+    {
+        explicit shard(size_t capacity_bytes);
+
+        std::mutex mtx;
+        std::list<entry> lru; // The front is the most recently used.
+        // The keys refer to the ones held by the entries of `lru`.
+        boost::unordered_flat_map<std::string_view, std::list<entry>::iterator> index;
+        size_t usage_bytes{0};
+        // Increased for each invalidation, to reject the fills which might be stale.
+        std::atomic<uint64_t> epoch{0};
+        frequency_sketch sketch;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    static uint64_t hash_of(std::string_view key);
+    shard &shard_of(uint64_t hash) const { return *_shards[hash % kShardCount]; }
+
+    // Erase the entry pointed by `it`, `s.mtx` should be held.
+    void erase(shard &s, std::list<entry>::iterator it);
+
+    const size_t _capacity_bytes;
+    const size_t _shard_capacity_bytes;
+    std::array<std::unique_ptr<shard>, kShardCount> _shards;
+    std::atomic<bool> _suspended{false};
+    std::atomic<uint32_t> _default_ttl{0};
+
+    METRIC_VAR_DECLARE_counter(read_cache_hits);
+    METRIC_VAR_DECLARE_counter(read_cache_misses);
+    METRIC_VAR_DECLARE_counter(read_cache_evictions);
+    METRIC_VAR_DECLARE_counter(read_cache_rejected_admissions);
+    METRIC_VAR_DECLARE_gauge_int64(read_cache_mem_usage_bytes);
+
+    DISALLOW_COPY_AND_ASSIGN(hotkey_read_cache);
+};
+
+} // namespace server
+} // namespace pegasus
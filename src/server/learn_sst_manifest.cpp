@@ -0,0 +1,213 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "learn_sst_manifest.h"
+
+#include <rocksdb/env.h>
+#include <rocksdb/slice.h>
+#include <rocksdb/status.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "utils/crc.h"
+#include "utils/env.h"
+#include "utils/filesystem.h"
+#include "utils/fmt_logging.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+// The size of the tail of an SST file to be checksummed, which is large enough to cover the
+// footer, the meta-index block and the properties block.
+constexpr int64_t kSstChecksumTailBytes = 64 << 10;
+
+bool find_sst_file(const std::vector<std::string> &dirs,
+                   const sst_file_info &expected,
+                   /*out*/ std::string &path)
+{
+    for (const auto &dir : dirs) {
+        const auto candidate = dsn::utils::filesystem::path_combine(dir, expected.name);
+        if (!dsn::utils::filesystem::file_exists(candidate)) {
+            continue;
+        }
+
+        sst_file_info info;
+        if (get_sst_file_info(candidate, info) && info.size == expected.size &&
+            info.checksum == expected.checksum) {
+            path = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+bool is_sst_file(const std::string &path)
+{
+    static const std::string kSstSuffix(".sst");
+    return path.size() > kSstSuffix.size() &&
+           path.compare(path.size() - kSstSuffix.size(), kSstSuffix.size(), kSstSuffix) == 0;
+}
+
+bool get_sst_file_info(const std::string &path, sst_file_info &info)
+{
+    info.name = dsn::utils::filesystem::get_file_name(path);
+    if (!dsn::utils::filesystem::file_size(
+            path, dsn::utils::FileDataType::kSensitive, info.size)) {
+        LOG_WARNING("get size of file {} failed", path);
+        return false;
+    }
+
+    std::unique_ptr<rocksdb::RandomAccessFile> file;
+    auto s = dsn::utils::PegasusEnv(dsn::utils::FileDataType::kSensitive)
+                 ->NewRandomAccessFile(path, &file, rocksdb::EnvOptions());
+    if (!s.ok()) {
+        LOG_WARNING("open file {} failed, err = {}", path, s.ToString());
+        return false;
+    }
+
+    const auto n = static_cast<size_t>(std::min(info.size, kSstChecksumTailBytes));
+    std::unique_ptr<char[]> scratch(new char[n]);
+    rocksdb::Slice tail;
+    s = file->Read(static_cast<uint64_t>(info.size) - n, n, &tail, scratch.get());
+    if (!s.ok() || tail.size() != n) {
+        LOG_WARNING("read file {} failed, err = {}", path, s.ToString());
+        return false;
+    }
+
+    info.checksum = dsn::utils::crc64_calc(tail.data(), tail.size(), 0);
+    return true;
+}
+
+void collect_sst_files(const std::vector<std::string> &dirs,
+                       const sst_file_manifest &known,
+                       sst_file_manifest &manifest)
+{
+    std::unordered_map<std::string, const sst_file_info *> known_files;
+    for (const auto &file : known.files) {
+        known_files.emplace(file.name, &file);
+    }
+
+    manifest.files.clear();
+    std::unordered_set<std::string> names;
+    for (const auto &dir : dirs) {
+        std::vector<std::string> files;
+        if (!dsn::utils::filesystem::get_subfiles(dir, files, false)) {
+            LOG_WARNING("list files in dir {} failed", dir);
+            continue;
+        }
+
+        for (const auto &path : files) {
+            auto name = dsn::utils::filesystem::get_file_name(path);
+            if (!is_sst_file(name) || !names.insert(name).second) {
+                continue;
+            }
+
+            // The file might have been removed by compaction or garbage collection of the
+            // checkpoints, just skip it.
+            int64_t size = 0;
+            if (!dsn::utils::filesystem::file_size(
+                    path, dsn::utils::FileDataType::kSensitive, size)) {
+                continue;
+            }
+
+            const auto found = known_files.find(name);
+            if (found != known_files.end() && found->second->size == size) {
+                manifest.files.push_back(*found->second);
+                continue;
+            }
+
+            sst_file_info info;
+            if (get_sst_file_info(path, info)) {
+                manifest.files.emplace_back(std::move(info));
+            }
+        }
+    }
+}
+
+void exclude_learner_sst_files(const sst_file_manifest &learner_manifest,
+                               std::vector<std::string> &files,
+                               sst_file_manifest &reused)
+{
+    if (learner_manifest.files.empty()) {
+        return;
+    }
+
+    std::unordered_map<std::string, const sst_file_info *> learner_files;
+    for (const auto &file : learner_manifest.files) {
+        learner_files.emplace(file.name, &file);
+    }
+
+    auto iter = std::remove_if(files.begin(), files.end(), [&](const std::string &path) {
+        if (!is_sst_file(path)) {
+            return false;
+        }
+
+        const auto found = learner_files.find(dsn::utils::filesystem::get_file_name(path));
+        if (found == learner_files.end()) {
+            return false;
+        }
+
+        // Check the size first to avoid reading the files which are obviously different.
+        int64_t size = 0;
+        if (!dsn::utils::filesystem::file_size(path, dsn::utils::FileDataType::kSensitive, size) ||
+            size != found->second->size) {
+            return false;
+        }
+
+        sst_file_info info;
+        if (!get_sst_file_info(path, info) || info.checksum != found->second->checksum) {
+            return false;
+        }
+
+        reused.files.emplace_back(std::move(info));
+        return true;
+    });
+    files.erase(iter, files.end());
+}
+
+dsn::error_code link_reused_sst_files(const sst_file_manifest &reused,
+                                      const std::vector<std::string> &dirs,
+                                      const std::string &learn_dir)
+{
+    for (const auto &file : reused.files) {
+        std::string src;
+        if (!find_sst_file(dirs, file, src)) {
+            LOG_ERROR("reused file {}(size = {}, checksum = {}) is not found locally",
+                      file.name,
+                      file.size,
+                      file.checksum);
+            return dsn::ERR_OBJECT_NOT_FOUND;
+        }
+
+        const auto target = dsn::utils::filesystem::path_combine(learn_dir, file.name);
+        if (!dsn::utils::filesystem::link_file(src, target)) {
+            LOG_ERROR("link file {} to {} failed", src, target);
+            return dsn::ERR_FILE_OPERATION_FAILED;
+        }
+    }
+    return dsn::ERR_OK;
+}
+
+} // namespace server
+} // namespace pegasus
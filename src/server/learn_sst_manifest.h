@@ -0,0 +1,79 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/json_helper.h"
+#include "utils/error_code.h"
+
+namespace pegasus {
+namespace server {
+
+// The identity of an immutable SST file. The files with the same name, size and checksum are
+// treated as the same file, no matter on which replica they are found.
+struct sst_file_info
+{
+    std::string name;
+    int64_t size{0};
+    // The CRC64 of the tail of the file, which holds the footer and the properties block
+    // including the db session id and the file number assigned by RocksDB, thus it's enough
+    // to tell the different files apart without reading the whole file.
+    uint64_t checksum{0};
+    DEFINE_JSON_SERIALIZATION(name, size, checksum)
+};
+
+// In LT_APP learning, the manifest of the SST files held by the learner is sent to the primary
+// in the learn request. The primary skips the files which are found in it, and sends back the
+// manifest of the skipped files in learn_state::meta, then the learner hard-links them into the
+// learn dir instead of copying them from the primary.
+struct sst_file_manifest
+{
+    std::vector<sst_file_info> files;
+    DEFINE_JSON_SERIALIZATION(files)
+};
+
+bool is_sst_file(const std::string &path);
+
+// Get the info of the SST file with the path, returns false if the file could not be read.
+bool get_sst_file_info(const std::string &path, sst_file_info &info);
+
+// Collect the SST files under the dirs (not recursively) into the manifest. The files with the
+// same name are collected only once. Since the SST files are immutable, the checksums of the
+// files found in `known` with the same size are reused rather than read again.
+void collect_sst_files(const std::vector<std::string> &dirs,
+                       const sst_file_manifest &known,
+                       /*out*/ sst_file_manifest &manifest);
+
+// Remove the SST files which are also held by the learner from the checkpoint files to be
+// copied, and put them into `reused`.
+void exclude_learner_sst_files(const sst_file_manifest &learner_manifest,
+                               /*inout*/ std::vector<std::string> &files,
+                               /*out*/ sst_file_manifest &reused);
+
+// Hard-link the reused SST files found under the dirs into the learn dir. The files must be
+// the same as the ones in the manifest, otherwise ERR_OBJECT_NOT_FOUND is returned and the
+// files have to be learned again.
+dsn::error_code link_reused_sst_files(const sst_file_manifest &reused,
+                                      const std::vector<std::string> &dirs,
+                                      const std::string &learn_dir);
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,178 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "pegasus_incr_merge_operator.h"
+
+#include <string_view>
+
+#include "base/pegasus_utils.h"
+#include "base/pegasus_value_schema.h"
+#include "utils/endians.h"
+#include "utils/fmt_logging.h"
+#include "utils/safe_arithmetic.h"
+#include "utils/string_conv.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+constexpr size_t kIncrMergeOperandSize = sizeof(uint8_t) + sizeof(int64_t) + sizeof(int32_t) +
+                                         sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+
+struct incr_merge_operand
+{
+    uint32_t data_version;
+    int64_t increment;
+    int32_t expire_ts_seconds;
+    uint32_t now;
+    uint32_t default_expire_ts;
+    uint64_t timetag;
+};
+
+bool decode_incr_merge_operand(const rocksdb::Slice &operand, incr_merge_operand &op)
+{
+    if (operand.size() != kIncrMergeOperandSize) {
+        return false;
+    }
+
+    dsn::data_input input(utils::to_string_view(operand));
+    op.data_version = input.read_u8();
+    op.increment = static_cast<int64_t>(input.read_u64());
+    op.expire_ts_seconds = static_cast<int32_t>(input.read_u32());
+    op.now = input.read_u32();
+    op.default_expire_ts = input.read_u32();
+    op.timetag = input.read_u64();
+    return op.data_version <= PEGASUS_DATA_VERSION_MAX;
+}
+
+size_t value_header_size(uint32_t data_version)
+{
+    return data_version == 0 ? sizeof(uint32_t) : sizeof(uint32_t) + sizeof(uint64_t);
+}
+
+} // anonymous namespace
+
+std::string encode_incr_merge_operand(uint32_t data_version,
+                                      int64_t increment,
+                                      int32_t expire_ts_seconds,
+                                      uint32_t now,
+                                      uint32_t default_expire_ts,
+                                      uint64_t timetag)
+{
+    std::string operand(kIncrMergeOperandSize, '\0');
+    dsn::data_output(operand)
+        .write_u8(static_cast<uint8_t>(data_version))
+        .write_u64(static_cast<uint64_t>(increment))
+        .write_u32(static_cast<uint32_t>(expire_ts_seconds))
+        .write_u32(now)
+        .write_u32(default_expire_ts)
+        .write_u64(timetag);
+    return operand;
+}
+
+bool merge_incr_operands(const rocksdb::Slice *existing_value,
+                         const std::vector<rocksdb::Slice> &operands,
+                         std::string &new_value)
+{
+    std::vector<incr_merge_operand> ops(operands.size());
+    for (size_t i = 0; i < operands.size(); ++i) {
+        if (!decode_incr_merge_operand(operands[i], ops[i])) {
+            LOG_ERROR("corrupted incr merge operand: size = {}", operands[i].size());
+            return false;
+        }
+    }
+    if (ops.empty()) {
+        if (existing_value != nullptr) {
+            new_value.assign(existing_value->data(), existing_value->size());
+        }
+        return existing_value != nullptr;
+    }
+
+    // All the operands are written by the same replica, thus share the same data version with
+    // the existing value.
+    const uint32_t data_version = ops.front().data_version;
+
+    bool found = existing_value != nullptr;
+    std::string user_data;
+    uint32_t expire_ts = 0;
+    if (found) {
+        if (existing_value->size() < value_header_size(data_version)) {
+            LOG_ERROR("corrupted base value of incr merge: size = {}", existing_value->size());
+            return false;
+        }
+        const std::string_view raw_value = utils::to_string_view(*existing_value);
+        expire_ts = pegasus_extract_expire_ts(data_version, raw_value);
+        user_data = pegasus_extract_user_data_view(data_version, raw_value);
+    }
+
+    bool applied = false;
+    uint64_t timetag = 0;
+    for (const auto &op : ops) {
+        int64_t new_int = op.increment;
+        uint32_t new_expire_ts = 0;
+        if (!found || check_if_ts_expired(op.now, expire_ts)) {
+            // The base value is absent or has expired, increment from 0.
+            new_expire_ts = op.expire_ts_seconds > 0 ? op.expire_ts_seconds : 0;
+        } else {
+            if (!user_data.empty()) {
+                int64_t old_int = 0;
+                if (!dsn::buf2int64(user_data, old_int) ||
+                    !dsn::safe_add(old_int, op.increment, new_int)) {
+                    // Keep the base value as is, just like the incr failed by read-before-write.
+                    continue;
+                }
+            }
+
+            if (op.expire_ts_seconds == 0) {
+                new_expire_ts = expire_ts;
+            } else if (op.expire_ts_seconds > 0) {
+                new_expire_ts = op.expire_ts_seconds;
+            }
+        }
+
+        found = true;
+        user_data = std::to_string(new_int);
+        expire_ts = new_expire_ts == 0 ? op.default_expire_ts : new_expire_ts;
+        timetag = op.timetag;
+        applied = true;
+    }
+
+    if (!applied) {
+        new_value.assign(existing_value->data(), existing_value->size());
+        return true;
+    }
+
+    pegasus_value_generator generator;
+    const rocksdb::SliceParts parts =
+        generator.generate_value(data_version, user_data, expire_ts, timetag);
+    new_value.clear();
+    for (int i = 0; i < parts.num_parts; ++i) {
+        new_value.append(parts.parts[i].data(), parts.parts[i].size());
+    }
+    return true;
+}
+
+bool pegasus_incr_merge_operator::FullMergeV2(const MergeOperationInput &merge_in,
+                                              MergeOperationOutput *merge_out) const
+{
+    return merge_incr_operands(
+        merge_in.existing_value, merge_in.operand_list, merge_out->new_value);
+}
+
+} // namespace server
+} // namespace pegasus
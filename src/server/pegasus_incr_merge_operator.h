@@ -0,0 +1,66 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <rocksdb/merge_operator.h>
+#include <rocksdb/slice.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pegasus {
+namespace server {
+
+// An incr request could be written as a merge operand instead of read-before-write, on the
+// tables whose "replica.incr_merge_enabled" env is true. The operand carries everything the
+// incr needs except the base value, which is resolved lazily by RocksDB on read and during
+// compaction:
+//
+//   [data_version: u8][increment: i64][expire_ts_seconds: i32][now: u32]
+//   [default_expire_ts: u32][timetag: u64]
+//
+// where `now` is the time the request was applied, used to decide whether the base value
+// has expired, and `default_expire_ts` is the expire timestamp derived from the default ttl
+// of the table, used once the incr does not set the ttl.
+std::string encode_incr_merge_operand(uint32_t data_version,
+                                      int64_t increment,
+                                      int32_t expire_ts_seconds,
+                                      uint32_t now,
+                                      uint32_t default_expire_ts,
+                                      uint64_t timetag);
+
+// Apply the incr operands in order to the existing raw value (nullptr if absent), and
+// generate the new raw value into `new_value` with the same semantics as the incr done by
+// read-before-write, except that an operand is skipped once the base value is not an
+// integer or the result overflows, since there is no response to carry the error any more.
+// Return false if the existing value or any operand is corrupted.
+bool merge_incr_operands(const rocksdb::Slice *existing_value,
+                         const std::vector<rocksdb::Slice> &operands,
+                         std::string &new_value);
+
+class pegasus_incr_merge_operator : public rocksdb::MergeOperator
+{
+public:
+    bool FullMergeV2(const MergeOperationInput &merge_in,
+                     MergeOperationOutput *merge_out) const override;
+
+    const char *Name() const override { return "PegasusIncrMergeOperator"; }
+};
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,183 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "pegasus_scan_context.h"
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "runtime/api_layer1.h"
+#include "utils/flags.h"
+#include "utils/rand.h"
+
+DSN_DEFINE_uint32(pegasus.server,
+                  scan_context_idle_timeout_s,
+                  300,
+                  "The scan context which has not been used for longer than this time will be "
+                  "removed, then the scanner has to restart the scan from the last key it got");
+DSN_TAG_VARIABLE(scan_context_idle_timeout_s, FT_MUTABLE);
+
+DSN_DEFINE_uint32(pegasus.server,
+                  max_scan_contexts_per_node,
+                  0,
+                  "The max number of the scan contexts of all replicas on a node, each of which "
+                  "holds a rocksdb iterator. Once exceeded, the contexts idle for the longest "
+                  "time are evicted. 0 means no limit");
+DSN_TAG_VARIABLE(max_scan_contexts_per_node, FT_MUTABLE);
+
+METRIC_DEFINE_gauge_int64(replica,
+                          scan_contexts,
+                          dsn::metric_unit::kContexts,
+                          "The number of the scan contexts cached for the ongoing scans");
+
+METRIC_DEFINE_counter(replica,
+                      expired_scan_contexts,
+                      dsn::metric_unit::kContexts,
+                      "The number of the scan contexts removed since they have been idle for "
+                      "too long");
+
+METRIC_DEFINE_counter(replica,
+                      evicted_scan_contexts,
+                      dsn::metric_unit::kContexts,
+                      "The number of the scan contexts evicted since there are too many scan "
+                      "contexts on the node");
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+std::atomic<int64_t> s_node_context_count{0};
+
+} // anonymous namespace
+
+pegasus_context_cache::pegasus_context_cache(replica_base *r)
+    : replica_base(r),
+      METRIC_VAR_INIT_replica(scan_contexts),
+      METRIC_VAR_INIT_replica(expired_scan_contexts),
+      METRIC_VAR_INIT_replica(evicted_scan_contexts)
+{
+    // some comments:
+    // 1. we should keep the context id unique when the server restarts, so as to prevent
+    //    an old scan reuse the context id assigned to a new scan
+    // 2. we should prevent the context id mixed when primary switches.
+    // 3. we should keep context id positive, as negtive value have specical meanings.
+    //
+    // a more detailed description on the context id confliction is here:
+    //   https://github.com/apache/incubator-pegasus/issues/156
+    //
+    // however, currently the implementation is not 100% correct.
+    //
+    int64_t counter = dsn::rand::next_u64(0, 2L << 31);
+    counter <<= 32;
+    _counter.store(counter, std::memory_order_relaxed);
+}
+
+pegasus_context_cache::~pegasus_context_cache() { clear(); }
+
+/*static*/ int64_t pegasus_context_cache::node_context_count()
+{
+    return s_node_context_count.load(std::memory_order_relaxed);
+}
+
+void pegasus_context_cache::clear()
+{
+    for (auto &s : _shards) {
+        std::unordered_map<int64_t, entry> contexts;
+        {
+            ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s.lock);
+            contexts.swap(s.contexts);
+            s.order.clear();
+        }
+        s_node_context_count.fetch_sub(contexts.size(), std::memory_order_relaxed);
+        METRIC_VAR_DECREMENT_BY(scan_contexts, contexts.size());
+        // The iterators are released out of the lock.
+    }
+}
+
+int64_t pegasus_context_cache::put(std::unique_ptr<pegasus_scan_context> context)
+{
+    const int64_t handle = _counter.fetch_add(1, std::memory_order_relaxed);
+    const int64_t node_count = s_node_context_count.fetch_add(1, std::memory_order_relaxed);
+    const uint32_t max_count = FLAGS_max_scan_contexts_per_node;
+    const bool exceeded = max_count > 0 && node_count >= max_count;
+    METRIC_VAR_INCREMENT(scan_contexts);
+
+    std::unique_ptr<pegasus_scan_context> evicted;
+    auto &s = shard_of(handle);
+    {
+        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s.lock);
+        if (exceeded && !s.order.empty()) {
+            evicted = erase(s, s.contexts.find(s.order.front()));
+        }
+        s.order.push_back(handle);
+        s.contexts.emplace(handle,
+                           entry{std::move(context), dsn_now_ms(), std::prev(s.order.end())});
+    }
+
+    if (evicted != nullptr) {
+        METRIC_VAR_INCREMENT(evicted_scan_contexts);
+    }
+    return handle;
+}
+
+std::unique_ptr<pegasus_scan_context> pegasus_context_cache::fetch(int64_t handle)
+{
+    auto &s = shard_of(handle);
+    ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s.lock);
+    auto iter = s.contexts.find(handle);
+    if (iter == s.contexts.end()) {
+        return nullptr;
+    }
+    return erase(s, iter);
+}
+
+void pegasus_context_cache::expire_idle_contexts()
+{
+    const uint64_t now_ms = dsn_now_ms();
+    const uint64_t timeout_ms = FLAGS_scan_context_idle_timeout_s * 1000ULL;
+    for (auto &s : _shards) {
+        std::vector<std::unique_ptr<pegasus_scan_context>> expired;
+        {
+            ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s.lock);
+            while (!s.order.empty()) {
+                auto iter = s.contexts.find(s.order.front());
+                if (iter->second.put_time_ms + timeout_ms > now_ms) {
+                    break;
+                }
+                expired.emplace_back(erase(s, iter));
+            }
+        }
+        METRIC_VAR_INCREMENT_BY(expired_scan_contexts, expired.size());
+        // The iterators are released out of the lock.
+    }
+}
+
+std::unique_ptr<pegasus_scan_context>
+pegasus_context_cache::erase(shard &s, std::unordered_map<int64_t, entry>::iterator iter)
+{
+    std::unique_ptr<pegasus_scan_context> context = std::move(iter->second.context);
+    s.order.erase(iter->second.order_pos);
+    s.contexts.erase(iter);
+    s_node_context_count.fetch_sub(1, std::memory_order_relaxed);
+    METRIC_VAR_DECREMENT(scan_contexts);
+    return context;
+}
+
+} // namespace server
+} // namespace pegasus
@@ -19,13 +19,22 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <list>
 #include <map>
 #include <rocksdb/db.h>
+#include <unordered_map>
+#include "replica/replica_base.h"
 #include "runtime/tool_api.h"
-#include "utils/rand.h"
+#include "utils/metrics.h"
+#include "utils/ports.h"
+#include "utils/synchronize.h"
 #include <rrdb/rrdb_types.h>
 
 #include "base/pegasus_utils.h"
+#include "scan_aggregator.h"
+#include "scan_geo_filter.h"
 
 namespace pegasus {
 namespace server {
@@ -40,6 +49,7 @@ struct pegasus_scan_context
                          ::dsn::apps::filter_type::type sort_key_filter_type_,
                          const std::string &&sort_key_filter_pattern_,
                          int32_t batch_size_,
+                         int32_t batch_bytes_,
                          bool no_value_,
                          bool validate_partition_hash_,
                          bool return_expire_ts_,
@@ -57,6 +67,7 @@ struct pegasus_scan_context
           sort_key_filter_pattern(
               _sort_key_filter_pattern_holder.data(), 0, _sort_key_filter_pattern_holder.length()),
           batch_size(batch_size_),
+          batch_bytes(batch_bytes_),
           no_value(no_value_),
           validate_partition_hash(validate_partition_hash_),
           return_expire_ts(return_expire_ts_),
@@ -82,61 +93,78 @@ public:
     ::dsn::apps::filter_type::type sort_key_filter_type;
     dsn::blob sort_key_filter_pattern;
     int32_t batch_size;
+    int32_t batch_bytes; // 0 means no limit
     bool no_value;
     bool validate_partition_hash;
     bool return_expire_ts;
     bool only_return_count;
+    // Not null if the records are aggregated instead of being returned.
+    std::unique_ptr<scan_aggregator> aggregator;
+    // Not null if the records are filtered by the points held by the values.
+    std::unique_ptr<scan_geo_filter> geo_filter;
 };
 
-class pegasus_context_cache
+// The cache of the contexts of the ongoing scans on a replica, each of which holds a rocksdb
+// iterator which pins the memtables and SST files it reads.
+//
+// The contexts are sharded by their handles to reduce the contention among the scanners. Since
+// all contexts share the same idle timeout, the contexts of each shard are kept in the order
+// they are put, thus the idle ones could be expired from the front by a periodic sweep rather
+// than a delayed task for each batch.
+//
+// The total number of the contexts on a node is limited by `max_scan_contexts_per_node`: once
+// exceeded, the context idle for the longest time in the same shard is evicted. A scanner whose
+// context is expired or evicted would restart the scan from the last key it received.
+class pegasus_context_cache : public dsn::replication::replica_base
 {
 public:
-    pegasus_context_cache()
-    {
-        // some comments:
-        // 1. we should keep the context id unique when the server restarts, so as to prevent
-        //    an old scan reuse the context id assigned to a new scan
-        // 2. we should prevent the context id mixed when primary switches.
-        // 3. we should keep context id positive, as negtive value have specical meanings.
-        //
-        // a more detailed description on the context id confliction is here:
-        //   https://github.com/apache/incubator-pegasus/issues/156
-        //
-        // however, currently the implementation is not 100% correct.
-        //
-        _counter = dsn::rand::next_u64(0, 2L << 31);
-        _counter <<= 32;
-    }
+    explicit pegasus_context_cache(replica_base *r);
+    ~pegasus_context_cache();
 
-    void clear()
-    {
-        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
-        _map.clear();
-    }
+    void clear();
+
+    int64_t put(std::unique_ptr<pegasus_scan_context> context);
 
-    int64_t put(std::unique_ptr<pegasus_scan_context> context)
+    std::unique_ptr<pegasus_scan_context> fetch(int64_t handle);
+
+    // Remove the contexts which have been idle for longer than `scan_context_idle_timeout_s`.
+    void expire_idle_contexts();
+
+    // The number of the contexts of all replicas on this node.
+    static int64_t node_context_count();
+
+private:
+    struct entry
     {
-        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
-        int64_t handle = _counter++;
-        _map[handle] = std::move(context);
-        return handle;
-    }
+        std::unique_ptr<pegasus_scan_context> context;
+        uint64_t put_time_ms;
+        std::list<int64_t>::iterator order_pos;
+    };
 
-    std::unique_ptr<pegasus_scan_context> fetch(int64_t handle)
+    struct shard
     {
-        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
-        auto kv = _map.find(handle);
-        if (kv == _map.end())
-            return nullptr;
-        std::unique_ptr<pegasus_scan_context> ret = std::move(kv->second);
-        _map.erase(kv);
-        return ret;
-    }
+        ::dsn::utils::ex_lock_nr_spin lock;
+        std::unordered_map<int64_t, entry> contexts;
+        // The handles of the contexts in the order they are put.
+        std::list<int64_t> order;
+    };
 
-private:
-    int64_t _counter;
-    std::unordered_map<int64_t, std::unique_ptr<pegasus_scan_context>> _map;
-    ::dsn::utils::ex_lock_nr_spin _lock;
+    static constexpr size_t kShardCount = 16;
+
+    shard &shard_of(int64_t handle) { return _shards[static_cast<uint64_t>(handle) % kShardCount]; }
+
+    // REQUIRES: the lock of `s` is held.
+    std::unique_ptr<pegasus_scan_context>
+    erase(shard &s, std::unordered_map<int64_t, entry>::iterator iter);
+
+    std::atomic<int64_t> _counter;
+    std::array<shard, kShardCount> _shards;
+
+    METRIC_VAR_DECLARE_gauge_int64(scan_contexts);
+    METRIC_VAR_DECLARE_counter(expired_scan_contexts);
+    METRIC_VAR_DECLARE_counter(evicted_scan_contexts);
+
+    DISALLOW_COPY_AND_ASSIGN(pegasus_context_cache);
 };
 } // namespace server
 } // namespace pegasus
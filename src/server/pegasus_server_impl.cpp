@@ -41,6 +41,7 @@
 #include <functional>
 #include <limits>
 #include <list>
+#include <map>
 #include <mutex>
 #include <ostream>
 #include <set>
@@ -58,6 +59,7 @@
 #include "consensus_types.h"
 #include "dsn.layer2_types.h"
 #include "hotkey_collector.h"
+#include "hotkey_read_cache.h"
 #include "pegasus_rpc_types.h"
 #include "pegasus_server_write.h"
 #include "replica_admin_types.h"
@@ -67,10 +69,13 @@
 #include "rrdb/rrdb_types.h"
 #include "runtime/api_layer1.h"
 #include "server/key_ttl_compaction_filter.h"
+#include "server/learn_sst_manifest.h"
 #include "server/pegasus_manual_compact_service.h"
 #include "server/pegasus_read_service.h"
 #include "server/pegasus_scan_context.h"
 #include "server/range_read_limiter.h"
+#include "server/scan_aggregator.h"
+#include "server/scan_geo_filter.h"
 #include "task/async_calls.h"
 #include "task/task_code.h"
 #include "utils/autoref_ptr.h"
@@ -91,6 +96,26 @@ DSN_DEFINE_bool(pegasus.server,
                 rocksdb_verbose_log,
                 false,
                 "Whether to print RocksDB related verbose log for debugging");
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_batched_multi_get,
+                true,
+                "Whether to read the keys of multi_get and batch_get by the batched MultiGet of "
+                "RocksDB, which looks up the keys in the same SST file together and reads their "
+                "data blocks in parallel, rather than one key after another");
+DSN_TAG_VARIABLE(rocksdb_batched_multi_get, FT_MUTABLE);
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_multi_get_async_io,
+                false,
+                "Whether to read the data blocks from different SST files asynchronously in the "
+                "batched MultiGet, which only takes effect if RocksDB is built with coroutine "
+                "support (USE_COROUTINES)");
+DSN_TAG_VARIABLE(rocksdb_multi_get_async_io, FT_MUTABLE);
+DSN_DEFINE_bool(pegasus.server,
+                learn_app_reuse_local_sst_files,
+                true,
+                "Whether to hard-link the SST files which are held locally rather than copying "
+                "them from the primary while learning the checkpoint of the app");
+DSN_TAG_VARIABLE(learn_app_reuse_local_sst_files, FT_MUTABLE);
 DSN_DEFINE_int32(pegasus.server,
                  hotkey_analyse_time_interval_s,
                  10,
@@ -131,6 +156,7 @@ static bool chkpt_init_from_dir(const char *name, int64_t &decree)
 std::shared_ptr<rocksdb::RateLimiter> pegasus_server_impl::_s_rate_limiter;
 int64_t pegasus_server_impl::_rocksdb_limiter_last_total_through;
 std::shared_ptr<rocksdb::Cache> pegasus_server_impl::_s_block_cache;
+std::shared_ptr<rocksdb::PersistentCache> pegasus_server_impl::_s_persistent_cache;
 std::shared_ptr<rocksdb::WriteBufferManager> pegasus_server_impl::_s_write_buffer_manager;
 ::dsn::task_ptr pegasus_server_impl::_update_server_rdb_stat;
 METRIC_VAR_DEFINE_gauge_int64(rdb_block_cache_mem_usage_bytes, pegasus_server_impl);
@@ -139,12 +165,23 @@ METRIC_VAR_DEFINE_gauge_int64(rdb_wbm_mutable_mem_usage_bytes, pegasus_server_im
 METRIC_VAR_DEFINE_gauge_int64(rdb_write_rate_limiter_through_bytes_per_sec, pegasus_server_impl);
 const std::string pegasus_server_impl::COMPRESSION_HEADER = "per_level:";
 const std::chrono::seconds pegasus_server_impl::kServerStatUpdateTimeSec = std::chrono::seconds(10);
+const std::chrono::seconds pegasus_server_impl::kScanContextExpireCheckTimeSec =
+    std::chrono::seconds(10);
 
 // should be same with items in dsn::backup_restore_constant
 const std::string ROCKSDB_ENV_RESTORE_FORCE_RESTORE("restore.force_restore");
 const std::string ROCKSDB_ENV_RESTORE_POLICY_NAME("restore.policy_name");
 const std::string ROCKSDB_ENV_RESTORE_BACKUP_ID("restore.backup_id");
 
+// The compression types of the blob files supported by the env
+// dsn::replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE.
+const std::map<std::string, rocksdb::CompressionType> blob_compression_types = {
+    {"none", rocksdb::kNoCompression},
+    {"snappy", rocksdb::kSnappyCompression},
+    {"lz4", rocksdb::kLZ4Compression},
+    {"zstd", rocksdb::kZSTD},
+};
+
 using cf_opts_setter = std::function<bool(const std::string &, rocksdb::ColumnFamilyOptions &)>;
 const std::unordered_map<std::string, cf_opts_setter> cf_opts_setters = {
     {dsn::replica_envs::ROCKSDB_WRITE_BUFFER_SIZE,
@@ -165,6 +202,39 @@ const std::unordered_map<std::string, cf_opts_setter> cf_opts_setters = {
          option.num_levels = val;
          return true;
      }},
+    {dsn::replica_envs::ROCKSDB_ENABLE_BLOB_FILES,
+     [](const std::string &str, rocksdb::ColumnFamilyOptions &option) -> bool {
+         return dsn::buf2bool(str, option.enable_blob_files);
+     }},
+    {dsn::replica_envs::ROCKSDB_MIN_BLOB_SIZE,
+     [](const std::string &str, rocksdb::ColumnFamilyOptions &option) -> bool {
+         return dsn::buf2uint64(str, option.min_blob_size);
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_FILE_SIZE,
+     [](const std::string &str, rocksdb::ColumnFamilyOptions &option) -> bool {
+         return dsn::buf2uint64(str, option.blob_file_size);
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE,
+     [](const std::string &str, rocksdb::ColumnFamilyOptions &option) -> bool {
+         const auto iter = blob_compression_types.find(str);
+         if (iter == blob_compression_types.end()) {
+             return false;
+         }
+         option.blob_compression_type = iter->second;
+         return true;
+     }},
+    {dsn::replica_envs::ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION,
+     [](const std::string &str, rocksdb::ColumnFamilyOptions &option) -> bool {
+         return dsn::buf2bool(str, option.enable_blob_garbage_collection);
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF,
+     [](const std::string &str, rocksdb::ColumnFamilyOptions &option) -> bool {
+         return dsn::buf2double(str, option.blob_garbage_collection_age_cutoff);
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_FORCE_THRESHOLD,
+     [](const std::string &str, rocksdb::ColumnFamilyOptions &option) -> bool {
+         return dsn::buf2double(str, option.blob_garbage_collection_force_threshold);
+     }},
 };
 
 using cf_opts_getter =
@@ -178,8 +248,69 @@ const std::unordered_map<std::string, cf_opts_getter> cf_opts_getters = {
      [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
          str = std::to_string(option.num_levels);
      }},
+    {dsn::replica_envs::ROCKSDB_ENABLE_BLOB_FILES,
+     [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
+         str = option.enable_blob_files ? "true" : "false";
+     }},
+    {dsn::replica_envs::ROCKSDB_MIN_BLOB_SIZE,
+     [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
+         str = std::to_string(option.min_blob_size);
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_FILE_SIZE,
+     [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
+         str = std::to_string(option.blob_file_size);
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE,
+     [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
+         str = "<unsupported>";
+         for (const auto &[name, type] : blob_compression_types) {
+             if (type == option.blob_compression_type) {
+                 str = name;
+                 break;
+             }
+         }
+     }},
+    {dsn::replica_envs::ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION,
+     [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
+         str = option.enable_blob_garbage_collection ? "true" : "false";
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_AGE_CUTOFF,
+     [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
+         str = fmt::format("{}", option.blob_garbage_collection_age_cutoff);
+     }},
+    {dsn::replica_envs::ROCKSDB_BLOB_GARBAGE_COLLECTION_FORCE_THRESHOLD,
+     [](const rocksdb::ColumnFamilyOptions &option, /*out*/ std::string &str) {
+         str = fmt::format("{}", option.blob_garbage_collection_force_threshold);
+     }},
 };
 
+// Translate the value of a dynamic option from the format of the app env into the one accepted
+// by rocksdb::DB::SetOptions(), return false if the value is invalid.
+static bool to_rocksdb_option_value(const std::string &option,
+                                    const std::string &env_value,
+                                    /*out*/ std::string &rocksdb_value)
+{
+    if (option == dsn::replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE) {
+        const auto iter = blob_compression_types.find(env_value);
+        return iter != blob_compression_types.end() &&
+               rocksdb::GetStringFromCompressionType(&rocksdb_value, iter->second).ok();
+    }
+
+    if (option == dsn::replica_envs::ROCKSDB_ENABLE_BLOB_FILES ||
+        option == dsn::replica_envs::ROCKSDB_ENABLE_BLOB_GARBAGE_COLLECTION) {
+        // RocksDB only accepts the booleans in lower case.
+        bool val = false;
+        if (!dsn::buf2bool(env_value, val)) {
+            return false;
+        }
+        rocksdb_value = val ? "true" : "false";
+        return true;
+    }
+
+    rocksdb_value = env_value;
+    return true;
+}
+
 void pegasus_server_impl::parse_checkpoints()
 {
     std::vector<std::string> dirs;
@@ -436,18 +567,32 @@ void pegasus_server_impl::on_get(get_rpc rpc)
     METRIC_VAR_AUTO_LATENCY(get_latency_ns);
 
     const auto &key = rpc.request();
-    rocksdb::Slice skey(key.data(), key.length());
+    const uint32_t epoch_now = utils::epoch_now();
+    rocksdb::Status status;
     std::string value;
-    rocksdb::Status status = _db->Get(_data_cf_rd_opts, _data_cf, skey, &value);
+    uint32_t expire_ts = 0;
 
-    if (status.ok()) {
-        if (check_if_record_expired(utils::epoch_now(), value)) {
-            METRIC_VAR_INCREMENT(read_expired_values);
-            LOG_EXPIRED_DATA_IF_VERBOSE(key);
-            status = rocksdb::Status::NotFound();
+    bool read_from_cache = false;
+    uint64_t fill_ticket = 0;
+    if (_read_cache != nullptr) {
+        read_from_cache = _read_cache->get(key.to_string_view(), epoch_now, resp.value);
+        if (!read_from_cache) {
+            fill_ticket = _read_cache->acquire_fill_ticket(key.to_string_view());
         }
-    } else {
-        if (FLAGS_rocksdb_verbose_log) {
+    }
+
+    // The value in the cache is neither expired nor stale, otherwise read it from RocksDB.
+    if (!read_from_cache) {
+        rocksdb::Slice skey(key.data(), key.length());
+        status = _db->Get(_data_cf_rd_opts, _data_cf, skey, &value);
+        if (status.ok()) {
+            expire_ts = pegasus_extract_expire_ts(_pegasus_data_version, value);
+            if (check_if_ts_expired(epoch_now, expire_ts)) {
+                METRIC_VAR_INCREMENT(read_expired_values);
+                LOG_EXPIRED_DATA_IF_VERBOSE(key);
+                status = rocksdb::Status::NotFound();
+            }
+        } else if (FLAGS_rocksdb_verbose_log) {
             ::dsn::blob hash_key, sort_key;
             pegasus_restore_key(key, hash_key, sort_key);
             LOG_ERROR_PREFIX("rocksdb get failed for get from {}: hash_key = \"{}\", sort_key = "
@@ -470,7 +615,8 @@ void pegasus_server_impl::on_get(get_rpc rpc)
 #endif
 
     auto time_used = METRIC_VAR_AUTO_LATENCY_DURATION_NS(get_latency_ns);
-    if (is_get_abnormal(time_used, value.size())) {
+    const size_t value_size = read_from_cache ? resp.value.size() : value.size();
+    if (is_get_abnormal(time_used, value_size)) {
         ::dsn::blob hash_key, sort_key;
         pegasus_restore_key(key, hash_key, sort_key);
         LOG_WARNING_PREFIX("rocksdb abnormal get from {}: "
@@ -480,14 +626,17 @@ void pegasus_server_impl::on_get(get_rpc rpc)
                            ::pegasus::utils::c_escape_sensitive_string(hash_key),
                            ::pegasus::utils::c_escape_sensitive_string(sort_key),
                            status.ToString(),
-                           value.size(),
+                           value_size,
                            time_used);
         METRIC_VAR_INCREMENT(abnormal_read_requests);
     }
 
     resp.error = status.code();
-    if (status.ok()) {
+    if (status.ok() && !read_from_cache) {
         pegasus_extract_user_data(_pegasus_data_version, std::move(value), resp.value);
+        if (_read_cache != nullptr) {
+            _read_cache->put(key.to_string_view(), resp.value, expire_ts, fill_ticket);
+        }
     }
 
     _cu_calculator->add_get_cu(rpc.dsn_request(), resp.error, key, resp.value);
@@ -801,7 +950,7 @@ void pegasus_server_impl::on_multi_get(multi_get_rpc rpc)
             keys_holder.emplace_back(std::move(raw_key));
         }
 
-        std::vector<rocksdb::Status> statuses = _db->MultiGet(_data_cf_rd_opts, keys, &values);
+        std::vector<rocksdb::Status> statuses = multi_get_from_db(keys, values);
         for (int i = 0; i < keys.size(); i++) {
             rocksdb::Status &status = statuses[i];
             std::string &value = values[i];
@@ -903,6 +1052,38 @@ void pegasus_server_impl::on_multi_get(multi_get_rpc rpc)
     _cu_calculator->add_multi_get_cu(req, resp.error, request.hash_key, resp.kvs);
 }
 
+std::vector<rocksdb::Status>
+pegasus_server_impl::multi_get_from_db(const std::vector<rocksdb::Slice> &keys,
+                                       std::vector<std::string> &values)
+{
+    if (!FLAGS_rocksdb_batched_multi_get) {
+        return _db->MultiGet(_data_cf_rd_opts, keys, &values);
+    }
+
+    rocksdb::ReadOptions rd_opts(_data_cf_rd_opts);
+    rd_opts.async_io = FLAGS_rocksdb_multi_get_async_io;
+
+    const size_t num_keys = keys.size();
+    values.clear();
+    values.resize(num_keys);
+    std::vector<rocksdb::PinnableSlice> pinnable_values;
+    pinnable_values.reserve(num_keys);
+    for (auto &value : values) {
+        pinnable_values.emplace_back(&value);
+    }
+    std::vector<rocksdb::Status> statuses(num_keys);
+    _db->MultiGet(
+        rd_opts, _data_cf, num_keys, keys.data(), pinnable_values.data(), statuses.data());
+
+    for (size_t i = 0; i < num_keys; ++i) {
+        // The value pinned in the block cache or memtable has not been copied into the buffer.
+        if (statuses[i].ok() && pinnable_values[i].IsPinned()) {
+            values[i].assign(pinnable_values[i].data(), pinnable_values[i].size());
+        }
+    }
+    return statuses;
+}
+
 void pegasus_server_impl::on_batch_get(batch_get_rpc rpc)
 {
     CHECK_TRUE(_is_open);
@@ -927,38 +1108,67 @@ void pegasus_server_impl::on_batch_get(batch_get_rpc rpc)
         return;
     }
 
-    std::vector<rocksdb::Slice> keys;
-    keys.reserve(request.keys.size());
+    rocksdb::Status final_status;
+    bool error_occurred = false;
+    int64_t total_data_size = 0;
+    uint32_t epoch_now = pegasus::utils::epoch_now();
+    uint64_t expire_count = 0;
+
+    // The keys found in the hotkey read cache are not read from RocksDB.
     std::vector<::dsn::blob> keys_holder;
     keys_holder.reserve(request.keys.size());
-    for (const auto &key : request.keys) {
+    std::vector<::dsn::blob> cached_values(request.keys.size());
+    std::vector<bool> found_in_cache(request.keys.size(), false);
+    std::vector<uint64_t> fill_tickets(request.keys.size(), 0);
+    std::vector<rocksdb::Slice> keys;
+    keys.reserve(request.keys.size());
+    for (int i = 0; i < request.keys.size(); i++) {
+        const auto &key = request.keys[i];
         dsn::blob raw_key;
         pegasus_generate_key(raw_key, key.hash_key, key.sort_key);
-        keys.emplace_back(rocksdb::Slice(raw_key.data(), raw_key.length()));
+        if (_read_cache != nullptr) {
+            found_in_cache[i] =
+                _read_cache->get(raw_key.to_string_view(), epoch_now, cached_values[i]);
+            if (!found_in_cache[i]) {
+                fill_tickets[i] = _read_cache->acquire_fill_ticket(raw_key.to_string_view());
+            }
+        }
+        if (!found_in_cache[i]) {
+            keys.emplace_back(rocksdb::Slice(raw_key.data(), raw_key.length()));
+        }
         keys_holder.emplace_back(std::move(raw_key));
     }
 
-    rocksdb::Status final_status;
-    bool error_occurred = false;
-    int64_t total_data_size = 0;
-    uint32_t epoch_now = pegasus::utils::epoch_now();
-    uint64_t expire_count = 0;
-
     std::vector<std::string> values;
-    std::vector<rocksdb::Status> statuses = _db->MultiGet(_data_cf_rd_opts, keys, &values);
+    std::vector<rocksdb::Status> statuses;
+    if (!keys.empty()) {
+        statuses = multi_get_from_db(keys, values);
+    }
     response.data.reserve(request.keys.size());
-    for (int i = 0; i < keys.size(); i++) {
-        const auto &status = statuses[i];
-        if (status.IsNotFound()) {
+    for (int i = 0, j = 0; i < request.keys.size(); i++) {
+        const ::dsn::blob &hash_key = request.keys[i].hash_key;
+        const ::dsn::blob &sort_key = request.keys[i].sort_key;
+
+        if (found_in_cache[i]) {
+            dsn::apps::full_data current_data;
+            current_data.hash_key = hash_key;
+            current_data.sort_key = sort_key;
+            current_data.value = std::move(cached_values[i]);
+            total_data_size += current_data.value.size();
+            response.data.emplace_back(std::move(current_data));
             continue;
         }
 
-        const ::dsn::blob &hash_key = request.keys[i].hash_key;
-        const ::dsn::blob &sort_key = request.keys[i].sort_key;
-        std::string &value = values[i];
+        const auto &status = statuses[j];
+        std::string &value = values[j];
+        ++j;
+        if (status.IsNotFound()) {
+            continue;
+        }
 
         if (dsn_likely(status.ok())) {
-            if (check_if_record_expired(epoch_now, value)) {
+            const uint32_t expire_ts = pegasus_extract_expire_ts(_pegasus_data_version, value);
+            if (check_if_ts_expired(epoch_now, expire_ts)) {
                 ++expire_count;
                 LOG_EXPIRED_DATA_IF_VERBOSE(hash_key, sort_key);
                 continue;
@@ -966,6 +1176,10 @@ void pegasus_server_impl::on_batch_get(batch_get_rpc rpc)
 
             dsn::blob real_value;
             pegasus_extract_user_data(_pegasus_data_version, std::move(value), real_value);
+            if (_read_cache != nullptr) {
+                _read_cache->put(
+                    keys_holder[i].to_string_view(), real_value, expire_ts, fill_tickets[i]);
+            }
             dsn::apps::full_data current_data;
             current_data.hash_key = hash_key;
             current_data.sort_key = sort_key;
@@ -1185,6 +1399,44 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
         return;
     }
 
+    std::unique_ptr<scan_aggregator> aggregator;
+    if (request.__isset.aggregation) {
+        std::string reason;
+        if (!scan_aggregator::validate(request.aggregation, reason)) {
+            LOG_ERROR_PREFIX("invalid argument for get_scanner from {}: {}",
+                             rpc.remote_address(),
+                             reason);
+            resp.error = rocksdb::Status::kInvalidArgument;
+            _cu_calculator->add_scan_cu(req, resp.error, resp.kvs);
+            return;
+        }
+        aggregator = std::make_unique<scan_aggregator>(request.aggregation);
+    }
+
+    std::unique_ptr<scan_geo_filter> geo_filter;
+    if (request.__isset.geo_filter) {
+        std::string reason;
+        if (!scan_geo_filter::validate(request.geo_filter, reason)) {
+            LOG_ERROR_PREFIX("invalid argument for get_scanner from {}: {}",
+                             rpc.remote_address(),
+                             reason);
+            resp.error = rocksdb::Status::kInvalidArgument;
+            _cu_calculator->add_scan_cu(req, resp.error, resp.kvs);
+            return;
+        }
+        geo_filter = std::make_unique<scan_geo_filter>(request.geo_filter);
+        // The nearest records could only be returned as records.
+        if (geo_filter->keep_nearest() &&
+            (aggregator || (request.__isset.only_return_count && request.only_return_count))) {
+            LOG_ERROR_PREFIX("invalid argument for get_scanner from {}: top_k_nearest of "
+                             "geo_filter could not be used with aggregation or only_return_count",
+                             rpc.remote_address());
+            resp.error = rocksdb::Status::kInvalidArgument;
+            _cu_calculator->add_scan_cu(req, resp.error, resp.kvs);
+            return;
+        }
+    }
+
     rocksdb::ReadOptions rd_opts(_data_cf_rd_opts);
     if (_data_cf_opts.prefix_extractor) {
         ::dsn::blob start_hash_key, tmp;
@@ -1257,10 +1509,12 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
 
     bool return_expire_ts = request.__isset.return_expire_ts ? request.return_expire_ts : false;
     bool only_return_count = request.__isset.only_return_count ? request.only_return_count : false;
+    int32_t batch_bytes =
+        request.__isset.batch_bytes && request.batch_bytes > 0 ? request.batch_bytes : 0;
 
     std::unique_ptr<range_read_limiter> limiter =
         std::make_unique<range_read_limiter>(_rng_rd_opts.rocksdb_max_iteration_count,
-                                             0,
+                                             batch_bytes,
                                              _rng_rd_opts.rocksdb_iteration_threshold_time_ms);
 
     while (count < batch_count && limiter->valid() && it->Valid()) {
@@ -1292,12 +1546,29 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
             epoch_now,
             request.__isset.validate_partition_hash ? request.validate_partition_hash : true);
 
+        double distance_m = 0;
+        if (state == range_iteration_state::kNormal && geo_filter &&
+            !geo_filter->match(pegasus_extract_user_data_view(_pegasus_data_version,
+                                                              utils::to_string_view(it->value())),
+                               distance_m)) {
+            state = range_iteration_state::kFiltered;
+        }
+
         switch (state) {
         case range_iteration_state::kNormal:
             count++;
-            if (!only_return_count) {
+            if (geo_filter && geo_filter->keep_nearest()) {
+                geo_filter->add_nearest(utils::to_string_view(it->key()),
+                                        utils::to_string_view(it->value()),
+                                        distance_m);
+            } else if (aggregator) {
+                aggregator->add(utils::to_string_view(it->key()),
+                                pegasus_extract_user_data_view(_pegasus_data_version,
+                                                               utils::to_string_view(it->value())));
+            } else if (!only_return_count) {
                 append_key_value(
                     resp.kvs, it->key(), it->value(), request.no_value, return_expire_ts);
+                limiter->add_size(resp.kvs.back().key.length() + resp.kvs.back().value.length());
             }
             break;
         case range_iteration_state::kExpired:
@@ -1318,9 +1589,12 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
 
         it->Next();
     }
-    if (only_return_count) {
+    if (only_return_count || aggregator) {
         resp.__set_kv_count(count);
     }
+    if (aggregator) {
+        resp.__set_aggregation(aggregator->take_result());
+    }
 
     // check iteration time whether exceed limit
     if (!complete) {
@@ -1370,23 +1644,22 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
             std::string(request.sort_key_filter_pattern.data(),
                         request.sort_key_filter_pattern.length()),
             batch_count,
+            batch_bytes,
             request.no_value,
             request.__isset.validate_partition_hash ? request.validate_partition_hash : true,
             return_expire_ts,
             only_return_count));
-        int64_t handle = _context_cache.put(std::move(context));
-        resp.context_id = handle;
-        // if the context is used, it will be fetched and re-put into cache,
-        // which will change the handle,
-        // then the delayed task will fetch null context by old handle, and do nothing.
-        ::dsn::tasking::enqueue(
-            LPC_PEGASUS_SERVER_DELAY,
-            &_tracker,
-            [this, handle]() { _context_cache.fetch(handle); },
-            0,
-            std::chrono::minutes(5));
+        context->aggregator = std::move(aggregator);
+        context->geo_filter = std::move(geo_filter);
+        // The context will be removed by expire_idle_contexts() if it's not used in time.
+        resp.context_id = _context_cache.put(std::move(context));
     } else {
         // scan completed
+        if (geo_filter && geo_filter->keep_nearest()) {
+            for (const auto &[key, value] : geo_filter->take_nearest()) {
+                append_key_value(resp.kvs, key, value, request.no_value, return_expire_ts);
+            }
+        }
         resp.context_id = pegasus_scan_context::SCAN_CONTEXT_ID_COMPLETED;
     }
 
@@ -1437,7 +1710,7 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
         }
 
         std::unique_ptr<range_read_limiter> limiter = std::make_unique<range_read_limiter>(
-            batch_count, 0, _rng_rd_opts.rocksdb_iteration_threshold_time_ms);
+            batch_count, context->batch_bytes, _rng_rd_opts.rocksdb_iteration_threshold_time_ms);
 
         while (count < batch_count && limiter->valid() && it->Valid()) {
             int c = it->key().compare(stop);
@@ -1458,11 +1731,31 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
                                                      epoch_now,
                                                      validate_hash);
 
+            double distance_m = 0;
+            if (state == range_iteration_state::kNormal && context->geo_filter &&
+                !context->geo_filter->match(
+                    pegasus_extract_user_data_view(_pegasus_data_version,
+                                                   utils::to_string_view(it->value())),
+                    distance_m)) {
+                state = range_iteration_state::kFiltered;
+            }
+
             switch (state) {
             case range_iteration_state::kNormal:
                 count++;
-                if (!context->only_return_count) {
+                if (context->geo_filter && context->geo_filter->keep_nearest()) {
+                    context->geo_filter->add_nearest(utils::to_string_view(it->key()),
+                                                     utils::to_string_view(it->value()),
+                                                     distance_m);
+                } else if (context->aggregator) {
+                    context->aggregator->add(
+                        utils::to_string_view(it->key()),
+                        pegasus_extract_user_data_view(_pegasus_data_version,
+                                                       utils::to_string_view(it->value())));
+                } else if (!context->only_return_count) {
                     append_key_value(resp.kvs, it->key(), it->value(), no_value, return_expire_ts);
+                    limiter->add_size(resp.kvs.back().key.length() +
+                                      resp.kvs.back().value.length());
                 }
                 break;
             case range_iteration_state::kExpired:
@@ -1484,9 +1777,12 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
             it->Next();
         }
 
-        if (context->only_return_count) {
+        if (context->only_return_count || context->aggregator) {
             resp.__set_kv_count(count);
         }
+        if (context->aggregator) {
+            resp.__set_aggregation(context->aggregator->take_result());
+        }
 
         // check iteration time whether exceed limit
         if (!complete) {
@@ -1523,16 +1819,14 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
                                limiter->max_duration_time());
         } else if (it->Valid() && !complete) {
             // scan not completed
-            int64_t handle = _context_cache.put(std::move(context));
-            resp.context_id = handle;
-            ::dsn::tasking::enqueue(
-                LPC_PEGASUS_SERVER_DELAY,
-                &_tracker,
-                [this, handle]() { _context_cache.fetch(handle); },
-                0,
-                std::chrono::minutes(5));
+            resp.context_id = _context_cache.put(std::move(context));
         } else {
             // scan completed
+            if (context->geo_filter && context->geo_filter->keep_nearest()) {
+                for (const auto &[key, value] : context->geo_filter->take_nearest()) {
+                    append_key_value(resp.kvs, key, value, no_value, return_expire_ts);
+                }
+            }
             resp.context_id = pegasus_scan_context::SCAN_CONTEXT_ID_COMPLETED;
         }
 
@@ -1843,6 +2137,7 @@ dsn::error_code pegasus_server_impl::start(int argc, char **argv)
     _cu_calculator = std::make_unique<capacity_unit_calculator>(
         this, _read_hotkey_collector, _write_hotkey_collector, _read_size_throttling_controller);
     _server_write = std::make_unique<pegasus_server_write>(this);
+    _server_write->set_incr_merge_enabled(_incr_merge_enabled);
 
     dsn::tasking::enqueue_timer(
         LPC_ANALYZE_HOTKEY,
@@ -1856,6 +2151,12 @@ dsn::error_code pegasus_server_impl::start(int argc, char **argv)
         [this]() { _write_hotkey_collector->analyse_data(); },
         std::chrono::seconds(FLAGS_hotkey_analyse_time_interval_s));
 
+    dsn::tasking::enqueue_timer(
+        LPC_PEGASUS_SERVER_DELAY,
+        &_tracker,
+        [this]() { _context_cache.expire_idle_contexts(); },
+        kScanContextExpireCheckTimeSec);
+
     return dsn::ERR_OK;
 }
 
@@ -1890,6 +2191,9 @@ void pegasus_server_impl::cancel_background_work(bool wait)
     _tracker.cancel_outstanding_tasks();
 
     _context_cache.clear();
+    if (_read_cache != nullptr) {
+        _read_cache->clear();
+    }
 
     _is_open = false;
     release_db();
@@ -1918,10 +2222,12 @@ void pegasus_server_impl::cancel_background_work(bool wait)
         }
         METRIC_VAR_SET(rdb_total_sst_files, 0);
         METRIC_VAR_SET(rdb_total_sst_size_mb, 0);
+        METRIC_VAR_SET(rdb_total_blob_file_size_mb, 0);
         METRIC_VAR_SET(rdb_index_and_filter_blocks_mem_usage_bytes, 0);
         METRIC_VAR_SET(rdb_memtable_mem_usage_bytes, 0);
         METRIC_VAR_SET(rdb_block_cache_hit_count, 0);
         METRIC_VAR_SET(rdb_block_cache_total_count, 0);
+        METRIC_VAR_SET(rdb_block_cache_secondary_hit_count, 0);
     }
 
     LOG_INFO_PREFIX("close app succeed, clear_state = {}", clear_state ? "true" : "false");
@@ -2249,11 +2555,71 @@ private:
         return ::dsn::ERR_FILE_OPERATION_FAILED;
     }
 
+    // skip the SST files which the learner already has. The other files, e.g. CURRENT and
+    // MANIFEST, are always learned, thus "state.files" would never be emptied, otherwise it
+    // would be taken as an empty checkpoint by the learner.
+    sst_file_manifest learner_manifest;
+    if (learn_request.length() > 0 &&
+        !dsn::json::json_forwarder<sst_file_manifest>::decode(learn_request, learner_manifest)) {
+        LOG_WARNING_PREFIX("decode the manifest of the learner failed, learn all the files");
+        learner_manifest.files.clear();
+    }
+    sst_file_manifest reused;
+    exclude_learner_sst_files(learner_manifest, state.files, reused);
+    if (!reused.files.empty()) {
+        state.meta = dsn::json::json_forwarder<sst_file_manifest>::encode(reused);
+    }
+
     state.from_decree_excluded = 0;
     state.to_decree_included = ci;
 
-    LOG_INFO_PREFIX("get checkpoint succeed, from_decree_excluded = 0, to_decree_included = {}",
-                    state.to_decree_included);
+    LOG_INFO_PREFIX("get checkpoint succeed, from_decree_excluded = 0, to_decree_included = {}, "
+                    "learned_file_count = {}, reused_sst_file_count = {}",
+                    state.to_decree_included,
+                    state.files.size(),
+                    reused.files.size());
+    return ::dsn::ERR_OK;
+}
+
+std::vector<std::string> pegasus_server_impl::get_sst_file_dirs()
+{
+    std::vector<std::string> dirs;
+    dirs.emplace_back(
+        ::dsn::utils::filesystem::path_combine(data_dir(), replication_app_base::kRdbDir));
+
+    ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr> l(_checkpoints_lock);
+    for (auto iter = _checkpoints.rbegin(); iter != _checkpoints.rend(); ++iter) {
+        dirs.emplace_back(
+            ::dsn::utils::filesystem::path_combine(data_dir(), chkpt_get_dir_name(*iter)));
+    }
+    return dirs;
+}
+
+::dsn::error_code pegasus_server_impl::prepare_get_checkpoint(dsn::blob &learn_req)
+{
+    if (!FLAGS_learn_app_reuse_local_sst_files) {
+        return ::dsn::ERR_OK;
+    }
+
+    // Only the SST files which are not found in the last manifest are read, the lock is not
+    // held while collecting since it might take a while.
+    sst_file_manifest known;
+    {
+        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr> l(_learner_sst_manifest_lock);
+        known = _learner_sst_manifest;
+    }
+
+    sst_file_manifest manifest;
+    collect_sst_files(get_sst_file_dirs(), known, manifest);
+    if (!manifest.files.empty()) {
+        learn_req = dsn::json::json_forwarder<sst_file_manifest>::encode(manifest);
+    }
+
+    LOG_INFO_PREFIX("prepare the manifest of the local sst files for learning, file_count = {}",
+                    manifest.files.size());
+
+    ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr> l(_learner_sst_manifest_lock);
+    _learner_sst_manifest = std::move(manifest);
     return ::dsn::ERR_OK;
 }
 
@@ -2264,6 +2630,35 @@ pegasus_server_impl::storage_apply_checkpoint(chkpt_apply_mode mode,
     ::dsn::error_code err;
     int64_t ci = state.to_decree_included;
 
+    // link the SST files skipped by the primary into the learn dir before the local files
+    // are cleared.
+    if (!state.files.empty() && state.meta.length() > 0) {
+        sst_file_manifest reused;
+        if (!dsn::json::json_forwarder<sst_file_manifest>::decode(state.meta, reused)) {
+            LOG_ERROR_PREFIX("decode the manifest of the reused sst files failed");
+            return ::dsn::ERR_INVALID_DATA;
+        }
+
+        auto learn_dir = ::dsn::utils::filesystem::remove_file_name(state.files[0]);
+        err = link_reused_sst_files(reused, get_sst_file_dirs(), learn_dir);
+        if (err != ::dsn::ERR_OK) {
+            LOG_ERROR_PREFIX(
+                "link the reused sst files into {} failed, error = {}", learn_dir, err);
+            return err;
+        }
+
+        int64_t reused_bytes = 0;
+        for (const auto &file : reused.files) {
+            reused_bytes += file.size;
+        }
+        METRIC_VAR_INCREMENT_BY(learn_reused_sst_files, reused.files.size());
+        METRIC_VAR_INCREMENT_BY(learn_reused_sst_file_bytes, reused_bytes);
+        LOG_INFO_PREFIX("link {} reused sst files ({} bytes) into {}",
+                        reused.files.size(),
+                        reused_bytes,
+                        learn_dir);
+    }
+
     if (mode == chkpt_apply_mode::copy) {
         CHECK_GT(ci, last_durable_decree());
 
@@ -2294,7 +2689,11 @@ pegasus_server_impl::storage_apply_checkpoint(chkpt_apply_mode mode,
         }
     }
 
-    // clear data dir
+    // clear data dir, the sst files in it are no longer held locally.
+    {
+        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr> l(_learner_sst_manifest_lock);
+        _learner_sst_manifest.files.clear();
+    }
     if (!::dsn::utils::filesystem::remove_path(data_dir())) {
         LOG_ERROR_PREFIX("clear data directory {} failed", data_dir());
         return ::dsn::ERR_FILE_OPERATION_FAILED;
@@ -2529,6 +2928,12 @@ void pegasus_server_impl::update_replica_rocksdb_statistics()
         METRIC_VAR_SET(rdb_total_sst_size_mb, val / bytes_per_mb);
     }
 
+    if (_db->GetProperty(_data_cf, rocksdb::DB::Properties::kTotalBlobFileSize, &str_val) &&
+        dsn::buf2uint64(str_val, val)) {
+        static uint64_t bytes_per_mb = 1U << 20U;
+        METRIC_VAR_SET(rdb_total_blob_file_size_mb, val / bytes_per_mb);
+    }
+
     std::map<std::string, std::string> props;
     if (_db->GetMapProperty(_data_cf, "rocksdb.cfstats", &props)) {
         auto write_amplification_iter = props.find("compaction.Sum.WriteAmp");
@@ -2591,6 +2996,12 @@ void pegasus_server_impl::update_replica_rocksdb_statistics()
     auto block_cache_total = block_cache_hit + block_cache_miss;
     METRIC_VAR_SET(rdb_block_cache_total_count, block_cache_total);
 
+    // Only one of the secondary tiers could be enabled, thus at most one of the tickers would
+    // be non-zero.
+    auto block_cache_secondary_hit = _statistics->getTickerCount(rocksdb::SECONDARY_CACHE_HITS) +
+                                     _statistics->getTickerCount(rocksdb::PERSISTENT_CACHE_HIT);
+    METRIC_VAR_SET(rdb_block_cache_secondary_hit_count, block_cache_secondary_hit);
+
     auto memtable_hit_count = _statistics->getTickerCount(rocksdb::MEMTABLE_HIT);
     METRIC_VAR_SET(rdb_memtable_hit_count, memtable_hit_count);
 
@@ -2603,6 +3014,13 @@ void pegasus_server_impl::update_replica_rocksdb_statistics()
     GET_TICKER_COUNT_AND_SET_METRIC(GET_HIT_L1, rdb_l1_hit_count);
 
     GET_TICKER_COUNT_AND_SET_METRIC(GET_HIT_L2_AND_UP, rdb_l2_and_up_hit_count);
+
+    rocksdb::HistogramData multi_get_io_batch_size;
+    _statistics->histogramData(rocksdb::MULTIGET_IO_BATCH_SIZE, &multi_get_io_batch_size);
+    METRIC_VAR_SET(rdb_multi_get_io_batch_size_p99,
+                   static_cast<int64_t>(multi_get_io_batch_size.percentile99));
+
+    GET_TICKER_COUNT_AND_SET_METRIC(MULTIGET_COROUTINE_COUNT, rdb_multi_get_coroutines);
 }
 
 void pegasus_server_impl::update_server_rocksdb_statistics()
@@ -2678,11 +3096,17 @@ void pegasus_server_impl::update_rocksdb_dynamic_options(
             continue;
         }
 
+        std::string value;
+        if (!to_rocksdb_option_value(option, find->second, value)) {
+            LOG_ERROR_PREFIX("{}={} is invalid.", find->first, find->second);
+            continue;
+        }
+
         std::vector<std::string> args;
         // split_args example: Parse "write_buffer_size" from "rocksdb.write_buffer_size"
         dsn::utils::split_args(option.c_str(), args, '.');
         CHECK_EQ(args.size(), 2);
-        new_options[args[1]] = find->second;
+        new_options[args[1]] = std::move(value);
     }
 
     // doing set option
@@ -2733,6 +3157,7 @@ void pegasus_server_impl::update_app_envs(const std::map<std::string, std::strin
     update_slow_query_threshold(envs);
     update_rocksdb_iteration_threshold(envs);
     update_validate_partition_hash(envs);
+    update_incr_merge_enabled(envs);
     update_user_specified_compaction(envs);
     _manual_compact_svc.start_manual_compact_if_needed(envs);
 
@@ -2749,6 +3174,7 @@ void pegasus_server_impl::update_app_envs_before_open_db(
     update_slow_query_threshold(envs);
     update_rocksdb_iteration_threshold(envs);
     update_validate_partition_hash(envs);
+    update_incr_merge_enabled(envs);
     update_user_specified_compaction(envs);
     _manual_compact_svc.start_manual_compact_if_needed(envs);
     set_rocksdb_options_before_creating(envs);
@@ -2822,6 +3248,9 @@ void pegasus_server_impl::update_default_ttl(const std::map<std::string, std::st
         }
         _server_write->set_default_ttl(static_cast<uint32_t>(ttl));
         _key_ttl_compaction_filter_factory->SetDefaultTTL(static_cast<uint32_t>(ttl));
+        if (_read_cache != nullptr) {
+            _read_cache->set_default_ttl(static_cast<uint32_t>(ttl));
+        }
     }
 }
 
@@ -2982,6 +3411,28 @@ void pegasus_server_impl::update_validate_partition_hash(
     }
 }
 
+void pegasus_server_impl::update_incr_merge_enabled(const std::map<std::string, std::string> &envs)
+{
+    bool new_value = false;
+    auto iter = envs.find(dsn::replica_envs::INCR_MERGE_ENABLED);
+    if (iter != envs.end()) {
+        if (!dsn::buf2bool(iter->second, new_value)) {
+            LOG_ERROR_PREFIX("{}={} is invalid.", iter->first, iter->second);
+            return;
+        }
+    }
+    if (new_value != _incr_merge_enabled) {
+        LOG_INFO_PREFIX(
+            "update '_incr_merge_enabled' from {} to {}", _incr_merge_enabled, new_value);
+        _incr_merge_enabled = new_value;
+        // The write service is not created yet before the db is opened, and it will take
+        // `_incr_merge_enabled` once created.
+        if (_server_write != nullptr) {
+            _server_write->set_incr_merge_enabled(_incr_merge_enabled);
+        }
+    }
+}
+
 void pegasus_server_impl::update_user_specified_compaction(
     const std::map<std::string, std::string> &envs)
 {
@@ -2990,12 +3441,19 @@ void pegasus_server_impl::update_user_specified_compaction(
         LOG_INFO_PREFIX("clear user specified compaction coz it was deleted");
         _key_ttl_compaction_filter_factory->clear_user_specified_ops();
         _user_specified_compaction = "";
+        if (_read_cache != nullptr) {
+            _read_cache->set_suspended(false);
+        }
         return;
     }
     if (dsn_unlikely(iter != envs.end() && iter->second != _user_specified_compaction)) {
         LOG_INFO_PREFIX("update user specified compaction coz it was changed");
         _key_ttl_compaction_filter_factory->extract_user_specified_ops(iter->second);
         _user_specified_compaction = iter->second;
+        // The values might be deleted or updated by any compaction according to the rules.
+        if (_read_cache != nullptr) {
+            _read_cache->set_suspended(true);
+        }
         return;
     }
 }
@@ -3183,6 +3641,15 @@ void pegasus_server_impl::reset_rocksdb_options(const rocksdb::ColumnFamilyOptio
     // aspect 2:
     target_cf_opts->num_levels = base_cf_opts.num_levels;
     target_cf_opts->write_buffer_size = base_cf_opts.write_buffer_size;
+    target_cf_opts->enable_blob_files = base_cf_opts.enable_blob_files;
+    target_cf_opts->min_blob_size = base_cf_opts.min_blob_size;
+    target_cf_opts->blob_file_size = base_cf_opts.blob_file_size;
+    target_cf_opts->blob_compression_type = base_cf_opts.blob_compression_type;
+    target_cf_opts->enable_blob_garbage_collection = base_cf_opts.enable_blob_garbage_collection;
+    target_cf_opts->blob_garbage_collection_age_cutoff =
+        base_cf_opts.blob_garbage_collection_age_cutoff;
+    target_cf_opts->blob_garbage_collection_force_threshold =
+        base_cf_opts.blob_garbage_collection_force_threshold;
 
     reset_allow_ingest_behind_option(base_db_opt, envs, target_db_opt);
 }
@@ -3387,6 +3854,10 @@ uint64_t pegasus_server_impl::do_manual_compact(const rocksdb::CompactRangeOptio
                         : dsn::replica_envs::MANUAL_COMPACT_BOTTOMMOST_LEVEL_COMPACTION_SKIP);
     start_time = dsn_now_ms();
     auto status = _db->CompactRange(options, _data_cf, nullptr, nullptr);
+    if (_read_cache != nullptr) {
+        // The compaction filter might have changed the data, e.g. by the default ttl.
+        _read_cache->clear();
+    }
     auto end_time = dsn_now_ms();
     LOG_INFO_PREFIX("finish CompactRange, status = {}, time_used = {}ms",
                     status.ToString(),
@@ -38,6 +38,7 @@
 
 #include "bulk_load_types.h"
 #include "common/gpid.h"
+#include "learn_sst_manifest.h"
 #include "metadata_types.h"
 #include "pegasus_manual_compact_service.h"
 #include "pegasus_read_service.h"
@@ -70,6 +71,8 @@ namespace rocksdb {
 class Cache;
 class ColumnFamilyHandle;
 class DB;
+struct LRUCacheOptions;
+class PersistentCache;
 class RateLimiter;
 class Statistics;
 class WriteBufferManager;
@@ -98,6 +101,7 @@ namespace server {
 
 class capacity_unit_calculator;
 class hotkey_collector;
+class hotkey_read_cache;
 class meta_store;
 class pegasus_server_write;
 
@@ -166,10 +170,9 @@ public:
                                   uint32_t count,
                                   idempotent_writer_ptr &&idem_writer) override;
 
-    ::dsn::error_code prepare_get_checkpoint(dsn::blob &learn_req) override
-    {
-        return ::dsn::ERR_OK;
-    }
+    // put the manifest of the local SST files into "learn_req", so that the primary could skip
+    // the SST files which the learner already has while learning the checkpoint.
+    ::dsn::error_code prepare_get_checkpoint(dsn::blob &learn_req) override;
 
     // returns:
     //  - ERR_OK: checkpoint succeed
@@ -207,8 +210,9 @@ public:
 
     // get the last checkpoint
     // if succeed:
-    //  - the checkpoint files path are put into "state.files"
-    //  - the checkpoint_info are serialized into "state.meta"
+    //  - the checkpoint files path are put into "state.files", except the SST files found in
+    //    the manifest of the learner carried by "learn_request"
+    //  - the manifest of the SST files skipped are serialized into "state.meta"
     //  - the "state.from_decree_excluded" and "state.to_decree_excluded" are set properly
     // returns:
     //  - ERR_OK
@@ -250,6 +254,9 @@ public:
         return _ingestion_status;
     }
 
+    // Whether `type` is a valid value of [pegasus.server] rocksdb_block_cache_secondary_type.
+    static bool is_block_cache_secondary_type_valid(const char *type);
+
 private:
     friend class manual_compact_service_test;
     friend class pegasus_compression_options_test;
@@ -261,6 +268,8 @@ private:
     FRIEND_TEST(pegasus_server_impl_test, test_open_db_with_app_envs);
     FRIEND_TEST(pegasus_server_impl_test, test_stop_db_twice);
     FRIEND_TEST(pegasus_server_impl_test, test_update_user_specified_compaction);
+    FRIEND_TEST(pegasus_server_impl_test, test_blob_files);
+    FRIEND_TEST(pegasus_server_impl_test, test_block_cache_secondary_type);
 
     friend class pegasus_manual_compact_service;
     friend class pegasus_write_service;
@@ -274,6 +283,10 @@ private:
     // if force_reserve_one == true, then only reserve the last one checkpoint
     void gc_checkpoints(bool force_reserve_one = false);
 
+    // the dirs where the local SST files could be found, i.e. the rocksdb dir and the
+    // checkpoint dirs, the newer ones first.
+    std::vector<std::string> get_sst_file_dirs();
+
     void set_last_durable_decree(int64_t decree) { _last_durable_decree.store(decree); }
 
     void append_key_value(std::vector<::dsn::apps::key_value> &kvs,
@@ -317,6 +330,12 @@ private:
 
     static void update_server_rocksdb_statistics();
 
+    // Get the options of the block cache shared by all replicas from the flags. The cache file
+    // of the secondary tier is opened into `persistent_cache` if the type of the tier is 'file';
+    // once it failed to be opened, the block cache would work without the secondary tier.
+    static rocksdb::LRUCacheOptions
+    get_block_cache_options(std::shared_ptr<rocksdb::PersistentCache> &persistent_cache);
+
     // get the absolute path of restore directory and the flag whether force restore from env
     // return
     //      std::pair<std::string, bool>, pair.first is the path of the restore dir; pair.second is
@@ -340,6 +359,8 @@ private:
 
     void update_validate_partition_hash(const std::map<std::string, std::string> &envs);
 
+    void update_incr_merge_enabled(const std::map<std::string, std::string> &envs);
+
     void update_user_specified_compaction(const std::map<std::string, std::string> &envs);
 
     void update_rocksdb_dynamic_options(const std::map<std::string, std::string> &envs);
@@ -460,6 +481,10 @@ private:
         return false;
     }
 
+    // Read the values of `keys` from the data column family for multi_get and batch_get.
+    std::vector<rocksdb::Status> multi_get_from_db(const std::vector<rocksdb::Slice> &keys,
+                                                   std::vector<std::string> &values);
+
     ::dsn::error_code
     check_column_families(const std::string &path, bool *missing_meta_cf, bool *miss_data_cf);
 
@@ -484,6 +509,7 @@ private:
     log_expired_data(const char *op, const dsn::rpc_address &addr, const rocksdb::Slice &key) const;
 
     static const std::chrono::seconds kServerStatUpdateTimeSec;
+    static const std::chrono::seconds kScanContextExpireCheckTimeSec;
     static const std::string COMPRESSION_HEADER;
 
     dsn::gpid _gpid;
@@ -514,6 +540,7 @@ private:
     rocksdb::ColumnFamilyHandle *_data_cf;
     rocksdb::ColumnFamilyHandle *_meta_cf;
     static std::shared_ptr<rocksdb::Cache> _s_block_cache;
+    static std::shared_ptr<rocksdb::PersistentCache> _s_persistent_cache;
     static std::shared_ptr<rocksdb::WriteBufferManager> _s_write_buffer_manager;
     static std::shared_ptr<rocksdb::RateLimiter> _s_rate_limiter;
     static int64_t _rocksdb_limiter_last_total_through;
@@ -533,6 +560,12 @@ private:
 
     pegasus_context_cache _context_cache;
 
+    // The manifest of the local SST files sent by the last learn request, which is used to
+    // avoid reading the files again in the next learning. It's prepared off the replica thread
+    // and cleared while applying the learned checkpoint, thus protected by the lock.
+    ::dsn::utils::ex_lock_nr _learner_sst_manifest_lock;
+    sst_file_manifest _learner_sst_manifest;
+
     ::dsn::task_ptr _update_replica_rdb_stat;
     static ::dsn::task_ptr _update_server_rdb_stat;
 
@@ -540,6 +573,7 @@ private:
 
     std::atomic<int32_t> _partition_version;
     bool _validate_partition_hash{false};
+    bool _incr_merge_enabled{false};
 
     dsn::replication::ingestion_status::type _ingestion_status{
         dsn::replication::ingestion_status::IS_INVALID};
@@ -549,6 +583,9 @@ private:
     std::shared_ptr<hotkey_collector> _read_hotkey_collector;
     std::shared_ptr<hotkey_collector> _write_hotkey_collector;
 
+    // Null if the hotkey read cache is disabled.
+    std::shared_ptr<hotkey_read_cache> _read_cache;
+
     std::shared_ptr<throttling_controller> _read_size_throttling_controller;
 
     METRIC_VAR_DECLARE_counter(get_requests);
@@ -556,10 +593,10 @@ private:
     METRIC_VAR_DECLARE_counter(batch_get_requests);
     METRIC_VAR_DECLARE_counter(scan_requests);
 
-    METRIC_VAR_DECLARE_percentile_int64(get_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(multi_get_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(batch_get_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(scan_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(get_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(multi_get_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(batch_get_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(scan_latency_ns);
 
     METRIC_VAR_DECLARE_counter(read_expired_values);
     METRIC_VAR_DECLARE_counter(read_filtered_values);
@@ -575,18 +612,22 @@ private:
     // Replica-level metrics for rocksdb.
     METRIC_VAR_DECLARE_gauge_int64(rdb_total_sst_files);
     METRIC_VAR_DECLARE_gauge_int64(rdb_total_sst_size_mb);
+    METRIC_VAR_DECLARE_gauge_int64(rdb_total_blob_file_size_mb);
     METRIC_VAR_DECLARE_gauge_int64(rdb_estimated_keys);
 
     METRIC_VAR_DECLARE_gauge_int64(rdb_index_and_filter_blocks_mem_usage_bytes);
     METRIC_VAR_DECLARE_gauge_int64(rdb_memtable_mem_usage_bytes);
     METRIC_VAR_DECLARE_gauge_int64(rdb_block_cache_hit_count);
     METRIC_VAR_DECLARE_gauge_int64(rdb_block_cache_total_count);
+    METRIC_VAR_DECLARE_gauge_int64(rdb_block_cache_secondary_hit_count);
     METRIC_VAR_DECLARE_gauge_int64(rdb_memtable_hit_count);
     METRIC_VAR_DECLARE_gauge_int64(rdb_memtable_total_count);
     METRIC_VAR_DECLARE_gauge_int64(rdb_l0_hit_count);
     METRIC_VAR_DECLARE_gauge_int64(rdb_l1_hit_count);
     METRIC_VAR_DECLARE_gauge_int64(rdb_l2_and_up_hit_count);
 
+    METRIC_VAR_DECLARE_gauge_int64(rdb_multi_get_io_batch_size_p99);
+    METRIC_VAR_DECLARE_gauge_int64(rdb_multi_get_coroutines);
     METRIC_VAR_DECLARE_gauge_int64(rdb_write_amplification);
     METRIC_VAR_DECLARE_gauge_int64(rdb_read_amplification);
 
@@ -595,6 +636,9 @@ private:
     METRIC_VAR_DECLARE_gauge_int64(rdb_bloom_filter_point_lookup_negatives);
     METRIC_VAR_DECLARE_gauge_int64(rdb_bloom_filter_point_lookup_positives);
     METRIC_VAR_DECLARE_gauge_int64(rdb_bloom_filter_point_lookup_true_positives);
+
+    METRIC_VAR_DECLARE_counter(learn_reused_sst_files);
+    METRIC_VAR_DECLARE_counter(learn_reused_sst_file_bytes);
 };
 
 } // namespace server
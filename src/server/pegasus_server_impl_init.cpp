@@ -21,8 +21,10 @@
 #include <rocksdb/cache.h>
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/options.h>
+#include <rocksdb/persistent_cache.h>
 #include <rocksdb/rate_limiter.h>
 #include <rocksdb/statistics.h>
+#include <rocksdb/status.h>
 #include <rocksdb/table.h>
 #include <rocksdb/write_buffer_manager.h>
 #include <stdio.h>
@@ -40,6 +42,7 @@
 #include "common/gpid.h"
 #include "hashkey_transform.h"
 #include "hotkey_collector.h"
+#include "hotkey_read_cache.h"
 #include "pegasus_event_listener.h"
 #include "pegasus_server_impl.h"
 #include "pegasus_value_schema.h"
@@ -48,6 +51,7 @@
 #include "runtime/api_layer1.h"
 #include "server/capacity_unit_calculator.h" // IWYU pragma: keep
 #include "server/key_ttl_compaction_filter.h"
+#include "server/pegasus_incr_merge_operator.h"
 #include "server/pegasus_read_service.h"
 #include "server/pegasus_server_write.h" // IWYU pragma: keep
 #include "server/range_read_limiter.h"
@@ -78,25 +82,25 @@ METRIC_DEFINE_counter(replica,
                       dsn::metric_unit::kRequests,
                       "The number of SCAN requests");
 
-METRIC_DEFINE_percentile_int64(replica,
-                               get_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of GET requests");
+METRIC_DEFINE_histogram_int64(replica,
+                              get_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of GET requests");
 
-METRIC_DEFINE_percentile_int64(replica,
-                               multi_get_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of MULTI_GET requests");
+METRIC_DEFINE_histogram_int64(replica,
+                              multi_get_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of MULTI_GET requests");
 
-METRIC_DEFINE_percentile_int64(replica,
-                               batch_get_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of BATCH_GET requests");
+METRIC_DEFINE_histogram_int64(replica,
+                              batch_get_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of BATCH_GET requests");
 
-METRIC_DEFINE_percentile_int64(replica,
-                               scan_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of SCAN requests");
+METRIC_DEFINE_histogram_int64(replica,
+                              scan_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of SCAN requests");
 
 METRIC_DEFINE_counter(replica,
                       read_expired_values,
@@ -125,6 +129,11 @@ METRIC_DEFINE_gauge_int64(replica,
                           dsn::metric_unit::kMegaBytes,
                           "The total size of rocksdb sst files");
 
+METRIC_DEFINE_gauge_int64(replica,
+                          rdb_total_blob_file_size_mb,
+                          dsn::metric_unit::kMegaBytes,
+                          "The total size of rocksdb blob files");
+
 METRIC_DEFINE_gauge_int64(replica,
                           rdb_estimated_keys,
                           dsn::metric_unit::kKeys,
@@ -150,6 +159,12 @@ METRIC_DEFINE_gauge_int64(replica,
                           dsn::metric_unit::kPointLookups,
                           "The total number of lookups on rocksdb block cache");
 
+METRIC_DEFINE_gauge_int64(replica,
+                          rdb_block_cache_secondary_hit_count,
+                          dsn::metric_unit::kPointLookups,
+                          "The hit number of lookups on the secondary tier of rocksdb block cache, "
+                          "i.e. the misses of the block cache served without reading sst files");
+
 METRIC_DEFINE_gauge_int64(replica,
                           rdb_memtable_hit_count,
                           dsn::metric_unit::kPointLookups,
@@ -175,6 +190,18 @@ METRIC_DEFINE_gauge_int64(replica,
                           dsn::metric_unit::kPointLookups,
                           "The number of lookups served by rocksdb L2 and up");
 
+METRIC_DEFINE_gauge_int64(replica,
+                          rdb_multi_get_io_batch_size_p99,
+                          dsn::metric_unit::kOperations,
+                          "The P99 of the number of the data blocks read in parallel by a batched "
+                          "MultiGet of rocksdb, i.e. the depth of the I/O issued by MultiGet");
+
+METRIC_DEFINE_gauge_int64(replica,
+                          rdb_multi_get_coroutines,
+                          dsn::metric_unit::kTasks,
+                          "The number of the coroutines used by the batched MultiGet of rocksdb to "
+                          "read the SST files asynchronously");
+
 METRIC_DEFINE_gauge_int64(replica,
                           rdb_write_amplification,
                           dsn::metric_unit::kAmplification,
@@ -232,6 +259,18 @@ METRIC_DEFINE_gauge_int64(replica,
                           "The number of times full bloom filter has not avoided the reads and "
                           "data actually exist, used by rocksdb");
 
+METRIC_DEFINE_counter(replica,
+                      learn_reused_sst_files,
+                      dsn::metric_unit::kFiles,
+                      "The number of the SST files hard-linked from the local ones rather than "
+                      "copied from the primary while learning the checkpoint");
+
+METRIC_DEFINE_counter(replica,
+                      learn_reused_sst_file_bytes,
+                      dsn::metric_unit::kBytes,
+                      "The size of the SST files hard-linked from the local ones rather than "
+                      "copied from the primary while learning the checkpoint");
+
 METRIC_DEFINE_gauge_int64(server,
                           rdb_block_cache_mem_usage_bytes,
                           dsn::metric_unit::kBytes,
@@ -579,6 +618,43 @@ DSN_DEFINE_string(pegasus.server,
 DSN_DEFINE_validator(rocksdb_filter_type, [](const char *value) -> bool {
     return dsn::utils::equals(value, "common") || dsn::utils::equals(value, "prefix");
 });
+DSN_DEFINE_string(pegasus.server,
+                  rocksdb_block_cache_secondary_type,
+                  "none",
+                  "The type of the secondary tier under the block cache shared by all RocksDB "
+                  "instances in the process, should be 'none', 'compressed' (an in-memory cache "
+                  "holding the blocks evicted from the block cache in compressed form) or 'file' "
+                  "(a cache file on a local SSD/NVMe path holding the blocks read from disk)");
+DSN_DEFINE_validator(rocksdb_block_cache_secondary_type, [](const char *value) -> bool {
+    return pegasus::server::pegasus_server_impl::is_block_cache_secondary_type_valid(value);
+});
+DSN_DEFINE_uint64(pegasus.server,
+                  rocksdb_block_cache_secondary_capacity,
+                  10 * 1024 * 1024 * 1024ULL,
+                  "The capacity in bytes of the secondary tier of the block cache");
+DSN_DEFINE_validator(rocksdb_block_cache_secondary_capacity,
+                     [](uint64_t value) -> bool { return value > 0; });
+DSN_DEFINE_string(pegasus.server,
+                  rocksdb_block_cache_secondary_path,
+                  "",
+                  "The directory of the cache file if rocksdb_block_cache_secondary_type is "
+                  "'file', which should be on a local SSD/NVMe device and not be shared with "
+                  "other processes");
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_block_cache_secondary_optimized_for_nvm,
+                false,
+                "Whether the cache file of the secondary tier is optimized for NVMe, corresponding "
+                "to the optimized_for_nvm argument of RocksDB's NewPersistentCache");
+DSN_DEFINE_group_validator(rocksdb_block_cache_secondary_path, [](std::string &message) -> bool {
+    if (dsn::utils::equals(FLAGS_rocksdb_block_cache_secondary_type, "file") &&
+        dsn::utils::is_empty(FLAGS_rocksdb_block_cache_secondary_path)) {
+        message = "[pegasus.server] rocksdb_block_cache_secondary_path should be set if "
+                  "rocksdb_block_cache_secondary_type is 'file'.";
+        return false;
+    }
+
+    return true;
+});
 DSN_DEFINE_uint64(pegasus.server,
                   stats_dump_period_sec,
                   600, // 600 is the default value in RocksDB.
@@ -587,6 +663,17 @@ DSN_DEFINE_uint64(pegasus.server,
                   stats_persist_period_sec,
                   600, // 600 is the default value in RocksDB.
                   "If not zero, dump rocksdb.stats to RocksDB every stats_persist_period_sec");
+DSN_DEFINE_bool(pegasus.server,
+                hotkey_read_cache_enabled,
+                false,
+                "Whether to cache the values of the frequently read keys of each replica in "
+                "memory, to serve GET and BATCH_GET without reading RocksDB");
+DSN_DEFINE_uint64(pegasus.server,
+                  hotkey_read_cache_capacity_bytes,
+                  16 * 1024 * 1024,
+                  "The memory capacity in bytes of the hotkey read cache of each replica");
+DSN_DEFINE_validator(hotkey_read_cache_capacity_bytes,
+                     [](uint64_t value) -> bool { return value > 0; });
 
 namespace dsn {
 namespace replication {
@@ -613,6 +700,7 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
       _pegasus_data_version(PEGASUS_DATA_VERSION_MAX),
       _last_durable_decree(0),
       _is_checkpointing(false),
+      _context_cache(this),
       _manual_compact_svc(this),
       _partition_version(0),
       METRIC_VAR_INIT_replica(get_requests),
@@ -629,23 +717,29 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
       METRIC_VAR_INIT_replica(throttling_rejected_read_requests),
       METRIC_VAR_INIT_replica(rdb_total_sst_files),
       METRIC_VAR_INIT_replica(rdb_total_sst_size_mb),
+      METRIC_VAR_INIT_replica(rdb_total_blob_file_size_mb),
       METRIC_VAR_INIT_replica(rdb_estimated_keys),
       METRIC_VAR_INIT_replica(rdb_index_and_filter_blocks_mem_usage_bytes),
       METRIC_VAR_INIT_replica(rdb_memtable_mem_usage_bytes),
       METRIC_VAR_INIT_replica(rdb_block_cache_hit_count),
       METRIC_VAR_INIT_replica(rdb_block_cache_total_count),
+      METRIC_VAR_INIT_replica(rdb_block_cache_secondary_hit_count),
       METRIC_VAR_INIT_replica(rdb_memtable_hit_count),
       METRIC_VAR_INIT_replica(rdb_memtable_total_count),
       METRIC_VAR_INIT_replica(rdb_l0_hit_count),
       METRIC_VAR_INIT_replica(rdb_l1_hit_count),
       METRIC_VAR_INIT_replica(rdb_l2_and_up_hit_count),
+      METRIC_VAR_INIT_replica(rdb_multi_get_io_batch_size_p99),
+      METRIC_VAR_INIT_replica(rdb_multi_get_coroutines),
       METRIC_VAR_INIT_replica(rdb_write_amplification),
       METRIC_VAR_INIT_replica(rdb_read_amplification),
       METRIC_VAR_INIT_replica(rdb_bloom_filter_seek_negatives),
       METRIC_VAR_INIT_replica(rdb_bloom_filter_seek_total),
       METRIC_VAR_INIT_replica(rdb_bloom_filter_point_lookup_negatives),
       METRIC_VAR_INIT_replica(rdb_bloom_filter_point_lookup_positives),
-      METRIC_VAR_INIT_replica(rdb_bloom_filter_point_lookup_true_positives)
+      METRIC_VAR_INIT_replica(rdb_bloom_filter_point_lookup_true_positives),
+      METRIC_VAR_INIT_replica(learn_reused_sst_files),
+      METRIC_VAR_INIT_replica(learn_reused_sst_file_bytes)
 {
     _primary_host_port = dsn_primary_host_port().to_string();
     _gpid = get_gpid();
@@ -655,6 +749,11 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
     _write_hotkey_collector =
         std::make_shared<hotkey_collector>(dsn::replication::hotkey_type::WRITE, this);
 
+    if (FLAGS_hotkey_read_cache_enabled) {
+        _read_cache =
+            std::make_shared<hotkey_read_cache>(this, FLAGS_hotkey_read_cache_capacity_bytes);
+    }
+
     _read_size_throttling_controller =
         std::make_shared<dsn::utils::token_bucket_throttling_controller>();
     _slow_query_threshold_ns = FLAGS_rocksdb_slow_query_threshold_ns;
@@ -723,12 +822,12 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
         static std::once_flag flag;
         std::call_once(flag, [&]() {
             // init block cache
-            _s_block_cache = rocksdb::NewLRUCache(FLAGS_rocksdb_block_cache_capacity,
-                                                  FLAGS_rocksdb_block_cache_num_shard_bits);
+            _s_block_cache = rocksdb::NewLRUCache(get_block_cache_options(_s_persistent_cache));
         });
 
         // every replica has the same block cache
         _tbl_opts.block_cache = _s_block_cache;
+        _tbl_opts.persistent_cache = _s_persistent_cache;
     }
 
     // FLAGS_rocksdb_limiter_max_write_megabytes_per_sec <= 0 means close the rate limit.
@@ -845,6 +944,9 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
 
     _key_ttl_compaction_filter_factory = std::make_shared<KeyWithTTLCompactionFilterFactory>();
     _data_cf_opts.compaction_filter_factory = _key_ttl_compaction_filter_factory;
+    // Always installed even if no table enables incr merge, since the merge operands might
+    // have been written before the env "replica.incr_merge_enabled" is disabled.
+    _data_cf_opts.merge_operator = std::make_shared<pegasus_incr_merge_operator>();
     _data_cf_opts.periodic_compaction_seconds = FLAGS_rocksdb_periodic_compaction_seconds;
     _checkpoint_reserve_min_count = FLAGS_checkpoint_reserve_min_count;
     _checkpoint_reserve_time_seconds = FLAGS_checkpoint_reserve_time_seconds;
@@ -864,5 +966,60 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
     });
 }
 
+/*static*/ bool pegasus_server_impl::is_block_cache_secondary_type_valid(const char *type)
+{
+    return dsn::utils::equals(type, "none") || dsn::utils::equals(type, "compressed") ||
+           dsn::utils::equals(type, "file");
+}
+
+/*static*/ rocksdb::LRUCacheOptions pegasus_server_impl::get_block_cache_options(
+    std::shared_ptr<rocksdb::PersistentCache> &persistent_cache)
+{
+    rocksdb::LRUCacheOptions cache_opts;
+    cache_opts.capacity = FLAGS_rocksdb_block_cache_capacity;
+    cache_opts.num_shard_bits = FLAGS_rocksdb_block_cache_num_shard_bits;
+
+    // The secondary tier is also shared by all replicas. A block evicted from the block cache
+    // would be kept in the compressed secondary cache, while the blocks read from sst files
+    // would be kept in the cache file, thus a miss of the block cache could be served without
+    // reading sst files on slow disks.
+    LOG_INFO("rocksdb_block_cache_secondary_type = {}, rocksdb_block_cache_secondary_capacity = {}",
+             FLAGS_rocksdb_block_cache_secondary_type,
+             FLAGS_rocksdb_block_cache_secondary_capacity);
+    if (dsn::utils::equals(FLAGS_rocksdb_block_cache_secondary_type, "compressed")) {
+        // A block is admitted into the compressed secondary cache only once it has been evicted
+        // from the block cache twice, so that the blocks read just once would not flush out the
+        // hot ones.
+        rocksdb::CompressedSecondaryCacheOptions secondary_opts;
+        secondary_opts.capacity = FLAGS_rocksdb_block_cache_secondary_capacity;
+        secondary_opts.num_shard_bits = FLAGS_rocksdb_block_cache_num_shard_bits;
+        cache_opts.secondary_cache = rocksdb::NewCompressedSecondaryCache(secondary_opts);
+    } else if (dsn::utils::equals(FLAGS_rocksdb_block_cache_secondary_type, "file")) {
+        LOG_INFO("rocksdb_block_cache_secondary_path = {}, "
+                 "rocksdb_block_cache_secondary_optimized_for_nvm = {}",
+                 FLAGS_rocksdb_block_cache_secondary_path,
+                 FLAGS_rocksdb_block_cache_secondary_optimized_for_nvm);
+        auto *env = dsn::utils::PegasusEnv(dsn::utils::FileDataType::kSensitive);
+        const auto s =
+            rocksdb::NewPersistentCache(env,
+                                        FLAGS_rocksdb_block_cache_secondary_path,
+                                        FLAGS_rocksdb_block_cache_secondary_capacity,
+                                        nullptr,
+                                        FLAGS_rocksdb_block_cache_secondary_optimized_for_nvm,
+                                        &persistent_cache);
+        if (!s.ok()) {
+            // The cache file is just an optimization, thus the server would still be started
+            // without it rather than failing on a bad path or a full disk.
+            LOG_ERROR("open the secondary block cache file in {} failed, the block cache would "
+                      "work without the secondary tier: {}",
+                      FLAGS_rocksdb_block_cache_secondary_path,
+                      s.ToString());
+            persistent_cache.reset();
+        }
+    }
+
+    return cache_opts;
+}
+
 } // namespace server
 } // namespace pegasus
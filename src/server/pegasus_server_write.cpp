@@ -20,6 +20,7 @@
 #include <fmt/core.h>
 #include <thrift/transport/TTransportException.h>
 #include <algorithm>
+#include <initializer_list>
 #include <string_view>
 #include <type_traits>
 #include <utility>
@@ -47,6 +48,14 @@ METRIC_DEFINE_counter(replica,
                       dsn::metric_unit::kRequests,
                       "The number of corrupt writes for each replica");
 
+DSN_DEFINE_bool(pegasus.server,
+                batch_multi_writes,
+                false,
+                "Whether to batch multi_put, multi_remove and non-idempotent incr requests with "
+                "other writes into a mutation, so that they are applied into RocksDB by one "
+                "write. Enable it only after all replica servers of the cluster support it, "
+                "since the replicas of old versions could not apply such mutations");
+
 DSN_DECLARE_bool(rocksdb_verbose_log);
 
 namespace pegasus::server {
@@ -148,9 +157,35 @@ int pegasus_server_write::on_batched_write_requests(dsn::message_ex **requests,
 
 void pegasus_server_write::set_default_ttl(uint32_t ttl) { _write_svc->set_default_ttl(ttl); }
 
+void pegasus_server_write::set_incr_merge_enabled(bool enabled)
+{
+    _write_svc->set_incr_merge_enabled(enabled);
+}
+
+void pegasus_server_write::init_batchable_write_codes()
+{
+    if (!FLAGS_batch_multi_writes) {
+        return;
+    }
+
+    // The incr requests which need to be made idempotent are still not batched, see
+    // mutation_queue::allow_batch().
+    for (const auto &code : {dsn::apps::RPC_RRDB_RRDB_MULTI_PUT,
+                             dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE,
+                             dsn::apps::RPC_RRDB_RRDB_INCR}) {
+        dsn::task_spec::get(code)->rpc_request_is_write_allow_batch = true;
+    }
+}
+
 int pegasus_server_write::on_batched_writes(dsn::message_ex **requests, uint32_t count)
 {
-    _write_svc->batch_prepare(_decree);
+    // The writes in a batch are invisible to the reads before it's committed, thus an incr
+    // following other writes needs to read them from the batch.
+    bool read_your_writes = false;
+    for (uint32_t i = 1; i < count && !read_your_writes; ++i) {
+        read_your_writes = requests[i]->rpc_code() == dsn::apps::RPC_RRDB_RRDB_INCR;
+    }
+    _write_svc->batch_prepare(_decree, read_your_writes);
 
     int err = rocksdb::Status::kOk;
     for (uint32_t i = 0; i < count; ++i) {
@@ -186,6 +221,18 @@ int pegasus_server_write::on_batched_writes(dsn::message_ex **requests, uint32_t
                 auto rpc = remove_rpc::auto_reply(requests[i]);
                 local_err = on_single_remove_in_batch(rpc);
                 _remove_rpc_batch.emplace_back(std::move(rpc));
+            } else if (rpc_code == dsn::apps::RPC_RRDB_RRDB_MULTI_PUT) {
+                auto rpc = multi_put_rpc::auto_reply(requests[i]);
+                local_err = on_multi_put_in_batch(rpc);
+                _multi_put_rpc_batch.emplace_back(std::move(rpc));
+            } else if (rpc_code == dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE) {
+                auto rpc = multi_remove_rpc::auto_reply(requests[i]);
+                local_err = on_multi_remove_in_batch(rpc);
+                _multi_remove_rpc_batch.emplace_back(std::move(rpc));
+            } else if (rpc_code == dsn::apps::RPC_RRDB_RRDB_INCR) {
+                auto rpc = incr_rpc::auto_reply(requests[i]);
+                local_err = on_incr_in_batch(rpc);
+                _incr_rpc_batch.emplace_back(std::move(rpc));
             } else {
                 if (_non_batch_write_handlers.find(rpc_code) != _non_batch_write_handlers.end()) {
                     LOG_FATAL_PREFIX("rpc code not allow batch: {}", rpc_code);
@@ -209,7 +256,9 @@ int pegasus_server_write::on_batched_writes(dsn::message_ex **requests, uint32_t
     }
 
     if (dsn_unlikely(err != rocksdb::Status::kOk ||
-                     (_put_rpc_batch.empty() && _remove_rpc_batch.empty()))) {
+                     (_put_rpc_batch.empty() && _remove_rpc_batch.empty() &&
+                      _multi_put_rpc_batch.empty() && _multi_remove_rpc_batch.empty() &&
+                      _incr_rpc_batch.empty()))) {
         _write_svc->batch_abort(_decree, err == rocksdb::Status::kOk ? -1 : err);
     } else {
         err = _write_svc->batch_commit(_decree);
@@ -218,6 +267,9 @@ int pegasus_server_write::on_batched_writes(dsn::message_ex **requests, uint32_t
     // reply the batched RPCs
     _put_rpc_batch.clear();
     _remove_rpc_batch.clear();
+    _multi_put_rpc_batch.clear();
+    _multi_remove_rpc_batch.clear();
+    _incr_rpc_batch.clear();
     return err;
 }
 
@@ -273,22 +325,10 @@ void pegasus_server_write::init_make_idempotent_handlers()
 
 void pegasus_server_write::init_non_batch_write_handlers()
 {
+    // multi_put, multi_remove and incr are applied by on_batched_writes() even if they are
+    // not batched with other writes, since they may be batched once FLAGS_batch_multi_writes
+    // is enabled on the primary.
     _non_batch_write_handlers = {
-        {dsn::apps::RPC_RRDB_RRDB_MULTI_PUT,
-         [this](dsn::message_ex *request) -> int {
-             auto rpc = multi_put_rpc::auto_reply(request);
-             return _write_svc->multi_put(_write_ctx, rpc.request(), rpc.response());
-         }},
-        {dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE,
-         [this](dsn::message_ex *request) -> int {
-             auto rpc = multi_remove_rpc::auto_reply(request);
-             return _write_svc->multi_remove(_decree, rpc.request(), rpc.response());
-         }},
-        {dsn::apps::RPC_RRDB_RRDB_INCR,
-         [this](dsn::message_ex *request) -> int {
-             auto rpc = incr_rpc::auto_reply(request);
-             return _write_svc->incr(_decree, rpc.request(), rpc.response());
-         }},
         {dsn::apps::RPC_RRDB_RRDB_DUPLICATE,
          [this](dsn::message_ex *request) -> int {
              auto rpc = duplicate_rpc::auto_reply(request);
@@ -78,6 +78,12 @@ public:
 
     void set_default_ttl(uint32_t ttl);
 
+    void set_incr_merge_enabled(bool enabled);
+
+    // Allow multi_put, multi_remove and incr to be batched with other writes into a mutation
+    // if FLAGS_batch_multi_writes is enabled. Must be called before any replica is opened.
+    static void init_batchable_write_codes();
+
 private:
     // Used to call make_idempotent() for each type (specified by TRpcHolder) of atomic write.
     // Only called by primary replicas.
@@ -143,6 +149,21 @@ private:
         return err;
     }
 
+    int on_multi_put_in_batch(multi_put_rpc &rpc)
+    {
+        return _write_svc->batch_multi_put(_write_ctx, rpc.request(), rpc.response());
+    }
+
+    int on_multi_remove_in_batch(multi_remove_rpc &rpc)
+    {
+        return _write_svc->batch_multi_remove(_decree, rpc.request(), rpc.response());
+    }
+
+    int on_incr_in_batch(incr_rpc &rpc)
+    {
+        return _write_svc->batch_incr(_decree, rpc.request(), rpc.response());
+    }
+
     // Ensure that the write request is directed to the right partition.
     // In verbose mode it will log for every request.
     void request_key_check(int64_t decree, dsn::message_ex *m, const dsn::blob &key);
@@ -158,6 +179,9 @@ private:
     std::unique_ptr<pegasus_write_service> _write_svc;
     std::vector<put_rpc> _put_rpc_batch;
     std::vector<remove_rpc> _remove_rpc_batch;
+    std::vector<multi_put_rpc> _multi_put_rpc_batch;
+    std::vector<multi_remove_rpc> _multi_remove_rpc_batch;
+    std::vector<incr_rpc> _incr_rpc_batch;
 
     db_write_context _write_ctx;
     int64_t _decree{invalid_decree};
@@ -169,7 +193,7 @@ private:
             dsn::message_ex *, std::vector<dsn::message_ex *> &, idempotent_writer_ptr &)>>;
     make_idempotent_map _make_idempotent_handlers;
 
-    // Handlers that process a write request which could not be batched, e.g. multi put/remove.
+    // Handlers that process a write request which could not be batched, e.g. check_and_set.
     using non_batch_write_map = std::map<dsn::task_code, std::function<int(dsn::message_ex *)>>;
     non_batch_write_map _non_batch_write_handlers;
 
@@ -21,6 +21,7 @@
 
 #include "meta/meta_service_app.h"
 #include "replica/replication_service_app.h"
+#include "server/pegasus_server_write.h"
 #include <pegasus/version.h>
 #include <pegasus/git_commit.h>
 #include "utils/builtin_metrics.h"
@@ -43,6 +44,9 @@ public:
         args_new.emplace_back(PEGASUS_VERSION);
         args_new.emplace_back(PEGASUS_GIT_COMMIT);
 
+        // The write codes allowed to be batched must be decided before any replica is opened.
+        pegasus_server_write::init_batchable_write_codes();
+
         // Actually the root caller, start_app() in service_control_task::exec() will also do
         // CHECK for ERR_OK. Do CHECK here to guarantee that all following services (such as
         // built-in metrics) are started.
@@ -110,40 +110,40 @@ METRIC_DEFINE_percentile_int64(replica,
                                "single-put and single-remove requests. Only used for the "
                                "primary replicas");
 
-METRIC_DEFINE_percentile_int64(replica,
-                               put_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of PUT requests");
-
-METRIC_DEFINE_percentile_int64(replica,
-                               multi_put_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of MULTI_PUT requests");
-
-METRIC_DEFINE_percentile_int64(replica,
-                               remove_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of REMOVE requests");
-
-METRIC_DEFINE_percentile_int64(replica,
-                               multi_remove_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of MULTI_REMOVE requests");
-
-METRIC_DEFINE_percentile_int64(replica,
-                               incr_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of INCR requests");
-
-METRIC_DEFINE_percentile_int64(replica,
-                               check_and_set_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of CHECK_AND_SET requests");
-
-METRIC_DEFINE_percentile_int64(replica,
-                               check_and_mutate_latency_ns,
-                               dsn::metric_unit::kNanoSeconds,
-                               "The latency of CHECK_AND_MUTATE requests");
+METRIC_DEFINE_histogram_int64(replica,
+                              put_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of PUT requests");
+
+METRIC_DEFINE_histogram_int64(replica,
+                              multi_put_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of MULTI_PUT requests");
+
+METRIC_DEFINE_histogram_int64(replica,
+                              remove_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of REMOVE requests");
+
+METRIC_DEFINE_histogram_int64(replica,
+                              multi_remove_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of MULTI_REMOVE requests");
+
+METRIC_DEFINE_histogram_int64(replica,
+                              incr_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of INCR requests");
+
+METRIC_DEFINE_histogram_int64(replica,
+                              check_and_set_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of CHECK_AND_SET requests");
+
+METRIC_DEFINE_histogram_int64(replica,
+                              check_and_mutate_latency_ns,
+                              dsn::metric_unit::kNanoSeconds,
+                              "The latency of CHECK_AND_MUTATE requests");
 
 METRIC_DEFINE_counter(replica,
                       dup_requests,
@@ -209,38 +209,6 @@ pegasus_write_service::~pegasus_write_service() {}
 
 int pegasus_write_service::empty_put(int64_t decree) { return _impl->empty_put(decree); }
 
-int pegasus_write_service::multi_put(const db_write_context &ctx,
-                                     const dsn::apps::multi_put_request &update,
-                                     dsn::apps::update_response &resp)
-{
-    METRIC_VAR_AUTO_LATENCY(multi_put_latency_ns);
-    METRIC_VAR_INCREMENT(multi_put_requests);
-
-    int err = _impl->multi_put(ctx, update, resp);
-
-    if (_server->is_primary()) {
-        _cu_calculator->add_multi_put_cu(resp.error, update.hash_key, update.kvs);
-    }
-
-    return err;
-}
-
-int pegasus_write_service::multi_remove(int64_t decree,
-                                        const dsn::apps::multi_remove_request &update,
-                                        dsn::apps::multi_remove_response &resp)
-{
-    METRIC_VAR_AUTO_LATENCY(multi_remove_latency_ns);
-    METRIC_VAR_INCREMENT(multi_remove_requests);
-
-    int err = _impl->multi_remove(decree, update, resp);
-
-    if (_server->is_primary()) {
-        _cu_calculator->add_multi_remove_cu(resp.error, update.hash_key, update.sort_keys);
-    }
-
-    return err;
-}
-
 int pegasus_write_service::make_idempotent(const dsn::apps::incr_request &req,
                                            dsn::apps::incr_response &err_resp,
                                            std::vector<dsn::apps::update_request> &updates)
@@ -267,22 +235,6 @@ int pegasus_write_service::put(const db_write_context &ctx,
     return err;
 }
 
-int pegasus_write_service::incr(int64_t decree,
-                                const dsn::apps::incr_request &update,
-                                dsn::apps::incr_response &resp)
-{
-    METRIC_VAR_AUTO_LATENCY(incr_latency_ns);
-    METRIC_VAR_INCREMENT(incr_requests);
-
-    int err = _impl->incr(decree, update, resp);
-
-    if (_server->is_primary()) {
-        _cu_calculator->add_incr_cu(resp.error, update.key);
-    }
-
-    return err;
-}
-
 int pegasus_write_service::make_idempotent(const dsn::apps::check_and_set_request &req,
                                            dsn::apps::check_and_set_response &err_resp,
                                            std::vector<dsn::apps::update_request> &updates)
@@ -374,12 +326,15 @@ int pegasus_write_service::check_and_mutate(int64_t decree,
     return err;
 }
 
-void pegasus_write_service::batch_prepare(int64_t decree)
+void pegasus_write_service::batch_prepare(int64_t decree, bool read_your_writes)
 {
     CHECK_EQ_MSG(
         _batch_start_time, 0, "batch_prepare and batch_commit/batch_abort must be called in pair");
 
     _batch_start_time = dsn_now_ns();
+    if (read_your_writes) {
+        _impl->enable_batch_overlay();
+    }
 }
 
 int pegasus_write_service::batch_put(const db_write_context &ctx,
@@ -445,6 +400,57 @@ int pegasus_write_service::batch_remove(int64_t decree,
     return err;
 }
 
+int pegasus_write_service::batch_multi_put(const db_write_context &ctx,
+                                           const dsn::apps::multi_put_request &update,
+                                           dsn::apps::update_response &resp)
+{
+    CHECK_GT_MSG(_batch_start_time, 0, "batch_multi_put must be called after batch_prepare");
+
+    ++batch_size(batch_write_type::multi_put);
+
+    const int err = _impl->batch_multi_put(ctx, update, resp);
+
+    if (_server->is_primary()) {
+        _cu_calculator->add_multi_put_cu(resp.error, update.hash_key, update.kvs);
+    }
+
+    return err;
+}
+
+int pegasus_write_service::batch_multi_remove(int64_t decree,
+                                              const dsn::apps::multi_remove_request &update,
+                                              dsn::apps::multi_remove_response &resp)
+{
+    CHECK_GT_MSG(_batch_start_time, 0, "batch_multi_remove must be called after batch_prepare");
+
+    ++batch_size(batch_write_type::multi_remove);
+
+    const int err = _impl->batch_multi_remove(decree, update, resp);
+
+    if (_server->is_primary()) {
+        _cu_calculator->add_multi_remove_cu(resp.error, update.hash_key, update.sort_keys);
+    }
+
+    return err;
+}
+
+int pegasus_write_service::batch_incr(int64_t decree,
+                                      const dsn::apps::incr_request &update,
+                                      dsn::apps::incr_response &resp)
+{
+    CHECK_GT_MSG(_batch_start_time, 0, "batch_incr must be called after batch_prepare");
+
+    ++batch_size(batch_write_type::incr);
+
+    const int err = _impl->batch_incr(decree, update, resp);
+
+    if (_server->is_primary()) {
+        _cu_calculator->add_incr_cu(resp.error, update.key);
+    }
+
+    return err;
+}
+
 int pegasus_write_service::batch_commit(int64_t decree)
 {
     CHECK_GT_MSG(_batch_start_time, 0, "batch_commit must be called after batch_prepare");
@@ -465,6 +471,11 @@ void pegasus_write_service::batch_abort(int64_t decree, int err)
 
 void pegasus_write_service::set_default_ttl(uint32_t ttl) { _impl->set_default_ttl(ttl); }
 
+void pegasus_write_service::set_incr_merge_enabled(bool enabled)
+{
+    _impl->set_incr_merge_enabled(enabled);
+}
+
 void pegasus_write_service::batch_finish()
 {
 #define UPDATE_BATCH_METRICS(op, nrequests)                                                        \
@@ -483,11 +494,14 @@ void pegasus_write_service::batch_finish()
     // request within it, since the latency of each request could not be known.
     UPDATE_BATCH_METRICS_FOR_SINGLE_WRITE(put);
     UPDATE_BATCH_METRICS_FOR_SINGLE_WRITE(remove);
+    UPDATE_BATCH_METRICS_FOR_SINGLE_WRITE(multi_put);
+    UPDATE_BATCH_METRICS_FOR_SINGLE_WRITE(multi_remove);
 
     // These idempotent updates are translated from the atomic write requests. See comments
     // in batch_put() for the two possible situations where we are now.
     //
-    // A batch only contains one update translated from an incr or check_and_set request.
+    // A batch only contains one update translated from an incr or check_and_set request,
+    // while the non-idempotent incr requests may be batched by batch_incr().
     // However, a batch may contain multiple updates translated from a check_and_mutate.
     // Therefore, we need to measure the number of check_and_mutate requests:
     // - 1 if the number of idempotent updates is at least 1;
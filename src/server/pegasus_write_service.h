@@ -128,16 +128,6 @@ public:
     // to know why we must have empty write.
     int empty_put(int64_t decree);
 
-    // Write MULTI_PUT record.
-    int multi_put(const db_write_context &ctx,
-                  const dsn::apps::multi_put_request &update,
-                  dsn::apps::update_response &resp);
-
-    // Write MULTI_REMOVE record.
-    int multi_remove(int64_t decree,
-                     const dsn::apps::multi_remove_request &update,
-                     dsn::apps::multi_remove_response &resp);
-
     // Translate an INCR request into an idempotent PUT request. Only called by primary
     // replicas.
     int make_idempotent(const dsn::apps::incr_request &req,
@@ -151,9 +141,6 @@ public:
             const dsn::apps::incr_request &req,
             dsn::apps::incr_response &resp);
 
-    // Write a non-idempotent INCR record.
-    int incr(int64_t decree, const dsn::apps::incr_request &update, dsn::apps::incr_response &resp);
-
     // Translate a CHECK_AND_SET request into an idempotent PUT request. Only called by
     // primary replicas.
     int make_idempotent(const dsn::apps::check_and_set_request &req,
@@ -203,8 +190,9 @@ public:
 
     /// For batch write.
 
-    // Prepare batch write.
-    void batch_prepare(int64_t decree);
+    // Prepare batch write. If `read_your_writes` is true, the read-modify-writes (i.e. incr)
+    // in the batch could read the writes previously added into the same batch.
+    void batch_prepare(int64_t decree, bool read_your_writes = false);
 
     // Add PUT record in batch write.
     // \returns rocksdb::Status::Code.
@@ -220,6 +208,27 @@ public:
     // NOTE that `resp` should not be moved or freed while the batch is not committed.
     int batch_remove(int64_t decree, const dsn::blob &key, dsn::apps::update_response &resp);
 
+    // Add MULTI_PUT record in batch write.
+    // \returns rocksdb::Status::Code.
+    // NOTE that `resp` should not be moved or freed while the batch is not committed.
+    int batch_multi_put(const db_write_context &ctx,
+                        const dsn::apps::multi_put_request &update,
+                        dsn::apps::update_response &resp);
+
+    // Add MULTI_REMOVE record in batch write.
+    // \returns rocksdb::Status::Code.
+    // NOTE that `resp` should not be moved or freed while the batch is not committed.
+    int batch_multi_remove(int64_t decree,
+                           const dsn::apps::multi_remove_request &update,
+                           dsn::apps::multi_remove_response &resp);
+
+    // Add a non-idempotent INCR record in batch write.
+    // \returns rocksdb::Status::Code.
+    // NOTE that `resp` should not be moved or freed while the batch is not committed.
+    int batch_incr(int64_t decree,
+                   const dsn::apps::incr_request &update,
+                   dsn::apps::incr_response &resp);
+
     // Commit batch write.
     // \returns rocksdb::Status::Code.
     // NOTE that if the batch contains no updates, rocksdb::Status::kOk is returned.
@@ -230,6 +239,8 @@ public:
 
     void set_default_ttl(uint32_t ttl);
 
+    void set_incr_merge_enabled(bool enabled);
+
 private:
     // Finish batch write with metrics such as latencies calculated and some states cleared.
     void batch_finish();
@@ -240,6 +251,8 @@ private:
     {
         put = 0,
         remove,
+        multi_put,
+        multi_remove,
         incr,
         check_and_set,
         check_and_mutate,
@@ -273,17 +286,19 @@ private:
 
     // To calculate the metrics such as the number of requests and latency for the writes
     // allowed to be batched, measure the size of requests in batch applied into RocksDB
-    // for single put, single remove, incr, check_and_set and check_and_mutate, all of which
-    // are contained in batch_write_type. In fact, incr, check_and_set and check_and_mutate
-    // are not batched; the reason why they are contained in batch_write_type is because
-    // all of them are not actually incr, check_and_set, or check_and_mutate themselves, but
-    // rather single put operations that have been transformed from these operations to be
-    // idempotent. Therefore, they essentially all appear in the form of single puts with an
-    // extra field indicating what the original request is.
+    // for single put, single remove, multi put, multi remove, incr, check_and_set and
+    // check_and_mutate, all of which are contained in batch_write_type. In fact,
+    // check_and_set and check_and_mutate are not batched; the reason why they are contained
+    // in batch_write_type is because all of them are not actually check_and_set or
+    // check_and_mutate themselves, but rather single put operations that have been
+    // transformed from these operations to be idempotent. Therefore, they essentially all
+    // appear in the form of single puts with an extra field indicating what the original
+    // request is. So are the idempotent incr requests, while the non-idempotent ones are
+    // batched by batch_incr().
     //
     // Each request of single put, single remove, incr and check_and_set contains only one
-    // write operation, while check_and_mutate may contain multiple operations of single
-    // puts and removes.
+    // write operation, while multi put, multi remove and check_and_mutate may contain
+    // multiple operations of single puts and removes.
     std::array<uint32_t, static_cast<size_t>(batch_write_type::COUNT)> _batch_sizes{};
 
     METRIC_VAR_DECLARE_counter(put_requests);
@@ -298,13 +313,13 @@ private:
     METRIC_VAR_DECLARE_percentile_int64(make_check_and_set_idempotent_latency_ns);
     METRIC_VAR_DECLARE_percentile_int64(make_check_and_mutate_idempotent_latency_ns);
 
-    METRIC_VAR_DECLARE_percentile_int64(put_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(multi_put_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(remove_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(multi_remove_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(incr_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(check_and_set_latency_ns);
-    METRIC_VAR_DECLARE_percentile_int64(check_and_mutate_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(put_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(multi_put_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(remove_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(multi_remove_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(incr_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(check_and_set_latency_ns);
+    METRIC_VAR_DECLARE_histogram_int64(check_and_mutate_latency_ns);
 
     METRIC_VAR_DECLARE_counter(dup_requests);
     METRIC_VAR_DECLARE_percentile_int64(dup_time_lag_ms);
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <gtest/gtest_prod.h>
+#include <atomic>
 
 #include "base/idl_utils.h"
 #include "base/meta_store.h"
@@ -261,88 +262,6 @@ public:
         return rocksdb::Status::kOk;
     }
 
-    int incr(int64_t decree, const dsn::apps::incr_request &update, dsn::apps::incr_response &resp)
-    {
-        resp.app_id = get_gpid().get_app_id();
-        resp.partition_index = get_gpid().get_partition_index();
-        resp.decree = decree;
-        resp.server = _primary_host_port;
-
-        std::string_view raw_key = update.key.to_string_view();
-        int64_t new_value = 0;
-        uint32_t new_expire_ts = 0;
-        db_get_context get_ctx;
-        int err = _rocksdb_wrapper->get(raw_key, &get_ctx);
-        if (err != rocksdb::Status::kOk) {
-            resp.error = err;
-            return err;
-        }
-        if (!get_ctx.found) {
-            // old value is not found, set to 0 before increment
-            new_value = update.increment;
-            new_expire_ts = update.expire_ts_seconds > 0 ? update.expire_ts_seconds : 0;
-        } else if (get_ctx.expired) {
-            // ttl timeout, set to 0 before increment
-            new_value = update.increment;
-            new_expire_ts = update.expire_ts_seconds > 0 ? update.expire_ts_seconds : 0;
-        } else {
-            ::dsn::blob old_value;
-            pegasus_extract_user_data(
-                _pegasus_data_version, std::move(get_ctx.raw_value), old_value);
-            if (old_value.length() == 0) {
-                // empty old value, set to 0 before increment
-                new_value = update.increment;
-            } else {
-                int64_t old_value_int;
-                if (!dsn::buf2int64(old_value.to_string_view(), old_value_int)) {
-                    // invalid old value
-                    LOG_ERROR_PREFIX("incr failed: decree = {}, error = "
-                                     "old value \"{}\" is not an integer or out of range",
-                                     decree,
-                                     utils::c_escape_sensitive_string(old_value));
-                    resp.error = rocksdb::Status::kInvalidArgument;
-                    // we should write empty record to update rocksdb's last flushed decree
-                    return empty_put(decree);
-                }
-
-                if (dsn_unlikely(!dsn::safe_add(old_value_int, update.increment, new_value))) {
-                    // new value is out of range, return old value by 'new_value'
-                    LOG_ERROR_PREFIX("incr failed: decree = {}, error = "
-                                     "new value is out of range, old_value = {}, increment = {}",
-                                     decree,
-                                     old_value_int,
-                                     update.increment);
-                    resp.error = rocksdb::Status::kInvalidArgument;
-                    resp.new_value = old_value_int;
-                    // we should write empty record to update rocksdb's last flushed decree
-                    return empty_put(decree);
-                }
-            }
-            // set new ttl
-            if (update.expire_ts_seconds == 0) {
-                new_expire_ts = get_ctx.expire_ts;
-            } else if (update.expire_ts_seconds < 0) {
-                new_expire_ts = 0;
-            } else { // update.expire_ts_seconds > 0
-                new_expire_ts = update.expire_ts_seconds;
-            }
-        }
-
-        auto cleanup = dsn::defer([this]() { _rocksdb_wrapper->clear_up_write_batch(); });
-        resp.error = _rocksdb_wrapper->write_batch_put(
-            decree, update.key.to_string_view(), std::to_string(new_value), new_expire_ts);
-        if (resp.error != rocksdb::Status::kOk) {
-            return resp.error;
-        }
-
-        resp.error = _rocksdb_wrapper->write(decree);
-        if (resp.error == rocksdb::Status::kOk) {
-            resp.new_value = new_value;
-        }
-
-        return resp.error;
-    }
-
     // Tranlate a check_and_set request into a single-put request which is certainly idempotent.
     // Return current status for RocksDB. Only called by primary replicas.
     int make_idempotent(const dsn::apps::check_and_set_request &req,
@@ -887,6 +806,100 @@ public:
         return resp.error;
     }
 
+    // Add the puts of a multi_put request into the batch. An invalid request is responded
+    // with rocksdb::Status::kInvalidArgument immediately, and an empty record is put instead
+    // to keep the batch non-empty.
+    int batch_multi_put(const db_write_context &ctx,
+                        const dsn::apps::multi_put_request &update,
+                        dsn::apps::update_response &resp)
+    {
+        if (update.kvs.empty()) {
+            LOG_ERROR_PREFIX("invalid argument for multi_put: decree = {}, error = {}",
+                             ctx.decree,
+                             "request.kvs is empty");
+            make_basic_response(ctx.decree, resp);
+            resp.error = rocksdb::Status::kInvalidArgument;
+            return _rocksdb_wrapper->write_batch_put(
+                ctx.decree, std::string_view(), std::string_view(), 0);
+        }
+
+        for (const auto &kv : update.kvs) {
+            resp.error =
+                _rocksdb_wrapper->write_batch_put_ctx(ctx,
+                                                      composite_raw_key(update.hash_key, kv.key),
+                                                      kv.value,
+                                                      update.expire_ts_seconds);
+            if (dsn_unlikely(resp.error != rocksdb::Status::kOk)) {
+                break;
+            }
+        }
+        _update_responses.emplace_back(&resp);
+        return resp.error;
+    }
+
+    // Add the removes of a multi_remove request into the batch. See batch_multi_put() for the
+    // invalid request.
+    int batch_multi_remove(int64_t decree,
+                           const dsn::apps::multi_remove_request &update,
+                           dsn::apps::multi_remove_response &resp)
+    {
+        if (update.sort_keys.empty()) {
+            LOG_ERROR_PREFIX("invalid argument for multi_remove: decree = {}, error = {}",
+                             decree,
+                             "request.sort_keys is empty");
+            make_basic_response(decree, resp);
+            resp.error = rocksdb::Status::kInvalidArgument;
+            return _rocksdb_wrapper->write_batch_put(
+                decree, std::string_view(), std::string_view(), 0);
+        }
+
+        for (const auto &sort_key : update.sort_keys) {
+            resp.error = _rocksdb_wrapper->write_batch_delete(
+                decree, composite_raw_key(update.hash_key, sort_key).to_string_view());
+            if (dsn_unlikely(resp.error != rocksdb::Status::kOk)) {
+                break;
+            }
+        }
+        _multi_remove_responses.emplace_back(&resp, static_cast<int64_t>(update.sort_keys.size()));
+        return resp.error;
+    }
+
+    // Add the put of a non-idempotent incr request into the batch. The base value is read
+    // through the batch overlay if enabled, thus the writes on the same key previously added
+    // into the batch are taken into account. See batch_multi_put() for the invalid request.
+    int batch_incr(int64_t decree,
+                   const dsn::apps::incr_request &update,
+                   dsn::apps::incr_response &resp)
+    {
+        if (incr_by_merge(update)) {
+            resp.error = _rocksdb_wrapper->write_batch_incr_merge(decree,
+                                                                  update.key.to_string_view(),
+                                                                  update.increment,
+                                                                  update.expire_ts_seconds);
+            _incr_responses.emplace_back(&resp, 0);
+            return resp.error;
+        }
+
+        int64_t new_value = 0;
+        uint32_t new_expire_ts = 0;
+        int err = calc_incr(decree, update, resp, new_value, new_expire_ts);
+        if (err == rocksdb::Status::kOk && resp.error != rocksdb::Status::kOk) {
+            make_basic_response(decree, resp);
+            return _rocksdb_wrapper->write_batch_put(
+                decree, std::string_view(), std::string_view(), 0);
+        }
+
+        if (err == rocksdb::Status::kOk) {
+            err = _rocksdb_wrapper->write_batch_put(
+                decree, update.key.to_string_view(), std::to_string(new_value), new_expire_ts);
+        }
+        resp.error = err;
+        _incr_responses.emplace_back(&resp, new_value);
+        return err;
+    }
+
+    void enable_batch_overlay() { _rocksdb_wrapper->enable_batch_overlay(); }
+
     int batch_commit(int64_t decree)
     {
         int err = _rocksdb_wrapper->write(decree);
@@ -898,7 +911,19 @@ public:
 
     void set_default_ttl(uint32_t ttl) { _rocksdb_wrapper->set_default_ttl(ttl); }
 
+    void set_incr_merge_enabled(bool enabled)
+    {
+        _incr_merge_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
 private:
+    // An incr could be written as a merge operand only if the client does not need the new
+    // value, which is unknown until the operand is resolved.
+    bool incr_by_merge(const dsn::apps::incr_request &update) const
+    {
+        return !update.return_new_value && _incr_merge_enabled.load(std::memory_order_relaxed);
+    }
+
     void clear_up_batch_states(int64_t decree, int err)
     {
         if (!_update_responses.empty()) {
@@ -914,9 +939,95 @@ private:
             _update_responses.clear();
         }
 
+        for (auto &[mresp, count] : _multi_remove_responses) {
+            make_basic_response(decree, *mresp);
+            mresp->error = err;
+            mresp->count = err == rocksdb::Status::kOk ? count : 0;
+        }
+        _multi_remove_responses.clear();
+
+        for (auto &[iresp, new_value] : _incr_responses) {
+            make_basic_response(decree, *iresp);
+            iresp->error = err;
+            if (err == rocksdb::Status::kOk) {
+                iresp->new_value = new_value;
+            }
+        }
+        _incr_responses.clear();
+
         _rocksdb_wrapper->clear_up_write_batch();
     }
 
+    // Calculate the new value and expire timestamp for an incr request based on the current
+    // value of the key. Return the status of reading the current value from RocksDB. Once
+    // the current value could not be incremented, rocksdb::Status::kOk is still returned
+    // with `resp.error` set to rocksdb::Status::kInvalidArgument, and nothing should be
+    // written for the request.
+    int calc_incr(int64_t decree,
+                  const dsn::apps::incr_request &update,
+                  dsn::apps::incr_response &resp,
+                  int64_t &new_value,
+                  uint32_t &new_expire_ts)
+    {
+        resp.error = rocksdb::Status::kOk;
+
+        db_get_context get_ctx;
+        int err = _rocksdb_wrapper->get(update.key.to_string_view(), &get_ctx);
+        if (err != rocksdb::Status::kOk) {
+            return err;
+        }
+        if (!get_ctx.found) {
+            // old value is not found, set to 0 before increment
+            new_value = update.increment;
+            new_expire_ts = update.expire_ts_seconds > 0 ? update.expire_ts_seconds : 0;
+        } else if (get_ctx.expired) {
+            // ttl timeout, set to 0 before increment
+            new_value = update.increment;
+            new_expire_ts = update.expire_ts_seconds > 0 ? update.expire_ts_seconds : 0;
+        } else {
+            ::dsn::blob old_value;
+            pegasus_extract_user_data(
+                _pegasus_data_version, std::move(get_ctx.raw_value), old_value);
+            if (old_value.length() == 0) {
+                // empty old value, set to 0 before increment
+                new_value = update.increment;
+            } else {
+                int64_t old_value_int;
+                if (!dsn::buf2int64(old_value.to_string_view(), old_value_int)) {
+                    // invalid old value
+                    LOG_ERROR_PREFIX("incr failed: decree = {}, error = "
+                                     "old value \"{}\" is not an integer or out of range",
+                                     decree,
+                                     utils::c_escape_sensitive_string(old_value));
+                    resp.error = rocksdb::Status::kInvalidArgument;
+                    return rocksdb::Status::kOk;
+                }
+
+                if (dsn_unlikely(!dsn::safe_add(old_value_int, update.increment, new_value))) {
+                    // new value is out of range, return old value by 'new_value'
+                    LOG_ERROR_PREFIX("incr failed: decree = {}, error = "
+                                     "new value is out of range, old_value = {}, increment = {}",
+                                     decree,
+                                     old_value_int,
+                                     update.increment);
+                    resp.error = rocksdb::Status::kInvalidArgument;
+                    resp.new_value = old_value_int;
+                    return rocksdb::Status::kOk;
+                }
+            }
+            // set new ttl
+            if (update.expire_ts_seconds == 0) {
+                new_expire_ts = get_ctx.expire_ts;
+            } else if (update.expire_ts_seconds < 0) {
+                new_expire_ts = 0;
+            } else { // update.expire_ts_seconds > 0
+                new_expire_ts = update.expire_ts_seconds;
+            }
+        }
+
+        return rocksdb::Status::kOk;
+    }
+
     // Convenient encapsulation of pegasus_generate_key().
     //
     // TKey may be std::string_view, std::string or dsn::blob.
@@ -1292,6 +1403,14 @@ private:
 
     // for setting update_response.error after committed.
     std::vector<dsn::apps::update_response *> _update_responses;
+    // for setting multi_remove_response after committed, with the number of removed keys.
+    std::vector<std::pair<dsn::apps::multi_remove_response *, int64_t>> _multi_remove_responses;
+    // for setting incr_response after committed, with the new value.
+    std::vector<std::pair<dsn::apps::incr_response *, int64_t>> _incr_responses;
+
+    // Whether the incr requests not asking for the new value are written as merge operands,
+    // see pegasus_incr_merge_operator.
+    std::atomic_bool _incr_merge_enabled{false};
 };
 
 } // namespace pegasus::server
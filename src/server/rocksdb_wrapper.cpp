@@ -30,7 +30,9 @@
 #include "pegasus_key_schema.h"
 #include "pegasus_utils.h"
 #include "pegasus_write_service_impl.h"
+#include "server/hotkey_read_cache.h"
 #include "server/logging_utils.h"
+#include "server/pegasus_incr_merge_operator.h"
 #include "server/pegasus_server_impl.h"
 #include "server/pegasus_write_service.h"
 #include "utils/autoref_ptr.h"
@@ -63,6 +65,7 @@ rocksdb_wrapper::rocksdb_wrapper(pegasus_server_impl *server)
       _rd_opts(server->_data_cf_rd_opts),
       _data_cf(server->_data_cf),
       _meta_cf(server->_meta_cf),
+      _read_cache(server->_read_cache.get()),
       _pegasus_data_version(server->_pegasus_data_version),
       METRIC_VAR_INIT_replica(read_expired_values),
       _default_ttl(0)
@@ -79,18 +82,27 @@ int rocksdb_wrapper::get(std::string_view raw_key, /*out*/ db_get_context *ctx)
 {
     FAIL_POINT_INJECT_F("db_get", [](std::string_view) -> int { return FAIL_DB_GET; });
 
+    if (!_batch_overlay.empty()) {
+        const auto iter = _batch_overlay.find(std::string(raw_key));
+        if (iter != _batch_overlay.end()) {
+            if (!iter->second) {
+                // The key has been removed in the uncommitted batch.
+                ctx->found = false;
+                ctx->expired = false;
+                return rocksdb::Status::kOk;
+            }
+
+            ctx->raw_value = *iter->second;
+            fill_get_context(ctx);
+            return rocksdb::Status::kOk;
+        }
+    }
+
     const rocksdb::Status s =
         _db->Get(_rd_opts, _data_cf, utils::to_rocksdb_slice(raw_key), &ctx->raw_value);
     if (dsn_likely(s.ok())) {
         // The key is found and its value is read successfully.
-        ctx->found = true;
-        ctx->expire_ts = pegasus_extract_expire_ts(_pegasus_data_version, ctx->raw_value);
-        if (check_if_ts_expired(utils::epoch_now(), ctx->expire_ts)) {
-            ctx->expired = true;
-            METRIC_VAR_INCREMENT(read_expired_values);
-        } else {
-            ctx->expired = false;
-        }
+        fill_get_context(ctx);
         return rocksdb::Status::kOk;
     }
 
@@ -112,6 +124,18 @@ int rocksdb_wrapper::get(std::string_view raw_key, /*out*/ db_get_context *ctx)
     return s.code();
 }
 
+void rocksdb_wrapper::fill_get_context(db_get_context *ctx)
+{
+    ctx->found = true;
+    ctx->expire_ts = pegasus_extract_expire_ts(_pegasus_data_version, ctx->raw_value);
+    if (check_if_ts_expired(utils::epoch_now(), ctx->expire_ts)) {
+        ctx->expired = true;
+        METRIC_VAR_INCREMENT(read_expired_values);
+    } else {
+        ctx->expired = false;
+    }
+}
+
 int rocksdb_wrapper::get(const dsn::blob &raw_key,
                          /*out*/ db_get_context *ctx)
 {
@@ -167,6 +191,16 @@ int rocksdb_wrapper::write_batch_put_ctx(const db_write_context &ctx,
     rocksdb::SliceParts svalue = _value_generator->generate_value(
         _pegasus_data_version, value, db_expire_ts(expire_sec), new_timetag);
     rocksdb::Status s = _write_batch->Put(_data_cf, skey_parts, svalue);
+    if (_read_cache != nullptr && !raw_key.empty()) {
+        _written_keys.emplace_back(raw_key);
+    }
+    if (_batch_overlay_enabled && !raw_key.empty()) {
+        std::string raw_value;
+        for (int i = 0; i < svalue.num_parts; ++i) {
+            raw_value.append(svalue.parts[i].data(), svalue.parts[i].size());
+        }
+        _batch_overlay[std::string(raw_key)] = std::move(raw_value);
+    }
     if (dsn_unlikely(!s.ok())) {
         dsn::blob hash_key;
         dsn::blob sort_key;
@@ -191,6 +225,59 @@ int rocksdb_wrapper::write_batch_put_ctx(const db_write_context &ctx,
         ctx, raw_key.to_string_view(), value.to_string_view(), static_cast<uint32_t>(expire_sec));
 }
 
+int rocksdb_wrapper::write_batch_incr_merge(int64_t decree,
+                                            std::string_view raw_key,
+                                            int64_t increment,
+                                            int32_t expire_ts_seconds)
+{
+    FAIL_POINT_INJECT_F("db_write_batch_put",
+                        [](std::string_view) -> int { return FAIL_DB_WRITE_BATCH_PUT; });
+
+    const std::string operand = encode_incr_merge_operand(
+        _pegasus_data_version,
+        increment,
+        expire_ts_seconds,
+        utils::epoch_now(),
+        db_expire_ts(0),
+        generate_timetag(0, dsn::replication::get_current_dup_cluster_id_or_default(), false));
+    rocksdb::Status s = _write_batch->Merge(_data_cf, utils::to_rocksdb_slice(raw_key), operand);
+    if (_read_cache != nullptr) {
+        _written_keys.emplace_back(raw_key);
+    }
+    if (s.ok() && _batch_overlay_enabled) {
+        // Resolve the operand against the value visible to the batch, so that the later
+        // read-modify-writes in the same batch see the incremented value.
+        db_get_context get_ctx;
+        int err = get(raw_key, &get_ctx);
+        if (dsn_unlikely(err != rocksdb::Status::kOk)) {
+            return err;
+        }
+
+        const rocksdb::Slice existing_value(get_ctx.raw_value);
+        std::string new_value;
+        if (merge_incr_operands(get_ctx.found ? &existing_value : nullptr,
+                                {rocksdb::Slice(operand)},
+                                new_value)) {
+            _batch_overlay[std::string(raw_key)] = std::move(new_value);
+        } else {
+            s = rocksdb::Status::Corruption("invalid base value for incr merge");
+        }
+    }
+    if (dsn_unlikely(!s.ok())) {
+        dsn::blob hash_key;
+        dsn::blob sort_key;
+        pegasus_restore_key(dsn::blob(raw_key.data(), 0, raw_key.size()), hash_key, sort_key);
+        LOG_ERROR_ROCKSDB("WriteBatchMerge",
+                          s.ToString(),
+                          "decree: {}, hash_key: {}, sort_key: {}, increment: {}",
+                          decree,
+                          utils::c_escape_sensitive_string(hash_key),
+                          utils::c_escape_sensitive_string(sort_key),
+                          increment);
+    }
+    return s.code();
+}
+
 int rocksdb_wrapper::write(int64_t decree)
 {
     CHECK_GT(_write_batch->Count(), 0);
@@ -215,6 +302,14 @@ int rocksdb_wrapper::write(int64_t decree)
     if (dsn_unlikely(!status.ok())) {
         LOG_ERROR_ROCKSDB("Write", status.ToString(), "write rocksdb error, decree: {}", decree);
     }
+
+    // The written keys are invalidated only after they have been applied, to reject the
+    // concurrent fills of the old values, see hotkey_read_cache.
+    for (const auto &key : _written_keys) {
+        _read_cache->invalidate(key);
+    }
+    _written_keys.clear();
+
     return status.code();
 }
 
@@ -224,6 +319,12 @@ int rocksdb_wrapper::write_batch_delete(int64_t decree, std::string_view raw_key
                         [](std::string_view) -> int { return FAIL_DB_WRITE_BATCH_DELETE; });
 
     rocksdb::Status s = _write_batch->Delete(_data_cf, utils::to_rocksdb_slice(raw_key));
+    if (_read_cache != nullptr) {
+        _written_keys.emplace_back(raw_key);
+    }
+    if (_batch_overlay_enabled) {
+        _batch_overlay[std::string(raw_key)] = std::nullopt;
+    }
     if (dsn_unlikely(!s.ok())) {
         dsn::blob hash_key;
         dsn::blob sort_key;
@@ -243,7 +344,13 @@ int rocksdb_wrapper::write_batch_delete(int64_t decree, const dsn::blob &raw_key
     return write_batch_delete(decree, raw_key.to_string_view());
 }
 
-void rocksdb_wrapper::clear_up_write_batch() { _write_batch->Clear(); }
+void rocksdb_wrapper::clear_up_write_batch()
+{
+    _write_batch->Clear();
+    _written_keys.clear();
+    _batch_overlay_enabled = false;
+    _batch_overlay.clear();
+}
 
 int rocksdb_wrapper::ingest_files(int64_t decree,
                                   const std::vector<std::string> &sst_file_list,
@@ -265,6 +372,9 @@ int rocksdb_wrapper::ingest_files(int64_t decree,
                          "Ingest files succeed, decree = {}, ingest_behind = {}",
                          decree,
                          ingest_behind);
+        if (_read_cache != nullptr) {
+            _read_cache->clear();
+        }
     }
     return s.code();
 }
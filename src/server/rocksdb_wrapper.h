@@ -24,8 +24,10 @@
 #include <rocksdb/write_batch.h>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "pegasus_value_schema.h"
@@ -44,6 +46,7 @@ class DB;
 namespace pegasus {
 
 namespace server {
+class hotkey_read_cache;
 class pegasus_server_impl;
 struct db_get_context;
 struct db_write_context;
@@ -74,9 +77,20 @@ public:
                             const dsn::blob &raw_key,
                             const dsn::blob &value,
                             int32_t expire_sec);
+    // Add an incr into the batch as a merge operand, which is resolved by
+    // pegasus_incr_merge_operator on read and during compaction, thus the current value
+    // need not be read. See pegasus_incr_merge_operator.h for the semantics.
+    int write_batch_incr_merge(int64_t decree,
+                               std::string_view raw_key,
+                               int64_t increment,
+                               int32_t expire_ts_seconds);
     int write(int64_t decree);
     int write_batch_delete(int64_t decree, std::string_view raw_key);
     int write_batch_delete(int64_t decree, const dsn::blob &raw_key);
+    // Make the writes added into the batch since now visible to get(), which is needed once
+    // a read-modify-write (e.g. incr) is batched after other writes on the same key. It's
+    // disabled again by clear_up_write_batch().
+    void enable_batch_overlay() { _batch_overlay_enabled = true; }
     void clear_up_write_batch();
     int ingest_files(int64_t decree,
                      const std::vector<std::string> &sst_file_list,
@@ -87,6 +101,9 @@ public:
 private:
     uint32_t db_expire_ts(uint32_t expire_ts);
 
+    // Fill `ctx` with the raw value which has been found.
+    void fill_get_context(db_get_context *ctx);
+
     rocksdb::DB *_db;
     rocksdb::ReadOptions &_rd_opts;
     std::unique_ptr<pegasus_value_generator> _value_generator;
@@ -95,6 +112,16 @@ private:
     rocksdb::ColumnFamilyHandle *_data_cf;
     rocksdb::ColumnFamilyHandle *_meta_cf;
 
+    // Null if the hotkey read cache is disabled. Otherwise the keys put into the write batch
+    // are recorded in `_written_keys`, to be invalidated once the batch is written.
+    hotkey_read_cache *_read_cache;
+    std::vector<std::string> _written_keys;
+
+    // The raw values put into the uncommitted batch while `_batch_overlay_enabled`, indexed
+    // by the raw keys. A removed key is mapped to std::nullopt.
+    bool _batch_overlay_enabled{false};
+    std::unordered_map<std::string, std::optional<std::string>> _batch_overlay;
+
     const uint32_t _pegasus_data_version;
     METRIC_VAR_DECLARE_counter(read_expired_values);
     volatile uint32_t _default_ttl;
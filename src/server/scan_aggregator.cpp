@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "scan_aggregator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "utils/blob.h"
+#include "utils/fmt_logging.h"
+#include "utils/string_conv.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+// The max number of the records with the largest values kept for a batch, to bound the size
+// of the response.
+constexpr int32_t kMaxTopK = 1000;
+
+// The max number of the buckets of the value size histogram.
+constexpr size_t kMaxValueSizeBuckets = 1000;
+
+// Used to build a min-heap, whose top is the smallest one of the top-k entries.
+bool larger_value_size(const ::dsn::apps::scan_value_size_entry &lhs,
+                       const ::dsn::apps::scan_value_size_entry &rhs)
+{
+    return lhs.value_size > rhs.value_size;
+}
+
+} // anonymous namespace
+
+scan_aggregator::scan_aggregator(const ::dsn::apps::scan_aggregation_request &request)
+    : _request(request)
+{
+    reset();
+}
+
+/*static*/ bool scan_aggregator::validate(const ::dsn::apps::scan_aggregation_request &request,
+                                          std::string &reason)
+{
+    if (request.top_k_by_value_size < 0 || request.top_k_by_value_size > kMaxTopK) {
+        reason = fmt::format(
+            "top_k_by_value_size({}) should be in [0, {}]", request.top_k_by_value_size, kMaxTopK);
+        return false;
+    }
+
+    const auto &buckets = request.value_size_buckets;
+    if (buckets.size() > kMaxValueSizeBuckets) {
+        reason = fmt::format("the number of value_size_buckets({}) should be no more than {}",
+                             buckets.size(),
+                             kMaxValueSizeBuckets);
+        return false;
+    }
+
+    for (size_t i = 1; i < buckets.size(); ++i) {
+        if (buckets[i - 1] >= buckets[i]) {
+            reason = "value_size_buckets should be in strictly ascending order";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void scan_aggregator::add(std::string_view raw_key, std::string_view user_data)
+{
+    const auto value_size = static_cast<int64_t>(user_data.size());
+    ++_result.count;
+    _result.total_key_size += raw_key.size();
+    _result.total_value_size += value_size;
+
+    if (_request.numeric_value_stats) {
+        int64_t value = 0;
+        if (dsn::buf2int64(user_data, value)) {
+            if (_result.numeric_count == 0) {
+                _result.min = value;
+                _result.max = value;
+            } else {
+                _result.min = std::min(_result.min, value);
+                _result.max = std::max(_result.max, value);
+            }
+            ++_result.numeric_count;
+            if (!_result.sum_overflow &&
+                __builtin_add_overflow(_result.sum, value, &_result.sum)) {
+                _result.sum_overflow = true;
+            }
+        } else {
+            ++_result.non_numeric_count;
+        }
+    }
+
+    const auto &buckets = _request.value_size_buckets;
+    if (!buckets.empty()) {
+        const auto index = std::upper_bound(buckets.begin(), buckets.end(), value_size) -
+                           buckets.begin();
+        ++_result.value_size_histogram[index];
+    }
+
+    if (_request.top_k_by_value_size > 0) {
+        auto &top_k = _result.top_k;
+        if (top_k.size() < static_cast<size_t>(_request.top_k_by_value_size)) {
+            ::dsn::apps::scan_value_size_entry entry;
+            entry.key = dsn::blob::create_from_bytes(raw_key.data(), raw_key.size());
+            entry.value_size = value_size;
+            top_k.emplace_back(std::move(entry));
+            std::push_heap(top_k.begin(), top_k.end(), larger_value_size);
+        } else if (value_size > top_k.front().value_size) {
+            // Replace the smallest one, the key is copied only if it's one of the top-k.
+            std::pop_heap(top_k.begin(), top_k.end(), larger_value_size);
+            top_k.back().key = dsn::blob::create_from_bytes(raw_key.data(), raw_key.size());
+            top_k.back().value_size = value_size;
+            std::push_heap(top_k.begin(), top_k.end(), larger_value_size);
+        }
+    }
+}
+
+::dsn::apps::scan_aggregation_result scan_aggregator::take_result()
+{
+    // Sorted by value size in descending order.
+    std::sort_heap(_result.top_k.begin(), _result.top_k.end(), larger_value_size);
+
+    ::dsn::apps::scan_aggregation_result result(std::move(_result));
+    reset();
+    return result;
+}
+
+void scan_aggregator::reset()
+{
+    _result = ::dsn::apps::scan_aggregation_result();
+    if (!_request.value_size_buckets.empty()) {
+        _result.value_size_histogram.assign(_request.value_size_buckets.size() + 1, 0);
+    }
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,57 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <rrdb/rrdb_types.h>
+#include <string_view>
+#include <vector>
+
+#include "utils/ports.h"
+
+namespace pegasus {
+namespace server {
+
+// Aggregates the records of a scan on the server side, so that only the aggregated result of
+// each batch is sent back to the client instead of all the keys and values.
+class scan_aggregator
+{
+public:
+    explicit scan_aggregator(const ::dsn::apps::scan_aggregation_request &request);
+
+    // Check if the request is valid, `reason` is set if not.
+    static bool validate(const ::dsn::apps::scan_aggregation_request &request,
+                         std::string &reason);
+
+    // Add a record which has passed the filters, `raw_key` is the key stored in rocksdb and
+    // `user_data` is the value extracted from the rocksdb value.
+    void add(std::string_view raw_key, std::string_view user_data);
+
+    // Move out the result aggregated since the last call, then start a new batch.
+    ::dsn::apps::scan_aggregation_result take_result();
+
+private:
+    void reset();
+
+    const ::dsn::apps::scan_aggregation_request _request;
+    ::dsn::apps::scan_aggregation_result _result;
+
+    DISALLOW_COPY_AND_ASSIGN(scan_aggregator);
+};
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,180 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "scan_geo_filter.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
+
+#include "utils/string_conv.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+// The max number of the nearest records kept by a scan, to bound the memory of the context
+// and the size of the last response.
+constexpr int32_t kMaxTopKNearest = 10000;
+
+// The same as S2Earth::RadiusMeters() used by the geo client.
+constexpr double kEarthRadiusMeters = 6371010.0;
+
+// The points are decoded from the text values, whose distances are a little different from the
+// ones calculated by the client. Be a little looser here since the client checks them again.
+constexpr double kRadiusTolerance = 1e-9;
+
+// Extract the fields at the indices (in ascending order) of the value split by '|'.
+bool extract_fields(std::string_view value,
+                    int32_t first_index,
+                    int32_t second_index,
+                    std::string_view &first,
+                    std::string_view &second)
+{
+    size_t begin = 0;
+    for (int32_t index = 0; index <= second_index; ++index) {
+        if (begin > value.size()) {
+            return false;
+        }
+        auto end = value.find('|', begin);
+        if (end == std::string_view::npos) {
+            end = value.size();
+        }
+        if (index == first_index) {
+            first = value.substr(begin, end - begin);
+        } else if (index == second_index) {
+            second = value.substr(begin, end - begin);
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+scan_geo_filter::scan_geo_filter(const ::dsn::apps::scan_geo_filter &request)
+    : _request(request),
+      _first_index(std::min(request.latitude_index, request.longitude_index)),
+      _second_index(std::max(request.latitude_index, request.longitude_index)),
+      _latlng_order(request.latitude_index < request.longitude_index)
+{
+}
+
+/*static*/ bool scan_geo_filter::validate(const ::dsn::apps::scan_geo_filter &request,
+                                          std::string &reason)
+{
+    if (!(std::abs(request.lat_degrees) <= 90) || !(std::abs(request.lng_degrees) <= 180)) {
+        reason = fmt::format("invalid center ({}, {})", request.lat_degrees, request.lng_degrees);
+        return false;
+    }
+
+    if (!(request.radius_m >= 0) || !std::isfinite(request.radius_m)) {
+        reason = fmt::format("radius_m({}) should be a non-negative number", request.radius_m);
+        return false;
+    }
+
+    if (request.latitude_index < 0 || request.longitude_index < 0 ||
+        request.latitude_index == request.longitude_index) {
+        reason = fmt::format("latitude_index({}) and longitude_index({}) should be different "
+                             "non-negative numbers",
+                             request.latitude_index,
+                             request.longitude_index);
+        return false;
+    }
+
+    if (request.top_k_nearest < 0 || request.top_k_nearest > kMaxTopKNearest) {
+        reason = fmt::format("top_k_nearest({}) should be in [0, {}]",
+                             request.top_k_nearest,
+                             kMaxTopKNearest);
+        return false;
+    }
+
+    return true;
+}
+
+bool scan_geo_filter::match(std::string_view user_data, double &distance_m) const
+{
+    std::string_view first;
+    std::string_view second;
+    if (!extract_fields(user_data, _first_index, _second_index, first, second)) {
+        return false;
+    }
+
+    double lat_degrees = 0;
+    double lng_degrees = 0;
+    if (!dsn::buf2double(_latlng_order ? first : second, lat_degrees) ||
+        !dsn::buf2double(_latlng_order ? second : first, lng_degrees) ||
+        !(std::abs(lat_degrees) <= 90) || !(std::abs(lng_degrees) <= 180)) {
+        return false;
+    }
+
+    distance_m =
+        distance_meters(_request.lat_degrees, _request.lng_degrees, lat_degrees, lng_degrees);
+    return distance_m <= _request.radius_m * (1 + kRadiusTolerance);
+}
+
+void scan_geo_filter::add_nearest(std::string_view raw_key,
+                                  std::string_view raw_value,
+                                  double distance_m)
+{
+    if (_nearest.size() >= static_cast<size_t>(_request.top_k_nearest)) {
+        if (distance_m >= _nearest.front().distance_m) {
+            return;
+        }
+        std::pop_heap(_nearest.begin(), _nearest.end(), nearer);
+        _nearest.pop_back();
+    }
+
+    _nearest.push_back({distance_m, std::string(raw_key), std::string(raw_value)});
+    std::push_heap(_nearest.begin(), _nearest.end(), nearer);
+}
+
+std::vector<std::pair<std::string, std::string>> scan_geo_filter::take_nearest()
+{
+    std::sort_heap(_nearest.begin(), _nearest.end(), nearer);
+
+    std::vector<std::pair<std::string, std::string>> records;
+    records.reserve(_nearest.size());
+    for (auto &record : _nearest) {
+        records.emplace_back(std::move(record.raw_key), std::move(record.raw_value));
+    }
+    _nearest.clear();
+    return records;
+}
+
+/*static*/ bool scan_geo_filter::nearer(const nearest_record &lhs, const nearest_record &rhs)
+{
+    return lhs.distance_m < rhs.distance_m;
+}
+
+/*static*/ double scan_geo_filter::distance_meters(double lat1_degrees,
+                                                   double lng1_degrees,
+                                                   double lat2_degrees,
+                                                   double lng2_degrees)
+{
+    // The haversine formula, which is the same as S2LatLng::GetDistance().
+    const double lat1 = lat1_degrees * (M_PI / 180);
+    const double lat2 = lat2_degrees * (M_PI / 180);
+    const double dlat = std::sin(0.5 * (lat2 - lat1));
+    const double dlng = std::sin(0.5 * (lng2_degrees - lng1_degrees) * (M_PI / 180));
+    const double x = dlat * dlat + dlng * dlng * std::cos(lat1) * std::cos(lat2);
+    return 2 * std::asin(std::sqrt(std::min(1.0, x))) * kEarthRadiusMeters;
+}
+
+} // namespace server
+} // namespace pegasus
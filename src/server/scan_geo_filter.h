@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <rrdb/rrdb_types.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "utils/ports.h"
+
+namespace pegasus {
+namespace server {
+
+// Filters the records of a scan by the distance between the center of the request and the
+// point held by the value, so that only the points within the radius are sent back to the geo
+// client rather than all the points in the scanned cells.
+class scan_geo_filter
+{
+public:
+    explicit scan_geo_filter(const ::dsn::apps::scan_geo_filter &request);
+
+    // Check if the request is valid, `reason` is set if not.
+    static bool validate(const ::dsn::apps::scan_geo_filter &request, std::string &reason);
+
+    // Check if the point held by `user_data` is within the radius, and get its distance to the
+    // center. The values which could not be decoded never match.
+    bool match(std::string_view user_data, double &distance_m) const;
+
+    // Whether only the nearest records are returned, by the last batch of the scan.
+    bool keep_nearest() const { return _request.top_k_nearest > 0; }
+
+    // Keep the matched record if it's one of the nearest ones so far, `raw_key` and `raw_value`
+    // are the ones stored in rocksdb.
+    void add_nearest(std::string_view raw_key, std::string_view raw_value, double distance_m);
+
+    // Move out the nearest records kept so far in ascending order of the distance, as pairs of
+    // the raw key and the raw value.
+    std::vector<std::pair<std::string, std::string>> take_nearest();
+
+    // Get the great-circle distance between the points in meters, which is the same as the one
+    // calculated by S2 on the client.
+    static double distance_meters(double lat1_degrees,
+                                  double lng1_degrees,
+                                  double lat2_degrees,
+                                  double lng2_degrees);
+
+private:
+    struct nearest_record
+    {
+        double distance_m;
+        std::string raw_key;
+        std::string raw_value;
+    };
+    // Used to build a max-heap, whose top is the farthest one.
+    static bool nearer(const nearest_record &lhs, const nearest_record &rhs);
+
+    const ::dsn::apps::scan_geo_filter _request;
+    // The indices of the latitude and the longitude in the value in ascending order.
+    int32_t _first_index;
+    int32_t _second_index;
+    bool _latlng_order;
+    // A max-heap, whose top is the farthest one of the nearest records.
+    std::vector<nearest_record> _nearest;
+
+    DISALLOW_COPY_AND_ASSIGN(scan_geo_filter);
+};
+
+} // namespace server
+} // namespace pegasus
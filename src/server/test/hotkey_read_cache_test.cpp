@@ -0,0 +1,164 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "base/pegasus_utils.h"
+#include "gtest/gtest.h"
+#include "pegasus_server_test_base.h"
+#include "server/hotkey_read_cache.h"
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+class hotkey_read_cache_test : public pegasus_server_test_base
+{
+protected:
+    void create_cache(size_t capacity_bytes)
+    {
+        _cache = std::make_unique<hotkey_read_cache>(_server, capacity_bytes);
+    }
+
+    // Read the key like on_get(): fill the cache with `value` on miss.
+    bool read(const std::string &key, const std::string &value, uint32_t expire_ts = 0)
+    {
+        dsn::blob cached;
+        if (_cache->get(key, utils::epoch_now(), cached)) {
+            EXPECT_EQ(value, cached.to_string());
+            return true;
+        }
+
+        const auto ticket = _cache->acquire_fill_ticket(key);
+        _cache->put(key, dsn::blob::create_from_bytes(std::string(value)), expire_ts, ticket);
+        return false;
+    }
+
+    bool contains(const std::string &key)
+    {
+        dsn::blob cached;
+        return _cache->get(key, utils::epoch_now(), cached);
+    }
+
+    std::unique_ptr<hotkey_read_cache> _cache;
+};
+
+INSTANTIATE_TEST_SUITE_P(, hotkey_read_cache_test, ::testing::Values(false, true));
+
+TEST_P(hotkey_read_cache_test, get_and_invalidate)
+{
+    create_cache(1024 * 1024);
+
+    ASSERT_FALSE(read("k1", "v1"));
+    ASSERT_TRUE(read("k1", "v1"));
+
+    _cache->invalidate("k1");
+    ASSERT_FALSE(contains("k1"));
+
+    ASSERT_FALSE(read("k1", "v2"));
+    ASSERT_TRUE(read("k1", "v2"));
+
+    _cache->clear();
+    ASSERT_FALSE(contains("k1"));
+}
+
+TEST_P(hotkey_read_cache_test, reject_stale_fill)
+{
+    create_cache(1024 * 1024);
+
+    // The key is written while the old value is being read.
+    const auto ticket = _cache->acquire_fill_ticket("k1");
+    _cache->invalidate("k1");
+    _cache->put("k1", dsn::blob::create_from_bytes("old"), 0, ticket);
+    ASSERT_FALSE(contains("k1"));
+
+    // So does clearing the cache.
+    const auto ticket2 = _cache->acquire_fill_ticket("k1");
+    _cache->clear();
+    _cache->put("k1", dsn::blob::create_from_bytes("old"), 0, ticket2);
+    ASSERT_FALSE(contains("k1"));
+}
+
+TEST_P(hotkey_read_cache_test, expired_entry)
+{
+    create_cache(1024 * 1024);
+
+    const uint32_t now = utils::epoch_now();
+    ASSERT_FALSE(read("expired", "v", now - 1));
+    ASSERT_FALSE(contains("expired"));
+
+    ASSERT_FALSE(read("not_expired", "v", now + 3600));
+    ASSERT_TRUE(contains("not_expired"));
+}
+
+TEST_P(hotkey_read_cache_test, default_ttl)
+{
+    create_cache(1024 * 1024);
+
+    ASSERT_FALSE(read("k1", "v1"));
+    ASSERT_TRUE(contains("k1"));
+
+    // All entries are invalidated once the default ttl is changed.
+    _cache->set_default_ttl(3600);
+    ASSERT_FALSE(contains("k1"));
+    ASSERT_FALSE(read("k1", "v1"));
+    ASSERT_TRUE(contains("k1"));
+
+    _cache->set_default_ttl(3600);
+    ASSERT_TRUE(contains("k1"));
+}
+
+TEST_P(hotkey_read_cache_test, suspended)
+{
+    create_cache(1024 * 1024);
+
+    ASSERT_FALSE(read("k1", "v1"));
+    _cache->set_suspended(true);
+    ASSERT_FALSE(contains("k1"));
+    ASSERT_FALSE(read("k1", "v1"));
+    ASSERT_FALSE(read("k1", "v1"));
+
+    _cache->set_suspended(false);
+    ASSERT_FALSE(read("k1", "v1"));
+    ASSERT_TRUE(read("k1", "v1"));
+}
+
+TEST_P(hotkey_read_cache_test, tinylfu_admission)
+{
+    // Each shard could only hold a few entries.
+    create_cache(16 * 1024);
+    const std::string value(200, 'v');
+
+    // The hot key is still cached after a large number of the keys are read once, which
+    // would flush it out of a plain LRU.
+    ASSERT_FALSE(read("hot", value));
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(read("hot", value));
+        read("cold_" + std::to_string(i), value);
+    }
+    ASSERT_TRUE(contains("hot"));
+
+    // The value larger than a shard is never cached.
+    const std::string large_value(2 * 1024, 'v');
+    ASSERT_FALSE(read("large", large_value));
+    ASSERT_FALSE(contains("large"));
+}
+
+} // namespace server
+} // namespace pegasus
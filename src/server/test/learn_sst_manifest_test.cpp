@@ -0,0 +1,242 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <rocksdb/env.h>
+#include <rocksdb/slice.h>
+#include <rocksdb/status.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/json_helper.h"
+#include "gtest/gtest.h"
+#include "server/learn_sst_manifest.h"
+#include "test_util/test_util.h"
+#include "utils/blob.h"
+#include "utils/env.h"
+#include "utils/error_code.h"
+#include "utils/filesystem.h"
+#include "utils/fmt_logging.h"
+
+namespace pegasus {
+namespace server {
+
+class learn_sst_manifest_test : public pegasus::encrypt_data_test_base
+{
+protected:
+    learn_sst_manifest_test()
+    {
+        dsn::utils::filesystem::remove_path(kTestDir);
+        for (const auto &dir : {kLearnerRdbDir, kLearnerCheckpointDir, kPrimaryDir, kLearnDir}) {
+            CHECK(dsn::utils::filesystem::create_directory(dir), "create {} failed", dir);
+        }
+    }
+
+    ~learn_sst_manifest_test() override { dsn::utils::filesystem::remove_path(kTestDir); }
+
+    static std::string create_file(const std::string &dir,
+                                   const std::string &name,
+                                   const std::string &content)
+    {
+        auto path = dsn::utils::filesystem::path_combine(dir, name);
+        const auto s =
+            rocksdb::WriteStringToFile(dsn::utils::PegasusEnv(dsn::utils::FileDataType::kSensitive),
+                                       rocksdb::Slice(content),
+                                       path,
+                                       /* should_sync */ true);
+        CHECK(s.ok(), "write file {} failed: {}", path, s.ToString());
+        return path;
+    }
+
+    static std::vector<std::string> learner_dirs()
+    {
+        return {kLearnerRdbDir, kLearnerCheckpointDir};
+    }
+
+    static std::vector<std::string> names_of(const std::vector<std::string> &files)
+    {
+        std::vector<std::string> names;
+        for (const auto &file : files) {
+            names.push_back(dsn::utils::filesystem::get_file_name(file));
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    static const std::string kTestDir;
+    static const std::string kLearnerRdbDir;
+    static const std::string kLearnerCheckpointDir;
+    static const std::string kPrimaryDir;
+    static const std::string kLearnDir;
+};
+
+const std::string learn_sst_manifest_test::kTestDir = "learn_sst_manifest_test";
+const std::string learn_sst_manifest_test::kLearnerRdbDir = "learn_sst_manifest_test/rdb";
+const std::string learn_sst_manifest_test::kLearnerCheckpointDir =
+    "learn_sst_manifest_test/checkpoint.100";
+const std::string learn_sst_manifest_test::kPrimaryDir = "learn_sst_manifest_test/primary";
+const std::string learn_sst_manifest_test::kLearnDir = "learn_sst_manifest_test/learn";
+
+INSTANTIATE_TEST_SUITE_P(, learn_sst_manifest_test, ::testing::Values(false, true));
+
+TEST_P(learn_sst_manifest_test, is_sst_file)
+{
+    ASSERT_TRUE(is_sst_file("000012.sst"));
+    ASSERT_TRUE(is_sst_file("rdb/000012.sst"));
+    ASSERT_FALSE(is_sst_file(".sst"));
+    ASSERT_FALSE(is_sst_file("MANIFEST-000005"));
+    ASSERT_FALSE(is_sst_file("000012.sst.tmp"));
+}
+
+TEST_P(learn_sst_manifest_test, sst_file_info)
+{
+    const std::string small(100, 'a');
+    const std::string large(200 << 10, 'b');
+    sst_file_info small_info;
+    sst_file_info large_info;
+    ASSERT_TRUE(get_sst_file_info(create_file(kLearnerRdbDir, "000001.sst", small), small_info));
+    ASSERT_TRUE(get_sst_file_info(create_file(kLearnerRdbDir, "000002.sst", large), large_info));
+    ASSERT_EQ("000001.sst", small_info.name);
+    ASSERT_EQ(static_cast<int64_t>(small.size()), small_info.size);
+    ASSERT_EQ("000002.sst", large_info.name);
+    ASSERT_EQ(static_cast<int64_t>(large.size()), large_info.size);
+
+    // Only the tail of the file is checksummed.
+    sst_file_info info;
+    ASSERT_TRUE(get_sst_file_info(create_file(kPrimaryDir,
+                                              "000002.sst",
+                                              std::string(100 << 10, 'c') +
+                                                  large.substr(100 << 10)),
+                                  info));
+    ASSERT_EQ(large_info.checksum, info.checksum);
+    ASSERT_TRUE(get_sst_file_info(create_file(kPrimaryDir, "000001.sst", std::string(100, 'c')),
+                                  info));
+    ASSERT_NE(small_info.checksum, info.checksum);
+
+    ASSERT_FALSE(get_sst_file_info(
+        dsn::utils::filesystem::path_combine(kPrimaryDir, "000003.sst"), info));
+}
+
+TEST_P(learn_sst_manifest_test, learn_with_local_sst_files)
+{
+    // The learner holds 000001.sst ~ 000004.sst, among which 000004.sst is only found in the
+    // checkpoint dir, and 000003.sst is different from the one of the primary.
+    create_file(kLearnerRdbDir, "000001.sst", "sst-1");
+    create_file(kLearnerRdbDir, "000002.sst", "sst-2");
+    create_file(kLearnerRdbDir, "000003.sst", "sst-3-learner");
+    create_file(kLearnerRdbDir, "MANIFEST-000010", "manifest-learner");
+    create_file(kLearnerCheckpointDir, "000002.sst", "sst-2");
+    create_file(kLearnerCheckpointDir, "000004.sst", "sst-4");
+
+    sst_file_manifest manifest;
+    collect_sst_files(learner_dirs(), sst_file_manifest(), manifest);
+    ASSERT_EQ(4u, manifest.files.size());
+
+    // The checksums of the known files are not computed again.
+    sst_file_manifest known = manifest;
+    for (auto &file : known.files) {
+        file.checksum = 0;
+    }
+    sst_file_manifest manifest2;
+    collect_sst_files(learner_dirs(), known, manifest2);
+    ASSERT_EQ(4u, manifest2.files.size());
+    for (const auto &file : manifest2.files) {
+        ASSERT_EQ(0u, file.checksum);
+    }
+
+    // The manifest is sent to the primary by the learn request.
+    const auto learn_request = dsn::json::json_forwarder<sst_file_manifest>::encode(manifest);
+    sst_file_manifest learner_manifest;
+    ASSERT_TRUE(
+        dsn::json::json_forwarder<sst_file_manifest>::decode(learn_request, learner_manifest));
+
+    std::vector<std::string> files = {create_file(kPrimaryDir, "000001.sst", "sst-1"),
+                                      create_file(kPrimaryDir, "000002.sst", "sst-2"),
+                                      create_file(kPrimaryDir, "000003.sst", "sst-3-primary"),
+                                      create_file(kPrimaryDir, "000004.sst", "sst-4"),
+                                      create_file(kPrimaryDir, "000005.sst", "sst-5"),
+                                      create_file(kPrimaryDir, "CURRENT", "MANIFEST-000010"),
+                                      create_file(kPrimaryDir, "MANIFEST-000010", "manifest")};
+    sst_file_manifest reused;
+    exclude_learner_sst_files(learner_manifest, files, reused);
+    ASSERT_EQ(std::vector<std::string>({"000003.sst", "000005.sst", "CURRENT", "MANIFEST-000010"}),
+              names_of(files));
+    ASSERT_EQ(3u, reused.files.size());
+
+    // The files to be learned are copied into the learn dir, and the others are linked.
+    for (const auto &file : files) {
+        ASSERT_TRUE(dsn::utils::filesystem::link_file(
+            file,
+            dsn::utils::filesystem::path_combine(kLearnDir,
+                                                 dsn::utils::filesystem::get_file_name(file))));
+    }
+    ASSERT_EQ(dsn::ERR_OK, link_reused_sst_files(reused, learner_dirs(), kLearnDir));
+
+    std::vector<std::string> learned_files;
+    ASSERT_TRUE(dsn::utils::filesystem::get_subfiles(kLearnDir, learned_files, false));
+    ASSERT_EQ(std::vector<std::string>({"000001.sst",
+                                        "000002.sst",
+                                        "000003.sst",
+                                        "000004.sst",
+                                        "000005.sst",
+                                        "CURRENT",
+                                        "MANIFEST-000010"}),
+              names_of(learned_files));
+    for (const auto &name : {"000001.sst", "000002.sst", "000003.sst", "000004.sst"}) {
+        sst_file_info expected;
+        sst_file_info actual;
+        ASSERT_TRUE(get_sst_file_info(dsn::utils::filesystem::path_combine(kPrimaryDir, name),
+                                      expected));
+        ASSERT_TRUE(
+            get_sst_file_info(dsn::utils::filesystem::path_combine(kLearnDir, name), actual));
+        ASSERT_EQ(expected.size, actual.size);
+        ASSERT_EQ(expected.checksum, actual.checksum);
+    }
+}
+
+TEST_P(learn_sst_manifest_test, reused_sst_file_removed)
+{
+    create_file(kLearnerRdbDir, "000001.sst", "sst-1");
+    create_file(kLearnerRdbDir, "000002.sst", "sst-2");
+
+    sst_file_manifest learner_manifest;
+    collect_sst_files(learner_dirs(), sst_file_manifest(), learner_manifest);
+
+    std::vector<std::string> files = {create_file(kPrimaryDir, "000001.sst", "sst-1"),
+                                      create_file(kPrimaryDir, "000002.sst", "sst-2")};
+    sst_file_manifest reused;
+    exclude_learner_sst_files(learner_manifest, files, reused);
+    ASSERT_TRUE(files.empty());
+    ASSERT_EQ(2u, reused.files.size());
+
+    // The local file has been compacted away before it's linked.
+    ASSERT_TRUE(dsn::utils::filesystem::remove_path(
+        dsn::utils::filesystem::path_combine(kLearnerRdbDir, "000002.sst")));
+    ASSERT_EQ(dsn::ERR_OBJECT_NOT_FOUND,
+              link_reused_sst_files(reused, learner_dirs(), kLearnDir));
+
+    // A different file with the same name is not linked either.
+    create_file(kLearnerRdbDir, "000002.sst", "sst-2-new");
+    dsn::utils::filesystem::remove_path(kLearnDir);
+    ASSERT_TRUE(dsn::utils::filesystem::create_directory(kLearnDir));
+    ASSERT_EQ(dsn::ERR_OBJECT_NOT_FOUND,
+              link_reused_sst_files(reused, learner_dirs(), kLearnDir));
+}
+
+} // namespace server
+} // namespace pegasus
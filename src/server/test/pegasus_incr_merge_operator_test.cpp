@@ -0,0 +1,141 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <rocksdb/slice.h>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "base/pegasus_value_schema.h"
+#include "gtest/gtest.h"
+#include "server/pegasus_incr_merge_operator.h"
+
+namespace pegasus {
+namespace server {
+
+class pegasus_incr_merge_operator_test : public ::testing::TestWithParam<uint32_t>
+{
+protected:
+    std::string make_value(const std::string &user_data, uint32_t expire_ts, uint64_t timetag = 0)
+    {
+        std::string value;
+        const auto parts = _gen.generate_value(GetParam(), user_data, expire_ts, timetag);
+        for (int i = 0; i < parts.num_parts; ++i) {
+            value.append(parts.parts[i].data(), parts.parts[i].size());
+        }
+        return value;
+    }
+
+    std::string make_operand(int64_t increment,
+                             int32_t expire_ts_seconds = 0,
+                             uint32_t now = kNow,
+                             uint32_t default_expire_ts = 0,
+                             uint64_t timetag = 0)
+    {
+        return encode_incr_merge_operand(
+            GetParam(), increment, expire_ts_seconds, now, default_expire_ts, timetag);
+    }
+
+    // Merge `operands` into `existing` (absent if nullptr), and check the resulting user data
+    // and expire timestamp.
+    void check_merge(const std::string *existing,
+                     const std::vector<std::string> &operands,
+                     const std::string &expected_user_data,
+                     uint32_t expected_expire_ts)
+    {
+        const rocksdb::Slice existing_slice =
+            existing == nullptr ? rocksdb::Slice() : rocksdb::Slice(*existing);
+        const std::vector<rocksdb::Slice> operand_slices(operands.begin(), operands.end());
+        std::string new_value;
+        ASSERT_TRUE(merge_incr_operands(
+            existing == nullptr ? nullptr : &existing_slice, operand_slices, new_value));
+        ASSERT_EQ(expected_user_data, pegasus_extract_user_data_view(GetParam(), new_value));
+        ASSERT_EQ(expected_expire_ts, pegasus_extract_expire_ts(GetParam(), new_value));
+    }
+
+    static const uint32_t kNow;
+
+    pegasus_value_generator _gen;
+};
+
+const uint32_t pegasus_incr_merge_operator_test::kNow = 1000;
+
+INSTANTIATE_TEST_SUITE_P(, pegasus_incr_merge_operator_test, ::testing::Values(0, 1));
+
+TEST_P(pegasus_incr_merge_operator_test, incr_on_absent_value)
+{
+    check_merge(nullptr, {make_operand(1)}, "1", 0);
+    check_merge(nullptr, {make_operand(1), make_operand(-3), make_operand(10)}, "8", 0);
+
+    // The ttl is reset only by a positive `expire_ts_seconds`.
+    check_merge(nullptr, {make_operand(1, 2000)}, "1", 2000);
+    check_merge(nullptr, {make_operand(1, -1)}, "1", 0);
+
+    // The default ttl of the table is applied once the ttl is not set.
+    check_merge(nullptr, {make_operand(1, 0, kNow, 3000)}, "1", 3000);
+}
+
+TEST_P(pegasus_incr_merge_operator_test, incr_on_existing_value)
+{
+    const auto existing = make_value("10", 2000);
+    check_merge(&existing, {make_operand(5)}, "15", 2000);
+    check_merge(&existing, {make_operand(5), make_operand(-20)}, "-5", 2000);
+    check_merge(&existing, {make_operand(5, 3000)}, "15", 3000);
+    check_merge(&existing, {make_operand(5, -1)}, "15", 0);
+    check_merge(&existing, {make_operand(5, -1, kNow, 4000)}, "15", 4000);
+
+    const auto empty = make_value("", 0);
+    check_merge(&empty, {make_operand(5)}, "5", 0);
+}
+
+TEST_P(pegasus_incr_merge_operator_test, incr_on_expired_value)
+{
+    const auto existing = make_value("10", 2000);
+
+    // The base value is regarded as 0 once it has expired when the incr was applied.
+    check_merge(&existing, {make_operand(5, 0, 2000)}, "5", 0);
+    check_merge(&existing, {make_operand(5, 0, 1999), make_operand(1, 0, 2000)}, "1", 0);
+    check_merge(&existing, {make_operand(5, -1, 1999), make_operand(1, 0, 2000)}, "16", 0);
+}
+
+TEST_P(pegasus_incr_merge_operator_test, skip_invalid_incr)
+{
+    const auto non_numeric = make_value("abc", 0);
+    check_merge(&non_numeric, {make_operand(1)}, "abc", 0);
+
+    const auto max = make_value(std::to_string(std::numeric_limits<int64_t>::max()), 0);
+    check_merge(&max,
+                {make_operand(1), make_operand(-1), make_operand(1)},
+                std::to_string(std::numeric_limits<int64_t>::max()),
+                0);
+}
+
+TEST_P(pegasus_incr_merge_operator_test, corrupted)
+{
+    std::string new_value;
+    const std::string bad_operand("bad");
+    ASSERT_FALSE(merge_incr_operands(nullptr, {rocksdb::Slice(bad_operand)}, new_value));
+
+    const std::string operand = make_operand(1);
+    const std::string bad_value("x");
+    const rocksdb::Slice bad_value_slice(bad_value);
+    ASSERT_FALSE(merge_incr_operands(&bad_value_slice, {rocksdb::Slice(operand)}, new_value));
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,117 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <rrdb/rrdb_types.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pegasus_server_test_base.h"
+#include "server/pegasus_scan_context.h"
+#include "test_util/test_util.h"
+#include "utils/flags.h"
+
+DSN_DECLARE_uint32(scan_context_idle_timeout_s);
+DSN_DECLARE_uint32(max_scan_contexts_per_node);
+
+namespace pegasus {
+namespace server {
+
+class pegasus_scan_context_test : public pegasus_server_test_base
+{
+protected:
+    pegasus_scan_context_test() { _cache = std::make_unique<pegasus_context_cache>(_server); }
+
+    static std::unique_ptr<pegasus_scan_context> make_context(int32_t batch_size)
+    {
+        return std::make_unique<pegasus_scan_context>(nullptr,
+                                                      std::string("stop"),
+                                                      false,
+                                                      ::dsn::apps::filter_type::FT_NO_FILTER,
+                                                      std::string(),
+                                                      ::dsn::apps::filter_type::FT_NO_FILTER,
+                                                      std::string(),
+                                                      batch_size,
+                                                      0,
+                                                      false,
+                                                      true,
+                                                      false,
+                                                      false);
+    }
+
+    std::unique_ptr<pegasus_context_cache> _cache;
+};
+
+INSTANTIATE_TEST_SUITE_P(, pegasus_scan_context_test, ::testing::Values(false, true));
+
+TEST_P(pegasus_scan_context_test, put_and_fetch)
+{
+    const auto base_count = pegasus_context_cache::node_context_count();
+    std::vector<int64_t> handles;
+    for (int i = 0; i < 100; ++i) {
+        handles.push_back(_cache->put(make_context(i)));
+    }
+    ASSERT_EQ(base_count + 100, pegasus_context_cache::node_context_count());
+
+    for (int i = 0; i < 100; ++i) {
+        auto context = _cache->fetch(handles[i]);
+        ASSERT_NE(nullptr, context);
+        ASSERT_EQ(i, context->batch_size);
+        // Each context could only be fetched once.
+        ASSERT_EQ(nullptr, _cache->fetch(handles[i]));
+    }
+    ASSERT_EQ(base_count, pegasus_context_cache::node_context_count());
+
+    _cache->put(make_context(0));
+    _cache->clear();
+    ASSERT_EQ(base_count, pegasus_context_cache::node_context_count());
+}
+
+TEST_P(pegasus_scan_context_test, expire_idle_contexts)
+{
+    const auto handle = _cache->put(make_context(0));
+    _cache->expire_idle_contexts();
+    ASSERT_NE(nullptr, _cache->fetch(handle));
+
+    const auto handle2 = _cache->put(make_context(0));
+    PRESERVE_FLAG(scan_context_idle_timeout_s);
+    FLAGS_scan_context_idle_timeout_s = 0;
+    _cache->expire_idle_contexts();
+    ASSERT_EQ(nullptr, _cache->fetch(handle2));
+}
+
+TEST_P(pegasus_scan_context_test, evict_when_exceeding_node_limit)
+{
+    // The contexts are evicted in the order they are put into the same shard.
+    PRESERVE_FLAG(max_scan_contexts_per_node);
+    FLAGS_max_scan_contexts_per_node =
+        static_cast<uint32_t>(pegasus_context_cache::node_context_count()) + 1;
+    std::vector<int64_t> handles;
+    for (int i = 0; i < 64; ++i) {
+        handles.push_back(_cache->put(make_context(i)));
+    }
+
+    // Only the latest context of each shard is kept.
+    for (size_t i = 0; i < handles.size(); ++i) {
+        ASSERT_EQ(i + 16 >= handles.size(), _cache->fetch(handles[i]) != nullptr) << i;
+    }
+}
+
+} // namespace server
+} // namespace pegasus
@@ -21,7 +21,11 @@
 #include <base/pegasus_key_schema.h>
 #include <fmt/core.h>
 #include <rocksdb/db.h>
+#include <rocksdb/cache.h>
 #include <rocksdb/options.h>
+#include <rocksdb/persistent_cache.h>
+#include <rocksdb/slice.h>
+#include <rocksdb/status.h>
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
@@ -33,6 +37,8 @@
 #include <utility>
 #include <vector>
 
+#include "base/pegasus_utils.h"
+#include "base/pegasus_value_schema.h"
 #include "common/gpid.h"
 #include "common/replica_envs.h"
 #include "common/replication.codes.h"
@@ -53,11 +59,17 @@
 #include "utils/defer.h"
 #include "utils/error_code.h"
 #include "utils/filesystem.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/metrics.h"
 #include "utils/test_macros.h"
 #include "utils_types.h"
 
+DSN_DECLARE_bool(rocksdb_batched_multi_get);
+DSN_DECLARE_string(rocksdb_block_cache_secondary_type);
+DSN_DECLARE_uint64(rocksdb_block_cache_secondary_capacity);
+DSN_DECLARE_string(rocksdb_block_cache_secondary_path);
+
 namespace pegasus::server {
 
 class pegasus_server_impl_test : public pegasus_server_test_base
@@ -111,6 +123,147 @@ protected:
         }
     }
 
+    // Write the record into the db directly, expire_ts is 0 if the record has no TTL.
+    void put_record(const std::string &hash_key,
+                    const std::string &sort_key,
+                    const std::string &value,
+                    uint32_t expire_ts)
+    {
+        dsn::blob key;
+        pegasus_generate_key(key, hash_key, sort_key);
+
+        pegasus_value_generator gen;
+        const auto parts =
+            gen.generate_value(_server->_pegasus_data_version, value, expire_ts, 0);
+        std::string raw_value;
+        for (int i = 0; i < parts.num_parts; ++i) {
+            raw_value.append(parts.parts[i].data(), parts.parts[i].size());
+        }
+
+        ASSERT_TRUE(_server->_db
+                        ->Put(rocksdb::WriteOptions(),
+                              _server->_data_cf,
+                              rocksdb::Slice(key.data(), key.length()),
+                              raw_value)
+                        .ok());
+    }
+
+    ::dsn::apps::multi_get_response multi_get(const std::string &hash_key,
+                                              const std::vector<std::string> &sort_keys,
+                                              int32_t max_kv_count,
+                                              int32_t max_kv_size)
+    {
+        auto request = std::make_unique<::dsn::apps::multi_get_request>();
+        request->__set_hash_key(dsn::blob::create_from_bytes(std::string(hash_key)));
+        std::vector<dsn::blob> keys;
+        for (const auto &sort_key : sort_keys) {
+            keys.emplace_back(dsn::blob::create_from_bytes(std::string(sort_key)));
+        }
+        request->__set_sort_keys(keys);
+        request->__set_max_kv_count(max_kv_count);
+        request->__set_max_kv_size(max_kv_size);
+
+        multi_get_rpc rpc(std::move(request), dsn::apps::RPC_RRDB_RRDB_MULTI_GET);
+        _server->on_multi_get(rpc);
+        return rpc.response();
+    }
+
+    // Get the record by on_get(), returns the error code of rocksdb.
+    int32_t get(const std::string &hash_key, const std::string &sort_key, std::string &value)
+    {
+        dsn::blob key;
+        pegasus_generate_key(key, hash_key, sort_key);
+        get_rpc rpc(std::make_unique<dsn::blob>(key), dsn::apps::RPC_RRDB_RRDB_GET);
+        _server->on_get(rpc);
+        value = rpc.response().value.to_string();
+        return rpc.response().error;
+    }
+
+    static void check_kvs(const std::vector<std::pair<std::string, std::string>> &expected_kvs,
+                          const std::vector<::dsn::apps::key_value> &kvs)
+    {
+        ASSERT_EQ(expected_kvs.size(), kvs.size());
+        for (size_t i = 0; i < kvs.size(); ++i) {
+            ASSERT_EQ(expected_kvs[i].first, kvs[i].key.to_string());
+            ASSERT_EQ(expected_kvs[i].second, kvs[i].value.to_string());
+        }
+    }
+
+    void test_multi_get_by_sort_keys()
+    {
+        // k0 ~ k9 are requested, among which k5 is missing, k3 and k7 have expired, and k8
+        // will expire in the future.
+        const std::string hash_key("hash_key");
+        const uint32_t now = utils::epoch_now();
+        std::vector<std::string> sort_keys;
+        std::vector<std::pair<std::string, std::string>> expected_kvs;
+        for (int i = 0; i < 10; ++i) {
+            const auto sort_key = fmt::format("k{}", i);
+            sort_keys.push_back(sort_key);
+            if (i == 5) {
+                continue;
+            }
+
+            const bool expired = (i == 3 || i == 7);
+            const auto value = fmt::format("v{}", i);
+            NO_FATALS(put_record(
+                hash_key, sort_key, value, expired ? now - 10 : (i == 8 ? now + 3600 : 0)));
+            if (!expired) {
+                expected_kvs.emplace_back(sort_key, value);
+            }
+
+            // Some of the records are read from the SST files, the others from the memtable.
+            if (i == 4) {
+                ASSERT_TRUE(_server->_db->Flush(rocksdb::FlushOptions(), _server->_data_cf).ok());
+            }
+        }
+
+        // The results of the keys got one by one.
+        std::set<std::string> found_sort_keys;
+        for (const auto &sort_key : sort_keys) {
+            std::string value;
+            const auto err = get(hash_key, sort_key, value);
+            if (err == rocksdb::Status::kNotFound) {
+                continue;
+            }
+            ASSERT_EQ(rocksdb::Status::kOk, err) << sort_key;
+            ASSERT_EQ(fmt::format("v{}", sort_key.substr(1)), value) << sort_key;
+            found_sort_keys.insert(sort_key);
+        }
+        ASSERT_EQ(expected_kvs.size(), found_sort_keys.size());
+        for (const auto &kv : expected_kvs) {
+            ASSERT_EQ(1U, found_sort_keys.count(kv.first)) << kv.first;
+        }
+
+        PRESERVE_FLAG(rocksdb_batched_multi_get);
+        for (const bool batched : {true, false}) {
+            FLAGS_rocksdb_batched_multi_get = batched;
+
+            // Only the records found by on_get() are returned, in the order of the sort keys.
+            const auto expired_count = _server->METRIC_VAR_VALUE(read_expired_values);
+            auto resp = multi_get(hash_key, sort_keys, 0, 0);
+            ASSERT_EQ(rocksdb::Status::kOk, resp.error) << batched;
+            NO_FATALS(check_kvs(expected_kvs, resp.kvs));
+            ASSERT_EQ(expired_count + 2, _server->METRIC_VAR_VALUE(read_expired_values));
+
+            // Not truncated if the count of the records found just reaches max_kv_count.
+            resp = multi_get(hash_key, sort_keys, static_cast<int32_t>(expected_kvs.size()), 0);
+            ASSERT_EQ(rocksdb::Status::kOk, resp.error) << batched;
+            NO_FATALS(check_kvs(expected_kvs, resp.kvs));
+
+            // Truncated by max_kv_count, the expired and missing records are not counted.
+            resp = multi_get(hash_key, sort_keys, 4, 0);
+            ASSERT_EQ(rocksdb::Status::kIncomplete, resp.error) << batched;
+            NO_FATALS(check_kvs({expected_kvs.begin(), expected_kvs.begin() + 4}, resp.kvs));
+
+            // Truncated by max_kv_size once the size of the records reaches it, i.e. each
+            // record of "kN" => "vN" takes 4 bytes.
+            resp = multi_get(hash_key, sort_keys, 0, 5);
+            ASSERT_EQ(rocksdb::Status::kIncomplete, resp.error) << batched;
+            NO_FATALS(check_kvs({expected_kvs.begin(), expected_kvs.begin() + 2}, resp.kvs));
+        }
+    }
+
     void test_open_db_with_rocksdb_envs(bool is_restart)
     {
         struct create_test
@@ -121,6 +274,13 @@ protected:
         } tests[] = {
             {"rocksdb.num_levels", "5", "5"},
             {"rocksdb.write_buffer_size", "33554432", "33554432"},
+            {"rocksdb.enable_blob_files", "true", "true"},
+            {"rocksdb.min_blob_size", "4096", "4096"},
+            {"rocksdb.blob_file_size", "134217728", "134217728"},
+            {"rocksdb.blob_compression_type", "zstd", "zstd"},
+            {"rocksdb.enable_blob_garbage_collection", "true", "true"},
+            {"rocksdb.blob_garbage_collection_age_cutoff", "0.5", "0.5"},
+            {"rocksdb.blob_garbage_collection_force_threshold", "0.8", "0.8"},
         };
 
         std::map<std::string, std::string> all_test_envs;
@@ -353,6 +513,12 @@ TEST_P(pegasus_server_impl_test, test_table_level_slow_query)
     test_table_level_slow_query();
 }
 
+TEST_P(pegasus_server_impl_test, test_multi_get_by_sort_keys)
+{
+    ASSERT_EQ(dsn::ERR_OK, start());
+    test_multi_get_by_sort_keys();
+}
+
 TEST_P(pegasus_server_impl_test, default_data_version)
 {
     ASSERT_EQ(dsn::ERR_OK, start());
@@ -401,6 +567,101 @@ TEST_P(pegasus_server_impl_test, test_restart_db_with_rocksdb_envs)
     test_open_db_with_rocksdb_envs(true);
 }
 
+TEST_P(pegasus_server_impl_test, test_blob_files)
+{
+    ASSERT_EQ(dsn::ERR_OK,
+              start({{dsn::replica_envs::ROCKSDB_ENABLE_BLOB_FILES, "true"},
+                     {dsn::replica_envs::ROCKSDB_MIN_BLOB_SIZE, "1024"}}));
+
+    // The options of blob files could be updated dynamically.
+    _server->update_app_envs({{dsn::replica_envs::ROCKSDB_ENABLE_BLOB_FILES, "TRUE"},
+                              {dsn::replica_envs::ROCKSDB_MIN_BLOB_SIZE, "2048"},
+                              {dsn::replica_envs::ROCKSDB_BLOB_COMPRESSION_TYPE, "lz4"}});
+    auto opts = _server->_db->GetOptions(_server->_data_cf);
+    ASSERT_TRUE(opts.enable_blob_files);
+    ASSERT_EQ(2048U, opts.min_blob_size);
+    ASSERT_EQ(rocksdb::kLZ4Compression, opts.blob_compression_type);
+
+    // The large values are separated into the blob files once flushed.
+    for (int i = 0; i < 10; ++i) {
+        dsn::blob key;
+        pegasus::pegasus_generate_key(key, std::string("hash_key"), std::to_string(i));
+        ASSERT_TRUE(_server->_db
+                        ->Put(rocksdb::WriteOptions(),
+                              _server->_data_cf,
+                              rocksdb::Slice(key.data(), key.length()),
+                              std::string(i % 2 == 0 ? 100 : 4096, 'v'))
+                        .ok());
+    }
+    ASSERT_TRUE(_server->_db->Flush(rocksdb::FlushOptions(), _server->_data_cf).ok());
+    uint64_t blob_file_size = 0;
+    ASSERT_TRUE(_server->_db->GetIntProperty(
+        _server->_data_cf, rocksdb::DB::Properties::kTotalBlobFileSize, &blob_file_size));
+    ASSERT_GT(blob_file_size, 0U);
+
+    // The blob files are included in the checkpoint, thus also learned and backed up.
+    const auto checkpoint_dir =
+        dsn::utils::filesystem::path_combine(_server->data_dir(), "test_blob_files_checkpoint");
+    auto cleanup = dsn::defer([&checkpoint_dir]() {
+        dsn::utils::filesystem::remove_path(checkpoint_dir);
+    });
+    ASSERT_EQ(dsn::ERR_OK,
+              _server->copy_checkpoint_to_dir(checkpoint_dir.c_str(), nullptr, false));
+    std::vector<std::string> files;
+    ASSERT_TRUE(dsn::utils::filesystem::get_subfiles(checkpoint_dir, files, false));
+    ASSERT_TRUE(std::any_of(files.begin(), files.end(), [](const std::string &file) {
+        return file.size() > 5 && file.compare(file.size() - 5, 5, ".blob") == 0;
+    }));
+}
+
+TEST_P(pegasus_server_impl_test, test_block_cache_secondary_type)
+{
+    ASSERT_TRUE(pegasus_server_impl::is_block_cache_secondary_type_valid("none"));
+    ASSERT_TRUE(pegasus_server_impl::is_block_cache_secondary_type_valid("compressed"));
+    ASSERT_TRUE(pegasus_server_impl::is_block_cache_secondary_type_valid("file"));
+    ASSERT_FALSE(pegasus_server_impl::is_block_cache_secondary_type_valid(""));
+    ASSERT_FALSE(pegasus_server_impl::is_block_cache_secondary_type_valid("Compressed"));
+    ASSERT_FALSE(pegasus_server_impl::is_block_cache_secondary_type_valid("nvm"));
+
+    PRESERVE_FLAG(rocksdb_block_cache_secondary_type);
+    PRESERVE_FLAG(rocksdb_block_cache_secondary_capacity);
+    PRESERVE_FLAG(rocksdb_block_cache_secondary_path);
+    FLAGS_rocksdb_block_cache_secondary_capacity = 1024 * 1024;
+
+    const std::string cache_dir("test_block_cache_secondary_type");
+    auto cleanup = dsn::defer([&cache_dir]() { dsn::utils::filesystem::remove_path(cache_dir); });
+    ASSERT_TRUE(dsn::utils::filesystem::create_directory(cache_dir));
+
+    struct test_case
+    {
+        const char *type;
+        std::string path;
+        bool expected_secondary_cache;
+        bool expected_persistent_cache;
+    } tests[] = {
+        {"none", "", false, false},
+        {"compressed", "", true, false},
+        {"file", dsn::utils::filesystem::path_combine(cache_dir, "cache"), false, true},
+        // The server would be started without the secondary tier once the cache file failed
+        // to be opened, e.g. the path is under a regular file.
+        {"file", dsn::utils::filesystem::path_combine(cache_dir, "not_a_dir/cache"), false, false},
+    };
+    ASSERT_TRUE(dsn::utils::filesystem::create_file(
+        dsn::utils::filesystem::path_combine(cache_dir, "not_a_dir")));
+
+    for (const auto &test : tests) {
+        FLAGS_rocksdb_block_cache_secondary_type = test.type;
+        FLAGS_rocksdb_block_cache_secondary_path = test.path.c_str();
+
+        std::shared_ptr<rocksdb::PersistentCache> persistent_cache;
+        const auto cache_opts = pegasus_server_impl::get_block_cache_options(persistent_cache);
+        ASSERT_EQ(test.expected_secondary_cache, cache_opts.secondary_cache != nullptr)
+            << test.type << ", " << test.path;
+        ASSERT_EQ(test.expected_persistent_cache, persistent_cache != nullptr)
+            << test.type << ", " << test.path;
+    }
+}
+
 TEST_P(pegasus_server_impl_test, test_stop_db_twice)
 {
     ASSERT_EQ(dsn::ERR_OK, start());
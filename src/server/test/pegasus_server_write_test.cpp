@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/pegasus_key_schema.h"
@@ -127,6 +128,78 @@ public:
         dsn::fail::teardown();
     }
 
+    void test_batch_multi_writes()
+    {
+        RPC_MOCKING(put_rpc)
+        RPC_MOCKING(multi_put_rpc)
+        RPC_MOCKING(multi_remove_rpc)
+        RPC_MOCKING(incr_rpc)
+        {
+            dsn::blob counter_key;
+            pegasus_generate_key(counter_key, std::string("hash"), std::string("counter"));
+
+            dsn::apps::update_request put_req;
+            put_req.key = counter_key;
+            put_req.value.assign("1", 0, 1);
+
+            dsn::apps::multi_put_request multi_put_req;
+            multi_put_req.hash_key.assign("hash", 0, 4);
+            multi_put_req.kvs.resize(2);
+            multi_put_req.kvs[0].key.assign("sort1", 0, 5);
+            multi_put_req.kvs[0].value.assign("value1", 0, 6);
+            multi_put_req.kvs[1].key.assign("sort2", 0, 5);
+            multi_put_req.kvs[1].value.assign("value2", 0, 6);
+
+            dsn::apps::multi_remove_request multi_remove_req;
+            multi_remove_req.hash_key.assign("hash", 0, 4);
+            multi_remove_req.sort_keys.emplace_back("sort1", 0, 5);
+
+            dsn::apps::incr_request incr_req;
+            incr_req.key = counter_key;
+            incr_req.increment = 2;
+
+            // The incr requests are applied upon the put in the same batch.
+            dsn::message_ex *writes[] = {pegasus::create_put_request(put_req),
+                                         pegasus::create_multi_put_request(multi_put_req),
+                                         pegasus::create_incr_request(incr_req),
+                                         pegasus::create_multi_remove_request(multi_remove_req),
+                                         pegasus::create_incr_request(incr_req)};
+            ASSERT_EQ(0, _server_write->on_batched_write_requests(writes, 5, 1, 0, nullptr));
+
+            ASSERT_TRUE(_server_write->_multi_put_rpc_batch.empty());
+            ASSERT_TRUE(_server_write->_multi_remove_rpc_batch.empty());
+            ASSERT_TRUE(_server_write->_incr_rpc_batch.empty());
+            ASSERT_TRUE(_server_write->_write_svc->_impl->_rocksdb_wrapper->_batch_overlay.empty());
+
+            ASSERT_EQ(1, multi_put_rpc::mail_box().size());
+            verify_response(multi_put_rpc::mail_box()[0].response(), 0, 1);
+            ASSERT_EQ(1, multi_remove_rpc::mail_box().size());
+            ASSERT_EQ(0, multi_remove_rpc::mail_box()[0].response().error);
+            ASSERT_EQ(1, multi_remove_rpc::mail_box()[0].response().count);
+            ASSERT_EQ(2, incr_rpc::mail_box().size());
+            ASSERT_EQ(0, incr_rpc::mail_box()[0].response().error);
+            ASSERT_EQ(3, incr_rpc::mail_box()[0].response().new_value);
+            ASSERT_EQ(0, incr_rpc::mail_box()[1].response().error);
+            ASSERT_EQ(5, incr_rpc::mail_box()[1].response().new_value);
+
+            // The incr of the next mutation reads the committed value.
+            dsn::message_ex *incr_write[] = {pegasus::create_incr_request(incr_req)};
+            ASSERT_EQ(0, _server_write->on_batched_write_requests(incr_write, 1, 2, 0, nullptr));
+            ASSERT_EQ(3, incr_rpc::mail_box().size());
+            ASSERT_EQ(7, incr_rpc::mail_box()[2].response().new_value);
+
+            const auto &wrapper = _server_write->_write_svc->_impl->_rocksdb_wrapper;
+            for (const auto &[sort_key, found] :
+                 std::vector<std::pair<std::string, bool>>{{"sort1", false}, {"sort2", true}}) {
+                dsn::blob key;
+                pegasus_generate_key(key, std::string("hash"), sort_key);
+                db_get_context get_ctx;
+                ASSERT_EQ(0, wrapper->get(key, &get_ctx));
+                ASSERT_EQ(found, get_ctx.found);
+            }
+        }
+    }
+
     void verify_response(const dsn::apps::update_response &response, int err, int64_t decree)
     {
         ASSERT_EQ(response.error, err);
@@ -141,5 +214,7 @@ INSTANTIATE_TEST_SUITE_P(, pegasus_server_write_test, ::testing::Values(false, t
 
 TEST_P(pegasus_server_write_test, batch_writes) { test_batch_writes(); }
 
+TEST_P(pegasus_server_write_test, batch_multi_writes) { test_batch_multi_writes(); }
+
 } // namespace server
 } // namespace pegasus
@@ -176,6 +176,18 @@ public:
         ASSERT_TRUE(get_ctx.expired);
     }
 
+    // Apply `req` as a batch of its own, the same way as pegasus_server_write does.
+    int apply_incr()
+    {
+        const int err = _write_impl->batch_incr(0, req, resp);
+        if (err != rocksdb::Status::kOk) {
+            _write_impl->batch_abort(0, err);
+            return err;
+        }
+
+        return _write_impl->batch_commit(0);
+    }
+
     // Test if the incr result in response is correct while there is not any error during incr.
     virtual void test_incr(int64_t base, int64_t increment) = 0;
 
@@ -220,7 +232,7 @@ public:
     void test_non_idempotent_incr(int64_t increment, int expected_ret_err, int expected_resp_err)
     {
         req.increment = increment;
-        ASSERT_EQ(expected_ret_err, _write_impl->incr(0, req, resp));
+        ASSERT_EQ(expected_ret_err, apply_incr());
         ASSERT_EQ(expected_resp_err, resp.error);
     }
 
@@ -449,4 +461,82 @@ INSTANTIATE_TEST_SUITE_P(PegasusWriteServiceImplTest,
                          IdempotentIncrTest,
                          testing::Values(false, true));
 
+class MergeIncrTest : public IncrTest
+{
+protected:
+    void SetUp() override
+    {
+        SET_UP_BASE(IncrTest);
+        req.return_new_value = false;
+        _write_impl->set_incr_merge_enabled(true);
+    }
+
+public:
+    // Test `incr` written as a merge operand, whose new value is not returned.
+    void test_merge_incr(int64_t increment)
+    {
+        req.increment = increment;
+        ASSERT_EQ(rocksdb::Status::kOk, apply_incr());
+        ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+        ASSERT_EQ(0, resp.new_value);
+    }
+
+    void test_incr(int64_t /*base*/, int64_t increment) override { test_merge_incr(increment); }
+};
+
+TEST_P(MergeIncrTest, IncrOnAbsentRecord)
+{
+    test_incr_on_absent_record(1);
+    test_incr_and_check_db_record(1, 100);
+    test_incr_and_check_db_record(101, -200);
+}
+
+TEST_P(MergeIncrTest, IncrOnExistingRecord)
+{
+    test_incr_on_existing_record(10, 1);
+    test_incr_on_existing_record(-10, 0);
+}
+
+TEST_P(MergeIncrTest, IncrOnNonNumericRecord)
+{
+    PUT_BASE_VALUE_STRING("abc");
+
+    // The invalid incr is skipped while the operand is resolved.
+    test_merge_incr(1);
+}
+
+TEST_P(MergeIncrTest, IncrOverflow)
+{
+    PUT_BASE_VALUE_INT64(1);
+
+    test_merge_incr(std::numeric_limits<int64_t>::max());
+}
+
+TEST_P(MergeIncrTest, IncrOnExpireRecord)
+{
+    // Make the record expired.
+    req.expire_ts_seconds = 1;
+    test_merge_incr(10);
+    check_db_record_expired();
+
+    // Incr the expired key.
+    req.expire_ts_seconds = 0;
+    test_incr_and_check_db_record(0, 100);
+}
+
+TEST_P(MergeIncrTest, ReturnNewValue)
+{
+    // The incr is done by read-before-write once the new value is needed.
+    req.return_new_value = true;
+    single_set(req.key, dsn::blob::create_from_numeric(static_cast<int64_t>(10)));
+    req.increment = 5;
+    ASSERT_EQ(rocksdb::Status::kOk, apply_incr());
+    ASSERT_EQ(15, resp.new_value);
+    check_db_record(static_cast<int64_t>(15));
+}
+
+INSTANTIATE_TEST_SUITE_P(PegasusWriteServiceImplTest,
+                         MergeIncrTest,
+                         testing::Values(false, true));
+
 } // namespace pegasus::server
@@ -63,6 +63,36 @@ public:
         _write_svc = _server_write->_write_svc.get();
     }
 
+    // Apply `request` as a batch of its own, the same way as pegasus_server_write does.
+    int apply_multi_put(const db_write_context &ctx,
+                        const dsn::apps::multi_put_request &request,
+                        dsn::apps::update_response &response)
+    {
+        _write_svc->batch_prepare(ctx.decree);
+        const int err = _write_svc->batch_multi_put(ctx, request, response);
+        if (err != rocksdb::Status::kOk) {
+            _write_svc->batch_abort(ctx.decree, err);
+            return err;
+        }
+
+        return _write_svc->batch_commit(ctx.decree);
+    }
+
+    // See apply_multi_put().
+    int apply_multi_remove(int64_t decree,
+                           const dsn::apps::multi_remove_request &request,
+                           dsn::apps::multi_remove_response &response)
+    {
+        _write_svc->batch_prepare(decree);
+        const int err = _write_svc->batch_multi_remove(decree, request, response);
+        if (err != rocksdb::Status::kOk) {
+            _write_svc->batch_abort(decree, err);
+            return err;
+        }
+
+        return _write_svc->batch_commit(decree);
+    }
+
     void test_multi_put()
     {
         dsn::fail::setup();
@@ -76,7 +106,7 @@ public:
         // alarm for empty request
         request.hash_key = dsn::blob(hash_key.data(), 0, hash_key.size());
         auto ctx = db_write_context::create(decree, 1000);
-        int err = _write_svc->multi_put(ctx, request, response);
+        int err = apply_multi_put(ctx, request, response);
         ASSERT_EQ(err, 0);
         verify_response(response, rocksdb::Status::kInvalidArgument, decree);
 
@@ -97,20 +127,20 @@ public:
 
         {
             dsn::fail::cfg("db_write_batch_put", "100%1*return()");
-            err = _write_svc->multi_put(ctx, request, response);
+            err = apply_multi_put(ctx, request, response);
             ASSERT_EQ(err, FAIL_DB_WRITE_BATCH_PUT);
             verify_response(response, err, decree);
         }
 
         {
             dsn::fail::cfg("db_write", "100%1*return()");
-            err = _write_svc->multi_put(ctx, request, response);
+            err = apply_multi_put(ctx, request, response);
             ASSERT_EQ(err, FAIL_DB_WRITE);
             verify_response(response, err, decree);
         }
 
         { // success
-            err = _write_svc->multi_put(ctx, request, response);
+            err = apply_multi_put(ctx, request, response);
             ASSERT_EQ(err, 0);
             verify_response(response, 0, decree);
         }
@@ -130,7 +160,7 @@ public:
 
         // alarm for empty request
         request.hash_key = dsn::blob(hash_key.data(), 0, hash_key.size());
-        int err = _write_svc->multi_remove(decree, request, response);
+        int err = apply_multi_remove(decree, request, response);
         ASSERT_EQ(err, 0);
         verify_response(response, rocksdb::Status::kInvalidArgument, decree);
 
@@ -148,20 +178,20 @@ public:
 
         {
             dsn::fail::cfg("db_write_batch_delete", "100%1*return()");
-            err = _write_svc->multi_remove(decree, request, response);
+            err = apply_multi_remove(decree, request, response);
             ASSERT_EQ(err, FAIL_DB_WRITE_BATCH_DELETE);
             verify_response(response, err, decree);
         }
 
         {
             dsn::fail::cfg("db_write", "100%1*return()");
-            err = _write_svc->multi_remove(decree, request, response);
+            err = apply_multi_remove(decree, request, response);
             ASSERT_EQ(err, FAIL_DB_WRITE);
             verify_response(response, err, decree);
         }
 
         { // success
-            err = _write_svc->multi_remove(decree, request, response);
+            err = apply_multi_remove(decree, request, response);
             ASSERT_EQ(err, 0);
             verify_response(response, 0, decree);
         }
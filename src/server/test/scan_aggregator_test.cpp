@@ -0,0 +1,97 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <rrdb/rrdb_types.h>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "server/scan_aggregator.h"
+
+namespace pegasus {
+namespace server {
+
+TEST(scan_aggregator_test, validate)
+{
+    struct test_case
+    {
+        std::vector<int64_t> value_size_buckets;
+        int32_t top_k_by_value_size;
+        bool expected_valid;
+    } tests[] = {{{}, 0, true},
+                 {{1, 10, 100}, 10, true},
+                 {{}, -1, false},
+                 {{}, 1001, false},
+                 {{10, 10}, 0, false},
+                 {{10, 1}, 0, false}};
+
+    for (const auto &test : tests) {
+        ::dsn::apps::scan_aggregation_request request;
+        request.value_size_buckets = test.value_size_buckets;
+        request.top_k_by_value_size = test.top_k_by_value_size;
+        std::string reason;
+        ASSERT_EQ(test.expected_valid, scan_aggregator::validate(request, reason));
+        ASSERT_EQ(test.expected_valid, reason.empty());
+    }
+}
+
+TEST(scan_aggregator_test, aggregate)
+{
+    ::dsn::apps::scan_aggregation_request request;
+    request.numeric_value_stats = true;
+    request.value_size_buckets = {2, 4};
+    request.top_k_by_value_size = 2;
+    scan_aggregator aggregator(request);
+
+    aggregator.add("k1", "1");
+    aggregator.add("k2", "-20");
+    aggregator.add("k3", "abcd");
+    aggregator.add("k4", "300");
+    aggregator.add("k5", "");
+
+    auto result = aggregator.take_result();
+    ASSERT_EQ(5, result.count);
+    ASSERT_EQ(10, result.total_key_size);
+    ASSERT_EQ(11, result.total_value_size);
+    ASSERT_EQ(3, result.numeric_count);
+    ASSERT_EQ(2, result.non_numeric_count);
+    ASSERT_EQ(281, result.sum);
+    ASSERT_FALSE(result.sum_overflow);
+    ASSERT_EQ(-20, result.min);
+    ASSERT_EQ(300, result.max);
+    ASSERT_EQ(std::vector<int64_t>({2, 2, 1}), result.value_size_histogram);
+    ASSERT_EQ(2u, result.top_k.size());
+    ASSERT_EQ("k3", result.top_k[0].key.to_string());
+    ASSERT_EQ(4, result.top_k[0].value_size);
+    ASSERT_EQ(3, result.top_k[1].value_size);
+
+    // A new batch is started after the result is taken.
+    aggregator.add("k6", std::to_string(std::numeric_limits<int64_t>::max()));
+    aggregator.add("k7", "1");
+    result = aggregator.take_result();
+    ASSERT_EQ(2, result.count);
+    ASSERT_EQ(2, result.numeric_count);
+    ASSERT_TRUE(result.sum_overflow);
+    ASSERT_EQ(1, result.min);
+    ASSERT_EQ(std::numeric_limits<int64_t>::max(), result.max);
+    ASSERT_EQ(std::vector<int64_t>({1, 0, 1}), result.value_size_histogram);
+}
+
+} // namespace server
+} // namespace pegasus
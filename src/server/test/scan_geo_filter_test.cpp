@@ -0,0 +1,144 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <rrdb/rrdb_types.h>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "server/scan_geo_filter.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+::dsn::apps::scan_geo_filter make_request(double lat_degrees,
+                                          double lng_degrees,
+                                          double radius_m,
+                                          int32_t latitude_index,
+                                          int32_t longitude_index,
+                                          int32_t top_k_nearest)
+{
+    ::dsn::apps::scan_geo_filter request;
+    request.lat_degrees = lat_degrees;
+    request.lng_degrees = lng_degrees;
+    request.radius_m = radius_m;
+    request.latitude_index = latitude_index;
+    request.longitude_index = longitude_index;
+    request.top_k_nearest = top_k_nearest;
+    return request;
+}
+
+} // anonymous namespace
+
+TEST(scan_geo_filter_test, validate)
+{
+    struct test_case
+    {
+        ::dsn::apps::scan_geo_filter request;
+        bool expected_valid;
+    } tests[] = {{make_request(39.9, 116.4, 1000, 4, 5, 0), true},
+                 {make_request(-90, 180, 0, 1, 0, 10000), true},
+                 {make_request(90.1, 116.4, 1000, 4, 5, 0), false},
+                 {make_request(39.9, -180.1, 1000, 4, 5, 0), false},
+                 {make_request(NAN, 116.4, 1000, 4, 5, 0), false},
+                 {make_request(39.9, 116.4, -1, 4, 5, 0), false},
+                 {make_request(39.9, 116.4, INFINITY, 4, 5, 0), false},
+                 {make_request(39.9, 116.4, 1000, 4, 4, 0), false},
+                 {make_request(39.9, 116.4, 1000, -1, 5, 0), false},
+                 {make_request(39.9, 116.4, 1000, 4, 5, -1), false},
+                 {make_request(39.9, 116.4, 1000, 4, 5, 10001), false}};
+
+    for (const auto &test : tests) {
+        std::string reason;
+        ASSERT_EQ(test.expected_valid, scan_geo_filter::validate(test.request, reason));
+        ASSERT_EQ(test.expected_valid, reason.empty());
+    }
+}
+
+TEST(scan_geo_filter_test, distance_meters)
+{
+    ASSERT_DOUBLE_EQ(0, scan_geo_filter::distance_meters(39.9, 116.4, 39.9, 116.4));
+    // One degree along a meridian.
+    ASSERT_NEAR(111195.08, scan_geo_filter::distance_meters(0, 0, 1, 0), 0.01);
+    ASSERT_NEAR(111195.08, scan_geo_filter::distance_meters(0, 0, 0, -1), 0.01);
+    // Half of the equator.
+    ASSERT_NEAR(6371010 * M_PI, scan_geo_filter::distance_meters(0, 0, 0, 180), 0.01);
+}
+
+TEST(scan_geo_filter_test, match)
+{
+    struct test_case
+    {
+        int32_t latitude_index;
+        int32_t longitude_index;
+        std::string value;
+        bool expected_match;
+    } tests[] = {
+        // The same as the values encoded by latlng_codec.
+        {4, 5, "00|2018-04-26|2018-04-28|ezp8xchrr|0.01|0.001|24.043028|4.15921|0|-1", true},
+        {5, 4, "00|2018-04-26|2018-04-28|ezp8xchrr|0.001|0.01|24.043028|4.15921|0|-1", true},
+        {0, 1, "0.01|0.001", true},
+        {1, 0, "0.001|0.01", true},
+        // Out of the radius.
+        {0, 1, "0.01|0.1", false},
+        {0, 1, "1|0.001", false},
+        // Could not be decoded.
+        {0, 1, "0.01", false},
+        {0, 1, "", false},
+        {0, 2, "0.01|0.001", false},
+        {0, 1, "0.01|abc", false},
+        {0, 1, "91|0.001", false},
+    };
+
+    for (const auto &test : tests) {
+        scan_geo_filter filter(
+            make_request(0, 0, 2000, test.latitude_index, test.longitude_index, 0));
+        double distance_m = 0;
+        ASSERT_EQ(test.expected_match, filter.match(test.value, distance_m)) << test.value;
+        if (test.expected_match) {
+            ASSERT_DOUBLE_EQ(scan_geo_filter::distance_meters(0, 0, 0.01, 0.001), distance_m);
+        }
+    }
+}
+
+TEST(scan_geo_filter_test, keep_nearest)
+{
+    ASSERT_FALSE(scan_geo_filter(make_request(0, 0, 2000, 0, 1, 0)).keep_nearest());
+
+    scan_geo_filter filter(make_request(0, 0, 2000, 0, 1, 3));
+    ASSERT_TRUE(filter.keep_nearest());
+    ASSERT_TRUE(filter.take_nearest().empty());
+
+    const std::vector<std::pair<std::string, double>> records = {
+        {"k1", 500}, {"k2", 100}, {"k3", 900}, {"k4", 300}, {"k5", 700}, {"k6", 200}};
+    for (const auto &[key, distance_m] : records) {
+        filter.add_nearest(key, "value_" + key, distance_m);
+    }
+
+    const std::vector<std::pair<std::string, std::string>> expected = {
+        {"k2", "value_k2"}, {"k6", "value_k6"}, {"k4", "value_k4"}};
+    ASSERT_EQ(expected, filter.take_nearest());
+    ASSERT_TRUE(filter.take_nearest().empty());
+}
+
+} // namespace server
+} // namespace pegasus
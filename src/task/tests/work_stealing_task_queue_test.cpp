@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "runtime/service_engine.h"
+#include "task/async_calls.h"
+#include "task/task.h"
+#include "task/task_code.h"
+#include "task/task_engine.h"
+#include "task/task_tracker.h"
+#include "task/work_stealing_task_queue.h"
+#include "utils/synchronize.h"
+#include "utils/threadpool_code.h"
+
+DEFINE_THREAD_POOL_CODE(THREAD_POOL_FOR_TEST_WORK_STEALING)
+DEFINE_TASK_CODE(LPC_WORK_STEALING_TEST_LOW,
+                 TASK_PRIORITY_LOW,
+                 THREAD_POOL_FOR_TEST_WORK_STEALING)
+DEFINE_TASK_CODE(LPC_WORK_STEALING_TEST_COMMON,
+                 TASK_PRIORITY_COMMON,
+                 THREAD_POOL_FOR_TEST_WORK_STEALING)
+DEFINE_TASK_CODE(LPC_WORK_STEALING_TEST_HIGH,
+                 TASK_PRIORITY_HIGH,
+                 THREAD_POOL_FOR_TEST_WORK_STEALING)
+
+namespace dsn {
+namespace tools {
+
+TEST(work_stealing_task_queue_test, run_all_tasks)
+{
+    if (service_engine::instance().spec().tool == "simulator") {
+        GTEST_SKIP() << "Skip the test in simulator mode, set 'tool = nativerun' in '[core]' "
+                        "section in config file to enable it.";
+    }
+
+    auto *pool = task::get_current_node2()->computation()->get_pool(
+        THREAD_POOL_FOR_TEST_WORK_STEALING);
+    ASSERT_NE(nullptr, pool);
+    ASSERT_EQ(1u, pool->queues().size());
+    ASSERT_NE(nullptr, dynamic_cast<work_stealing_task_queue *>(pool->queues()[0]));
+
+    const std::vector<task_code> codes = {
+        LPC_WORK_STEALING_TEST_LOW, LPC_WORK_STEALING_TEST_COMMON, LPC_WORK_STEALING_TEST_HIGH};
+    const int kOuterTaskCount = 300;
+    const int kInnerTaskCount = 10;
+    const int kTotalTaskCount = kOuterTaskCount * (kInnerTaskCount + 1);
+
+    std::atomic<int> finished_count(0);
+    utils::notify_event all_finished;
+    auto on_finished = [&]() {
+        if (++finished_count == kTotalTaskCount) {
+            all_finished.notify();
+        }
+    };
+
+    // The outer tasks are enqueued into the global queues, while the inner ones are enqueued
+    // by the workers into their local queues, and could be stolen by the others.
+    task_tracker tracker;
+    for (int i = 0; i < kOuterTaskCount; ++i) {
+        tasking::enqueue(codes[i % codes.size()], &tracker, [&, i]() {
+            for (int j = 0; j < kInnerTaskCount; ++j) {
+                tasking::enqueue(codes[(i + j) % codes.size()], &tracker, on_finished);
+            }
+            on_finished();
+        });
+    }
+
+    ASSERT_TRUE(all_finished.wait_for(30000));
+    ASSERT_EQ(kTotalTaskCount, finished_count.load());
+    tracker.wait_outstanding_tasks();
+}
+
+} // namespace tools
+} // namespace dsn
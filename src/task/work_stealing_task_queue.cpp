@@ -0,0 +1,211 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "work_stealing_task_queue.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "boost/iterator/function_output_iterator.hpp"
+#include "task.h"
+#include "task_engine.h"
+#include "task_spec.h"
+#include "task_worker.h"
+#include "utils/rand.h"
+
+namespace dsn {
+namespace tools {
+
+namespace {
+
+// The max number of the tasks taken from the LIFO slot in a row.
+constexpr int kMaxLifoStreak = 3;
+
+} // anonymous namespace
+
+void work_stealing_task_queue::task_list::append(task *t)
+{
+    if (tail != nullptr) {
+        tail->next = t;
+    } else {
+        head = t;
+    }
+
+    tail = t;
+    tail->next = nullptr;
+}
+
+work_stealing_task_queue::local_queue::local_queue()
+{
+    for (auto &size : sizes) {
+        size.store(0, std::memory_order_relaxed);
+    }
+}
+
+work_stealing_task_queue::work_stealing_task_queue(task_worker_pool *pool,
+                                                   int index,
+                                                   task_queue *inner_provider)
+    : task_queue(pool, index, inner_provider)
+{
+    const auto &spec = pool->spec();
+    if (!spec.partitioned && spec.worker_count > 1) {
+        _local_queues.reserve(spec.worker_count);
+        for (int i = 0; i < spec.worker_count; ++i) {
+            _local_queues.emplace_back(std::make_unique<local_queue>());
+        }
+    }
+}
+
+work_stealing_task_queue::local_queue *work_stealing_task_queue::current_local_queue() const
+{
+    if (_local_queues.empty()) {
+        return nullptr;
+    }
+
+    const auto *worker = task::get_current_worker2();
+    if (worker == nullptr || worker->queue() != this) {
+        return nullptr;
+    }
+    return _local_queues[worker->index()].get();
+}
+
+void work_stealing_task_queue::enqueue(task *task)
+{
+    const int priority = task->spec().priority;
+    auto *lq = current_local_queue();
+    if (lq == nullptr) {
+        _global_queues[priority].enqueue(task);
+    } else {
+        std::lock_guard<std::mutex> l(lq->mtx);
+        if (lq->lifo_slot != nullptr) {
+            lq->tasks[lq->lifo_slot->spec().priority].push_back(lq->lifo_slot);
+        }
+        lq->lifo_slot = task;
+        lq->sizes[priority].fetch_add(1, std::memory_order_relaxed);
+    }
+    _sema.signal(1);
+}
+
+task *work_stealing_task_queue::dequeue(int &batch_size)
+{
+    batch_size = _sema.waitMany(batch_size);
+    if (batch_size == 0) {
+        return nullptr;
+    }
+
+    // Each signal of the semaphore stands for a task which has been enqueued, thus exactly
+    // `batch_size` tasks could be found, although some of them might be stolen by the others
+    // and have to be searched again.
+    auto *lq = current_local_queue();
+    task_list out;
+    int count = batch_size;
+    do {
+        for (int priority = TASK_PRIORITY_COUNT - 1; priority >= 0 && count > 0; --priority) {
+            if (lq != nullptr) {
+                count -= pop_local(lq, priority, count, out);
+            }
+            if (count > 0) {
+                count -= pop_global(priority, count, out);
+            }
+            if (count > 0) {
+                count -= steal(lq, priority, count, out);
+            }
+        }
+    } while (count != 0);
+    return out.head;
+}
+
+int work_stealing_task_queue::pop_local(local_queue *lq, int priority, int count, task_list &out)
+{
+    if (lq->sizes[priority].load(std::memory_order_relaxed) == 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> l(lq->mtx);
+    auto &tasks = lq->tasks[priority];
+    int taken = 0;
+    if (lq->lifo_slot != nullptr && lq->lifo_slot->spec().priority == priority) {
+        if (lq->lifo_streak < kMaxLifoStreak) {
+            out.append(lq->lifo_slot);
+            ++lq->lifo_streak;
+            ++taken;
+        } else {
+            // Let the tasks which have been waiting longer run first.
+            tasks.push_back(lq->lifo_slot);
+        }
+        lq->lifo_slot = nullptr;
+    }
+
+    if (taken < count && !tasks.empty()) {
+        lq->lifo_streak = 0;
+        do {
+            out.append(tasks.front());
+            tasks.pop_front();
+            ++taken;
+        } while (taken < count && !tasks.empty());
+    }
+    lq->sizes[priority].fetch_sub(taken, std::memory_order_relaxed);
+    return taken;
+}
+
+int work_stealing_task_queue::pop_global(int priority, int count, task_list &out)
+{
+    auto iter = boost::make_function_output_iterator([&out](task *t) { out.append(t); });
+    return static_cast<int>(_global_queues[priority].try_dequeue_bulk(iter, count));
+}
+
+int work_stealing_task_queue::steal(local_queue *thief, int priority, int count, task_list &out)
+{
+    const size_t n = _local_queues.size();
+    if (n == 0) {
+        return 0;
+    }
+
+    int taken = 0;
+    const size_t start = rand::next_u32(static_cast<uint32_t>(n));
+    for (size_t i = 0; i < n && taken < count; ++i) {
+        auto *victim = _local_queues[(start + i) % n].get();
+        if (victim == thief || victim->sizes[priority].load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> l(victim->mtx);
+        const int size = victim->sizes[priority].load(std::memory_order_relaxed);
+        const int quota = std::min(count - taken, (size + 1) / 2);
+        auto &tasks = victim->tasks[priority];
+        int stolen = 0;
+        while (stolen < quota && !tasks.empty()) {
+            out.append(tasks.front());
+            tasks.pop_front();
+            ++stolen;
+        }
+        // The task in the LIFO slot is stolen at last, since it's most likely to be run soon
+        // by the victim itself.
+        if (stolen < quota && victim->lifo_slot != nullptr &&
+            victim->lifo_slot->spec().priority == priority) {
+            out.append(victim->lifo_slot);
+            victim->lifo_slot = nullptr;
+            ++stolen;
+        }
+        victim->sizes[priority].fetch_sub(stolen, std::memory_order_relaxed);
+        taken += stolen;
+    }
+    return taken;
+}
+
+} // namespace tools
+} // namespace dsn
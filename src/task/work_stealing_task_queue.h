@@ -0,0 +1,111 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "concurrentqueue/concurrentqueue.h"
+#include "concurrentqueue/lightweightsemaphore.h"
+#include "task_code.h"
+#include "task_queue.h"
+#include "utils/ports.h"
+
+namespace dsn {
+class task;
+class task_worker_pool;
+
+namespace tools {
+
+// A task queue shared by the workers of a non-partitioned thread pool, which schedules the
+// tasks by work stealing instead of contending on one global queue.
+//
+// Each worker owns a local queue for each priority, plus a LIFO slot which holds the task
+// most recently enqueued by the worker itself, since the continuation is likely to be run
+// best on the same core while its data is still in cache. The tasks enqueued from outside
+// the pool are put into the global queues.
+//
+// A worker dequeues the tasks from the highest priority to the lowest, and for each priority
+// from its LIFO slot, its local queue, the global queue and then the local queues of the other
+// workers picked randomly. The LIFO slot is bypassed after being used several times in a row,
+// to prevent the tasks in the local queue from starving.
+//
+// For the pool with only one worker for each queue (e.g. the partitioned pool), there is
+// nothing to steal from and the order of the tasks must be kept, thus all the tasks go
+// through the global queues, which works just like hpc_concurrent_task_queue.
+class work_stealing_task_queue : public task_queue
+{
+public:
+    work_stealing_task_queue(task_worker_pool *pool, int index, task_queue *inner_provider);
+
+    void enqueue(task *task) override;
+
+    task *dequeue(/*inout*/ int &batch_size) override;
+
+private:
+    // The singly-linked list of the dequeued tasks.
+    struct task_list
+    {
+        task *head{nullptr};
+        task *tail{nullptr};
+
+        void append(task *t);
+    };
+
+    struct local_queue
+    {
+        std::mutex mtx;
+        task *lifo_slot{nullptr};
+        std::deque<task *> tasks[TASK_PRIORITY_COUNT];
+        // The number of the tasks of each priority, including the one in the LIFO slot. Used
+        // to skip the empty queues without locking.
+        std::atomic<int> sizes[TASK_PRIORITY_COUNT];
+        // The number of the tasks taken from the LIFO slot in a row, only accessed by the
+        // owner worker.
+        int lifo_streak{0};
+
+        local_queue();
+    };
+
+    // Get the local queue of the current thread, nullptr if it's not a worker of this queue.
+    local_queue *current_local_queue() const;
+
+    // Take at most `count` tasks of `priority` from the LIFO slot and the local queue of
+    // the owner worker. Returns the number of the tasks taken.
+    int pop_local(local_queue *lq, int priority, int count, task_list &out);
+
+    // Take at most `count` tasks of `priority` from the global queue.
+    int pop_global(int priority, int count, task_list &out);
+
+    // Steal at most `count` tasks of `priority` from the other workers, at most half of the
+    // tasks of a victim are stolen.
+    int steal(local_queue *thief, int priority, int count, task_list &out);
+
+    moodycamel::LightweightSemaphore _sema;
+    moodycamel::ConcurrentQueue<task *> _global_queues[TASK_PRIORITY_COUNT];
+    // Empty unless there are multiple workers on this queue.
+    std::vector<std::unique_ptr<local_queue>> _local_queues;
+
+    DISALLOW_COPY_AND_ASSIGN(work_stealing_task_queue);
+};
+
+} // namespace tools
+} // namespace dsn
@@ -31,7 +31,9 @@
 #include "base/pegasus_key_schema.h"
 #include "client/partition_resolver.h"
 #include "gtest/gtest.h"
+#include "include/pegasus/client.h"
 #include "include/rrdb/rrdb.client.h"
+#include "pegasus/error.h"
 #include "test/function_test/utils/test_util.h"
 #include "utils/blob.h"
 #include "utils/error_code.h"
@@ -113,3 +115,39 @@ TEST_F(batch_get, set_and_then_batch_get)
         ASSERT_EQ(response.data[i].value.to_string(), test_data_values[i]);
     }
 }
+
+TEST_F(batch_get, batch_get_across_partitions)
+{
+    const int test_data_count = 200;
+    std::vector<std::pair<std::string, std::string>> keys;
+    std::vector<std::string> values;
+    for (int i = 0; i < test_data_count; ++i) {
+        const auto hash_key = "batch_get_hash_key_" + std::to_string(i);
+        const auto sort_key = "batch_get_sort_key_" + std::to_string(i);
+        const auto value = "batch_get_value_" + std::to_string(i);
+        ASSERT_EQ(PERR_OK, client_->set(hash_key, sort_key, value));
+        keys.emplace_back(hash_key, sort_key);
+        values.emplace_back(value);
+
+        // Interleave the keys not existing with the existing ones.
+        if (i % 10 == 0) {
+            keys.emplace_back("batch_get_no_exist_hash_key_" + std::to_string(i), sort_key);
+            values.emplace_back();
+        }
+    }
+
+    std::vector<pegasus::pegasus_client::batch_get_result> results;
+    ASSERT_EQ(PERR_OK, client_->batch_get(keys, results));
+    ASSERT_EQ(keys.size(), results.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (values[i].empty()) {
+            ASSERT_EQ(PERR_NOT_FOUND, results[i].error);
+        } else {
+            ASSERT_EQ(PERR_OK, results[i].error);
+            ASSERT_EQ(values[i], results[i].value);
+        }
+    }
+
+    ASSERT_EQ(PERR_OK, client_->batch_get({}, results));
+    ASSERT_TRUE(results.empty());
+}
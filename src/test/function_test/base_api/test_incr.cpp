@@ -21,11 +21,14 @@
 #include <unistd.h>
 #include <climits>
 #include <string>
+#include <vector>
 
+#include "common/replica_envs.h"
 #include "gtest/gtest.h"
 #include "include/pegasus/client.h"
 #include "pegasus/error.h"
 #include "test/function_test/utils/test_util.h"
+#include "utils/test_macros.h"
 
 using namespace ::pegasus;
 
@@ -247,3 +250,51 @@ TEST_F(incr, reset_ttl)
 
     ASSERT_EQ(PERR_OK, client_->del("incr_test_reset_ttl", ""));
 }
+
+TEST_F(incr, without_returning_new_value)
+{
+    const std::string hash_key("incr_test_without_returning_new_value");
+    pegasus_client::incr_options options;
+    options.return_new_value = false;
+
+    // The new value is still returned while the incr merge is not enabled on the table.
+    ASSERT_EQ(PERR_OK, client_->set(hash_key, "", "100"));
+    int64_t new_value_int;
+    ASSERT_EQ(PERR_OK, client_->incr(hash_key, "", 1, options, new_value_int));
+    ASSERT_EQ(101, new_value_int);
+
+    // Once the incr merge is enabled, the incr is written as a merge operand without
+    // read-before-write, thus the new value is not returned.
+    NO_FATALS(update_table_env({dsn::replica_envs::INCR_MERGE_ENABLED}, {"true"}));
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(PERR_OK, client_->incr(hash_key, "", 2, options, new_value_int));
+        ASSERT_EQ(0, new_value_int);
+    }
+    std::string new_value_str;
+    ASSERT_EQ(PERR_OK, client_->get(hash_key, "", new_value_str));
+    ASSERT_EQ("121", new_value_str);
+
+    // The new value is returned as before if required, even on the merged value.
+    ASSERT_EQ(PERR_OK, client_->incr(hash_key, "", 1, new_value_int));
+    ASSERT_EQ(122, new_value_int);
+
+    // The ttl is reset by the merged incr as well.
+    options.ttl_seconds = 10;
+    ASSERT_EQ(PERR_OK, client_->incr(hash_key, "", 1, options, new_value_int));
+    int ttl_seconds;
+    ASSERT_EQ(PERR_OK, client_->ttl(hash_key, "", ttl_seconds));
+    ASSERT_LT(0, ttl_seconds);
+    ASSERT_GE(10, ttl_seconds);
+    ASSERT_EQ(PERR_OK, client_->get(hash_key, "", new_value_str));
+    ASSERT_EQ("123", new_value_str);
+
+    // The merged incr on invalid old data is ignored rather than failed.
+    ASSERT_EQ(PERR_OK, client_->set(hash_key, "", "aaa"));
+    options.ttl_seconds = 0;
+    ASSERT_EQ(PERR_OK, client_->incr(hash_key, "", 1, options, new_value_int));
+    ASSERT_EQ(PERR_OK, client_->get(hash_key, "", new_value_str));
+    ASSERT_EQ("aaa", new_value_str);
+
+    ASSERT_EQ(PERR_OK, client_->del(hash_key, ""));
+    NO_FATALS(update_table_env({dsn::replica_envs::INCR_MERGE_ENABLED}, {"false"}));
+}
@@ -17,9 +17,11 @@
  * under the License.
  */
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
@@ -167,6 +169,60 @@ TEST_F(scan_test, OVERALL_COUNT_ONLY)
     ASSERT_EQ(base_data_count, data_count);
 }
 
+TEST_F(scan_test, OVERALL_AGGREGATION)
+{
+    const int top_k = 5;
+    pegasus_client::scan_options options;
+    options.aggregation.enabled = true;
+    options.aggregation.numeric_value_stats = true;
+    options.aggregation.value_size_buckets = {8, 16, 32};
+    options.aggregation.top_k_by_value_size = top_k;
+    std::vector<pegasus_client::pegasus_scanner *> scanners;
+    ASSERT_EQ(PERR_OK, client_->get_unordered_scanners(3, options, scanners));
+    ASSERT_LE(scanners.size(), 3);
+
+    pegasus_client::scan_aggregation_result total;
+    for (auto scanner : scanners) {
+        ASSERT_NE(nullptr, scanner);
+        pegasus_client::scan_aggregation_result result;
+        int ret;
+        while (PERR_OK == (ret = (scanner->next(result)))) {
+            ASSERT_EQ(PERR_OK, total.merge(result, top_k));
+        }
+        ASSERT_EQ(PERR_SCAN_COMPLETE, ret)
+            << "Error occurred when scan. error=" << client_->get_error_string(ret);
+        delete scanner;
+    }
+
+    int64_t expect_count = 0;
+    int64_t expect_value_size = 0;
+    std::vector<int64_t> value_sizes;
+    for (const auto &m : expect_kvs_) {
+        for (const auto &kv : m.second) {
+            ++expect_count;
+            expect_value_size += kv.second.size();
+            value_sizes.push_back(kv.second.size());
+        }
+    }
+    std::sort(value_sizes.begin(), value_sizes.end(), std::greater<int64_t>());
+
+    ASSERT_EQ(expect_count, total.count);
+    ASSERT_EQ(expect_value_size, total.total_value_size);
+    ASSERT_EQ(expect_count, total.numeric_count + total.non_numeric_count);
+    ASSERT_EQ(4u, total.value_size_histogram.size());
+    int64_t histogram_count = 0;
+    for (const auto count : total.value_size_histogram) {
+        histogram_count += count;
+    }
+    ASSERT_EQ(expect_count, histogram_count);
+    ASSERT_EQ(static_cast<size_t>(top_k), total.top_k.size());
+    for (int i = 0; i < top_k; ++i) {
+        ASSERT_EQ(value_sizes[i], total.top_k[i].value_size);
+        const auto &value = expect_kvs_[total.top_k[i].hash_key][total.top_k[i].sort_key];
+        ASSERT_EQ(value_sizes[i], static_cast<int64_t>(value.size()));
+    }
+}
+
 TEST_F(scan_test, ALL_SORT_KEY)
 {
     pegasus_client::scan_options options;
@@ -348,6 +404,38 @@ TEST_F(scan_test, OVERALL)
     ASSERT_NO_FATAL_FAILURE(compare(expect_kvs_, data));
 }
 
+TEST_F(scan_test, OVERALL_PREFETCH)
+{
+    pegasus_client::scan_options options;
+    options.prefetch = true;
+    options.batch_bytes = 4096;
+    std::vector<pegasus_client::pegasus_scanner *> scanners;
+    ASSERT_EQ(PERR_OK, client_->get_unordered_scanners(3, options, scanners));
+    ASSERT_LE(scanners.size(), 3);
+
+    std::string hash_key;
+    std::string sort_key;
+    std::string value;
+    std::map<std::string, std::map<std::string, std::string>> data;
+    for (auto scanner : scanners) {
+        ASSERT_NE(nullptr, scanner);
+        int ret;
+        while (PERR_OK == (ret = (scanner->next(hash_key, sort_key, value)))) {
+            check_and_put(data, hash_key, sort_key, value);
+        }
+        ASSERT_EQ(PERR_SCAN_COMPLETE, ret)
+            << "Error occurred when scan. error=" << client_->get_error_string(ret);
+        delete scanner;
+    }
+    ASSERT_NO_FATAL_FAILURE(compare(expect_kvs_, data));
+
+    // The scanner could be destructed while the next batch is being prefetched.
+    ASSERT_EQ(PERR_OK, client_->get_unordered_scanners(1, options, scanners));
+    ASSERT_EQ(1u, scanners.size());
+    ASSERT_EQ(PERR_OK, scanners[0]->next(hash_key, sort_key, value));
+    delete scanners[0];
+}
+
 TEST_F(scan_test, REQUEST_EXPIRE_TS)
 {
     pegasus_client::scan_options options;
@@ -25,6 +25,16 @@
  */
 
 #include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+// VPCLMULQDQ is not supported until GCC 8.
+#if defined(__clang__) || __GNUC__ >= 8
+#define CRC_HAS_AVX512_KERNEL
+#endif
+#endif
+
 #include "utils/crc.h"
 
 namespace dsn {
@@ -444,9 +454,368 @@ uint64_t crc64::_crc_table[sizeof(crc64::_crc_table) / sizeof(crc64::_crc_table[
 
 namespace dsn {
 namespace utils {
+namespace {
+
+// Returns (x ** n) mod POLY, in the same "reversed" representation as crc_generator.
+template <typename crc>
+typename crc::uint x_pow_mod(uint64_t n)
+{
+    return crc::MulPoly(crc::ComputeX_N(n / 8), crc::MSB >> (n % 8));
+}
+
+#if defined(__x86_64__)
+
+inline uint64_t load_u64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// The raw CRC (i.e. without the bitwise NOTs before and after) computed by the tables, which is
+// used to finish the folding kernels.
+template <typename crc>
+inline typename crc::uint raw_compute(typename crc::uint raw_crc, const void *ptr, size_t size)
+{
+    return ~crc::compute(ptr, size, ~raw_crc);
+}
+
+//
+// CRC32 by the SSE4.2 CRC32 instruction, which happens to implement the same polynomial
+// (CRC-32C).
+//
+// The instruction has a latency of 3 cycles but a throughput of 1 per cycle, thus the input is
+// split into 3 streams which are computed in parallel, and then combined by shifting the CRCs
+// of the preceding streams with PCLMULQDQ:
+//      raw_crc(A##B) = raw_crc(A) * x**(8*size(B)) + raw_crc(B)   (mod POLY)
+//
+constexpr size_t kCrc32StreamBytes = 256;
+
+struct crc32_shift_constants
+{
+    crc32_shift_constants()
+        // clmul(crc, k) followed by crc32(0, ...) computes (crc * k * x**33) mod POLY.
+        : one_stream(x_pow_mod<crc32>(8 * kCrc32StreamBytes - 33)),
+          two_streams(x_pow_mod<crc32>(16 * kCrc32StreamBytes - 33))
+    {
+    }
+
+    uint64_t one_stream;
+    uint64_t two_streams;
+};
+
+__attribute__((target("sse4.2,pclmul"))) inline uint64_t crc32_shift(uint64_t raw_crc, uint64_t k)
+{
+    const __m128i product =
+        _mm_clmulepi64_si128(_mm_cvtsi64_si128(raw_crc), _mm_cvtsi64_si128(k), 0x00);
+    return _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product)));
+}
+
+__attribute__((target("sse4.2,pclmul"))) uint32_t crc32_sse42(const void *ptr,
+                                                                size_t size,
+                                                                uint32_t init_crc)
+{
+    static const crc32_shift_constants kShift;
+
+    const uint8_t *p = static_cast<const uint8_t *>(ptr);
+    uint64_t c0 = static_cast<uint32_t>(~init_crc);
+
+    while (size >= 3 * kCrc32StreamBytes) {
+        uint64_t c1 = 0;
+        uint64_t c2 = 0;
+        for (size_t i = 0; i < kCrc32StreamBytes; i += 8) {
+            c0 = _mm_crc32_u64(c0, load_u64(p + i));
+            c1 = _mm_crc32_u64(c1, load_u64(p + kCrc32StreamBytes + i));
+            c2 = _mm_crc32_u64(c2, load_u64(p + 2 * kCrc32StreamBytes + i));
+        }
+        c0 = crc32_shift(c0, kShift.two_streams) ^ crc32_shift(c1, kShift.one_stream) ^ c2;
+        p += 3 * kCrc32StreamBytes;
+        size -= 3 * kCrc32StreamBytes;
+    }
+
+    for (; size >= 8; size -= 8, p += 8) {
+        c0 = _mm_crc32_u64(c0, load_u64(p));
+    }
+    uint32_t c = static_cast<uint32_t>(c0);
+    for (; size > 0; --size, ++p) {
+        c = _mm_crc32_u8(c, *p);
+    }
+
+    return ~c;
+}
+
+//
+// CRC64 by folding with PCLMULQDQ, see "Fast CRC Computation for Generic Polynomials Using
+// PCLMULQDQ Instruction" by Intel.
+//
+// The 128-bit blocks are folded forward by d bits as:
+//      (H * x**64 + L) * x**d = H * x**(d+64) + L * x**d   (mod POLY)
+// where H is the low (i.e. the former) quadword in the reversed representation. Since the
+// carry-less product of two reversed 64-bit values is one bit short of 128 bits, the constants
+// to be multiplied are x**(d+63) and x**(d-1). The folded 128 bits are finally reduced by the
+// tables, along with the tail shorter than a block.
+//
+// x**(d+63) in the low quadword and x**(d-1) in the high quadword to fold forward by d bits.
+struct crc64_fold_constant
+{
+    explicit crc64_fold_constant(uint64_t bits)
+        : lo(x_pow_mod<crc64>(bits + 63)), hi(x_pow_mod<crc64>(bits - 1))
+    {
+    }
+
+    __m128i m128() const
+    {
+        return _mm_set_epi64x(static_cast<int64_t>(hi), static_cast<int64_t>(lo));
+    }
+
+#ifdef CRC_HAS_AVX512_KERNEL
+    __attribute__((target("avx512f"))) __m512i m512() const
+    {
+        return _mm512_set4_epi64(static_cast<int64_t>(hi),
+                                 static_cast<int64_t>(lo),
+                                 static_cast<int64_t>(hi),
+                                 static_cast<int64_t>(lo));
+    }
+#endif
+
+    uint64_t lo;
+    uint64_t hi;
+};
+
+struct crc64_fold_constants
+{
+    crc64_fold_constants()
+        : fold_128(128),
+          fold_256(256),
+          fold_384(384),
+          fold_512(512),
+          fold_1024(1024),
+          fold_1536(1536),
+          fold_2048(2048)
+    {
+    }
+
+    crc64_fold_constant fold_128;
+    crc64_fold_constant fold_256;
+    crc64_fold_constant fold_384;
+    crc64_fold_constant fold_512;
+    crc64_fold_constant fold_1024;
+    crc64_fold_constant fold_1536;
+    crc64_fold_constant fold_2048;
+};
+
+const crc64_fold_constants &get_crc64_fold_constants()
+{
+    static const crc64_fold_constants kFold;
+    return kFold;
+}
+
+__attribute__((target("pclmul"))) inline __m128i fold_128(__m128i x, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+// Fold the remaining 128-bit blocks into `x`, then reduce it along with the tail.
+__attribute__((target("pclmul"))) uint64_t crc64_fold_finish(__m128i x,
+                                                             const uint8_t *p,
+                                                             size_t size)
+{
+    const __m128i k = get_crc64_fold_constants().fold_128.m128();
+    for (; size >= 16; size -= 16, p += 16) {
+        x = _mm_xor_si128(fold_128(x, k),
+                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    }
+
+    uint8_t folded[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(folded), x);
+    const uint64_t c = raw_compute<crc64>(0, folded, sizeof(folded));
+    return ~raw_compute<crc64>(c, p, size);
+}
+
+__attribute__((target("pclmul"))) uint64_t crc64_pclmul(const void *ptr,
+                                                        size_t size,
+                                                        uint64_t init_crc)
+{
+    if (size < 16) {
+        return crc64::compute(ptr, size, init_crc);
+    }
+
+    const auto *p = static_cast<const uint8_t *>(ptr);
+    const auto *v = reinterpret_cast<const __m128i *>(p);
+
+    // The initial CRC is equivalent to be xor-ed into the first 64 bits of the input.
+    __m128i x0 = _mm_xor_si128(_mm_loadu_si128(v), _mm_cvtsi64_si128(~init_crc));
+    if (size < 64) {
+        return crc64_fold_finish(x0, p + 16, size - 16);
+    }
+
+    const auto &kFold = get_crc64_fold_constants();
+    __m128i x1 = _mm_loadu_si128(v + 1);
+    __m128i x2 = _mm_loadu_si128(v + 2);
+    __m128i x3 = _mm_loadu_si128(v + 3);
+    p += 64;
+    size -= 64;
+
+    const __m128i k = kFold.fold_512.m128();
+    for (; size >= 64; size -= 64, p += 64) {
+        v = reinterpret_cast<const __m128i *>(p);
+        x0 = _mm_xor_si128(fold_128(x0, k), _mm_loadu_si128(v));
+        x1 = _mm_xor_si128(fold_128(x1, k), _mm_loadu_si128(v + 1));
+        x2 = _mm_xor_si128(fold_128(x2, k), _mm_loadu_si128(v + 2));
+        x3 = _mm_xor_si128(fold_128(x3, k), _mm_loadu_si128(v + 3));
+    }
+
+    __m128i x = _mm_xor_si128(_mm_xor_si128(fold_128(x0, kFold.fold_384.m128()), x3),
+                              _mm_xor_si128(fold_128(x1, kFold.fold_256.m128()),
+                                            fold_128(x2, kFold.fold_128.m128())));
+    return crc64_fold_finish(x, p, size);
+}
+
+#ifdef CRC_HAS_AVX512_KERNEL
+// The same folding as crc64_pclmul(), except that each 512-bit register holds 4 blocks folded
+// by VPCLMULQDQ at once.
+__attribute__((target("avx512f,pclmul,vpclmulqdq"))) inline __m512i fold_512(__m512i x, __m512i k)
+{
+    return _mm512_xor_si512(_mm512_clmulepi64_epi128(x, k, 0x00),
+                            _mm512_clmulepi64_epi128(x, k, 0x11));
+}
+
+__attribute__((target("avx512f,pclmul,vpclmulqdq"))) uint64_t crc64_avx512(const void *ptr,
+                                                                           size_t size,
+                                                                           uint64_t init_crc)
+{
+    // Avoid the overhead of the wide registers for the short inputs.
+    if (size < 256) {
+        return crc64_pclmul(ptr, size, init_crc);
+    }
+
+    const auto &kFold = get_crc64_fold_constants();
+    const auto *p = static_cast<const uint8_t *>(ptr);
+
+    __m512i z0 = _mm512_xor_si512(
+        _mm512_loadu_si512(p),
+        _mm512_inserti32x4(_mm512_setzero_si512(), _mm_cvtsi64_si128(~init_crc), 0));
+    __m512i z1 = _mm512_loadu_si512(p + 64);
+    __m512i z2 = _mm512_loadu_si512(p + 128);
+    __m512i z3 = _mm512_loadu_si512(p + 192);
+    p += 256;
+    size -= 256;
+
+    const __m512i fold_2048 = kFold.fold_2048.m512();
+    for (; size >= 256; size -= 256, p += 256) {
+        z0 = _mm512_xor_si512(fold_512(z0, fold_2048), _mm512_loadu_si512(p));
+        z1 = _mm512_xor_si512(fold_512(z1, fold_2048), _mm512_loadu_si512(p + 64));
+        z2 = _mm512_xor_si512(fold_512(z2, fold_2048), _mm512_loadu_si512(p + 128));
+        z3 = _mm512_xor_si512(fold_512(z3, fold_2048), _mm512_loadu_si512(p + 192));
+    }
+
+    const __m512i fold_512_bits = kFold.fold_512.m512();
+    __m512i z = _mm512_xor_si512(_mm512_xor_si512(fold_512(z0, kFold.fold_1536.m512()), z3),
+                                 _mm512_xor_si512(fold_512(z1, kFold.fold_1024.m512()),
+                                                  fold_512(z2, fold_512_bits)));
+    for (; size >= 64; size -= 64, p += 64) {
+        z = _mm512_xor_si512(fold_512(z, fold_512_bits), _mm512_loadu_si512(p));
+    }
+
+    __m128i lanes[4];
+    _mm512_storeu_si512(lanes, z);
+    __m128i x = _mm_xor_si128(_mm_xor_si128(fold_128(lanes[0], kFold.fold_384.m128()), lanes[3]),
+                              _mm_xor_si128(fold_128(lanes[1], kFold.fold_256.m128()),
+                                            fold_128(lanes[2], kFold.fold_128.m128())));
+    return crc64_fold_finish(x, p, size);
+}
+#endif // CRC_HAS_AVX512_KERNEL
+
+#endif // defined(__x86_64__)
+
+uint32_t crc32_table(const void *ptr, size_t size, uint32_t init_crc)
+{
+    return crc32::compute(ptr, size, init_crc);
+}
+
+uint64_t crc64_table(const void *ptr, size_t size, uint64_t init_crc)
+{
+    return crc64::compute(ptr, size, init_crc);
+}
+
+using crc32_func = uint32_t (*)(const void *, size_t, uint32_t);
+using crc64_func = uint64_t (*)(const void *, size_t, uint64_t);
+
+crc32_func get_crc32_func(crc_kernel kernel)
+{
+    switch (kernel) {
+#if defined(__x86_64__)
+    case crc_kernel::kSse42:
+    case crc_kernel::kAvx512:
+        return crc32_sse42;
+#endif
+    default:
+        return crc32_table;
+    }
+}
+
+crc64_func get_crc64_func(crc_kernel kernel)
+{
+    switch (kernel) {
+#if defined(__x86_64__)
+    case crc_kernel::kSse42:
+        return crc64_pclmul;
+#ifdef CRC_HAS_AVX512_KERNEL
+    case crc_kernel::kAvx512:
+        return crc64_avx512;
+#endif
+#endif
+    default:
+        return crc64_table;
+    }
+}
+
+} // anonymous namespace
+
+bool crc_kernel_supported(crc_kernel kernel)
+{
+    switch (kernel) {
+    case crc_kernel::kTable:
+        return true;
+#if defined(__x86_64__)
+    case crc_kernel::kSse42:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul");
+#ifdef CRC_HAS_AVX512_KERNEL
+    case crc_kernel::kAvx512:
+        __builtin_cpu_init();
+        return crc_kernel_supported(crc_kernel::kSse42) && __builtin_cpu_supports("avx512f") &&
+               __builtin_cpu_supports("vpclmulqdq");
+#endif
+#endif
+    default:
+        return false;
+    }
+}
+
+crc_kernel best_crc_kernel()
+{
+    static const crc_kernel kBest = []() {
+        if (crc_kernel_supported(crc_kernel::kAvx512)) {
+            return crc_kernel::kAvx512;
+        }
+        if (crc_kernel_supported(crc_kernel::kSse42)) {
+            return crc_kernel::kSse42;
+        }
+        return crc_kernel::kTable;
+    }();
+    return kBest;
+}
+
 uint32_t crc32_calc(const void *ptr, size_t size, uint32_t init_crc)
 {
-    return dsn::utils::crc32::compute(ptr, size, init_crc);
+    static const crc32_func kFunc = get_crc32_func(best_crc_kernel());
+    return kFunc(ptr, size, init_crc);
+}
+
+uint32_t crc32_calc(crc_kernel kernel, const void *ptr, size_t size, uint32_t init_crc)
+{
+    return get_crc32_func(kernel)(ptr, size, init_crc);
 }
 
 uint32_t crc32_concat(uint32_t xy_init,
@@ -463,7 +832,13 @@ uint32_t crc32_concat(uint32_t xy_init,
 
 uint64_t crc64_calc(const void *ptr, size_t size, uint64_t init_crc)
 {
-    return dsn::utils::crc64::compute(ptr, size, init_crc);
+    static const crc64_func kFunc = get_crc64_func(best_crc_kernel());
+    return kFunc(ptr, size, init_crc);
+}
+
+uint64_t crc64_calc(crc_kernel kernel, const void *ptr, size_t size, uint64_t init_crc)
+{
+    return get_crc64_func(kernel)(ptr, size, init_crc);
 }
 
 uint64_t crc64_concat(uint32_t xy_init,
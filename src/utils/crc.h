@@ -34,8 +34,28 @@
 namespace dsn {
 namespace utils {
 
+// The kernels to compute CRC32 and CRC64, all of which produce the same results. The fastest
+// one supported by the CPU is chosen at runtime by crc32_calc() and crc64_calc().
+enum class crc_kernel
+{
+    // Byte-at-a-time table lookups, which are supported on all platforms.
+    kTable,
+    // CRC32 by SSE4.2 CRC32 instructions, and CRC64 by folding with PCLMULQDQ.
+    kSse42,
+    // The same as kSse42, except that CRC64 is folded with AVX-512 VPCLMULQDQ.
+    kAvx512,
+};
+
+bool crc_kernel_supported(crc_kernel kernel);
+
+crc_kernel best_crc_kernel();
+
 uint32_t crc32_calc(const void *ptr, size_t size, uint32_t init_crc);
 
+// Compute CRC32 with the specified kernel, which must be supported by the CPU. It's used for
+// tests and benchmarks.
+uint32_t crc32_calc(crc_kernel kernel, const void *ptr, size_t size, uint32_t init_crc);
+
 //
 // Given
 //      x_final = crc32_calc(x_ptr, x_size, x_init);
@@ -55,6 +75,10 @@ uint32_t crc32_concat(uint32_t xy_init,
 
 uint64_t crc64_calc(const void *ptr, size_t size, uint64_t init_crc);
 
+// Compute CRC64 with the specified kernel, which must be supported by the CPU. It's used for
+// tests and benchmarks.
+uint64_t crc64_calc(crc_kernel kernel, const void *ptr, size_t size, uint64_t init_crc);
+
 //
 // Given
 //      x_final = crc64_calc(x_ptr, x_size, x_init);
@@ -76,6 +76,16 @@ metric_entity::~metric_entity()
     close(close_option::kWait);
 }
 
+namespace {
+
+inline bool is_closeable_metric(const metric_ptr &m)
+{
+    const auto type = m->prototype()->type();
+    return type == metric_type::kPercentile || type == metric_type::kHistogram;
+}
+
+} // anonymous namespace
+
 void metric_entity::close(close_option option)
 {
     utils::auto_write_lock l(_lock);
@@ -85,7 +95,7 @@ void metric_entity::close(close_option option)
     // It's inefficient to wait for each metric to be closed one by one. Therefore, the metric is
     // not closed in its destructor.
     for (auto &m : _metrics) {
-        if (m.second->prototype()->type() == metric_type::kPercentile) {
+        if (is_closeable_metric(m.second)) {
             auto p = down_cast<closeable_metric *>(m.second.get());
             p->close();
         }
@@ -97,7 +107,7 @@ void metric_entity::close(close_option option)
 
     // Wait for all of the close operations to be finished.
     for (auto &m : _metrics) {
-        if (m.second->prototype()->type() == metric_type::kPercentile) {
+        if (is_closeable_metric(m.second)) {
             auto p = down_cast<closeable_metric *>(m.second.get());
             p->wait();
         }
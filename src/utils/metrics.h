@@ -28,6 +28,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <new>
 #include <ratio>
@@ -136,6 +137,12 @@ class error_code;
     dsn::floating_percentile_prototype<double> METRIC_##name(                                      \
         {#entity_type, dsn::metric_type::kPercentile, #name, unit, desc, ##__VA_ARGS__})
 
+// The histogram records int64 observations into log-linear buckets, which could be merged among
+// entities (e.g. all replicas of a table) to compute accurate aggregated percentiles.
+#define METRIC_DEFINE_histogram_int64(entity_type, name, unit, desc, ...)                          \
+    dsn::histogram_prototype METRIC_##name(                                                        \
+        {#entity_type, dsn::metric_type::kHistogram, #name, unit, desc, ##__VA_ARGS__})
+
 // The following macros act as forward declarations for entity types and metric prototypes.
 #define METRIC_DECLARE_entity(name) extern ::dsn::metric_entity_prototype METRIC_ENTITY_##name
 #define METRIC_DECLARE_gauge_int64(name) extern ::dsn::gauge_prototype<int64_t> METRIC_##name
@@ -152,6 +159,7 @@ class error_code;
     extern dsn::percentile_prototype<int64_t> METRIC_##name
 #define METRIC_DECLARE_percentile_double(name)                                                     \
     extern dsn::floating_percentile_prototype<double> METRIC_##name
+#define METRIC_DECLARE_histogram_int64(name) extern dsn::histogram_prototype METRIC_##name
 
 // Following METRIC_VAR* macros are introduced so that:
 // * only need to use prototype name to operate each metric variable;
@@ -172,6 +180,8 @@ class error_code;
     METRIC_VAR_DECLARE(name, __VA_ARGS__ dsn::counter_ptr<dsn::striped_long_adder, false>)
 #define METRIC_VAR_DECLARE_percentile_int64(name, ...)                                             \
     METRIC_VAR_DECLARE(name, __VA_ARGS__ dsn::percentile_ptr<int64_t>)
+#define METRIC_VAR_DECLARE_histogram_int64(name, ...)                                              \
+    METRIC_VAR_DECLARE(name, __VA_ARGS__ dsn::histogram_ptr)
 
 // Macro METRIC_VAR_DEFINE* are used for the metric that is a static member of a class:
 // * `clazz` is the name of the class;
@@ -183,6 +193,8 @@ class error_code;
     METRIC_VAR_DEFINE(name, clazz, __VA_ARGS__ dsn::counter_ptr<dsn::striped_long_adder, false>)
 #define METRIC_VAR_DEFINE_percentile_int64(name, clazz, ...)                                       \
     METRIC_VAR_DEFINE(name, clazz, __VA_ARGS__ dsn::percentile_ptr<int64_t>)
+#define METRIC_VAR_DEFINE_histogram_int64(name, clazz, ...)                                        \
+    METRIC_VAR_DEFINE(name, clazz, __VA_ARGS__ dsn::histogram_ptr)
 
 // Initialize a metric variable in user class:
 // * macros METRIC_VAR_INIT* could be used to initialize metric variables in member initializer
@@ -230,18 +242,19 @@ class error_code;
 // Perform decrement() operations on gauges.
 #define METRIC_VAR_DECREMENT(name) METRIC_VAR_NAME(name)->decrement()
 
-// Perform set() operations on gauges and percentiles.
+// Perform set() operations on gauges, percentiles and histograms.
 //
 // There are 2 kinds of invocations of set() for a metric:
-// * set(val): set a single value for a metric, such as gauge, percentile;
+// * set(val): set a single value for a metric, such as gauge, percentile, histogram;
 // * set(n, val): set multiple repeated values (the number of duplicates is n) for a metric,
-// such as percentile.
+// such as percentile, histogram.
 #define METRIC_VAR_SET(name, ...) METRIC_VAR_NAME(name)->set(__VA_ARGS__)
 
 // Read the current measurement of gauges and counters.
 #define METRIC_VAR_VALUE(name) METRIC_VAR_NAME(name)->value()
 
-// Convenient macro that is used to compute latency automatically, which is dedicated to percentile.
+// Convenient macro that is used to compute latency automatically, which is dedicated to percentile
+// and histogram.
 #define METRIC_VAR_AUTO_LATENCY(name, ...)                                                         \
     dsn::auto_latency __##name##_auto_latency(METRIC_VAR_NAME(name), ##__VA_ARGS__)
 
@@ -753,13 +766,14 @@ private:
 // monitoring system.
 //
 // On the other hand, it is also needed when some special operation should be done
-// for a metric type. For example, percentile should be closed while it's no longer
-// used.
+// for a metric type. For example, percentile and histogram should be closed while they
+// are no longer used.
 #define ENUM_FOREACH_METRIC_TYPE(DEF)                                                              \
     DEF(Gauge)                                                                                     \
     DEF(Counter)                                                                                   \
     DEF(VolatileCounter)                                                                           \
-    DEF(Percentile)
+    DEF(Percentile)                                                                                \
+    DEF(Histogram)
 
 enum class metric_type
 {
@@ -812,7 +826,8 @@ ENUM_END(metric_type)
     DEF(FileLoads)                                                                                 \
     DEF(FileUploads)                                                                               \
     DEF(BulkLoads)                                                                                 \
-    DEF(Beacons)
+    DEF(Beacons)                                                                                   \
+    DEF(Contexts)
 
 enum class metric_unit : size_t
 {
@@ -1590,35 +1605,372 @@ template <typename T,
 using floating_percentile_prototype =
     metric_prototype_with<floating_percentile<T, NthElementFinder>>;
 
-// Compute latency automatically at the end of the scope, which is set to percentile which it has
-// bound to.
+// The layout of the buckets of histograms, which is log-linear like HdrHistogram: the values
+// less than 2 * kHistogramSubBucketCount are recorded exactly, while each larger range
+// [2^n, 2^(n+1)) is divided into kHistogramSubBucketCount linear sub-buckets. Thus the relative
+// error of each recorded value is at most 1 / kHistogramSubBucketCount. Since the layout is the
+// same for all histograms, the buckets of different histograms could be merged directly.
+constexpr size_t kHistogramSubBucketBits = 4;
+constexpr size_t kHistogramSubBucketCount = static_cast<size_t>(1) << kHistogramSubBucketBits;
+constexpr size_t kHistogramBucketCount =
+    (64 - kHistogramSubBucketBits + 1) * kHistogramSubBucketCount;
+
+inline size_t histogram_bucket_index(uint64_t value)
+{
+    if (value < 2 * kHistogramSubBucketCount) {
+        return static_cast<size_t>(value);
+    }
+
+    const auto msb = static_cast<size_t>(63 - __builtin_clzll(value));
+    const auto shift = msb - kHistogramSubBucketBits;
+    return (shift + 1) * kHistogramSubBucketCount +
+           static_cast<size_t>((value >> shift) - kHistogramSubBucketCount);
+}
+
+// The min value that would be put into the bucket.
+inline uint64_t histogram_bucket_lower_bound(size_t index)
+{
+    CHECK_LT(index, kHistogramBucketCount);
+    if (index < 2 * kHistogramSubBucketCount) {
+        return index;
+    }
+
+    const auto shift = index / kHistogramSubBucketCount - 1;
+    return static_cast<uint64_t>(kHistogramSubBucketCount + index % kHistogramSubBucketCount)
+           << shift;
+}
+
+// The max value that would be put into the bucket.
+inline uint64_t histogram_bucket_upper_bound(size_t index)
+{
+    if (index + 1 >= kHistogramBucketCount) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return histogram_bucket_lower_bound(index + 1) - 1;
+}
+
+// The snapshot of the buckets of a histogram. The snapshots of the same metric from different
+// entities could be merged, e.g. to compute the percentiles of the latencies of a table from
+// all of its replicas, or the snapshot taken earlier could be subtracted to get the observations
+// recorded during a period.
+class histogram_snapshot
+{
+public:
+    histogram_snapshot() : _buckets(kHistogramBucketCount, 0) {}
+
+    // Add the observations whose values are in the same bucket as `value`.
+    void add(uint64_t value, uint64_t n = 1)
+    {
+        _buckets[histogram_bucket_index(value)] += n;
+        _count += n;
+    }
+
+    void add_sum(uint64_t sum) { _sum += sum; }
+
+    void merge(const histogram_snapshot &other)
+    {
+        for (size_t i = 0; i < kHistogramBucketCount; ++i) {
+            _buckets[i] += other._buckets[i];
+        }
+        _count += other._count;
+        _sum += other._sum;
+    }
+
+    // `earlier` must be taken from the same histogram before this snapshot.
+    void subtract(const histogram_snapshot &earlier)
+    {
+        for (size_t i = 0; i < kHistogramBucketCount; ++i) {
+            _buckets[i] -= earlier._buckets[i];
+        }
+        _count -= earlier._count;
+        _sum -= earlier._sum;
+    }
+
+    uint64_t count() const { return _count; }
+
+    uint64_t sum() const { return _sum; }
+
+    const std::vector<uint64_t> &buckets() const { return _buckets; }
+
+    // Get the kth percentile, whose nth index is computed in the same way as percentile. The
+    // max value of the bucket the nth observation falls in is returned, which means the real
+    // value is not greater than it.
+    uint64_t value_at(kth_percentile_type type) const
+    {
+        if (_count == 0) {
+            return 0;
+        }
+
+        const auto nth = kth_percentile_to_nth_index(static_cast<size_t>(_count), type);
+        uint64_t accumulated = 0;
+        for (size_t i = 0; i < kHistogramBucketCount; ++i) {
+            accumulated += _buckets[i];
+            if (accumulated > nth) {
+                return histogram_bucket_upper_bound(i);
+            }
+        }
+        return histogram_bucket_upper_bound(kHistogramBucketCount - 1);
+    }
+
+private:
+    friend class histogram;
+
+    std::vector<uint64_t> _buckets;
+    uint64_t _count{0};
+    uint64_t _sum{0};
+};
+
+const std::string kHistogramCountField = "count";
+const std::string kHistogramSumField = "sum";
+const std::string kHistogramBucketsField = "buckets";
+
+// The histogram is a metric type that records each observation into the bucket it falls in,
+// without sampling. Compared with percentile, recording an observation is just 2 relaxed atomic
+// increments, and computing percentiles needs neither copying nor sorting samples.
+//
+// The kth percentiles are computed periodically over the observations recorded during the last
+// interval, which are the same as the ones of percentile. Besides, the accumulated count, sum
+// and non-empty buckets are also provided by the snapshot, which could be merged among the
+// entities or subtracted between 2 snapshots by the monitoring systems to compute accurate
+// percentiles of tables and servers.
+class histogram : public closeable_metric
+{
+public:
+    using value_type = int64_t;
+
+    // The negative values are recorded as 0.
+    void set(const value_type &val) { set(1, val); }
+
+    // Set the same value for n times, see also percentile::set().
+    void set(size_t n, const value_type &val)
+    {
+        const auto v = static_cast<uint64_t>(std::max<value_type>(val, 0));
+        _buckets.get()[histogram_bucket_index(v)].fetch_add(n, std::memory_order_relaxed);
+        _sum.fetch_add(v * n, std::memory_order_relaxed);
+    }
+
+    // The same as percentile::get().
+    bool get(kth_percentile_type type, value_type &val) const
+    {
+        const auto index = static_cast<size_t>(type);
+        CHECK_LT(index, static_cast<size_t>(kth_percentile_type::COUNT));
+
+        val = value(index);
+        return _kth_percentile_bitset.test(index);
+    }
+
+    // Take the snapshot of all of the observations recorded so far.
+    histogram_snapshot snapshot() const
+    {
+        histogram_snapshot result;
+        for (size_t i = 0; i < kHistogramBucketCount; ++i) {
+            result._buckets[i] = _buckets.get()[i].load(std::memory_order_relaxed);
+            result._count += result._buckets[i];
+        }
+        result._sum = _sum.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // The snapshot collected has following json format:
+    // {
+    //     "name": "<metric_name>",
+    //     "p50": ...,
+    //     "p90": ...,
+    //     ...
+    //     "count": ...,
+    //     "sum": ...,
+    //     "buckets": [[<min value of bucket>, <count>], ...]
+    // }
+    // where the configured kth percentiles are the same as percentile, and "count", "sum" and
+    // "buckets" are accumulated since the histogram was created. Only non-empty buckets are
+    // included.
+    void take_snapshot(metric_json_writer &writer, const metric_filters &filters) override
+    {
+        writer.StartObject();
+
+        encode_prototype(writer, filters);
+
+        for (size_t i = 0; i < static_cast<size_t>(kth_percentile_type::COUNT); ++i) {
+            if (!_kth_percentile_bitset.test(i)) {
+                continue;
+            }
+
+            encode(writer, kAllKthPercentiles[i].name, value(i), filters);
+        }
+
+        const auto accumulated = snapshot();
+        encode(writer, kHistogramCountField, accumulated.count(), filters);
+        encode(writer, kHistogramSumField, accumulated.sum(), filters);
+        if (filters.match_with_metric_field(kHistogramBucketsField)) {
+            writer.Key(kHistogramBucketsField.c_str());
+            writer.StartArray();
+            for (size_t i = 0; i < kHistogramBucketCount; ++i) {
+                if (accumulated.buckets()[i] == 0) {
+                    continue;
+                }
+
+                writer.StartArray();
+                writer.Uint64(histogram_bucket_lower_bound(i));
+                writer.Uint64(accumulated.buckets()[i]);
+                writer.EndArray();
+            }
+            writer.EndArray();
+        }
+
+        writer.EndObject();
+    }
+
+    bool timer_enabled() const { return !!_timer; }
+
+    uint64_t get_initial_delay_ms() const
+    {
+        return timer_enabled() ? _timer->get_initial_delay_ms() : 0;
+    }
+
+protected:
+    // `interval_ms` is the interval between the computations for kth percentiles, see also
+    // the constructor of percentile.
+    explicit histogram(const metric_prototype *prototype,
+                       uint64_t interval_ms = 10000,
+                       const std::set<kth_percentile_type> &kth_percentiles =
+                           kAllKthPercentileTypes)
+        : closeable_metric(prototype),
+          _buckets(cacheline_aligned_alloc_array<std::atomic<uint64_t>>(kHistogramBucketCount)),
+          _sum(0),
+          _kth_percentile_bitset(),
+          _kth_values(static_cast<size_t>(kth_percentile_type::COUNT)),
+          _timer()
+    {
+        CHECK(_buckets, "");
+        for (size_t i = 0; i < kHistogramBucketCount; ++i) {
+            _buckets.get()[i].store(0, std::memory_order_relaxed);
+        }
+
+        for (const auto &kth : kth_percentiles) {
+            _kth_percentile_bitset.set(static_cast<size_t>(kth));
+        }
+
+        for (auto &value : _kth_values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+
+#ifdef MOCK_TEST
+        if (interval_ms == 0) {
+            // Timer is disabled.
+            return;
+        }
+#else
+        CHECK_GT(interval_ms, 0);
+#endif
+
+        // The ref count is held by the timer, and will be released by on_close(), the same as
+        // percentile.
+        add_ref();
+        _timer.reset(new metric_timer(interval_ms,
+                                      std::bind(&histogram::compute_kth_percentiles, this),
+                                      std::bind(&histogram::on_close, this)));
+    }
+
+    virtual ~histogram() = default;
+
+private:
+    friend class metric_entity;
+    friend class ref_ptr<histogram>;
+    friend class MetricVarTest;
+    friend class HistogramTest;
+
+    void close() override
+    {
+        if (_timer) {
+            _timer->close();
+        }
+    }
+
+    void wait() override
+    {
+        if (_timer) {
+            _timer->wait();
+        }
+    }
+
+    void on_close() { release_ref(); }
+
+    value_type value(size_t index) const
+    {
+        return _kth_values[index].load(std::memory_order_relaxed);
+    }
+
+    void compute_kth_percentiles()
+    {
+        auto current = snapshot();
+        auto recent = current;
+        recent.subtract(_last_snapshot);
+        _last_snapshot = std::move(current);
+
+        if (recent.count() == 0) {
+            // Keep the kth percentiles of the last interval if nothing was recorded, the same
+            // as percentile whose samples are kept.
+            return;
+        }
+
+        for (size_t i = 0; i < static_cast<size_t>(kth_percentile_type::COUNT); ++i) {
+            if (!_kth_percentile_bitset.test(i)) {
+                continue;
+            }
+
+            const auto val = recent.value_at(static_cast<kth_percentile_type>(i));
+            _kth_values[i].store(static_cast<value_type>(std::min<uint64_t>(
+                                     val, std::numeric_limits<value_type>::max())),
+                                 std::memory_order_relaxed);
+        }
+    }
+
+    cacheline_aligned_ptr<std::atomic<uint64_t>> _buckets;
+    std::atomic<uint64_t> _sum;
+    std::bitset<static_cast<size_t>(kth_percentile_type::COUNT)> _kth_percentile_bitset;
+    std::vector<std::atomic<value_type>> _kth_values;
+
+    // Only accessed by the timer.
+    histogram_snapshot _last_snapshot;
+
+    std::unique_ptr<metric_timer> _timer;
+
+    DISALLOW_COPY_AND_ASSIGN(histogram);
+};
+
+using histogram_ptr = ref_ptr<histogram>;
+using histogram_prototype = metric_prototype_with<histogram>;
+
+// Compute latency automatically at the end of the scope, which is set to the percentile or
+// histogram which it has bound to.
+template <typename TLatencyMetricPtr>
 class auto_latency
 {
 public:
-    auto_latency(const percentile_ptr<int64_t> &p) : _percentile(p) {}
+    auto_latency(const TLatencyMetricPtr &p) : _metric(p) {}
 
-    auto_latency(const percentile_ptr<int64_t> &p, std::function<void(uint64_t)> callback)
-        : _percentile(p), _callback(std::move(callback))
+    auto_latency(const TLatencyMetricPtr &p, std::function<void(uint64_t)> callback)
+        : _metric(p), _callback(std::move(callback))
     {
     }
 
-    auto_latency(const percentile_ptr<int64_t> &p, uint64_t start_time_ns)
-        : _percentile(p), _chrono(start_time_ns)
+    auto_latency(const TLatencyMetricPtr &p, uint64_t start_time_ns)
+        : _metric(p), _chrono(start_time_ns)
     {
     }
 
-    auto_latency(const percentile_ptr<int64_t> &p,
+    auto_latency(const TLatencyMetricPtr &p,
                  uint64_t start_time_ns,
                  std::function<void(uint64_t)> callback)
-        : _percentile(p), _chrono(start_time_ns), _callback(std::move(callback))
+        : _metric(p), _chrono(start_time_ns), _callback(std::move(callback))
     {
     }
 
     ~auto_latency()
     {
         auto latency =
-            convert_metric_latency_from_ns(_chrono.duration_ns(), _percentile->prototype()->unit());
-        _percentile->set(static_cast<int64_t>(latency));
+            convert_metric_latency_from_ns(_chrono.duration_ns(), _metric->prototype()->unit());
+        _metric->set(static_cast<int64_t>(latency));
 
         if (_callback) {
             _callback(latency);
@@ -1628,7 +1980,7 @@ public:
     inline uint64_t duration_ns() const { return _chrono.duration_ns(); }
 
 private:
-    percentile_ptr<int64_t> _percentile;
+    TLatencyMetricPtr _metric;
     utils::chronograph _chrono;
     std::function<void(uint64_t)> _callback;
 
@@ -1705,6 +2057,39 @@ DEF_ALL_METRIC_BRIEF_SNAPSHOTS(value);
 
 DEF_ALL_METRIC_BRIEF_SNAPSHOTS(p99);
 
+// The brief snapshot of a histogram, by which the histograms of the same metric from different
+// entities (e.g. all replicas of a table, or all tables of a server) could be merged to compute
+// accurate percentiles, see merge_histogram_brief_snapshot().
+struct metric_brief_histogram_snapshot
+{
+    std::string name;
+    uint64_t sum = 0;
+    std::vector<std::vector<uint64_t>> buckets;
+
+    DEFINE_JSON_SERIALIZATION(name, sum, buckets)
+};
+
+DEF_METRIC_ENTITY_BRIEF_SNAPSHOT(histogram);
+
+DEF_METRIC_QUERY_BRIEF_SNAPSHOT(histogram);
+
+inline error_s merge_histogram_brief_snapshot(const metric_brief_histogram_snapshot &brief,
+                                              histogram_snapshot &snapshot)
+{
+    for (const auto &bucket : brief.buckets) {
+        if (dsn_unlikely(bucket.size() != 2)) {
+            return FMT_ERR(dsn::ERR_INVALID_DATA,
+                           "invalid bucket of histogram {}: size should be 2 rather than {}",
+                           brief.name,
+                           bucket.size());
+        }
+
+        snapshot.add(bucket[0], bucket[1]);
+    }
+    snapshot.add_sum(brief.sum);
+    return error_s::ok();
+}
+
 // Deserialize the json string into the snapshot.
 template <typename TMetricSnapshot>
 inline error_s deserialize_metric_snapshot(const std::string &json_string,
@@ -0,0 +1,147 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <fmt/core.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "runtime/api_layer1.h"
+#include "utils/crc.h"
+#include "utils/rand.h"
+#include "utils/string_conv.h"
+
+void print_usage(const char *cmd)
+{
+    fmt::print(stderr, "USAGE: {} <num_operations> <data_size>\n", cmd);
+    fmt::print(stderr,
+               "Run a simple benchmark that computes CRC32 and CRC64 by each sort of kernel "
+               "supported by the CPU.\n\n");
+
+    fmt::print(stderr, "    <num_operations>       the number of operations.\n");
+    fmt::print(stderr,
+               "    <data_size>            the size in bytes of data for each operation.\n");
+}
+
+template <typename Func>
+void run_bench(const std::string &name,
+               uint64_t num_operations,
+               const std::string &data,
+               uint64_t expected_checksum,
+               Func func)
+{
+    uint64_t checksum = 0;
+    const auto start = dsn_now_ns();
+    for (uint64_t i = 0; i < num_operations; ++i) {
+        checksum = func(data.data(), data.size(), checksum);
+    }
+    const auto end = dsn_now_ns();
+
+    if (checksum != expected_checksum) {
+        fmt::print(stderr,
+                   "{}: checksum({:#x}) != expected_checksum({:#x})\n",
+                   name,
+                   checksum,
+                   expected_checksum);
+        ::exit(-1);
+    }
+
+    std::chrono::nanoseconds nano(end - start);
+    const auto duration_s = std::chrono::duration_cast<std::chrono::duration<double>>(nano).count();
+    fmt::print("Running {} operations of {} with each data {} bytes took {} seconds, {:.2f} "
+               "MB/s.\n",
+               num_operations,
+               name,
+               data.size(),
+               duration_s,
+               num_operations * data.size() / duration_s / (1 << 20));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t num_operations;
+    if (!dsn::buf2uint64(argv[1], num_operations) || num_operations == 0) {
+        fmt::print(stderr, "Invalid num_operations: {}\n\n", argv[1]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t data_size;
+    if (!dsn::buf2uint64(argv[2], data_size) || data_size == 0) {
+        fmt::print(stderr, "Invalid data_size: {}\n\n", argv[2]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    std::string data(data_size, '\0');
+    for (auto &c : data) {
+        c = static_cast<char>(dsn::rand::next_u32(0, 255));
+    }
+
+    // Chain the checksums of the operations, so that each kernel could be verified by the
+    // final checksum of the tables.
+    uint64_t crc32_checksum = 0;
+    uint64_t crc64_checksum = 0;
+    for (uint64_t i = 0; i < num_operations; ++i) {
+        crc32_checksum = dsn::utils::crc32_calc(dsn::utils::crc_kernel::kTable,
+                                                data.data(),
+                                                data.size(),
+                                                static_cast<uint32_t>(crc32_checksum));
+        crc64_checksum = dsn::utils::crc64_calc(
+            dsn::utils::crc_kernel::kTable, data.data(), data.size(), crc64_checksum);
+    }
+
+    const std::vector<std::pair<std::string, dsn::utils::crc_kernel>> kernels = {
+        {"table", dsn::utils::crc_kernel::kTable},
+        {"sse4.2", dsn::utils::crc_kernel::kSse42},
+        {"avx512", dsn::utils::crc_kernel::kAvx512}};
+    for (const auto &kernel : kernels) {
+        if (!dsn::utils::crc_kernel_supported(kernel.second)) {
+            fmt::print("Kernel {} is not supported by the CPU, skip it.\n", kernel.first);
+            continue;
+        }
+
+        run_bench(fmt::format("crc32_{}", kernel.first),
+                  num_operations,
+                  data,
+                  crc32_checksum,
+                  [&kernel](const void *ptr, size_t size, uint64_t init_crc) -> uint64_t {
+                      return dsn::utils::crc32_calc(
+                          kernel.second, ptr, size, static_cast<uint32_t>(init_crc));
+                  });
+        run_bench(fmt::format("crc64_{}", kernel.first),
+                  num_operations,
+                  data,
+                  crc64_checksum,
+                  [&kernel](const void *ptr, size_t size, uint64_t init_crc) -> uint64_t {
+                      return dsn::utils::crc64_calc(kernel.second, ptr, size, init_crc);
+                  });
+    }
+
+    return 0;
+}
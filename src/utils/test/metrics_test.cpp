@@ -29,6 +29,7 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <thread>
 #include <vector>
@@ -197,6 +198,11 @@ METRIC_DEFINE_percentile_int64(my_replica,
                                dsn::metric_unit::kSeconds,
                                "a replica-level percentile of int64 type in seconds for test");
 
+METRIC_DEFINE_histogram_int64(my_server,
+                              test_server_histogram_int64,
+                              dsn::metric_unit::kNanoSeconds,
+                              "a server-level histogram of int64 type for test");
+
 namespace dsn {
 
 TEST(metrics_test, create_entity)
@@ -3349,4 +3355,140 @@ TEST_F(MetricVarTest, AutoLatencySeconds) { TEST_METRIC_VAR_AUTO_LATENCY(s, 1000
 
 TEST_F(MetricVarTest, AutoCount) { ASSERT_NO_FATAL_FAILURE(test_auto_count()); }
 
+class HistogramTest : public testing::Test
+{
+protected:
+    HistogramTest()
+        : _my_server_entity(METRIC_ENTITY_my_server.instantiate("histogram_test")),
+          // Disable the timer to compute the kth percentiles manually.
+          _histogram(METRIC_test_server_histogram_int64.instantiate(_my_server_entity, 0))
+    {
+    }
+
+    void compute_kth_percentiles() { _histogram->compute_kth_percentiles(); }
+
+    void check_kth_percentiles(const std::vector<int64_t> &expected_values) const
+    {
+        ASSERT_EQ(static_cast<size_t>(kth_percentile_type::COUNT), expected_values.size());
+        for (size_t i = 0; i < expected_values.size(); ++i) {
+            int64_t value = 0;
+            ASSERT_TRUE(_histogram->get(static_cast<kth_percentile_type>(i), value));
+            ASSERT_EQ(expected_values[i], value);
+        }
+    }
+
+    const metric_entity_ptr _my_server_entity;
+    histogram_ptr _histogram;
+};
+
+TEST_F(HistogramTest, BucketLayout)
+{
+    for (uint64_t value = 0; value < 2 * kHistogramSubBucketCount; ++value) {
+        const auto index = histogram_bucket_index(value);
+        ASSERT_EQ(value, index);
+        ASSERT_EQ(value, histogram_bucket_lower_bound(index));
+        ASSERT_EQ(value, histogram_bucket_upper_bound(index));
+    }
+
+    ASSERT_EQ(kHistogramBucketCount - 1,
+              histogram_bucket_index(std::numeric_limits<uint64_t>::max()));
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(),
+              histogram_bucket_upper_bound(kHistogramBucketCount - 1));
+
+    // The buckets are continuous, and the relative error is bounded.
+    for (size_t index = 0; index + 1 < kHistogramBucketCount; ++index) {
+        const auto lower = histogram_bucket_lower_bound(index);
+        const auto upper = histogram_bucket_upper_bound(index);
+        ASSERT_EQ(upper + 1, histogram_bucket_lower_bound(index + 1));
+        ASSERT_EQ(index, histogram_bucket_index(lower));
+        ASSERT_EQ(index, histogram_bucket_index(upper));
+        ASSERT_LE((upper - lower) * kHistogramSubBucketCount, lower);
+    }
+}
+
+TEST_F(HistogramTest, Set)
+{
+    for (int64_t value = 1; value <= 10; ++value) {
+        _histogram->set(value);
+    }
+    // Negative values are recorded as 0.
+    _histogram->set(-1);
+    _histogram->set(5, 1000);
+
+    const auto snapshot = _histogram->snapshot();
+    ASSERT_EQ(16u, snapshot.count());
+    ASSERT_EQ(55u + 5000u, snapshot.sum());
+    ASSERT_EQ(1u, snapshot.buckets()[0]);
+    ASSERT_EQ(5u, snapshot.buckets()[histogram_bucket_index(1000)]);
+
+    // The 16 observations are [0, 1, 2, ..., 10, 1000 x 5].
+    ASSERT_EQ(8u, snapshot.value_at(kth_percentile_type::P50));
+    const auto upper = histogram_bucket_upper_bound(histogram_bucket_index(1000));
+    ASSERT_LE(1000u, upper);
+    ASSERT_EQ(upper, snapshot.value_at(kth_percentile_type::P90));
+    ASSERT_EQ(upper, snapshot.value_at(kth_percentile_type::P999));
+}
+
+TEST_F(HistogramTest, ComputeKthPercentilesByInterval)
+{
+    // Nothing has been computed.
+    ASSERT_NO_FATAL_FAILURE(check_kth_percentiles({0, 0, 0, 0, 0}));
+
+    for (int64_t value = 0; value < 20; ++value) {
+        _histogram->set(value);
+    }
+    compute_kth_percentiles();
+    ASSERT_NO_FATAL_FAILURE(check_kth_percentiles({10, 18, 19, 19, 19}));
+
+    // Only the observations during the last interval are considered.
+    _histogram->set(10, 3);
+    compute_kth_percentiles();
+    ASSERT_NO_FATAL_FAILURE(check_kth_percentiles({3, 3, 3, 3, 3}));
+
+    // The kth percentiles are kept if nothing was recorded.
+    compute_kth_percentiles();
+    ASSERT_NO_FATAL_FAILURE(check_kth_percentiles({3, 3, 3, 3, 3}));
+}
+
+TEST_F(HistogramTest, MergeBriefSnapshots)
+{
+    // The histograms of 2 replicas, one of which is much slower than the other.
+    auto fast_entity = METRIC_ENTITY_my_server.instantiate("histogram_test_fast");
+    auto fast = METRIC_test_server_histogram_int64.instantiate(fast_entity, 0);
+    auto slow_entity = METRIC_ENTITY_my_server.instantiate("histogram_test_slow");
+    auto slow = METRIC_test_server_histogram_int64.instantiate(slow_entity, 0);
+    fast->set(990, 10);
+    slow->set(10, 20000);
+
+    histogram_snapshot merged;
+    for (const auto &h : {fast, slow}) {
+        metric_filters filters;
+        filters.with_metric_fields = {
+            kMetricNameField, kHistogramSumField, kHistogramBucketsField};
+        const auto json_string = take_snapshot_as_json(h.get(), filters);
+
+        metric_brief_histogram_snapshot brief;
+        ASSERT_TRUE(deserialize_metric_snapshot(json_string, brief));
+        ASSERT_EQ("test_server_histogram_int64", brief.name);
+        ASSERT_TRUE(merge_histogram_brief_snapshot(brief, merged));
+    }
+
+    auto expected = fast->snapshot();
+    expected.merge(slow->snapshot());
+    ASSERT_EQ(1000u, merged.count());
+    ASSERT_EQ(expected.count(), merged.count());
+    ASSERT_EQ(expected.sum(), merged.sum());
+    ASSERT_EQ(expected.buckets(), merged.buckets());
+
+    // The 99th percentile of all observations is 20000, which could never be computed from the
+    // percentiles of each replica.
+    ASSERT_EQ(histogram_bucket_upper_bound(histogram_bucket_index(20000)),
+              merged.value_at(kth_percentile_type::P99));
+    ASSERT_EQ(10u, merged.value_at(kth_percentile_type::P50));
+
+    metric_brief_histogram_snapshot invalid;
+    invalid.buckets = {{1, 2, 3}};
+    ASSERT_FALSE(merge_histogram_brief_snapshot(invalid, merged));
+}
+
 } // namespace dsn
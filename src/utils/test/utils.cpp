@@ -72,6 +72,46 @@ TEST(core, crc)
     EXPECT_TRUE(c3 == c4);
 }
 
+TEST(core, crc_kernels)
+{
+    ASSERT_TRUE(crc_kernel_supported(best_crc_kernel()));
+
+    std::string buffer(20000, '\0');
+    for (auto &c : buffer) {
+        c = static_cast<char>(rand::next_u32(0, 255));
+    }
+
+    // All the supported kernels should produce the same results as the tables, no matter how
+    // the input is aligned and how long it is.
+    for (const auto kernel : {crc_kernel::kSse42, crc_kernel::kAvx512}) {
+        if (!crc_kernel_supported(kernel)) {
+            continue;
+        }
+
+        for (size_t size : {0, 1, 7, 8, 15, 16, 17, 63, 64, 65, 255, 256, 257, 767, 768, 769}) {
+            for (size_t offset = 0; offset < 16; ++offset) {
+                const auto *data = buffer.data() + offset;
+                const auto init32 = rand::next_u32();
+                const auto init64 = rand::next_u64();
+                ASSERT_EQ(crc32_calc(crc_kernel::kTable, data, size, init32),
+                          crc32_calc(kernel, data, size, init32));
+                ASSERT_EQ(crc64_calc(crc_kernel::kTable, data, size, init64),
+                          crc64_calc(kernel, data, size, init64));
+            }
+        }
+
+        for (int i = 0; i < 100; ++i) {
+            const auto offset = rand::next_u32(0, 63);
+            const auto size = rand::next_u32(0, buffer.size() - offset);
+            const auto *data = buffer.data() + offset;
+            ASSERT_EQ(crc32_calc(crc_kernel::kTable, data, size, 0),
+                      crc32_calc(kernel, data, size, 0));
+            ASSERT_EQ(crc64_calc(crc_kernel::kTable, data, size, 0),
+                      crc64_calc(kernel, data, size, 0));
+        }
+    }
+}
+
 TEST(core, binary_io)
 {
     int value = 0xdeadbeef;